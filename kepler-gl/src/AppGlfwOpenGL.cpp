@@ -2,6 +2,8 @@
 #include "App.hpp"
 #include <OpenGL.hpp>
 #include "RenderState.hpp"
+#include "Performance.hpp"
+#include "GLStats.hpp"
 #include <GLFW/glfw3.h>
 
 namespace kepler {
@@ -224,6 +226,7 @@ GLFWwindow* App::Impl::createWindow(int width, int height) {
         std::cout << "Failed to initialize OpenGL context" << std::endl;
         return nullptr;
     }
+    gl::loadExtensions((GLADloadproc)glfwGetProcAddress);
     glViewport(0, 0, _width, _height);
     glGetError(); // clear error flag
     return _window;
@@ -241,10 +244,17 @@ void App::Impl::mainLoop() {
         // If depth writes were disabled then glClear won't clear the depth buffer.
         // This can happen if the last object to be drawn disabled depth writes.
         RenderState::setGlobalDepthMask(true);
+        FrameProfiler::beginFrame();
+        GLStats::beginFrame();
         if (_delegate) {
-            _delegate->update();
+            {
+                ProfileScope scope("update");
+                _delegate->update();
+            }
+            ProfileScope scope("render");
             _delegate->render();
         }
+        ProfileScope scope("swap");
         glfwSwapBuffers(_window);
     }
 }
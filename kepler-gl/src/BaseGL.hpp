@@ -24,6 +24,13 @@ class Image;
 class Texture;
 class Sampler;
 class BmpFont;
+class OcclusionCuller;
+class ClusteredLighting;
+class TextureUploader;
+class TextureStreamer;
+class TextureArray;
+class GpuTimer;
+class SceneLoad;
 
 class AxisCompass;
 
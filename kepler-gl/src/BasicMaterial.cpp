@@ -0,0 +1,127 @@
+#include "stdafx.h"
+#include "BasicMaterial.hpp"
+#include "Technique.hpp"
+#include "MaterialParameter.hpp"
+#include "EffectCache.hpp"
+#include "ClusteredLighting.hpp"
+#include "StringUtils.hpp"
+
+#include <vector>
+
+namespace kepler {
+namespace gl {
+
+static constexpr const GLchar* BASIC_VERT_PATH = "../kepler/res/shaders/basic.vert";
+static constexpr const GLchar* BASIC_FRAG_PATH = "../kepler/res/shaders/basic.frag";
+
+static constexpr const char* HAS_UV = "HAS_UV";
+static constexpr const char* HAS_BASE_COLOR_MAP = "HAS_BASE_COLOR_MAP";
+static constexpr const char* OCT_NORMALS = "OCT_NORMALS";
+static constexpr const char* CLUSTERED_LIGHTS = "CLUSTERED_LIGHTS";
+static constexpr const char* HAS_BASE_COLOR_ARRAY = "HAS_BASE_COLOR_ARRAY";
+static constexpr const char* BINDLESS_TEXTURES = "BINDLESS_TEXTURES";
+
+shared_ptr<Technique> createBasicTechnique(const BasicMaterialParams& params, ClusteredLighting* lighting, bool async) {
+    std::vector<const char*> defines;
+    if (params.texCoords) {
+        defines.push_back(HAS_UV);
+    }
+    if (params.octNormals) {
+        defines.push_back(OCT_NORMALS);
+    }
+    if (lighting) {
+        defines.push_back(CLUSTERED_LIGHTS);
+    }
+    const bool useBindless = params.bindless && bindless::supported();
+    if (params.baseMap && params.baseMapLayer >= 0) {
+        defines.push_back(HAS_BASE_COLOR_ARRAY);
+    }
+    else if (params.baseMap) {
+        defines.push_back(HAS_BASE_COLOR_MAP);
+        if (useBindless) {
+            defines.push_back(BINDLESS_TEXTURES);
+        }
+    }
+
+    shared_ptr<Effect> effect = EffectCache::createFromFile(BASIC_VERT_PATH, BASIC_FRAG_PATH, defines.data(), defines.size(), async);
+    if (!effect) {
+        // try one directory back
+        std::string vPath{concat("../", BASIC_VERT_PATH)};
+        std::string fPath{concat("../", BASIC_FRAG_PATH)};
+        effect = EffectCache::createFromFile(vPath.c_str(), fPath.c_str(), defines.data(), defines.size(), async);
+    }
+    if (!effect) {
+        return nullptr;
+    }
+    auto tech = Technique::create(effect);
+
+    if (params.baseMap && params.baseMapLayer >= 0) {
+        // Materials with textures in the same array share the bound texture and only differ by the layer.
+        tech->setUniform("s_baseMaps", MaterialParameter::create("s_baseMaps", params.baseMap));
+        tech->setUniform("baseMapLayer", MaterialParameter::create("baseMapLayer", static_cast<float>(params.baseMapLayer)));
+    }
+    else if (params.baseMap && useBindless) {
+        auto param = MaterialParameter::create("s_baseMap");
+        param->setBindlessTexture(params.baseMap);
+        tech->setUniform("s_baseMap", param);
+    }
+    else if (params.baseMap) {
+        tech->setUniform("s_baseMap", MaterialParameter::create("s_baseMap", params.baseMap));
+    }
+
+    tech->setAttribute("a_position", AttributeSemantic::POSITION);
+    tech->setAttribute("a_normal", AttributeSemantic::NORMAL);
+    tech->setAttribute("a_texcoord0", AttributeSemantic::TEXCOORD_0);
+
+    tech->setSemanticUniform("mvp", MaterialParameter::Semantic::MODELVIEWPROJECTION);
+    tech->setSemanticUniform("modelView", MaterialParameter::Semantic::MODELVIEW);
+    tech->setSemanticUniform("normalMatrix", MaterialParameter::Semantic::MODELVIEWINVERSETRANSPOSE);
+
+    tech->setUniform("shininess", MaterialParameter::create("shininess", 64.0f));
+    tech->setUniform("specularStrength", MaterialParameter::create("specularStrength", 0.2f));
+    tech->setUniform("ambient", MaterialParameter::create("ambient", vec3(0.2f)));
+
+    if (lighting) {
+        lighting->setUniforms(*tech);
+    }
+    else {
+        tech->setUniform("lightPos", MaterialParameter::create("lightPos", vec3(1, 1, 1)));
+        tech->setUniform("lightColor", MaterialParameter::create("lightColor", vec3(1, 1, 1)));
+        tech->setUniform("constantAttenuation", MaterialParameter::create("constantAttenuation", 1.f));
+        tech->setUniform("linearAttenuation", MaterialParameter::create("linearAttenuation", 0.f));
+        tech->setUniform("quadraticAttenuation", MaterialParameter::create("quadraticAttenuation", 0.0025f));
+    }
+
+    // gltf 2.0
+    tech->setUniform("baseColorFactor", MaterialParameter::create("baseColorFactor", params.baseColorFactor));
+
+    auto& state = tech->renderState();
+    state.setDepthTest(true);
+    state.setCulling(!params.doubleSided);
+    return tech;
+}
+
+bool readBasicTechnique(Technique& technique, BasicMaterialParams& params) {
+    auto factor = technique.findValueParameter("baseColorFactor");
+    if (factor == nullptr || factor->vectorValue(params.baseColorFactor) != 4) {
+        return false;
+    }
+    params.baseMap = nullptr;
+    params.baseMapLayer = -1;
+    if (auto baseMaps = technique.findValueParameter("s_baseMaps")) {
+        vec4 layer;
+        auto param = technique.findValueParameter("baseMapLayer");
+        if (param && param->vectorValue(layer) == 1) {
+            params.baseMap = baseMaps->texture();
+            params.baseMapLayer = static_cast<int>(layer.x);
+        }
+    }
+    else if (auto baseMap = technique.findValueParameter("s_baseMap")) {
+        params.baseMap = baseMap->texture();
+    }
+    params.doubleSided = !technique.renderState().isCullingEnabled();
+    return true;
+}
+
+} // namespace gl
+} // namespace kepler
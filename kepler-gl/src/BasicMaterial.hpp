@@ -0,0 +1,37 @@
+#pragma once
+
+#include <BaseGL.hpp>
+#include <BaseMath.hpp>
+
+namespace kepler {
+namespace gl {
+
+/// The values that select the shader variant and parameters of the material drawn with basic.vert and basic.frag.
+struct BasicMaterialParams {
+    vec4 baseColorFactor = vec4(1);
+    /// The base color texture. May be null.
+    shared_ptr<Texture> baseMap;
+    /// The layer of baseMap if it is a texture array; -1 otherwise.
+    int baseMapLayer = -1;
+    /// True if the primitive has TEXCOORD_0.
+    bool texCoords = false;
+    /// True if the normals are octahedral encoded.
+    bool octNormals = false;
+    bool doubleSided = false;
+    /// True if the base map should be bound with a bindless handle. Ignored for texture arrays.
+    bool bindless = false;
+};
+
+/// Creates the technique of a basic material. Materials with the same defines share one compiled effect.
+/// @param[in] lighting The lights to use. A single point light is used if null.
+/// @param[in] async    Compiles the effect with Effect::createFromSourceAsync() so it may not be ready yet.
+/// @return The technique. Null if the shader files weren't found or didn't compile.
+shared_ptr<Technique> createBasicTechnique(const BasicMaterialParams& params, ClusteredLighting* lighting, bool async);
+
+/// Reads the parameters back from a technique that was created by createBasicTechnique().
+/// Only baseColorFactor, baseMap, baseMapLayer and doubleSided are set since the others aren't kept by the technique.
+/// @return False if the technique wasn't created by createBasicTechnique().
+bool readBasicTechnique(Technique& technique, BasicMaterialParams& params);
+
+} // namespace gl
+} // namespace kepler
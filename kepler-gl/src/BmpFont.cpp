@@ -8,6 +8,7 @@
 #include "Texture.hpp"
 #include "Sampler.hpp"
 #include "App.hpp"
+#include "GLStats.hpp"
 
 #include <regex>
 #include <chrono>
@@ -452,11 +453,14 @@ void BmpFontRenderer::draw(const GLfloat* data, GLsizei count, const Texture* te
     _state.bind();
     effect->setValue(effect->getUniformLocation("u_textColor"), color);
     glActiveTexture(GL_TEXTURE0);
+    KEPLER_GL_COUNT(VERTEX_ARRAY_BINDS);
     glBindVertexArray(_vao);
     texture->bind(0);
     glBindBuffer(GL_ARRAY_BUFFER, _vbo);
     static constexpr GLsizeiptr SIZE = VERTEX_COUNT * VERTEX_SIZE * sizeof(GLfloat);
+    KEPLER_GL_COUNT(BUFFER_UPDATES);
     glBufferSubData(GL_ARRAY_BUFFER, 0, SIZE * count, data);
+    KEPLER_GL_COUNT(DRAW_CALLS);
     glDrawArrays(GL_TRIANGLES, 0, count * VERTEX_COUNT);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
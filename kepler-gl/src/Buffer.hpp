@@ -47,6 +47,11 @@ public:
         glBindBuffer(Target, _handle);
     }
 
+    /// Returns the GL buffer name.
+    BufferHandle handle() const noexcept {
+        return _handle;
+    }
+
     void destroy() {
         if (_handle) {
             glDeleteBuffers(1, &_handle);
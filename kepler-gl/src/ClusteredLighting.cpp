@@ -0,0 +1,118 @@
+#include "stdafx.h"
+#include "ClusteredLighting.hpp"
+#include "Technique.hpp"
+#include "MaterialParameter.hpp"
+#include "Effect.hpp"
+#include "Camera.hpp"
+#include "GLStats.hpp"
+
+#include <algorithm>
+
+namespace kepler {
+namespace gl {
+
+// Empty texture buffers are not allowed so every buffer has room for at least this many bytes.
+static constexpr size_t MIN_BUFFER_SIZE = 16;
+
+ClusteredLighting::ClusteredLighting(int tilesX, int tilesY, int slices) : _clusters(tilesX, tilesY, slices) {
+}
+
+ClusteredLighting::~ClusteredLighting() noexcept {
+    destroy(_lightBuffer);
+    destroy(_clusterBuffer);
+    destroy(_indexBuffer);
+}
+
+shared_ptr<ClusteredLighting> ClusteredLighting::create(int tilesX, int tilesY, int slices) {
+    return std::make_shared<ClusteredLighting>(tilesX, tilesY, slices);
+}
+
+std::vector<PointLight>& ClusteredLighting::lights() {
+    return _lights;
+}
+
+void ClusteredLighting::addLight(const PointLight& light) {
+    _lights.push_back(light);
+}
+
+void ClusteredLighting::clearLights() {
+    _lights.clear();
+}
+
+void ClusteredLighting::update(const Camera& camera, int viewportWidth, int viewportHeight) {
+    _clusters.update(_lights, camera);
+
+    const auto& lightData = _clusters.lightData();
+    const auto& clusters = _clusters.clusters();
+    const auto& indices = _clusters.lightIndices();
+    upload(_lightBuffer, GL_RGBA32F, lightData.data(), lightData.size() * sizeof(vec4));
+    upload(_clusterBuffer, GL_RG32UI, clusters.data(), clusters.size() * sizeof(uint32_t));
+    upload(_indexBuffer, GL_R32UI, indices.data(), indices.size() * sizeof(uint32_t));
+
+    _grid = vec4(static_cast<float>(viewportWidth) / _clusters.tilesX(), static_cast<float>(viewportHeight) / _clusters.tilesY(),
+        _clusters.tilesX(), _clusters.tilesY());
+    _slices = vec4(_clusters.sliceScale(), _clusters.sliceBias(), _clusters.slices(), _clusters.linearSlices() ? 1.0f : 0.0f);
+}
+
+void ClusteredLighting::setUniforms(Technique& technique) {
+    std::weak_ptr<ClusteredLighting> weak = shared_from_this();
+    auto textureBuffer = [weak](TextureBuffer ClusteredLighting::* member) {
+        return MaterialParameter::FunctionBinding([weak, member](Effect& effect, const Uniform* uniform) {
+            if (auto lighting = weak.lock()) {
+                effect.setTextureBuffer(uniform, ((*lighting).*member).texture);
+            }
+        });
+    };
+    technique.setUniform("u_lights", MaterialParameter::create("u_lights", textureBuffer(&ClusteredLighting::_lightBuffer)));
+    technique.setUniform("u_clusters", MaterialParameter::create("u_clusters", textureBuffer(&ClusteredLighting::_clusterBuffer)));
+    technique.setUniform("u_lightIndices", MaterialParameter::create("u_lightIndices", textureBuffer(&ClusteredLighting::_indexBuffer)));
+
+    technique.setUniform("clusterGrid", MaterialParameter::create("clusterGrid",
+        MaterialParameter::FunctionBinding([weak](Effect& effect, const Uniform* uniform) {
+        if (auto lighting = weak.lock()) {
+            effect.setValue(uniform, lighting->_grid);
+        }
+    })));
+    technique.setUniform("clusterSlices", MaterialParameter::create("clusterSlices",
+        MaterialParameter::FunctionBinding([weak](Effect& effect, const Uniform* uniform) {
+        if (auto lighting = weak.lock()) {
+            effect.setValue(uniform, lighting->_slices);
+        }
+    })));
+}
+
+LightClusters& ClusteredLighting::clusters() {
+    return _clusters;
+}
+
+void ClusteredLighting::upload(TextureBuffer& textureBuffer, GLenum format, const void* data, size_t size) {
+    if (textureBuffer.buffer == 0) {
+        glGenBuffers(1, &textureBuffer.buffer);
+        glGenTextures(1, &textureBuffer.texture);
+        glBindBuffer(GL_TEXTURE_BUFFER, textureBuffer.buffer);
+        glBufferData(GL_TEXTURE_BUFFER, MIN_BUFFER_SIZE, nullptr, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, textureBuffer.texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, textureBuffer.buffer);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, textureBuffer.buffer);
+    KEPLER_GL_COUNT(BUFFER_UPDATES);
+    // Orphan the old storage so the driver doesn't wait for the previous frame to finish with it.
+    glBufferData(GL_TEXTURE_BUFFER, std::max(size, MIN_BUFFER_SIZE), nullptr, GL_STREAM_DRAW);
+    if (size > 0) {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void ClusteredLighting::destroy(TextureBuffer& textureBuffer) {
+    if (textureBuffer.texture) {
+        glDeleteTextures(1, &textureBuffer.texture);
+    }
+    if (textureBuffer.buffer) {
+        glDeleteBuffers(1, &textureBuffer.buffer);
+    }
+    textureBuffer = TextureBuffer();
+}
+
+} // namespace gl
+} // namespace kepler
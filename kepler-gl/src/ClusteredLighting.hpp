@@ -0,0 +1,73 @@
+#pragma once
+
+#include <BaseGL.hpp>
+#include <OpenGL.hpp>
+#include <BaseMath.hpp>
+#include <LightClusters.hpp>
+
+#include <vector>
+
+namespace kepler {
+namespace gl {
+
+/// ClusteredLighting shades many point lights with the CLUSTERED_LIGHTS variant of basic.frag.
+///
+/// Each frame the lights are assigned to the clusters of a LightClusters grid and the results are uploaded
+/// to texture buffers. Texture buffers are used instead of shader storage buffers so that this works with OpenGL 3.3.
+/// - u_lights       RGBA32F: 2 texels per light. The view space position and range, then the color.
+/// - u_clusters     RG32UI: 1 texel per cluster. The offset into u_lightIndices and the number of lights.
+/// - u_lightIndices R32UI: The lights of every cluster.
+///
+/// The cost of each pixel is proportional to the number of lights in its cluster instead of the total number of lights.
+class ClusteredLighting : public std::enable_shared_from_this<ClusteredLighting> {
+public:
+    /// Use ClusteredLighting::create()
+    ClusteredLighting(int tilesX, int tilesY, int slices);
+    virtual ~ClusteredLighting() noexcept;
+    ClusteredLighting(const ClusteredLighting&) = delete;
+    ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+    static shared_ptr<ClusteredLighting> create(int tilesX = 16, int tilesY = 9, int slices = 24);
+
+    /// Returns the lights. Changes take effect on the next update().
+    std::vector<PointLight>& lights();
+
+    void addLight(const PointLight& light);
+    void clearLights();
+
+    /// Assigns the lights to the clusters of the camera and uploads the results.
+    /// Call once per frame before drawing.
+    /// @param[in] camera         The camera that the scene will be drawn with.
+    /// @param[in] viewportWidth  The width of the viewport in pixels.
+    /// @param[in] viewportHeight The height of the viewport in pixels.
+    void update(const Camera& camera, int viewportWidth, int viewportHeight);
+
+    /// Adds the uniforms used by the CLUSTERED_LIGHTS shader variant to the technique.
+    void setUniforms(Technique& technique);
+
+    /// Returns the cluster grid.
+    LightClusters& clusters();
+
+private:
+    struct TextureBuffer {
+        BufferHandle buffer = 0;
+        TextureHandle texture = 0;
+    };
+
+    static void upload(TextureBuffer& textureBuffer, GLenum format, const void* data, size_t size);
+    static void destroy(TextureBuffer& textureBuffer);
+
+private:
+    LightClusters _clusters;
+    std::vector<PointLight> _lights;
+    TextureBuffer _lightBuffer;
+    TextureBuffer _clusterBuffer;
+    TextureBuffer _indexBuffer;
+    // tile width and height in pixels, tiles x and y
+    vec4 _grid;
+    // slice scale, slice bias, slice count and 1 if the slices are linear
+    vec4 _slices;
+};
+
+} // namespace gl
+} // namespace kepler
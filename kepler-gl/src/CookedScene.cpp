@@ -0,0 +1,511 @@
+#include "stdafx.h"
+#include "CookedScene.hpp"
+#include "CookedFormat.hpp"
+#include "MappedFile.hpp"
+#include "FileSystem.hpp"
+#include "Logging.hpp"
+#include "Scene.hpp"
+#include "Node.hpp"
+#include "Mesh.hpp"
+#include "MeshPrimitive.hpp"
+#include "MeshRenderer.hpp"
+#include "VertexAttributeAccessor.hpp"
+#include "VertexBuffer.hpp"
+#include "IndexBuffer.hpp"
+#include "IndexAccessor.hpp"
+#include "Material.hpp"
+#include "Technique.hpp"
+#include "Texture.hpp"
+#include "Sampler.hpp"
+#include "BasicMaterial.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <tuple>
+
+namespace kepler {
+namespace gl {
+
+using std::chrono::high_resolution_clock;
+
+namespace {
+
+/// Builds the cooked data of a scene by reading its GL objects back.
+class Cooker {
+public:
+    void addNode(const Node& node, uint32_t parent);
+
+    cooked::SceneData scene;
+
+private:
+    uint32_t addMesh(const Mesh& mesh);
+    void addPrimitive(MeshPrimitive& prim);
+    uint32_t addMaterial(const shared_ptr<Material>& material);
+    uint32_t addTexture(const Texture& texture);
+    template<GLenum Target>
+    uint32_t addBuffer(const Buffer<Target>& buffer);
+
+    std::map<const Mesh*, uint32_t> _meshes;
+    std::map<const Material*, uint32_t> _materials;
+    std::map<const Texture*, uint32_t> _textures;
+    // Textures that share a GL texture share their levels.
+    std::map<TextureHandle, std::pair<uint32_t, uint32_t>> _levels;
+    std::map<BufferHandle, uint32_t> _buffers;
+};
+
+void Cooker::addNode(const Node& node, uint32_t parent) {
+    cooked::Node cNode = {};
+    memcpy(cNode.matrix, glm::value_ptr(node.localTransform().matrix()), sizeof(cNode.matrix));
+    cNode.parent = parent;
+    cNode.mesh = cooked::NONE;
+    cNode.name = scene.addString(node.namePtr());
+    auto renderer = std::dynamic_pointer_cast<MeshRenderer>(node.drawable());
+    if (renderer && renderer->mesh()) {
+        cNode.mesh = addMesh(*renderer->mesh());
+    }
+    const uint32_t index = static_cast<uint32_t>(scene.nodes.size());
+    scene.nodes.push_back(cNode);
+    for (size_t i = 0; i < node.childCount(); ++i) {
+        addNode(*node.childAt(i), index);
+    }
+}
+
+uint32_t Cooker::addMesh(const Mesh& mesh) {
+    auto it = _meshes.find(&mesh);
+    if (it != _meshes.end()) {
+        return it->second;
+    }
+    cooked::Mesh cMesh = {};
+    cMesh.firstPrimitive = static_cast<uint32_t>(scene.primitives.size());
+    for (size_t i = 0; i < mesh.primitiveCount(); ++i) {
+        addPrimitive(*mesh.primitivePtr(i));
+    }
+    cMesh.primitiveCount = static_cast<uint32_t>(scene.primitives.size()) - cMesh.firstPrimitive;
+    const uint32_t index = static_cast<uint32_t>(scene.meshes.size());
+    scene.meshes.push_back(cMesh);
+    _meshes[&mesh] = index;
+    return index;
+}
+
+void Cooker::addPrimitive(MeshPrimitive& prim) {
+    cooked::Primitive cPrim = {};
+    cPrim.mode = static_cast<uint32_t>(prim.mode());
+    cPrim.firstAttribute = static_cast<uint32_t>(scene.attributes.size());
+    for (int i = static_cast<int>(AttributeSemantic::POSITION); i <= static_cast<int>(AttributeSemantic::TEXCOORD_31); ++i) {
+        auto accessor = prim.attribute(static_cast<AttributeSemantic>(i));
+        if (accessor == nullptr || accessor->buffer() == nullptr) {
+            continue;
+        }
+        cooked::Attribute attribute = {};
+        attribute.semantic = static_cast<uint32_t>(i);
+        attribute.buffer = addBuffer(*accessor->buffer());
+        attribute.componentSize = static_cast<uint32_t>(accessor->componentSize());
+        attribute.type = accessor->type();
+        attribute.normalized = accessor->normalized();
+        attribute.stride = static_cast<uint32_t>(accessor->stride());
+        attribute.count = static_cast<uint32_t>(accessor->count());
+        attribute.offset = static_cast<uint64_t>(accessor->offset());
+        scene.attributes.push_back(attribute);
+    }
+    cPrim.attributeCount = static_cast<uint32_t>(scene.attributes.size()) - cPrim.firstAttribute;
+
+    cPrim.indexBuffer = cooked::NONE;
+    if (auto indices = prim.indices()) {
+        cPrim.indexBuffer = addBuffer(*indices->buffer());
+        cPrim.indexType = indices->type();
+        cPrim.indexCount = static_cast<uint32_t>(indices->count());
+        cPrim.indexOffset = static_cast<uint64_t>(indices->offset());
+    }
+    const BoundingBox& box = prim.boundingBox();
+    if (!box.empty()) {
+        cPrim.flags |= cooked::Primitive::BOUNDING_BOX;
+        memcpy(cPrim.boxMin, glm::value_ptr(box.min), sizeof(vec3));
+        memcpy(cPrim.boxMax, glm::value_ptr(box.max), sizeof(vec3));
+    }
+    if (prim.positionTransform() != mat4(1)) {
+        cPrim.flags |= cooked::Primitive::POSITION_TRANSFORM;
+    }
+    memcpy(cPrim.positionTransform, glm::value_ptr(prim.positionTransform()), sizeof(cPrim.positionTransform));
+    cPrim.material = addMaterial(prim.material());
+    scene.primitives.push_back(cPrim);
+}
+
+uint32_t Cooker::addMaterial(const shared_ptr<Material>& material) {
+    if (material == nullptr || material->technique() == nullptr) {
+        return cooked::NONE;
+    }
+    auto it = _materials.find(material.get());
+    if (it != _materials.end()) {
+        return it->second;
+    }
+    uint32_t index = cooked::NONE;
+    BasicMaterialParams params;
+    if (readBasicTechnique(*material->technique(), params)) {
+        cooked::Material cMaterial = {};
+        memcpy(cMaterial.baseColorFactor, glm::value_ptr(params.baseColorFactor), sizeof(cMaterial.baseColorFactor));
+        cMaterial.baseMap = params.baseMap ? addTexture(*params.baseMap) : cooked::NONE;
+        cMaterial.baseMapLayer = params.baseMapLayer;
+        cMaterial.flags = params.doubleSided ? static_cast<uint32_t>(cooked::Material::DOUBLE_SIDED) : 0u;
+        cMaterial.name = scene.addString(material->name().c_str());
+        index = static_cast<uint32_t>(scene.materials.size());
+        scene.materials.push_back(cMaterial);
+    }
+    _materials[material.get()] = index;
+    return index;
+}
+
+static bool isSrgb(GLint internalFormat) {
+    return internalFormat == GL_SRGB || internalFormat == GL_SRGB8 || internalFormat == GL_SRGB_ALPHA || internalFormat == GL_SRGB8_ALPHA8;
+}
+
+uint32_t Cooker::addTexture(const Texture& texture) {
+    auto it = _textures.find(&texture);
+    if (it != _textures.end()) {
+        return it->second;
+    }
+    const GLenum target = static_cast<GLenum>(texture.type());
+    cooked::Texture cTexture = {};
+    cTexture.target = target;
+
+    auto levels = _levels.find(texture.handle());
+    glBindTexture(target, texture.handle());
+    GLint baseLevel = 0;
+    glGetTexParameteriv(target, GL_TEXTURE_BASE_LEVEL, &baseLevel);
+    GLint width = 0;
+    GLint height = 0;
+    GLint depth = 0;
+    GLint internalFormat = 0;
+    GLint compressed = GL_FALSE;
+    glGetTexLevelParameteriv(target, baseLevel, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(target, baseLevel, GL_TEXTURE_HEIGHT, &height);
+    glGetTexLevelParameteriv(target, baseLevel, GL_TEXTURE_DEPTH, &depth);
+    glGetTexLevelParameteriv(target, baseLevel, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+    glGetTexLevelParameteriv(target, baseLevel, GL_TEXTURE_COMPRESSED, &compressed);
+    cTexture.width = static_cast<uint32_t>(width);
+    cTexture.height = static_cast<uint32_t>(height);
+    cTexture.depth = static_cast<uint32_t>(std::max(depth, 1));
+    if (compressed) {
+        cTexture.flags = cooked::Texture::COMPRESSED;
+        cTexture.internalFormat = static_cast<uint32_t>(internalFormat);
+    }
+    else {
+        // Uncompressed textures are read back as RGBA8 which keeps the values of the 8 bit formats.
+        cTexture.internalFormat = isSrgb(internalFormat) ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    }
+
+    if (levels == _levels.end()) {
+        GLint maxLevel = 0;
+        glGetTexParameteriv(target, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+        const uint32_t firstLevel = static_cast<uint32_t>(scene.levels.size());
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        for (GLint level = baseLevel; level <= maxLevel; ++level) {
+            GLint w = 0;
+            GLint h = 0;
+            glGetTexLevelParameteriv(target, level, GL_TEXTURE_WIDTH, &w);
+            glGetTexLevelParameteriv(target, level, GL_TEXTURE_HEIGHT, &h);
+            if (w == 0 || h == 0) {
+                break;
+            }
+            cooked::Level cLevel = {};
+            if (compressed) {
+                GLint size = 0;
+                glGetTexLevelParameteriv(target, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+                cLevel.size = static_cast<uint64_t>(size);
+                cLevel.offset = scene.addData(nullptr, cLevel.size);
+                glGetCompressedTexImage(target, level, scene.data.data() + cLevel.offset);
+            }
+            else {
+                cLevel.size = static_cast<uint64_t>(w) * static_cast<uint64_t>(h) * cTexture.depth * 4;
+                cLevel.offset = scene.addData(nullptr, cLevel.size);
+                glGetTexImage(target, level, GL_RGBA, GL_UNSIGNED_BYTE, scene.data.data() + cLevel.offset);
+            }
+            scene.levels.push_back(cLevel);
+        }
+        levels = _levels.emplace(texture.handle(),
+            std::make_pair(firstLevel, static_cast<uint32_t>(scene.levels.size()) - firstLevel)).first;
+    }
+    glBindTexture(target, 0);
+    if (levels->second.second == 0) {
+        // Nothing is uploaded yet.
+        _textures[&texture] = cooked::NONE;
+        return cooked::NONE;
+    }
+    cTexture.firstLevel = levels->second.first;
+    cTexture.levelCount = levels->second.second;
+
+    GLint wrapS = GL_REPEAT;
+    GLint wrapT = GL_REPEAT;
+    GLint minFilter = GL_NEAREST_MIPMAP_LINEAR;
+    GLint magFilter = GL_LINEAR;
+    if (auto sampler = texture.sampler()) {
+        glGetSamplerParameteriv(sampler->handle(), GL_TEXTURE_WRAP_S, &wrapS);
+        glGetSamplerParameteriv(sampler->handle(), GL_TEXTURE_WRAP_T, &wrapT);
+        glGetSamplerParameteriv(sampler->handle(), GL_TEXTURE_MIN_FILTER, &minFilter);
+        glGetSamplerParameteriv(sampler->handle(), GL_TEXTURE_MAG_FILTER, &magFilter);
+    }
+    cTexture.wrapS = static_cast<uint32_t>(wrapS);
+    cTexture.wrapT = static_cast<uint32_t>(wrapT);
+    cTexture.minFilter = static_cast<uint32_t>(minFilter);
+    cTexture.magFilter = static_cast<uint32_t>(magFilter);
+
+    const uint32_t index = static_cast<uint32_t>(scene.textures.size());
+    scene.textures.push_back(cTexture);
+    _textures[&texture] = index;
+    return index;
+}
+
+template<GLenum Target>
+uint32_t Cooker::addBuffer(const Buffer<Target>& buffer) {
+    auto it = _buffers.find(buffer.handle());
+    if (it != _buffers.end()) {
+        return it->second;
+    }
+    // The copy read target doesn't change the element array buffer of the bound vertex array.
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer.handle());
+    GLint64 size = 0;
+    glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+    cooked::Buffer cBuffer = {};
+    cBuffer.target = Target;
+    cBuffer.size = static_cast<uint64_t>(size);
+    cBuffer.offset = scene.addData(nullptr, cBuffer.size);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, static_cast<GLsizeiptr>(size), scene.data.data() + cBuffer.offset);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    const uint32_t index = static_cast<uint32_t>(scene.buffers.size());
+    scene.buffers.push_back(cBuffer);
+    _buffers[buffer.handle()] = index;
+    return index;
+}
+
+/// Creates the GL objects of a cooked file.
+class Uploader {
+public:
+    Uploader(const cooked::SceneView& view, const shared_ptr<ClusteredLighting>& lighting) : _view(view), _lighting(lighting) {}
+
+    shared_ptr<Scene> createScene();
+
+private:
+    void createBuffers();
+    shared_ptr<Texture> createTexture(const cooked::Texture& cTexture);
+    shared_ptr<Mesh> createMesh(const cooked::Mesh& cMesh);
+    shared_ptr<MeshPrimitive> createPrimitive(const cooked::Primitive& cPrim);
+    shared_ptr<Material> createMaterial(uint32_t index, bool texCoords, bool octNormals);
+
+    const cooked::SceneView& _view;
+    shared_ptr<ClusteredLighting> _lighting;
+    std::vector<shared_ptr<VertexBuffer>> _vbos;
+    std::vector<shared_ptr<IndexBuffer>> _indexBuffers;
+    std::vector<shared_ptr<Texture>> _textures;
+    std::vector<shared_ptr<Mesh>> _meshes;
+    // The shader variant of a material depends on the attributes of the primitive.
+    std::map<std::tuple<uint32_t, bool, bool>, shared_ptr<Material>> _materials;
+};
+
+shared_ptr<Scene> Uploader::createScene() {
+    createBuffers();
+    _textures.resize(_view.textureCount);
+    for (size_t i = 0; i < _view.textureCount; ++i) {
+        _textures[i] = createTexture(_view.textures[i]);
+    }
+    _meshes.resize(_view.meshCount);
+    for (size_t i = 0; i < _view.meshCount; ++i) {
+        _meshes[i] = createMesh(_view.meshes[i]);
+    }
+
+    auto scene = Scene::create();
+    std::vector<shared_ptr<Node>> nodes(_view.nodeCount);
+    for (size_t i = 0; i < _view.nodeCount; ++i) {
+        const cooked::Node& cNode = _view.nodes[i];
+        auto node = Node::create(_view.string(cNode.name));
+        node->setLocalTransform(glm::make_mat4(cNode.matrix));
+        if (cNode.mesh != cooked::NONE && _meshes[cNode.mesh]) {
+            node->addComponent(MeshRenderer::create(_meshes[cNode.mesh]));
+        }
+        // Parents always come before their children.
+        if (cNode.parent == cooked::NONE) {
+            scene->addNode(node);
+        }
+        else {
+            nodes[cNode.parent]->addNode(node);
+        }
+        nodes[i] = node;
+    }
+    return scene;
+}
+
+void Uploader::createBuffers() {
+    _vbos.resize(_view.bufferCount);
+    _indexBuffers.resize(_view.bufferCount);
+    for (size_t i = 0; i < _view.bufferCount; ++i) {
+        const cooked::Buffer& cBuffer = _view.buffers[i];
+        // The driver copies straight from the mapped file.
+        ByteSpan bytes = _view.bytes(cBuffer.offset, cBuffer.size);
+        if (cBuffer.target == GL_ELEMENT_ARRAY_BUFFER) {
+            _indexBuffers[i] = IndexBuffer::create(static_cast<GLsizeiptr>(bytes.size), bytes.data);
+        }
+        else {
+            _vbos[i] = VertexBuffer::create(static_cast<GLsizeiptr>(bytes.size), bytes.data);
+        }
+    }
+}
+
+shared_ptr<Texture> Uploader::createTexture(const cooked::Texture& cTexture) {
+    const GLenum target = cTexture.target;
+    if (target != GL_TEXTURE_2D && target != GL_TEXTURE_2D_ARRAY) {
+        return nullptr;
+    }
+    TextureHandle handle;
+    glGenTextures(1, &handle);
+    if (handle == 0) {
+        return nullptr;
+    }
+    const bool compressed = (cTexture.flags & cooked::Texture::COMPRESSED) != 0;
+    const GLsizei levelCount = static_cast<GLsizei>(cTexture.levelCount);
+    const GLsizei width = static_cast<GLsizei>(cTexture.width);
+    const GLsizei height = static_cast<GLsizei>(cTexture.height);
+    const GLsizei depth = static_cast<GLsizei>(cTexture.depth);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(target, handle);
+    if (target == GL_TEXTURE_2D_ARRAY) {
+        glTexStorage3D(target, levelCount, cTexture.internalFormat, width, height, depth);
+    }
+    else {
+        glTexStorage2D(target, levelCount, cTexture.internalFormat, width, height);
+    }
+    for (GLsizei level = 0; level < levelCount; ++level) {
+        const cooked::Level& cLevel = _view.levels[cTexture.firstLevel + level];
+        ByteSpan bytes = _view.bytes(cLevel.offset, cLevel.size);
+        const GLsizei w = std::max(1, width >> level);
+        const GLsizei h = std::max(1, height >> level);
+        const GLsizei size = static_cast<GLsizei>(bytes.size);
+        if (target == GL_TEXTURE_2D_ARRAY && compressed) {
+            glCompressedTexSubImage3D(target, level, 0, 0, 0, w, h, depth, cTexture.internalFormat, size, bytes.data);
+        }
+        else if (target == GL_TEXTURE_2D_ARRAY) {
+            glTexSubImage3D(target, level, 0, 0, 0, w, h, depth, GL_RGBA, GL_UNSIGNED_BYTE, bytes.data);
+        }
+        else if (compressed) {
+            glCompressedTexSubImage2D(target, level, 0, 0, w, h, cTexture.internalFormat, size, bytes.data);
+        }
+        else {
+            glTexSubImage2D(target, level, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, bytes.data);
+        }
+    }
+    glBindTexture(target, 0);
+
+    auto texture = std::make_shared<Texture>(handle, static_cast<Texture::Type>(target), width, height);
+    if (auto sampler = Sampler::create()) {
+        sampler->setWrapMode(static_cast<Sampler::Wrap>(cTexture.wrapS), static_cast<Sampler::Wrap>(cTexture.wrapT));
+        sampler->setFilterMode(static_cast<Sampler::MinFilter>(cTexture.minFilter), static_cast<Sampler::MagFilter>(cTexture.magFilter));
+        texture->setSampler(sampler);
+    }
+    return texture;
+}
+
+shared_ptr<Mesh> Uploader::createMesh(const cooked::Mesh& cMesh) {
+    auto mesh = Mesh::create();
+    for (uint32_t i = 0; i < cMesh.primitiveCount; ++i) {
+        if (auto prim = createPrimitive(_view.primitives[cMesh.firstPrimitive + i])) {
+            mesh->addMeshPrimitive(prim);
+        }
+    }
+    return mesh->primitiveCount() > 0 ? mesh : nullptr;
+}
+
+shared_ptr<MeshPrimitive> Uploader::createPrimitive(const cooked::Primitive& cPrim) {
+    auto prim = MeshPrimitive::create(static_cast<MeshPrimitive::Mode>(cPrim.mode));
+    bool octNormals = false;
+    for (uint32_t i = 0; i < cPrim.attributeCount; ++i) {
+        const cooked::Attribute& attribute = _view.attributes[cPrim.firstAttribute + i];
+        auto& vbo = _vbos[attribute.buffer];
+        if (vbo == nullptr) {
+            continue;
+        }
+        const auto semantic = static_cast<AttributeSemantic>(attribute.semantic);
+        prim->setAttribute(semantic, VertexAttributeAccessor::create(vbo, static_cast<GLint>(attribute.componentSize),
+            attribute.type, static_cast<GLboolean>(attribute.normalized), static_cast<GLsizei>(attribute.stride),
+            static_cast<GLintptr>(attribute.offset), static_cast<GLsizei>(attribute.count)));
+        // Quantized normals are octahedral encoded in 2 components.
+        octNormals = octNormals || (semantic == AttributeSemantic::NORMAL && attribute.componentSize == 2);
+    }
+    if (cPrim.indexBuffer != cooked::NONE) {
+        prim->setIndices(IndexAccessor::create(_indexBuffers[cPrim.indexBuffer], static_cast<GLsizei>(cPrim.indexCount),
+            cPrim.indexType, static_cast<GLintptr>(cPrim.indexOffset)));
+    }
+    if (cPrim.flags & cooked::Primitive::BOUNDING_BOX) {
+        prim->setBoundingBox(glm::make_vec3(cPrim.boxMin), glm::make_vec3(cPrim.boxMax));
+    }
+    if (cPrim.flags & cooked::Primitive::POSITION_TRANSFORM) {
+        prim->setPositionTransform(glm::make_mat4(cPrim.positionTransform));
+    }
+    prim->setMaterial(createMaterial(cPrim.material, prim->hasAttribute(AttributeSemantic::TEXCOORD_0), octNormals));
+    return prim;
+}
+
+shared_ptr<Material> Uploader::createMaterial(uint32_t index, bool texCoords, bool octNormals) {
+    auto key = std::make_tuple(index, texCoords, octNormals);
+    auto it = _materials.find(key);
+    if (it != _materials.end()) {
+        return it->second;
+    }
+    BasicMaterialParams params;
+    params.texCoords = texCoords;
+    params.octNormals = octNormals;
+    auto material = Material::create();
+    if (index != cooked::NONE) {
+        const cooked::Material& cMaterial = _view.materials[index];
+        params.baseColorFactor = glm::make_vec4(cMaterial.baseColorFactor);
+        if (cMaterial.baseMap != cooked::NONE) {
+            params.baseMap = _textures[cMaterial.baseMap];
+            params.baseMapLayer = params.baseMap && params.baseMap->type() == Texture::Type::TEXTURE_2D_ARRAY
+                ? cMaterial.baseMapLayer : -1;
+        }
+        params.doubleSided = (cMaterial.flags & cooked::Material::DOUBLE_SIDED) != 0;
+        material->setName(_view.string(cMaterial.name));
+    }
+    if (auto tech = createBasicTechnique(params, _lighting.get(), false)) {
+        material->setTechnique(tech);
+    }
+    _materials[key] = material;
+    return material;
+}
+
+} // namespace
+
+bool CookedScene::write(const Scene& scene, const char* path) {
+    Cooker cooker;
+    for (const auto& node : scene.children()) {
+        cooker.addNode(*node, cooked::NONE);
+    }
+    std::vector<uint8_t> file;
+    cooked::write(cooker.scene, file);
+    if (!writeBinaryFile(path, file)) {
+        loge("COOKED_SCENE::WRITE_FAILED ", path);
+        return false;
+    }
+    return true;
+}
+
+shared_ptr<Scene> CookedScene::load(const char* path, const shared_ptr<ClusteredLighting>& lighting) {
+    auto start = high_resolution_clock::now();
+    auto file = MappedFile::open(path);
+    if (file == nullptr) {
+        loge("COOKED_SCENE::OPEN_FAILED ", path);
+        return nullptr;
+    }
+    cooked::SceneView view;
+    if (!cooked::read(file->span(), view)) {
+        loge("COOKED_SCENE::INVALID_FILE ", path);
+        return nullptr;
+    }
+    // The GL objects are created before the mapping is released since they are uploaded from it.
+    auto scene = Uploader(view, lighting).createScene();
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(high_resolution_clock::now() - start);
+    std::clog << "Cooked scene loaded in " << time.count() << " ms" << std::endl;
+    return scene;
+}
+
+} // namespace gl
+} // namespace kepler
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <BaseGL.hpp>
+
+namespace kepler {
+namespace gl {
+
+/// Writes scenes to the cooked scene format (see CookedFormat.hpp) and loads them back.
+///
+/// A cooked file holds the node hierarchy and the vertex, index and texture data exactly as it was uploaded,
+/// including any optimization, quantization and texture compression that was done when the scene was first
+/// loaded. Loading maps the file and uploads straight from the mapping so there is no parsing, decoding or copying.
+///
+/// Materials are stored as the parameters of the basic material and recreated with createBasicTechnique().
+/// Cameras, LODs and materials with other techniques are not stored; primitives without a basic material are
+/// drawn with a white basic material.
+class CookedScene {
+public:
+    CookedScene() = delete;
+
+    /// Writes a loaded scene. The buffers and textures are read back from GL so this must be called on the GL thread
+    /// after every texture has finished uploading.
+    /// @return False if the file couldn't be written.
+    static bool write(const Scene& scene, const char* path);
+
+    /// Loads a cooked file.
+    /// @param[in] lighting The lights the materials use. A single point light is used if null.
+    /// @return The scene. Null if the file couldn't be mapped or isn't a valid cooked scene.
+    static shared_ptr<Scene> load(const char* path, const shared_ptr<ClusteredLighting>& lighting = nullptr);
+};
+
+} // namespace gl
+} // namespace kepler
@@ -1,7 +1,9 @@
 #include "stdafx.h"
 #include "Effect.hpp"
 #include "Shader.hpp"
+#include "ProgramBinaryCache.hpp"
 #include "Sampler.hpp"
+#include "GLStats.hpp"
 #include "FileSystem.hpp"
 #include "StringUtils.hpp"
 #include "Logging.hpp"
@@ -13,10 +15,13 @@ namespace gl {
 
 static constexpr const char* VERSION_STR = "#version 120\n"; // TODO move this to be platform specific.
 static constexpr const char* DEFINE = "#define ";
+// GL_COMPLETION_STATUS_KHR from GL_KHR_parallel_shader_compile. The ARB extension uses the same value.
+static constexpr GLenum COMPLETION_STATUS_KHR = 0x91B1;
 
 //static GLuint loadShaderFromFile(const char* path, GLenum shaderType);
-static Shader loadShaderFromSource(const std::string& source, GLenum shaderType, const char* defines[] = nullptr, size_t defineCount = 0);
-static Program createAndLinkProgram(const Shader& vertShader, const Shader& fragShader);
+static std::string preprocessSource(const std::string& source, const char* defines[] = nullptr, size_t defineCount = 0);
+static Shader compileShader(const std::string& source, GLenum shaderType);
+static Program createAndLinkProgram(const Shader& vertShader, const Shader& fragShader, bool retrievable = false);
 //static GLuint loadShaderProgramFromFile(const char* vertShaderPath, const char* fragShaderPath);
 
 Effect::Effect(Program&& program) : _program(std::move(program)) {
@@ -44,7 +49,68 @@ shared_ptr<Effect> Effect::createFromFile(const char* vertexShaderPath, const ch
     return createFromSource(vertSrc, fragSrc, defines, defineCount);
 }
 
+shared_ptr<Effect> Effect::createFromSourceAsync(const std::string& vertSource, const std::string& fragSource, const char* defines[], size_t defineCount) {
+    const std::string vert = preprocessSource(vertSource, defines, defineCount);
+    const std::string frag = preprocessSource(fragSource, defines, defineCount);
+    const bool useBinaryCache = ProgramBinaryCache::enabled();
+    uint64_t binaryKey = 0;
+    if (useBinaryCache) {
+        binaryKey = ProgramBinaryCache::key(vert, frag);
+        Program program = ProgramBinaryCache::load(binaryKey);
+        if (program) {
+            // Nothing to wait for.
+            shared_ptr<Effect> effect = std::make_shared<Effect>(std::move(program));
+            effect->queryAttributes();
+            effect->queryUniforms();
+            return effect;
+        }
+    }
+    Shader vertShader(GL_VERTEX_SHADER);
+    Shader fragShader(GL_FRAGMENT_SHADER);
+    Program program(glCreateProgram());
+    if (!vertShader || !fragShader || !program) {
+        loge("EFFECT::CREATE_ASYNC");
+        return nullptr;
+    }
+    vertShader.loadSource({vert.c_str()});
+    fragShader.loadSource({frag.c_str()});
+    vertShader.compileAsync();
+    fragShader.compileAsync();
+    if (useBinaryCache) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    program.linkAsync(vertShader, fragShader);
+
+    shared_ptr<Effect> effect = std::make_shared<Effect>(std::move(program));
+    effect->_status = Status::PENDING;
+    effect->_vertShader = std::move(vertShader);
+    effect->_fragShader = std::move(fragShader);
+    effect->_saveBinary = useBinaryCache;
+    effect->_binaryKey = binaryKey;
+    return effect;
+}
+
+bool Effect::ready() {
+    if (_status == Status::PENDING) {
+        if (parallelCompileSupported() && _program.getInt(COMPLETION_STATUS_KHR) == GL_FALSE) {
+            return false;
+        }
+        finishCompile();
+    }
+    return _status == Status::READY;
+}
+
+bool Effect::failed() const {
+    return _status == Status::FAILED;
+}
+
+bool Effect::parallelCompileSupported() {
+    static const bool supported = hasExtension("GL_KHR_parallel_shader_compile") || hasExtension("GL_ARB_parallel_shader_compile");
+    return supported;
+}
+
 void Effect::bind() const noexcept {
+    KEPLER_GL_COUNT(PROGRAM_BINDS);
     glUseProgram(_program);
 }
 
@@ -81,46 +147,57 @@ Uniform* Effect::uniform(const std::string& uniformName) const {
 }
 
 void Effect::setValue(GLint location, float value) const noexcept {
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
     glUniform1f(location, value);
 }
 
 void Effect::setValue(const Uniform* uniform, float value) const noexcept {
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
     glUniform1f(uniform->_location, value);
 }
 
 void Effect::setValue(GLint location, int value) const noexcept {
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
     glUniform1i(location, value);
 }
 
 void Effect::setValue(const Uniform* uniform, int value) const noexcept {
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
     glUniform1i(uniform->_location, value);
 }
 
 void Effect::setValue(const Uniform* uniform, const mat3& value) const noexcept {
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
     glUniformMatrix3fv(uniform->_location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
 void Effect::setValue(GLint location, const mat4& value) const noexcept {
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
     glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
 void Effect::setValue(const Uniform* uniform, const mat4& value) const noexcept {
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
     glUniformMatrix4fv(uniform->_location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
 void Effect::setValue(const Uniform* uniform, const vec2& value) const noexcept {
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
     glUniform2f(uniform->_location, value.x, value.y);
 }
 
 void Effect::setValue(GLint location, const vec3& value) const noexcept {
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
     glUniform3f(location, value.x, value.y, value.z);
 }
 
 void Effect::setValue(const Uniform* uniform, const vec3& value) const noexcept {
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
     glUniform3f(uniform->_location, value.x, value.y, value.z);
 }
 
 void Effect::setValue(const Uniform* uniform, const vec4& value) const noexcept {
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
     glUniform4f(uniform->_location, value.x, value.y, value.z, value.w);
 }
 
@@ -128,19 +205,72 @@ void Effect::setTexture(const Uniform* uniform, const shared_ptr<Texture>& textu
     GLenum textureUnit = GL_TEXTURE0 + uniform->_index;
     glActiveTexture(textureUnit);
     texture->bind(uniform->_index);
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
     glUniform1i(uniform->_location, (GLint)uniform->_index);
 }
 
+void Effect::setTextureBuffer(const Uniform* uniform, TextureHandle texture) const noexcept {
+    glActiveTexture(GL_TEXTURE0 + uniform->_index);
+    KEPLER_GL_COUNT(TEXTURE_BINDS);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
+    glUniform1i(uniform->_location, (GLint)uniform->_index);
+}
+
+void Effect::setTextureHandle(const Uniform* uniform, GLuint64 handle) const noexcept {
+    KEPLER_GL_COUNT(UNIFORM_UPLOADS);
+    bindless::uniformHandle(uniform->_location, handle);
+}
+
 shared_ptr<Effect> Effect::createFromSource(const std::string& vertSource, const std::string& fragSource, const char* defines[], size_t defineCount) {
-    Shader vertShader = loadShaderFromSource(vertSource, GL_VERTEX_SHADER, defines, defineCount);
-    Shader fragShader = loadShaderFromSource(fragSource, GL_FRAGMENT_SHADER, defines, defineCount);
-    Program program = createAndLinkProgram(vertShader, fragShader);
+    const std::string vert = preprocessSource(vertSource, defines, defineCount);
+    const std::string frag = preprocessSource(fragSource, defines, defineCount);
+    const bool useBinaryCache = ProgramBinaryCache::enabled();
+    uint64_t binaryKey = 0;
+    Program program;
+    if (useBinaryCache) {
+        binaryKey = ProgramBinaryCache::key(vert, frag);
+        program = ProgramBinaryCache::load(binaryKey);
+    }
+    if (!program) {
+        Shader vertShader = compileShader(vert, GL_VERTEX_SHADER);
+        Shader fragShader = compileShader(frag, GL_FRAGMENT_SHADER);
+        program = createAndLinkProgram(vertShader, fragShader, useBinaryCache);
+        if (useBinaryCache) {
+            ProgramBinaryCache::save(binaryKey, program);
+        }
+    }
     shared_ptr<Effect> effect = std::make_shared<Effect>(std::move(program));
     effect->queryAttributes();
     effect->queryUniforms();
     return effect;
 }
 
+void Effect::finishCompile() {
+    if (!_vertShader.compiled()) {
+        loge("ERROR::SHADER::COMPILE\n", _vertShader.getInfoLog().c_str());
+        _status = Status::FAILED;
+    }
+    else if (!_fragShader.compiled()) {
+        loge("ERROR::SHADER::COMPILE\n", _fragShader.getInfoLog().c_str());
+        _status = Status::FAILED;
+    }
+    else if (!_program.linked()) {
+        loge("PROGRAM::LINK\n", _program.getInfoLog().c_str());
+        _status = Status::FAILED;
+    }
+    else {
+        queryAttributes();
+        queryUniforms();
+        if (_saveBinary) {
+            ProgramBinaryCache::save(_binaryKey, _program);
+        }
+        _status = Status::READY;
+    }
+    _vertShader.destroy();
+    _fragShader.destroy();
+}
+
 void Effect::saveAttribLocation(const GLchar* attribName, GLint location) {
     _attribLocations[std::string(attribName)] = location;
 }
@@ -166,6 +296,25 @@ void Effect::queryAttributes() {
     }
 }
 
+/// Returns true if the uniform type is a sampler that needs its own texture unit.
+static bool isSampler(GLenum type) {
+    switch (type) {
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_CUBE_SHADOW:
+    case GL_SAMPLER_BUFFER:
+    case GL_INT_SAMPLER_BUFFER:
+    case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+        return true;
+    default:
+        return false;
+    }
+}
+
 void Effect::queryUniforms() {
     // Query and store uniforms from the program.
     const auto activeUniforms = _program.getInt(GL_ACTIVE_UNIFORMS);
@@ -194,7 +343,7 @@ void Effect::queryUniforms() {
             uniformLocation = glGetUniformLocation(_program, uniformName.data());
 
             auto uniform = std::make_unique<Uniform>(uniformName.data(), uniformLocation, uniformType, shared_from_this());
-            if (uniformType == GL_SAMPLER_2D || uniformType == GL_SAMPLER_CUBE) {
+            if (isSampler(uniformType)) {
                 uniform->_index = samplerIndex;
                 samplerIndex += uniformSize;
             }
@@ -218,14 +367,8 @@ shared_ptr<Effect> Uniform::effect() const {
 //////////////
 // functions
 
-Shader loadShaderFromSource(const std::string& source, GLenum shaderType, const char* defines[], size_t defineCount) {
-    Shader shader(shaderType);
-    if (!shader) {
-        throw std::runtime_error("SHADER::CREATE");
-    }
-    std::string version;
-    std::vector<const GLchar*> srcLines;
-    srcLines.reserve(defineCount * 3 + 2);
+std::string preprocessSource(const std::string& source, const char* defines[], size_t defineCount) {
+    std::string result;
     const char* sourceStr = source.c_str();
 
     size_t versionStart = source.find("#version");
@@ -234,25 +377,30 @@ Shader loadShaderFromSource(const std::string& source, GLenum shaderType, const
             size_t versionEnd = source.find('\n', versionStart);
             if (versionEnd != std::string::npos) {
                 // copy the version, including the newline
-                version.assign(sourceStr + versionStart, versionEnd - versionStart + 1);
+                result.assign(sourceStr + versionStart, versionEnd - versionStart + 1);
                 // move the source pointer past the version line
                 sourceStr += versionEnd + 1;
-                srcLines.push_back(version.c_str());
             }
         }
     }
     else {
         // If the source doesn't specify a version then add our own.
         // This is used when loading glTF 1.0 shaders
-        srcLines.push_back(VERSION_STR);
+        result.append(VERSION_STR);
     }
     for (size_t i = 0; i < defineCount; ++i) {
-        srcLines.push_back(DEFINE);
-        srcLines.push_back(defines[i]);
-        srcLines.push_back("\n");
+        result.append(DEFINE).append(defines[i]).push_back('\n');
+    }
+    result.append(sourceStr);
+    return result;
+}
+
+Shader compileShader(const std::string& source, GLenum shaderType) {
+    Shader shader(shaderType);
+    if (!shader) {
+        throw std::runtime_error("SHADER::CREATE");
     }
-    srcLines.push_back(sourceStr);
-    shader.loadSource(srcLines);
+    shader.loadSource({source.c_str()});
     if (!shader.compile()) {
         loge("ERROR::SHADER::COMPILE\n", shader.getInfoLog().c_str());
         throw std::runtime_error("ERROR::SHADER::COMPILE");
@@ -260,11 +408,15 @@ Shader loadShaderFromSource(const std::string& source, GLenum shaderType, const
     return shader;
 }
 
-Program createAndLinkProgram(const Shader& vertShader, const Shader& fragShader) {
+Program createAndLinkProgram(const Shader& vertShader, const Shader& fragShader, bool retrievable) {
     Program program(glCreateProgram());
     if (!program) {
         throw std::runtime_error("PROGRAM::CREATE");
     }
+    if (retrievable) {
+        // Lets the driver know that glGetProgramBinary will be called.
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     if (!program.link(vertShader, fragShader)) {
         loge("PROGRAM::LINK\n", program.getInfoLog().c_str());
         throw std::runtime_error("PROGRAM::CREATE");
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <cstdint>
 
 #include <BaseGL.hpp>
 #include <OpenGL.hpp>
@@ -24,6 +25,22 @@ public:
     static shared_ptr<Effect> createFromFile(const char* vertexShaderPath, const char* fragmentShaderPath, const char* defines[] = nullptr, size_t defineCount = 0);
     static shared_ptr<Effect> createFromSource(const std::string& vertSource, const std::string& fragSource, const char* defines[] = nullptr, size_t defineCount = 0);
 
+    /// Creates an effect that compiles in the background with GL_KHR_parallel_shader_compile.
+    /// The effect is returned before it is ready. Poll ready() before using it; MeshPrimitive skips drawing until then.
+    /// Without the extension the compile finishes the first time ready() is called.
+    /// Returns null if the shaders could not be created. Compile errors are logged and make failed() return true.
+    static shared_ptr<Effect> createFromSourceAsync(const std::string& vertSource, const std::string& fragSource, const char* defines[] = nullptr, size_t defineCount = 0);
+
+    /// Returns true if the program has finished compiling and linking successfully.
+    /// Never blocks if GL_KHR_parallel_shader_compile is supported.
+    bool ready();
+
+    /// Returns true if the program failed to compile or link.
+    bool failed() const;
+
+    /// Returns true if the driver supports GL_KHR_parallel_shader_compile or GL_ARB_parallel_shader_compile.
+    static bool parallelCompileSupported();
+
     void bind() const noexcept;
     void unbind() const noexcept;
 
@@ -51,15 +68,33 @@ public:
     void setValue(const Uniform* uniform, const vec4& value) const noexcept;
 
     void setTexture(const Uniform* uniform, const shared_ptr<Texture>& texture) const noexcept;
+    /// Binds a buffer texture to the texture unit of a samplerBuffer uniform.
+    void setTextureBuffer(const Uniform* uniform, TextureHandle texture) const noexcept;
+
+    /// Sets a bindless_sampler uniform to a GL_ARB_bindless_texture handle. No texture unit is bound.
+    void setTextureHandle(const Uniform* uniform, GLuint64 handle) const noexcept;
 
 private:
 
     void saveAttribLocation(const GLchar* attribName, GLint location);
     void queryAttributes();
     void queryUniforms();
+    void finishCompile();
 
 private:
+    enum class Status {
+        PENDING,
+        READY,
+        FAILED
+    };
+
     Program _program;
+    Status _status = Status::READY;
+    // The shaders are kept until the async compile finishes to get their info logs.
+    Shader _vertShader;
+    Shader _fragShader;
+    bool _saveBinary = false;
+    uint64_t _binaryKey = 0;
     std::map<std::string, GLint> _attribLocations;
     std::map<std::string, std::unique_ptr<Uniform>> _uniforms;
 };
@@ -79,6 +114,11 @@ public:
     const std::string& name() const {
         return _name;
     }
+
+    /// Returns the texture unit of a sampler uniform. Every sampler of an effect has its own unit.
+    unsigned int textureUnit() const {
+        return _index;
+    }
 private:
     std::string _name;
     GLint _location;
@@ -0,0 +1,130 @@
+#include "stdafx.h"
+#include "EffectCache.hpp"
+#include "Effect.hpp"
+#include "FileSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace kepler {
+namespace gl {
+
+namespace {
+
+struct EffectKey {
+    size_t vertHash;
+    size_t fragHash;
+    size_t vertLength;
+    size_t fragLength;
+    std::string defines;
+
+    bool operator<(const EffectKey& rhs) const {
+        return std::tie(vertHash, fragHash, vertLength, fragLength, defines)
+            < std::tie(rhs.vertHash, rhs.fragHash, rhs.vertLength, rhs.fragLength, rhs.defines);
+    }
+};
+
+struct CachedFile {
+    bool exists;
+    std::string source;
+};
+
+std::mutex __mutex;
+std::map<EffectKey, std::weak_ptr<Effect>> __effects;
+std::map<std::string, CachedFile> __files;
+EffectCache::Stats __stats;
+
+/// Returns the shader file from the cache or reads it. Returns null if it can't be read.
+const std::string* readFile(const char* path) {
+    auto it = __files.find(path);
+    if (it == __files.end()) {
+        CachedFile file{false, std::string()};
+        try {
+            readTextFile(path, file.source);
+            file.exists = true;
+        }
+        catch (const std::ios::failure&) {
+        }
+        ++__stats.fileReads;
+        it = __files.emplace(path, std::move(file)).first;
+    }
+    return it->second.exists ? &it->second.source : nullptr;
+}
+
+} // anonymous namespace
+
+shared_ptr<Effect> EffectCache::createFromFile(const char* vertexShaderPath, const char* fragmentShaderPath,
+    const char* defines[], size_t defineCount, bool async) {
+    if (vertexShaderPath == nullptr || fragmentShaderPath == nullptr) {
+        return nullptr;
+    }
+    std::string vertSource;
+    std::string fragSource;
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+        const std::string* vert = readFile(vertexShaderPath);
+        const std::string* frag = readFile(fragmentShaderPath);
+        if (vert == nullptr || frag == nullptr) {
+            return nullptr;
+        }
+        vertSource = *vert;
+        fragSource = *frag;
+    }
+    return createFromSource(vertSource, fragSource, defines, defineCount, async);
+}
+
+shared_ptr<Effect> EffectCache::createFromSource(const std::string& vertSource, const std::string& fragSource,
+    const char* defines[], size_t defineCount, bool async) {
+    std::vector<std::string> sorted;
+    for (size_t i = 0; i < defineCount; ++i) {
+        sorted.emplace_back(defines[i]);
+    }
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    EffectKey key{std::hash<std::string>()(vertSource), std::hash<std::string>()(fragSource),
+        vertSource.size(), fragSource.size(), std::string()};
+    for (const auto& define : sorted) {
+        key.defines.append(define).push_back('\n');
+    }
+
+    std::lock_guard<std::mutex> lock(__mutex);
+    ++__stats.requests;
+    auto& cached = __effects[key];
+    if (auto effect = cached.lock()) {
+        ++__stats.hits;
+        return effect;
+    }
+    std::vector<const char*> sortedDefines;
+    for (const auto& define : sorted) {
+        sortedDefines.push_back(define.c_str());
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    auto effect = async ? Effect::createFromSourceAsync(vertSource, fragSource, sortedDefines.data(), sortedDefines.size())
+        : Effect::createFromSource(vertSource, fragSource, sortedDefines.data(), sortedDefines.size());
+    auto end = std::chrono::high_resolution_clock::now();
+    ++__stats.compiles;
+    __stats.compileMilliseconds += std::chrono::duration<double, std::milli>(end - start).count();
+    cached = effect;
+    return effect;
+}
+
+EffectCache::Stats EffectCache::stats() {
+    std::lock_guard<std::mutex> lock(__mutex);
+    return __stats;
+}
+
+void EffectCache::clear() {
+    std::lock_guard<std::mutex> lock(__mutex);
+    __effects.clear();
+    __files.clear();
+    __stats = Stats();
+}
+
+} // namespace gl
+} // namespace kepler
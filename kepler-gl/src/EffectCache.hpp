@@ -0,0 +1,54 @@
+#pragma once
+
+#include <BaseGL.hpp>
+
+#include <string>
+
+namespace kepler {
+namespace gl {
+
+/// EffectCache shares Effects between everything that uses the same shader sources and defines.
+///
+/// Effects are keyed by a hash of the vertex and fragment source and the sorted list of defines,
+/// so the order of the defines doesn't matter. Shader files are only read once.
+/// The cache only keeps weak references; an Effect is deleted once nothing else uses it.
+/// The cache is shared by the whole process and is thread safe, but Effects must still be created
+/// on the thread that owns the GL context.
+class EffectCache final {
+public:
+    /// Counters since the start of the process or the last clear().
+    struct Stats {
+        /// Number of effects that were requested.
+        size_t requests = 0;
+        /// Number of programs that were compiled and linked.
+        size_t compiles = 0;
+        /// Number of requests that returned an existing effect instead of compiling.
+        size_t hits = 0;
+        /// Number of shader files that were read from disk.
+        size_t fileReads = 0;
+        /// Time spent compiling and linking in milliseconds.
+        double compileMilliseconds = 0.0;
+    };
+
+    EffectCache() = delete;
+
+    /// Returns the effect for the shader files and defines. Compiles it if it isn't in the cache.
+    /// Returns null if a file can't be read or the program fails to compile.
+    /// @param[in] async Compiles with Effect::createFromSourceAsync() so the effect may not be ready yet.
+    static shared_ptr<Effect> createFromFile(const char* vertexShaderPath, const char* fragmentShaderPath,
+        const char* defines[] = nullptr, size_t defineCount = 0, bool async = false);
+
+    /// Returns the effect for the shader sources and defines. Compiles it if it isn't in the cache.
+    static shared_ptr<Effect> createFromSource(const std::string& vertSource, const std::string& fragSource,
+        const char* defines[] = nullptr, size_t defineCount = 0, bool async = false);
+
+    /// Returns the counters.
+    static Stats stats();
+
+    /// Forgets the cached effects and shader files and resets the counters.
+    /// Effects that are still in use are not deleted.
+    static void clear();
+};
+
+} // namespace gl
+} // namespace kepler
@@ -0,0 +1,101 @@
+#include "stdafx.h"
+#include "GLStats.hpp"
+
+#include <fstream>
+
+namespace kepler {
+namespace gl {
+
+bool GLStats::s_enabled = false;
+GLStats::Frame GLStats::s_current;
+
+namespace {
+
+GLStats::Frame __lastFrame;
+uint64_t __frameNumber = 0;
+std::ofstream __csv;
+
+const char* __categoryNames[] = {
+    "draw_calls",
+    "program_binds",
+    "texture_binds",
+    "sampler_binds",
+    "vertex_array_binds",
+    "uniform_uploads",
+    "buffer_updates",
+    "state_changes",
+};
+static_assert(sizeof(__categoryNames) / sizeof(__categoryNames[0]) == GLStats::CATEGORY_COUNT, "a category is missing a name");
+
+} // anonymous namespace
+
+void GLStats::setEnabled(bool enabled) {
+    s_enabled = enabled;
+}
+
+bool GLStats::enabled() {
+    return s_enabled;
+}
+
+void GLStats::beginFrame() {
+    ++__frameNumber;
+    if (!s_enabled) {
+        s_current = Frame();
+        return;
+    }
+    if (s_current.number != 0) {
+        __lastFrame = s_current;
+        if (__csv.is_open()) {
+            __csv << __lastFrame.number;
+            for (size_t count : __lastFrame.counts) {
+                __csv << ',' << count;
+            }
+            __csv << '\n';
+        }
+    }
+    s_current = Frame();
+    s_current.number = __frameNumber;
+}
+
+const GLStats::Frame& GLStats::lastFrame() {
+    return __lastFrame;
+}
+
+const GLStats::Frame& GLStats::currentFrame() {
+    return s_current;
+}
+
+bool GLStats::openCsv(const char* path) {
+    closeCsv();
+    __csv.open(path, std::ios::out | std::ios::trunc);
+    if (!__csv.is_open()) {
+        return false;
+    }
+    __csv << "frame";
+    for (const char* name : __categoryNames) {
+        __csv << ',' << name;
+    }
+    __csv << '\n';
+    return true;
+}
+
+void GLStats::closeCsv() {
+    if (__csv.is_open()) {
+        __csv.close();
+    }
+}
+
+const char* GLStats::categoryName(Category category) {
+    const size_t index = static_cast<size_t>(category);
+    return index < CATEGORY_COUNT ? __categoryNames[index] : "";
+}
+
+void GLStats::print(std::ostream& out) {
+    out << "frame " << __lastFrame.number << std::endl;
+    for (size_t i = 0; i < CATEGORY_COUNT; ++i) {
+        out << "    " << __categoryNames[i] << ": " << __lastFrame.counts[i] << std::endl;
+    }
+}
+
+} // namespace gl
+} // namespace kepler
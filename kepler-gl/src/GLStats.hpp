@@ -0,0 +1,95 @@
+#pragma once
+
+#include <BaseGL.hpp>
+
+#include <array>
+#include <iostream>
+
+// define in order to count GL calls with KEPLER_GL_COUNT. Release builds don't count anything.
+#ifndef NDEBUG
+#define KEPLER_GL_STATS
+#endif
+
+#ifdef KEPLER_GL_STATS
+#define KEPLER_GL_COUNT(category) ::kepler::gl::GLStats::count(::kepler::gl::GLStats::Category::category)
+#else
+#define KEPLER_GL_COUNT(category) ((void)0)
+#endif
+
+namespace kepler {
+namespace gl {
+
+/// GLStats counts the GL calls the engine makes each frame by category.
+///
+/// The call sites use KEPLER_GL_COUNT so counting is compiled out when KEPLER_GL_STATS isn't defined.
+/// When it is compiled in, counting is off until setEnabled(true) and then only costs a branch and an increment.
+/// Only use from the GL thread.
+class GLStats final {
+public:
+    enum class Category {
+        DRAW_CALLS,
+        PROGRAM_BINDS,
+        TEXTURE_BINDS,
+        SAMPLER_BINDS,
+        VERTEX_ARRAY_BINDS,
+        UNIFORM_UPLOADS,
+        BUFFER_UPDATES,
+        STATE_CHANGES,
+        COUNT
+    };
+
+    static constexpr size_t CATEGORY_COUNT = static_cast<size_t>(Category::COUNT);
+
+    struct Frame {
+        /// The number of the frame. Zero if no frame has finished while counting was enabled.
+        uint64_t number = 0;
+        std::array<size_t, CATEGORY_COUNT> counts = {};
+
+        size_t operator[](Category category) const {
+            return counts[static_cast<size_t>(category)];
+        }
+    };
+
+    GLStats() = delete;
+
+    /// Enables or disables counting. Disabled by default.
+    static void setEnabled(bool enabled);
+
+    /// Returns true if counting is enabled.
+    static bool enabled();
+
+    /// Finishes the current frame and starts a new one. Called by the App at the start of every frame.
+    static void beginFrame();
+
+    /// Returns the counts of the last frame that finished.
+    static const Frame& lastFrame();
+
+    /// Returns the counts of the current frame so far.
+    static const Frame& currentFrame();
+
+    /// Writes the counts of every frame that finishes to a CSV file, one row per frame.
+    /// @return False if the file couldn't be opened.
+    static bool openCsv(const char* path);
+
+    /// Stops writing the CSV file.
+    static void closeCsv();
+
+    /// Returns the name of the category. Like "draw_calls".
+    static const char* categoryName(Category category);
+
+    /// Prints the counts of the last frame.
+    static void print(std::ostream& out = std::clog);
+
+    static void count(Category category) noexcept {
+        if (s_enabled) {
+            ++s_current.counts[static_cast<size_t>(category)];
+        }
+    }
+
+private:
+    static bool s_enabled;
+    static Frame s_current;
+};
+
+} // namespace gl
+} // namespace kepler
@@ -20,13 +20,40 @@
 #include "Sampler.hpp"
 #include "Image.hpp"
 #include "FileSystem.hpp"
+#include "MappedFile.hpp"
 #include "StringUtils.hpp"
 #include "Logging.hpp"
+#include "MeshSimplifier.hpp"
+#include "LodSelector.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshoptDecoder.hpp"
+#include "VertexQuantization.hpp"
+#include "ClusteredLighting.hpp"
+#include "EffectCache.hpp"
+#include "ProgramBinaryCache.hpp"
+#include "TextureCache.hpp"
+#include "Texture.hpp"
+#include "TextureArray.hpp"
+#include "BasicMaterial.hpp"
 
 #include <iostream>
 #include <iomanip> // setprecision
 #include <chrono>
 #include <array>
+#include <numeric>
+#include <limits>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <future>
+#include <deque>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
 
 #define RETURN_IF_FOUND(map, key) \
     { \
@@ -39,6 +66,21 @@
 namespace kepler {
 namespace gl {
 
+/// Returns the peak resident memory of the process in bytes.
+static size_t peakResidentMemory() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
 static constexpr GLchar* DEFAULT_VERT_SHADER = "precision highp float;\n"
     "\n"
     "uniform mat4 u_modelViewMatrix;\n"
@@ -62,21 +104,18 @@ static constexpr GLchar* DEFAULT_FRAG_SHADER = "precision highp float;\n"
     "    gl_FragColor = u_emission;\n"
     "}\n";
 
-static constexpr const GLchar* BASIC_VERT_PATH = "../kepler/res/shaders/basic.vert";
-static constexpr const GLchar* BASIC_FRAG_PATH = "../kepler/res/shaders/basic.frag";
-
 using std::string;
 using std::chrono::high_resolution_clock;
 
 using ubyte = uint8_t;
 
-static constexpr const char* HAS_UV = "HAS_UV";
-static constexpr const char* HAS_NORMALS = "HAS_NORMALS";
-static constexpr const char* HAS_TANGENTS = "HAS_TANGENTS";
-static constexpr const char* HAS_BASE_COLOR_MAP = "HAS_BASE_COLOR_MAP";
-
 static constexpr int DEFAULT_FORMAT = GL_RGBA;
 
+// A generated LOD is used once its error is smaller than LOD_PIXEL_ERROR pixels on a LOD_REFERENCE_HEIGHT pixel tall screen.
+static constexpr float LOD_PIXEL_ERROR = 1.0f;
+static constexpr float LOD_REFERENCE_HEIGHT = 1080.0f;
+static constexpr float LOD_MAX_ERROR = 0.05f;
+
 // functions
 static MeshPrimitive::Mode toMode(gltf2::Primitive::Mode mode);
 static MaterialParameter::Semantic toSemantic(const string& semantic);
@@ -85,6 +124,7 @@ static Sampler::Wrap toWrapMode(gltf2::Sampler::Wrap wrap);
 static Sampler::MinFilter toMinFilterMode(gltf2::Sampler::MinFilter filter);
 static Sampler::MagFilter toMagFilterMode(gltf2::Sampler::MagFilter filter);
 static GLint numComponentsOfType(const string& type);
+static size_t componentSize(gltf2::Accessor::ComponentType type);
 static void setState(int state, RenderState& block);
 template<typename T>
 static void printTime(T start, T end, const char* str) {
@@ -96,18 +136,31 @@ static void printTime(T start, T end, const char* str) {
     std::clog << str << std::endl;
 }
 
+// The extensions that the loader can read. Files that require any other extension are rejected.
+static constexpr const char* SUPPORTED_EXTENSIONS[] = {
+    "EXT_meshopt_compression",
+    "KHR_texture_basisu",
+    "MSFT_lod",
+};
+
 using time_type = std::chrono::nanoseconds;
 static time_type __totalTime;
 
+/// Units of GL work that loadSceneFromFileAsync() runs a few at a time.
+using WorkQueue = std::deque<std::function<void()>>;
+
 // Private implementation
 /// @Internal
 class GLTF2Loader::Impl final {
     friend class GLTF2Loader;
+    friend class SceneLoad;
 public:
     Impl();
     ~Impl() noexcept;
 
     bool loadJson(const char* path);
+    /// Returns false and logs the extensions if the file requires extensions that the loader can't read.
+    bool supportsRequiredExtensions() const;
 
     shared_ptr<Scene> loadSceneFromFile(const char* path);
 
@@ -117,24 +170,119 @@ public:
 
     shared_ptr<Node> loadNode(size_t index);
     shared_ptr<Node> loadNode(const gltf2::Node& gNode);
+    /// Creates a node with its transform, mesh and camera but not its children.
+    shared_ptr<Node> createNode(const gltf2::Node& gNode);
 
     shared_ptr<Mesh> loadMesh(size_t index);
     shared_ptr<MeshPrimitive> loadPrimitive(const gltf2::Primitive& gPrim);
+    bool loadOptimizedGeometry(const gltf2::Primitive& gPrim, MeshPrimitive& prim, bool& octNormals);
+    bool quantizeAttribute(AttributeSemantic semantic, GLint components, const std::vector<float>& data, size_t vertexCount,
+        MeshPrimitive& prim, std::vector<ubyte>& vertices, size_t offset, GLint& quantizedComponents, GLenum& type);
+    void printQuantizationStats() const;
+    void printEffectStats(const EffectCache::Stats& before, const ProgramBinaryCache::Stats& binaryBefore) const;
+    void printTextureStats(const TextureCache::Stats& before) const;
+    shared_ptr<Mesh> loadMeshLods(const gltf2::Node& gNode, const shared_ptr<Mesh>& mesh);
+    void generateLods(const gltf2::Mesh& gMesh, Mesh& mesh);
 
     shared_ptr<Camera> loadCamera(size_t index);
 
-    shared_ptr<std::vector<ubyte>> loadBuffer(size_t index);
+    /// Returns the data of a buffer. Empty if it couldn't be loaded.
+    ByteSpan loadBuffer(size_t index);
+    /// Returns the part of a buffer that a buffer view refers to. Empty if it couldn't be loaded or is out of bounds.
+    /// Views that use EXT_meshopt_compression return their decoded data.
+    ByteSpan bufferViewData(size_t index);
+    /// Decodes the views that use EXT_meshopt_compression on worker threads.
+    /// The views are decoded straight into the memory that their GL buffers are uploaded from.
+    void decodeBufferViews(const std::set<size_t>& views);
 
     shared_ptr<VertexBuffer> loadVertexBuffer(size_t index);
     shared_ptr<IndexBuffer> loadIndexBuffer(size_t index);
     shared_ptr<IndexAccessor> loadIndexAccessor(size_t index);
     shared_ptr<VertexAttributeAccessor> loadVertexAttributeAccessor(size_t index);
 
-    shared_ptr<Material> loadMaterial(size_t index, MeshPrimitive& primitive);
+    const ubyte* accessorData(const gltf2::Accessor& gAccessor, size_t elementSize, size_t& byteStride);
+    bool loadIndices(size_t index, std::vector<uint32_t>& indices);
+
+    shared_ptr<Material> loadMaterial(size_t index, MeshPrimitive& primitive, bool octNormals = false);
+    /// Returns the material without its base color texture for primitives that are drawn before the texture is
+    /// uploaded. Returns the real material if it doesn't have a texture.
+    shared_ptr<Material> loadPlaceholderMaterial(size_t index, MeshPrimitive& primitive, bool octNormals);
+    /// Replaces the placeholder materials of the mesh and its LODs with the real materials.
+    void resolveMaterials(Mesh& mesh);
 
     shared_ptr<Texture> loadTexture(size_t index);
+    /// Returns the texture array that holds the image of the texture and sets the layer.
+    /// Returns null if the image wasn't packed by packTextureArrays().
+    shared_ptr<Texture> loadTextureLayer(size_t index, int& layer);
+    shared_ptr<Sampler> loadTextureSampler(const gltf2::Texture& gTexture);
     shared_ptr<Sampler> loadSampler(size_t index);
-    shared_ptr<Image> loadImage(size_t index);
+    shared_ptr<Texture> loadImage(size_t index);
+    /// Gets the file path or the encoded memory of an image. Base64 images are decoded and kept in _base64Images.
+    bool imageSource(size_t index, TextureCache::ImageSource& source);
+    /// Adds the textures used by the materials of the node and its descendants.
+    void collectTextures(size_t nodeIndex, std::set<size_t>& textures) const;
+    /// Adds the images used by the materials of the scene.
+    void collectImages(size_t sceneIndex, std::set<size_t>& images) const;
+    /// Decodes the images used by the scene on worker threads.
+    void decodeImages(size_t sceneIndex);
+
+    /// The resources that a scene needs.
+    struct ScenePlan {
+        std::set<size_t> buffers;
+        std::set<size_t> vertexViews;
+        std::set<size_t> indexViews;
+        /// The views that use EXT_meshopt_compression.
+        std::set<size_t> compressedViews;
+        std::set<size_t> textures;
+    };
+    /// Loads a scene in stages: plan, read and decode on worker threads, create the GL objects, assemble the nodes.
+    shared_ptr<Scene> loadSceneStaged(size_t sceneIndex);
+    /// Finds the buffers, buffer views and textures the scene needs.
+    void planScene(size_t sceneIndex, ScenePlan& plan) const;
+    /// Adds the buffers and buffer views used by the meshes of the node and its descendants.
+    void planNode(size_t nodeIndex, ScenePlan& plan) const;
+    void planAccessor(size_t accessorIndex, ScenePlan& plan, std::set<size_t>& views) const;
+    /// Reads the buffers on worker threads. Mapped buffers only have their pages loaded.
+    void readBuffers(const std::set<size_t>& buffers);
+    /// Creates the vertex buffers, index buffers and textures of the plan.
+    void createResources(size_t sceneIndex, const ScenePlan& plan);
+    void queueBuffers(const ScenePlan& plan, WorkQueue& work);
+    void queueTextures(size_t sceneIndex, const ScenePlan& plan, WorkQueue& work);
+
+    /// The state of a load started by loadSceneFromFileAsync().
+    struct AsyncLoad {
+        string path;
+        /// Parses the json, plans the scene, reads the buffers and decodes the images.
+        std::future<bool> background;
+        /// The number of background steps that are done.
+        std::atomic<int> backgroundSteps{0};
+        bool backgroundDone = false;
+        bool failed = false;
+        bool done = false;
+        size_t sceneIndex = 0;
+        ScenePlan plan;
+        shared_ptr<Scene> scene;
+        WorkQueue work;
+        size_t workCount = 0;
+        size_t frames = 0;
+        high_resolution_clock::time_point start;
+        EffectCache::Stats effectStats;
+        ProgramBinaryCache::Stats binaryStats;
+        TextureCache::Stats textureStats;
+    };
+    static constexpr int BACKGROUND_STEPS = 5;
+    void startAsync(const char* path);
+    /// Runs on the background thread.
+    bool readAsync();
+    /// Queues the GL work of the scene once the background thread is done.
+    void queueScene(AsyncLoad& load);
+    /// Queues the creation of the node and its descendants, parents first.
+    /// @param[in] parent The index of the parent node or max size_t for the root nodes of the scene.
+    /// @param[out] queued The indices of the nodes that were queued.
+    void queueNode(size_t index, size_t parent, AsyncLoad& load, std::vector<size_t>& queued);
+    bool updateAsync(double budgetMilliseconds);
+    /// Copies the base color images of the scene that have the same size into the layers of texture arrays.
+    void packTextureArrays(size_t sceneIndex);
 
     shared_ptr<Material> loadDefaultMaterial();
     shared_ptr<Technique> loadDefaultTechnique();
@@ -144,6 +292,8 @@ public:
 
     void useDefaultMaterial(bool value);
     void setAutoLoadMaterials(bool value);
+    /// Copies the settings of another loader but none of its loaded data.
+    void copySettings(const Impl& other);
 
 private:
     void loadTransform(const gltf2::Node& gNode, const shared_ptr<Node>& node);
@@ -151,7 +301,17 @@ private:
 private:
     gltf2::Gltf _gltf;
 
-    std::map <size_t, std::shared_ptr<std::vector<ubyte>>> _buffers;
+    /// The data of a buffer. A view of a mapped file or a copy read into memory.
+    struct BufferData {
+        shared_ptr<MappedFile> file;
+        std::vector<ubyte> bytes;
+        ByteSpan span;
+    };
+    std::map<size_t, BufferData> _buffers;
+    // The decoded data of buffer views that use EXT_meshopt_compression.
+    std::map<size_t, std::vector<ubyte>> _decodedViews;
+    // Each file is only mapped once even if several buffers are stored in it.
+    std::map<string, shared_ptr<MappedFile>> _mappedFiles;
 
     std::map<size_t, shared_ptr<Node>> _nodes;
     std::map<size_t, shared_ptr<VertexBuffer>> _vbos;
@@ -160,11 +320,20 @@ private:
     std::map<size_t, shared_ptr<VertexAttributeAccessor>> _vertexAttributeAccessors;
 
     std::map<size_t, shared_ptr<Material>> _materials;
+    // Materials of primitives with octahedral encoded normals need a different shader.
+    std::map<size_t, shared_ptr<Material>> _octNormalMaterials;
     std::map<size_t, shared_ptr<Technique>> _techniques;
     std::map<size_t, shared_ptr<Effect>> _effects;
     std::map<size_t, shared_ptr<Texture>> _textures;
     std::map<size_t, shared_ptr<Sampler>> _samplers;
-    std::map<size_t, shared_ptr<Image>> _images;
+    // Textures from the TextureCache. loadTexture() shares them so each glTF texture can have its own sampler.
+    std::map<size_t, shared_ptr<Texture>> _images;
+    std::map<size_t, std::vector<unsigned char>> _base64Images;
+    // Images from decodeImages(). Held until their textures are created since the TextureCache only has weak references.
+    std::vector<shared_ptr<Image>> _decodedImages;
+    // The texture array and layer of images packed by packTextureArrays().
+    std::map<size_t, std::pair<shared_ptr<Texture>, int>> _imageLayers;
+    std::map<size_t, shared_ptr<Texture>> _layerTextures;
 
     shared_ptr<Material> _defaultMaterial;
     shared_ptr<Technique> _defaultTechnique;
@@ -176,6 +345,35 @@ private:
     bool _useDefaultMaterial;
     bool _autoLoadMaterials;
     float _aspectRatio;
+    size_t _lodLevels = 0;
+    bool _optimizeMeshes = false;
+    // The vertex remap of optimized primitives that is needed to generate their LODs.
+    std::map<const MeshPrimitive*, std::vector<uint32_t>> _vertexRemaps;
+    // The index of each primitive in its glTF mesh for generateLods(). Invalid glTF primitives are skipped when
+    // loading so it can differ from the index of the primitive in the Mesh.
+    std::map<const MeshPrimitive*, size_t> _primitiveIndices;
+    bool _quantizeVertices = false;
+    shared_ptr<ClusteredLighting> _clusteredLighting;
+    bool _asyncShaders = false;
+    bool _parallelImageDecode = true;
+    bool _textureArrays = false;
+    bool _bindlessTextures = false;
+    bool _memoryMapping = true;
+    bool _stagedLoading = true;
+    bool _progressiveLoading = false;
+    // Set while a progressive load creates its nodes so primitives get placeholder materials.
+    bool _deferTextures = false;
+    std::map<std::pair<size_t, bool>, shared_ptr<Material>> _placeholderMaterials;
+    // The material index and octahedral normals flag of each placeholder.
+    std::map<const Material*, std::pair<size_t, bool>> _placeholders;
+    std::unique_ptr<AsyncLoad> _async;
+    struct QuantizationStats {
+        size_t bytesBefore = 0;
+        size_t bytesAfter = 0;
+        float positionError = 0.0f;
+        float normalError = 0.0f;
+        float texCoordError = 0.0f;
+    } _quantizationStats;
 
     time_type _jsonLoadTime = {};
 };
@@ -204,6 +402,14 @@ shared_ptr<Scene> GLTF2Loader::loadSceneFromFile(const char* path) {
     return _impl->loadSceneFromFile(path);
 }
 
+shared_ptr<SceneLoad> GLTF2Loader::loadSceneFromFileAsync(const char* path) {
+    // The background thread only ever touches the state of the load, never the state of this loader.
+    auto impl = std::make_shared<Impl>();
+    impl->copySettings(*_impl);
+    impl->startAsync(path);
+    return std::make_shared<SceneLoad>(impl);
+}
+
 shared_ptr<Mesh> GLTF2Loader::findMeshByIndex(size_t index) {
     return _impl->loadMesh(index);
 }
@@ -225,17 +431,117 @@ void GLTF2Loader::setCameraAspectRatio(float aspectRatio) {
     _impl->_aspectRatio = aspectRatio;
 }
 
+void GLTF2Loader::setGenerateLods(size_t levels) {
+    _impl->_lodLevels = levels;
+}
+
+void GLTF2Loader::setOptimizeMeshes(bool value) {
+    _impl->_optimizeMeshes = value;
+}
+
+void GLTF2Loader::setQuantizeVertices(bool value) {
+    _impl->_quantizeVertices = value;
+}
+
+void GLTF2Loader::setClusteredLighting(const shared_ptr<ClusteredLighting>& lighting) {
+    _impl->_clusteredLighting = lighting;
+}
+
+void GLTF2Loader::setAsyncShaderCompile(bool value) {
+    _impl->_asyncShaders = value;
+}
+
+void GLTF2Loader::setParallelImageDecode(bool value) {
+    _impl->_parallelImageDecode = value;
+}
+
+void GLTF2Loader::setTextureArrays(bool value) {
+    _impl->_textureArrays = value;
+}
+
+void GLTF2Loader::setBindlessTextures(bool value) {
+    _impl->_bindlessTextures = value;
+}
+
+void GLTF2Loader::setMemoryMapping(bool value) {
+    _impl->_memoryMapping = value;
+}
+
+void GLTF2Loader::setStagedLoading(bool value) {
+    _impl->_stagedLoading = value;
+}
+
+void GLTF2Loader::setProgressiveLoading(bool value) {
+    _impl->_progressiveLoading = value;
+}
+
 void GLTF2Loader::printTotalTime() {
     std::clog << "Total: " << std::chrono::duration_cast<std::chrono::milliseconds>(__totalTime).count() << " ms" << std::endl;
 }
 
 ////////////////////////////////////////////////////////////////
 
+SceneLoad::SceneLoad(const shared_ptr<GLTF2Loader::Impl>& loader) : _loader(loader) {
+}
+
+SceneLoad::~SceneLoad() noexcept {
+}
+
+bool SceneLoad::update(double budgetMilliseconds) {
+    return _loader->updateAsync(budgetMilliseconds);
+}
+
+shared_ptr<Scene> SceneLoad::finish() {
+    if (_loader->_async && _loader->_async->background.valid()) {
+        _loader->_async->background.wait();
+    }
+    while (!_loader->updateAsync(std::numeric_limits<double>::max())) {
+    }
+    return scene();
+}
+
+shared_ptr<Scene> SceneLoad::scene() const {
+    const auto& load = _loader->_async;
+    if (load && !load->failed && (load->done || _loader->_progressiveLoading)) {
+        return load->scene;
+    }
+    return nullptr;
+}
+
+float SceneLoad::progress() const {
+    const auto& load = _loader->_async;
+    if (!load || load->done || load->failed) {
+        return 1.0f;
+    }
+    // The background work and the GL work count as half each.
+    const float background = static_cast<float>(load->backgroundSteps) / GLTF2Loader::Impl::BACKGROUND_STEPS;
+    if (!load->backgroundDone || load->workCount == 0) {
+        return 0.5f * background;
+    }
+    return 0.5f + 0.5f * static_cast<float>(load->workCount - load->work.size()) / static_cast<float>(load->workCount);
+}
+
+bool SceneLoad::done() const {
+    const auto& load = _loader->_async;
+    return !load || load->done || load->failed;
+}
+
+bool SceneLoad::failed() const {
+    const auto& load = _loader->_async;
+    return !load || load->failed;
+}
+
+////////////////////////////////////////////////////////////////
+
 GLTF2Loader::Impl::Impl()
     : _loaded(false), _useDefaultMaterial(false), _autoLoadMaterials(true), _aspectRatio(0.0f) {
 }
 
 GLTF2Loader::Impl::~Impl() noexcept {
+    // The background thread uses the loader.
+    if (_async && _async->background.valid()) {
+        _async->background.wait();
+    }
 }
 
 bool GLTF2Loader::Impl::loadJson(const char* path) {
@@ -243,7 +549,7 @@ bool GLTF2Loader::Impl::loadJson(const char* path) {
 
     auto start = high_resolution_clock::now();
 
-    _loaded = _gltf.load(path);
+    _loaded = _gltf.load(path, gltf2::Gltf::ParseMode::IN_SITU) && supportsRequiredExtensions();
 
     auto end = high_resolution_clock::now();
     _jsonLoadTime = std::chrono::duration_cast<time_type>(end - start);
@@ -251,9 +557,40 @@ bool GLTF2Loader::Impl::loadJson(const char* path) {
     return _loaded;
 }
 
+bool GLTF2Loader::Impl::supportsRequiredExtensions() const {
+    const auto isSupported = [](const char* name) {
+        for (const char* supported : SUPPORTED_EXTENSIONS) {
+            if (strcmp(name, supported) == 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+    bool supported = true;
+    for (const char* name : _gltf.extensionsRequired()) {
+        if (!isSupported(name)) {
+            // Draco meshes have no uncompressed data when the extension is required so they can't be drawn at all.
+            loge("GLTF2_LOADER::UNSUPPORTED_REQUIRED_EXTENSION ", name);
+            supported = false;
+        }
+    }
+    if (supported) {
+        for (const char* name : _gltf.extensionsUsed()) {
+            if (strcmp(name, "KHR_draco_mesh_compression") == 0) {
+                std::clog << "    KHR_draco_mesh_compression is not supported, using the uncompressed fallback" << std::endl;
+            }
+        }
+    }
+    return supported;
+}
+
 shared_ptr<Scene> GLTF2Loader::Impl::loadSceneFromFile(const char* path) {
     // TODO call clear() first?
     auto start = high_resolution_clock::now();
+    _quantizationStats = QuantizationStats();
+    const auto effectStats = EffectCache::stats();
+    const auto binaryStats = ProgramBinaryCache::stats();
+    const auto textureStats = TextureCache::stats();
 
     if (!loadJson(path)) {
         loge("LOAD_SCENE_FROM_FILE ", path);
@@ -275,13 +612,80 @@ shared_ptr<Scene> GLTF2Loader::Impl::loadSceneFromFile(const char* path) {
     std::clog.width(2);
     std::clog << std::fixed;
     std::clog << std::setprecision(0);
-    std::clog << percent << "% json) ";
+    std::clog << percent << "% json, ";
+    std::clog << std::chrono::duration_cast<std::chrono::milliseconds>(_jsonLoadTime).count() << " ms parse, ";
+    std::clog << (peakResidentMemory() >> 20) << " MB peak) ";
     std::clog << path << std::endl;
     std::clog.unsetf(std::ios_base::floatfield);
     std::clog.width(clogWidth);
+    printEffectStats(effectStats, binaryStats);
+    printTextureStats(textureStats);
+    if (_quantizeVertices) {
+        printQuantizationStats();
+    }
     return scene;
 }
 
+void GLTF2Loader::Impl::printEffectStats(const EffectCache::Stats& before, const ProgramBinaryCache::Stats& binaryBefore) const {
+    const auto after = EffectCache::stats();
+    const auto binaryAfter = ProgramBinaryCache::stats();
+    const size_t requests = after.requests - before.requests;
+    if (requests == 0) {
+        return;
+    }
+    // The compile time includes programs loaded from binaries so it shows the difference between cold and warm starts.
+    std::clog << std::fixed << std::setprecision(1)
+        << "    effects " << requests
+        << "  compiled " << after.compiles - before.compiles
+        << "  reused " << after.hits - before.hits
+        << "  compile " << after.compileMilliseconds - before.compileMilliseconds << " ms";
+    const size_t binaryHits = binaryAfter.hits - binaryBefore.hits;
+    const size_t binarySaves = binaryAfter.saves - binaryBefore.saves;
+    const size_t binaryRejected = binaryAfter.rejected - binaryBefore.rejected;
+    if (binaryHits + binarySaves + binaryRejected > 0) {
+        std::clog << "  binaries loaded " << binaryHits
+            << " (" << binaryAfter.loadMilliseconds - binaryBefore.loadMilliseconds << " ms)"
+            << "  saved " << binarySaves
+            << "  rejected " << binaryRejected;
+    }
+    std::clog << std::endl;
+    std::clog.unsetf(std::ios_base::floatfield);
+}
+
+void GLTF2Loader::Impl::printTextureStats(const TextureCache::Stats& before) const {
+    const auto after = TextureCache::stats();
+    const size_t requests = after.textureRequests - before.textureRequests;
+    if (requests == 0) {
+        return;
+    }
+    const auto memory = TextureCache::memory();
+    std::clog << std::fixed << std::setprecision(1)
+        << "    textures " << requests
+        << "  uploaded " << after.uploads - before.uploads
+        << "  reused " << after.textureHits - before.textureHits
+        << "  decoded " << after.decodes - before.decodes
+        << "  compressed " << after.compressedUploads - before.compressedUploads
+        << "  total " << memory.textures << " textures " << memory.textureBytes / (1024.0 * 1024.0) << " MB"
+        << std::endl;
+    std::clog.unsetf(std::ios_base::floatfield);
+}
+
+void GLTF2Loader::Impl::printQuantizationStats() const {
+    const auto& stats = _quantizationStats;
+    if (stats.bytesBefore == 0) {
+        return;
+    }
+    double percent = (1.0 - (double)stats.bytesAfter / (double)stats.bytesBefore) * 100.0;
+    std::clog << std::fixed << std::setprecision(0)
+        << "    vertex data " << stats.bytesBefore / 1024 << " KB -> " << stats.bytesAfter / 1024 << " KB ("
+        << percent << "% smaller)";
+    std::clog << std::scientific << std::setprecision(2)
+        << "  max error: position " << stats.positionError
+        << "  normal " << glm::degrees(stats.normalError) << " deg"
+        << "  uv " << stats.texCoordError << std::endl;
+    std::clog.unsetf(std::ios_base::floatfield);
+}
+
 shared_ptr<Scene> GLTF2Loader::Impl::loadDefaultScene() {
     size_t index;
     if (_gltf.defaultScene(index)) {
@@ -295,17 +699,406 @@ shared_ptr<Scene> GLTF2Loader::Impl::loadDefaultScene() {
 }
 
 shared_ptr<Scene> GLTF2Loader::Impl::loadScene(size_t index) {
+    if (_stagedLoading) {
+        return loadSceneStaged(index);
+    }
     if (auto gScene = _gltf.scene(index)) {
+        // Decode every image of the scene on worker threads first so loadImage() only has to upload.
+        decodeImages(index);
+        packTextureArrays(index);
         auto scene = Scene::create();
         for (const auto& index : gScene.nodes()) {
             scene->addNode(loadNode(index));
         }
+        // The textures hold the GL copies now.
+        _decodedImages.clear();
+        _base64Images.clear();
         // TODO active camera?
         return scene;
     }
     return nullptr;
 }
 
+shared_ptr<Scene> GLTF2Loader::Impl::loadSceneStaged(size_t sceneIndex) {
+    auto gScene = _gltf.scene(sceneIndex);
+    if (!gScene) {
+        return nullptr;
+    }
+    using std::chrono::milliseconds;
+    auto t0 = high_resolution_clock::now();
+
+    // 1. Find everything the scene needs without loading anything.
+    ScenePlan plan;
+    planScene(sceneIndex, plan);
+    auto t1 = high_resolution_clock::now();
+
+    // 2. Disk reads, base64, mesh and image decoding on worker threads.
+    readBuffers(plan.buffers);
+    decodeBufferViews(plan.compressedViews);
+    auto t2 = high_resolution_clock::now();
+    decodeImages(sceneIndex);
+    auto t3 = high_resolution_clock::now();
+
+    // 3. The GL objects are created together so the GL thread isn't waiting on I/O in between.
+    createResources(sceneIndex, plan);
+    auto t4 = high_resolution_clock::now();
+
+    // 4. Everything is cached now so this only builds the nodes, meshes and materials.
+    auto scene = Scene::create();
+    for (const auto& index : gScene.nodes()) {
+        scene->addNode(loadNode(index));
+    }
+    _decodedImages.clear();
+    _base64Images.clear();
+    auto t5 = high_resolution_clock::now();
+
+    std::clog << "    stages: plan " << std::chrono::duration_cast<milliseconds>(t1 - t0).count() << " ms"
+        << "  read " << plan.buffers.size() << " buffers " << std::chrono::duration_cast<milliseconds>(t2 - t1).count() << " ms"
+        << "  decode " << std::chrono::duration_cast<milliseconds>(t3 - t2).count() << " ms"
+        << "  gpu " << plan.vertexViews.size() + plan.indexViews.size() << " buffers " << plan.textures.size()
+        << " textures " << std::chrono::duration_cast<milliseconds>(t4 - t3).count() << " ms"
+        << "  assemble " << std::chrono::duration_cast<milliseconds>(t5 - t4).count() << " ms" << std::endl;
+    return scene;
+}
+
+void GLTF2Loader::Impl::planScene(size_t sceneIndex, ScenePlan& plan) const {
+    auto gScene = _gltf.scene(sceneIndex);
+    if (!gScene) {
+        return;
+    }
+    for (size_t node : gScene.nodes()) {
+        planNode(node, plan);
+    }
+    const bool materials = _autoLoadMaterials && !_useDefaultMaterial;
+    if (materials) {
+        for (size_t node : gScene.nodes()) {
+            collectTextures(node, plan.textures);
+        }
+        // Images stored in buffer views need their buffer before they can be decoded.
+        std::set<size_t> images;
+        collectImages(sceneIndex, images);
+        for (size_t imageIndex : images) {
+            size_t viewIndex;
+            size_t bufferIndex;
+            auto gImage = _gltf.image(imageIndex);
+            if (gImage && gImage.bufferView(viewIndex) && _gltf.bufferView(viewIndex).buffer(bufferIndex)) {
+                plan.buffers.insert(bufferIndex);
+            }
+        }
+    }
+}
+
+void GLTF2Loader::Impl::planNode(size_t nodeIndex, ScenePlan& plan) const {
+    auto gNode = _gltf.node(nodeIndex);
+    if (!gNode) {
+        return;
+    }
+    size_t meshIndex;
+    if (gNode.mesh(meshIndex)) {
+        if (auto gMesh = _gltf.mesh(meshIndex)) {
+            for (const auto& gPrim : gMesh.primitives()) {
+                for (const auto& attrib : gPrim.attributes()) {
+                    planAccessor(attrib.second, plan, plan.vertexViews);
+                }
+                size_t indicesIndex;
+                if (gPrim.indices(indicesIndex)) {
+                    planAccessor(indicesIndex, plan, plan.indexViews);
+                }
+            }
+        }
+    }
+    for (size_t lod : gNode.lods()) {
+        planNode(lod, plan);
+    }
+    for (size_t child : gNode.children()) {
+        planNode(child, plan);
+    }
+}
+
+void GLTF2Loader::Impl::planAccessor(size_t accessorIndex, ScenePlan& plan, std::set<size_t>& views) const {
+    auto gAccessor = _gltf.accessor(accessorIndex);
+    size_t viewIndex;
+    if (!gAccessor || !gAccessor.bufferView(viewIndex)) {
+        return;
+    }
+    auto gBufferView = _gltf.bufferView(viewIndex);
+    size_t bufferIndex;
+    // Compressed views only need the buffer of the compressed data. Their own buffer may be an empty fallback.
+    if (auto meshopt = gBufferView.meshoptCompression()) {
+        if (meshopt.buffer(bufferIndex)) {
+            views.insert(viewIndex);
+            plan.compressedViews.insert(viewIndex);
+            plan.buffers.insert(bufferIndex);
+        }
+    }
+    else if (gBufferView.buffer(bufferIndex)) {
+        views.insert(viewIndex);
+        plan.buffers.insert(bufferIndex);
+    }
+}
+
+void GLTF2Loader::Impl::readBuffers(const std::set<size_t>& buffers) {
+    struct Job {
+        size_t index;
+        gltf2::Buffer gBuffer;
+        BufferData data;
+        bool loaded;
+    };
+    std::vector<Job> jobs;
+    // Mapped buffers are split into chunks so the pages of one large GLB are loaded by several threads.
+    static constexpr size_t CHUNK_SIZE = 4 * 1024 * 1024;
+    std::vector<ByteSpan> chunks;
+    for (size_t index : buffers) {
+        if (_buffers.find(index) != _buffers.end()) {
+            continue;
+        }
+        auto gBuffer = _gltf.buffer(index);
+        if (!gBuffer) {
+            continue;
+        }
+        string path;
+        size_t offset;
+        if (_memoryMapping && gBuffer.fileLocation(path, offset)) {
+            // Mapping is cheap so it's done here; _buffers and _mappedFiles are only used by this thread.
+            const ByteSpan span = loadBuffer(index);
+            for (size_t i = 0; i < span.size; i += CHUNK_SIZE) {
+                chunks.push_back(span.subspan(i, std::min(CHUNK_SIZE, span.size - i)));
+            }
+            continue;
+        }
+        jobs.push_back(Job{index, gBuffer, BufferData(), false});
+    }
+    const size_t total = jobs.size() + chunks.size();
+    if (total == 0) {
+        return;
+    }
+    std::atomic<size_t> next(0);
+    std::atomic<unsigned> checksum(0);
+    auto work = [&jobs, &chunks, &next, &checksum, total]() {
+        static constexpr size_t PAGE_SIZE = 4096;
+        for (size_t i = next++; i < total; i = next++) {
+            if (i < jobs.size()) {
+                Job& job = jobs[i];
+                job.loaded = job.gBuffer.load(job.data.bytes);
+                continue;
+            }
+            // Reading a byte of every page makes the OS load the file now instead of during the GL upload.
+            const ByteSpan& chunk = chunks[i - jobs.size()];
+            unsigned sum = 0;
+            for (size_t offset = 0; offset < chunk.size; offset += PAGE_SIZE) {
+                sum += chunk.data[offset];
+            }
+            checksum += sum;
+        }
+    };
+    const size_t threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), total));
+    std::vector<std::future<void>> workers;
+    for (size_t i = 1; i < threads; ++i) {
+        workers.push_back(std::async(std::launch::async, work));
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.get();
+    }
+    for (auto& job : jobs) {
+        if (job.loaded) {
+            BufferData& buffer = _buffers[job.index];
+            buffer = std::move(job.data);
+            buffer.span = ByteSpan(buffer.bytes.data(), buffer.bytes.size());
+        }
+    }
+}
+
+void GLTF2Loader::Impl::createResources(size_t sceneIndex, const ScenePlan& plan) {
+    WorkQueue work;
+    queueBuffers(plan, work);
+    queueTextures(sceneIndex, plan, work);
+    for (auto& function : work) {
+        function();
+    }
+}
+
+void GLTF2Loader::Impl::queueBuffers(const ScenePlan& plan, WorkQueue& work) {
+    // Optimized and quantized primitives build their own buffers from the accessor data.
+    if (!_optimizeMeshes && !_quantizeVertices) {
+        for (size_t view : plan.vertexViews) {
+            work.push_back([this, view]() { loadVertexBuffer(view); });
+        }
+        for (size_t view : plan.indexViews) {
+            work.push_back([this, view]() { loadIndexBuffer(view); });
+        }
+    }
+}
+
+void GLTF2Loader::Impl::queueTextures(size_t sceneIndex, const ScenePlan& plan, WorkQueue& work) {
+    work.push_back([this, sceneIndex]() { packTextureArrays(sceneIndex); });
+    for (size_t textureIndex : plan.textures) {
+        work.push_back([this, textureIndex]() {
+            int layer;
+            if (!loadTextureLayer(textureIndex, layer)) {
+                loadTexture(textureIndex);
+            }
+        });
+    }
+}
+
+void GLTF2Loader::Impl::startAsync(const char* path) {
+    if (_async && _async->background.valid()) {
+        _async->background.wait();
+    }
+    _async = std::make_unique<AsyncLoad>();
+    AsyncLoad& load = *_async;
+    load.path = path != nullptr ? path : "";
+    load.start = high_resolution_clock::now();
+    load.effectStats = EffectCache::stats();
+    load.binaryStats = ProgramBinaryCache::stats();
+    load.textureStats = TextureCache::stats();
+    _quantizationStats = QuantizationStats();
+    load.background = std::async(std::launch::async, [this]() { return readAsync(); });
+}
+
+bool GLTF2Loader::Impl::readAsync() {
+    // Nothing here touches GL. The GL thread doesn't use the loader until this returns.
+    AsyncLoad& load = *_async;
+    if (load.path.empty() || !loadJson(load.path.c_str())) {
+        return false;
+    }
+    ++load.backgroundSteps;
+    size_t sceneIndex;
+    if (!_gltf.defaultScene(sceneIndex)) {
+        if (_gltf.sceneCount() == 0) {
+            return false;
+        }
+        sceneIndex = 0;
+    }
+    load.sceneIndex = sceneIndex;
+    planScene(sceneIndex, load.plan);
+    ++load.backgroundSteps;
+    readBuffers(load.plan.buffers);
+    ++load.backgroundSteps;
+    decodeBufferViews(load.plan.compressedViews);
+    ++load.backgroundSteps;
+    decodeImages(sceneIndex);
+    ++load.backgroundSteps;
+    return true;
+}
+
+void GLTF2Loader::Impl::queueScene(AsyncLoad& load) {
+    auto gScene = _gltf.scene(load.sceneIndex);
+    load.scene = Scene::create();
+    const auto roots = gScene.nodes();
+    std::vector<size_t> nodes;
+    if (_progressiveLoading) {
+        // Nodes are drawn as soon as their buffers exist. Their textures come after all of the nodes.
+        _deferTextures = !load.plan.textures.empty();
+        queueBuffers(load.plan, load.work);
+        for (size_t index : roots) {
+            queueNode(index, std::numeric_limits<size_t>::max(), load, nodes);
+        }
+        if (_deferTextures) {
+            load.work.push_back([this]() { _deferTextures = false; });
+            queueTextures(load.sceneIndex, load.plan, load.work);
+            // Each mesh gets its real materials once every texture exists.
+            for (size_t index : nodes) {
+                size_t meshIndex;
+                if (!_gltf.node(index).mesh(meshIndex)) {
+                    continue;
+                }
+                load.work.push_back([this, index]() {
+                    auto it = _nodes.find(index);
+                    if (it != _nodes.end()) {
+                        if (auto renderer = it->second->component<MeshRenderer>()) {
+                            resolveMaterials(*renderer->mesh());
+                        }
+                    }
+                });
+            }
+        }
+    }
+    else {
+        queueBuffers(load.plan, load.work);
+        queueTextures(load.sceneIndex, load.plan, load.work);
+        for (size_t index : roots) {
+            queueNode(index, std::numeric_limits<size_t>::max(), load, nodes);
+        }
+    }
+    load.workCount = load.work.size();
+}
+
+void GLTF2Loader::Impl::queueNode(size_t index, size_t parent, AsyncLoad& load, std::vector<size_t>& queued) {
+    auto gNode = _gltf.node(index);
+    if (!gNode) {
+        return;
+    }
+    queued.push_back(index);
+    load.work.push_back([this, index, parent, &load]() {
+        auto node = _nodes.find(index) != _nodes.end() ? _nodes[index] : createNode(_gltf.node(index));
+        _nodes[index] = node;
+        if (parent == std::numeric_limits<size_t>::max()) {
+            load.scene->addNode(node);
+        }
+        else if (auto parentNode = _nodes[parent]) {
+            parentNode->addNode(node);
+        }
+    });
+    for (size_t child : gNode.children()) {
+        queueNode(child, index, load, queued);
+    }
+}
+
+bool GLTF2Loader::Impl::updateAsync(double budgetMilliseconds) {
+    if (!_async) {
+        return true;
+    }
+    AsyncLoad& load = *_async;
+    if (load.done || load.failed) {
+        return true;
+    }
+    if (!load.backgroundDone) {
+        if (load.background.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+        load.backgroundDone = true;
+        if (!load.background.get()) {
+            loge("LOAD_SCENE_FROM_FILE ", load.path.c_str());
+            load.failed = true;
+            return true;
+        }
+        queueScene(load);
+    }
+    ++load.frames;
+    const auto start = high_resolution_clock::now();
+    const auto budget = std::chrono::duration<double, std::milli>(budgetMilliseconds);
+    size_t count = 0;
+    while (!load.work.empty() && (count == 0 || high_resolution_clock::now() - start < budget)) {
+        auto function = std::move(load.work.front());
+        load.work.pop_front();
+        function();
+        ++count;
+    }
+    if (!load.work.empty()) {
+        return false;
+    }
+
+    // The textures hold the GL copies now.
+    _decodedImages.clear();
+    _base64Images.clear();
+    _deferTextures = false;
+    load.done = true;
+
+    auto end = high_resolution_clock::now();
+    __totalTime += std::chrono::duration_cast<time_type>(end - load.start);
+    std::clog << std::chrono::duration_cast<std::chrono::milliseconds>(end - load.start).count() << " ms to load over "
+        << load.frames << " frames (" << std::chrono::duration_cast<std::chrono::milliseconds>(_jsonLoadTime).count()
+        << " ms parse, " << load.workCount << " steps) " << load.path << std::endl;
+    printEffectStats(load.effectStats, load.binaryStats);
+    printTextureStats(load.textureStats);
+    if (_quantizeVertices) {
+        printQuantizationStats();
+    }
+    return true;
+}
+
 shared_ptr<Node> GLTF2Loader::Impl::loadNode(size_t index) {
     RETURN_IF_FOUND(_nodes, index);
     if (auto gNode = _gltf.node(index)) {
@@ -317,6 +1110,16 @@ shared_ptr<Node> GLTF2Loader::Impl::loadNode(size_t index) {
 }
 
 shared_ptr<Node> GLTF2Loader::Impl::loadNode(const gltf2::Node& gNode) {
+    auto node = createNode(gNode);
+
+    // load children
+    for (const auto& index : gNode.children()) {
+        node->addNode(loadNode(index));
+    }
+    return node;
+}
+
+shared_ptr<Node> GLTF2Loader::Impl::createNode(const gltf2::Node& gNode) {
     auto node = Node::create(gNode.name());
 
     loadTransform(gNode, node);
@@ -325,6 +1128,9 @@ shared_ptr<Node> GLTF2Loader::Impl::loadNode(const gltf2::Node& gNode) {
     size_t meshIndex;
     if (gNode.mesh(meshIndex)) {
         if (auto mesh = loadMesh(meshIndex)) {
+            if (gNode.extension("MSFT_lod")) {
+                mesh = loadMeshLods(gNode, mesh);
+            }
             node->addComponent(MeshRenderer::create(mesh));
         }
     }
@@ -334,11 +1140,6 @@ shared_ptr<Node> GLTF2Loader::Impl::loadNode(const gltf2::Node& gNode) {
     if (gNode.camera(cameraIndex)) {
         node->addComponent(loadCamera(cameraIndex));
     }
-
-    // load children
-    for (const auto& index : gNode.children()) {
-        node->addNode(loadNode(index));
-    }
     return node;
 }
 
@@ -350,10 +1151,16 @@ shared_ptr<Mesh> GLTF2Loader::Impl::loadMesh(size_t index) {
         for (size_t i = 0; i < primCount; ++i) {
             if (auto gPrim = gMesh.primitive(i)) {
                 auto prim = loadPrimitive(gPrim);
+                if (_lodLevels > 0) {
+                    _primitiveIndices[prim.get()] = i;
+                }
                 mesh->addMeshPrimitive(prim);
             }
         }
         if (mesh->primitiveCount() > 0) {
+            if (_lodLevels > 0) {
+                generateLods(gMesh, *mesh);
+            }
             return mesh;
         }
         else {
@@ -365,27 +1172,29 @@ shared_ptr<Mesh> GLTF2Loader::Impl::loadMesh(size_t index) {
 
 shared_ptr<MeshPrimitive> GLTF2Loader::Impl::loadPrimitive(const gltf2::Primitive& gPrim) {
     auto prim = MeshPrimitive::create(toMode(gPrim.mode()));
-    for (const auto& attrib : gPrim.attributes()) {
-        auto vertexAttributeAccessor = loadVertexAttributeAccessor(attrib.second);
-        if (vertexAttributeAccessor) {
-            auto attribSemantic = toAttributeSemantic(attrib.first);
-            prim->setAttribute(attribSemantic, vertexAttributeAccessor);
-            if (attribSemantic == AttributeSemantic::POSITION) {
-                // find the bounding box
-                auto gAccessor = _gltf.accessor(attrib.second);
-                vec3 min;
-                vec3 max;
-                if (gAccessor.min(glm::value_ptr(min), 3) && gAccessor.max(glm::value_ptr(max), 3)) {
-                    prim->setBoundingBox(min, max);
-                }
+    bool octNormals = false;
+    if (!loadOptimizedGeometry(gPrim, *prim, octNormals)) {
+        for (const auto& attrib : gPrim.attributes()) {
+            auto vertexAttributeAccessor = loadVertexAttributeAccessor(attrib.second);
+            if (vertexAttributeAccessor) {
+                prim->setAttribute(toAttributeSemantic(attrib.first), vertexAttributeAccessor);
+            }
+        }
+        // load indices
+        size_t indicesIndex;
+        if (gPrim.indices(indicesIndex)) {
+            if (auto indexAccessor = loadIndexAccessor(indicesIndex)) {
+                prim->setIndices(indexAccessor);
             }
         }
     }
-    // load indices
-    size_t indicesIndex;
-    if (gPrim.indices(indicesIndex)) {
-        if (auto indexAccessor = loadIndexAccessor(indicesIndex)) {
-            prim->setIndices(indexAccessor);
+    if (prim->hasAttribute(AttributeSemantic::POSITION)) {
+        // find the bounding box
+        auto gAccessor = gPrim.position();
+        vec3 min;
+        vec3 max;
+        if (gAccessor.min(glm::value_ptr(min), 3) && gAccessor.max(glm::value_ptr(max), 3)) {
+            prim->setBoundingBox(min, max);
         }
     }
     if (_autoLoadMaterials) {
@@ -393,7 +1202,10 @@ shared_ptr<MeshPrimitive> GLTF2Loader::Impl::loadPrimitive(const gltf2::Primitiv
         shared_ptr<Material> material = nullptr;
         size_t materialIndex;
         if (gPrim.material(materialIndex)) {
-            if (material = loadMaterial(materialIndex, *prim)) {
+            // Progressive loads draw the primitive without its texture until resolveMaterials().
+            material = _deferTextures ? loadPlaceholderMaterial(materialIndex, *prim, octNormals)
+                : loadMaterial(materialIndex, *prim, octNormals);
+            if (material) {
                 prim->setMaterial(material);
             }
         }
@@ -404,6 +1216,356 @@ shared_ptr<MeshPrimitive> GLTF2Loader::Impl::loadPrimitive(const gltf2::Primitiv
     return prim;
 }
 
+bool GLTF2Loader::Impl::loadOptimizedGeometry(const gltf2::Primitive& gPrim, MeshPrimitive& prim, bool& octNormals) {
+    octNormals = false;
+    size_t indicesIndex;
+    auto gPosition = gPrim.position();
+    const bool indexed = gPrim.indices(indicesIndex);
+    const bool optimize = _optimizeMeshes && indexed && prim.mode() == MeshPrimitive::TRIANGLES;
+    if (!gPosition || (!optimize && !_quantizeVertices)) {
+        return false;
+    }
+    const size_t vertexCount = gPosition.count();
+    std::vector<uint32_t> indices;
+    if (optimize) {
+        if (!loadIndices(indicesIndex, indices)) {
+            return false;
+        }
+        for (uint32_t index : indices) {
+            if (index >= vertexCount) {
+                loge("ACCESSOR::INDEX_OUT_OF_RANGE");
+                return false;
+            }
+        }
+    }
+
+    // Find the data of every attribute before changing anything.
+    struct Attribute {
+        AttributeSemantic semantic;
+        gltf2::Accessor accessor;
+        const ubyte* data;
+        size_t elementSize;
+        size_t stride;
+    };
+    std::vector<Attribute> attributes;
+    const Attribute* position = nullptr;
+    for (const auto& attrib : gPrim.attributes()) {
+        auto gAccessor = _gltf.accessor(attrib.second);
+        if (!gAccessor || gAccessor.count() != vertexCount || gAccessor.sparse()) {
+            return false;
+        }
+        const size_t elementSize = gltf2::numberOfComponents<size_t>(gAccessor.type()) * componentSize(gAccessor.componentType());
+        size_t stride = 0;
+        const ubyte* data = accessorData(gAccessor, elementSize, stride);
+        if (data == nullptr) {
+            return false;
+        }
+        attributes.push_back({toAttributeSemantic(attrib.first), gAccessor, data, elementSize, stride});
+    }
+    for (const auto& attribute : attributes) {
+        if (attribute.semantic == AttributeSemantic::POSITION && attribute.accessor.type() == gltf2::Accessor::Type::VEC3
+            && attribute.accessor.componentType() == gltf2::Accessor::ComponentType::FLOAT) {
+            position = &attribute;
+        }
+    }
+
+    VertexCacheStats before;
+    VertexCacheStats after;
+    size_t uniqueCount = vertexCount;
+    std::vector<uint32_t> remap;
+    if (optimize) {
+        before = analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+        std::vector<uint32_t> clusters;
+        indices = optimizeVertexCache(indices.data(), indices.size(), vertexCount, 16, &clusters);
+        if (position) {
+            indices = optimizeOverdraw(indices.data(), indices.size(), reinterpret_cast<const float*>(position->data),
+                vertexCount, position->stride, clusters);
+        }
+        remap = optimizeVertexFetch(indices.data(), indices.size(), vertexCount, uniqueCount);
+        after = analyzeVertexCache(indices.data(), indices.size(), uniqueCount);
+    }
+    else {
+        remap.resize(vertexCount);
+        std::iota(remap.begin(), remap.end(), 0);
+    }
+
+    // Copy each attribute to its own tightly packed range of one vertex buffer.
+    struct Layout {
+        GLint components;
+        GLenum type;
+        GLboolean normalized;
+    };
+    std::vector<ubyte> vertices;
+    std::vector<size_t> offsets;
+    std::vector<Layout> layouts;
+    std::vector<float> floats;
+    for (const auto& attribute : attributes) {
+        const auto& gAccessor = attribute.accessor;
+        const size_t offset = (vertices.size() + 3) & ~static_cast<size_t>(3);
+        offsets.push_back(offset);
+        Layout layout = {gltf2::numberOfComponents<GLint>(gAccessor.type()), static_cast<GLenum>(gAccessor.componentType()), gAccessor.normalized()};
+
+        const bool isFloat = gAccessor.componentType() == gltf2::Accessor::ComponentType::FLOAT;
+        if (_quantizeVertices && isFloat) {
+            floats.resize(uniqueCount * layout.components);
+            remapVertices(floats.data(), attribute.data, vertexCount, attribute.elementSize, attribute.stride, remap);
+            if (quantizeAttribute(attribute.semantic, layout.components, floats, uniqueCount, prim, vertices, offset,
+                layout.components, layout.type)) {
+                layout.normalized = GL_TRUE;
+                octNormals = octNormals || attribute.semantic == AttributeSemantic::NORMAL;
+                _quantizationStats.bytesBefore += uniqueCount * attribute.elementSize;
+                _quantizationStats.bytesAfter += vertices.size() - offset;
+                layouts.push_back(layout);
+                continue;
+            }
+        }
+        vertices.resize(offset + uniqueCount * attribute.elementSize);
+        remapVertices(&vertices[offset], attribute.data, vertexCount, attribute.elementSize, attribute.stride, remap);
+        if (_quantizeVertices) {
+            _quantizationStats.bytesBefore += uniqueCount * attribute.elementSize;
+            _quantizationStats.bytesAfter += uniqueCount * attribute.elementSize;
+        }
+        layouts.push_back(layout);
+    }
+    auto vbo = VertexBuffer::create(vertices.size(), vertices.data(), GL_STATIC_DRAW);
+    for (size_t i = 0; i < attributes.size(); ++i) {
+        const auto& layout = layouts[i];
+        auto accessor = VertexAttributeAccessor::create(vbo, layout.components, layout.type, layout.normalized, 0,
+            offsets[i], static_cast<GLsizei>(uniqueCount));
+        prim.setAttribute(attributes[i].semantic, accessor);
+    }
+
+    if (!optimize) {
+        // The vertex order didn't change so the original indices still work.
+        if (indexed) {
+            if (auto indexAccessor = loadIndexAccessor(indicesIndex)) {
+                prim.setIndices(indexAccessor);
+            }
+        }
+        return true;
+    }
+
+    const auto count = static_cast<GLsizei>(indices.size());
+    shared_ptr<IndexBuffer> indexBuffer;
+    GLenum indexType;
+    if (uniqueCount <= 0xFFFF) {
+        std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+        indexBuffer = IndexBuffer::create(shortIndices.size() * sizeof(uint16_t), shortIndices.data(), GL_STATIC_DRAW);
+        indexType = GL_UNSIGNED_SHORT;
+    }
+    else {
+        indexBuffer = IndexBuffer::create(indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+        indexType = GL_UNSIGNED_INT;
+    }
+    prim.setIndices(IndexAccessor::create(indexBuffer, count, indexType, 0));
+
+    if (_lodLevels > 0) {
+        _vertexRemaps[&prim] = std::move(remap);
+    }
+    std::clog << std::fixed << std::setprecision(3)
+        << "    triangles " << count / 3
+        << "  ACMR " << before.acmr << " -> " << after.acmr
+        << "  ATVR " << before.atvr << " -> " << after.atvr
+        << "  vertices " << vertexCount << " -> " << uniqueCount << std::endl;
+    std::clog.unsetf(std::ios_base::floatfield);
+    return true;
+}
+
+bool GLTF2Loader::Impl::quantizeAttribute(AttributeSemantic semantic, GLint components, const std::vector<float>& data,
+    size_t vertexCount, MeshPrimitive& prim, std::vector<ubyte>& vertices, size_t offset, GLint& quantizedComponents, GLenum& type) {
+    auto& stats = _quantizationStats;
+    switch (semantic) {
+    case AttributeSemantic::POSITION: {
+        if (components != 3) {
+            return false;
+        }
+        // Use the bounds of the data instead of the accessor min and max in case those are not exact.
+        BoundingBox box(vec3(std::numeric_limits<float>::max()), vec3(-std::numeric_limits<float>::max()));
+        for (size_t i = 0; i < vertexCount; ++i) {
+            vec3 p(data[i * 3], data[i * 3 + 1], data[i * 3 + 2]);
+            box.min = glm::min(box.min, p);
+            box.max = glm::max(box.max, p);
+        }
+        vertices.resize(offset + vertexCount * 4 * sizeof(uint16_t));
+        float error = quantizePositions(reinterpret_cast<uint16_t*>(&vertices[offset]), data.data(), vertexCount, 0, box);
+        stats.positionError = std::max(stats.positionError, error);
+        prim.setPositionTransform(positionDequantizationMatrix(box));
+        quantizedComponents = 4;
+        type = GL_UNSIGNED_SHORT;
+        return true;
+    }
+    case AttributeSemantic::NORMAL: {
+        if (components != 3) {
+            return false;
+        }
+        vertices.resize(offset + vertexCount * 2 * sizeof(int16_t));
+        float error = quantizeNormals(reinterpret_cast<int16_t*>(&vertices[offset]), data.data(), vertexCount, 0);
+        stats.normalError = std::max(stats.normalError, error);
+        quantizedComponents = 2;
+        type = GL_SHORT;
+        return true;
+    }
+    case AttributeSemantic::TEXCOORD_0:
+    case AttributeSemantic::TEXCOORD_1: {
+        if (components != 2) {
+            return false;
+        }
+        vertices.resize(offset + vertexCount * 2 * sizeof(uint16_t));
+        float error = 0.0f;
+        if (!quantizeTexCoords(reinterpret_cast<uint16_t*>(&vertices[offset]), data.data(), vertexCount, 0, &error)) {
+            // Repeating texture coordinates outside of [0, 1] stay as floats.
+            vertices.resize(offset);
+            return false;
+        }
+        stats.texCoordError = std::max(stats.texCoordError, error);
+        quantizedComponents = 2;
+        type = GL_UNSIGNED_SHORT;
+        return true;
+    }
+    default:
+        // Tangents stay as floats because no shader decodes octahedral tangents.
+        return false;
+    }
+}
+
+shared_ptr<Mesh> GLTF2Loader::Impl::loadMeshLods(const gltf2::Node& gNode, const shared_ptr<Mesh>& mesh) {
+    // The LODs of the extension belong to this node so don't add them to a mesh that other nodes may share.
+    auto lodMesh = Mesh::create();
+    const size_t primCount = mesh->primitiveCount();
+    for (size_t i = 0; i < primCount; ++i) {
+        lodMesh->addMeshPrimitive(mesh->primitiveAt(i));
+    }
+    // MSFT_screencoverage is a fraction of the screen area, which is converted to the same screen size that the
+    // generated LODs use.
+    const auto coverage = gNode.screenCoverage();
+    const float aspectRatio = _aspectRatio > 0.0f ? _aspectRatio : 1.0f;
+    const auto lodNodes = gNode.lods();
+    float screenSize = 1.0f;
+    for (size_t i = 0; i < lodNodes.size(); ++i) {
+        size_t meshIndex;
+        auto gLodNode = _gltf.node(lodNodes[i]);
+        if (!gLodNode || !gLodNode.mesh(meshIndex)) {
+            continue;
+        }
+        if (auto lod = loadMesh(meshIndex)) {
+            screenSize = i < coverage.size() ? LodSelector::screenSizeFromCoverage(coverage[i], aspectRatio) : screenSize * 0.5f;
+            lodMesh->addLod(lod, screenSize);
+        }
+    }
+    if (coverage.size() > lodNodes.size()) {
+        lodMesh->setCullScreenSize(LodSelector::screenSizeFromCoverage(coverage[lodNodes.size()], aspectRatio));
+    }
+    return lodMesh;
+}
+
+void GLTF2Loader::Impl::generateLods(const gltf2::Mesh& gMesh, Mesh& mesh) {
+    // lods[level][primitive]
+    std::vector<std::vector<shared_ptr<MeshPrimitive>>> lods;
+    std::vector<float> errors;
+    const size_t primCount = mesh.primitiveCount();
+    for (size_t i = 0; i < primCount; ++i) {
+        auto prim = mesh.primitiveAt(i);
+        auto primIndex = _primitiveIndices.find(prim.get());
+        if (primIndex == _primitiveIndices.end()) {
+            continue;
+        }
+        auto gPrim = gMesh.primitive(primIndex->second);
+        size_t indicesIndex;
+        if (prim->mode() != MeshPrimitive::TRIANGLES || !gPrim.indices(indicesIndex)) {
+            continue;
+        }
+        auto gPosition = gPrim.position();
+        if (!gPosition || gPosition.componentType() != gltf2::Accessor::ComponentType::FLOAT
+            || gPosition.type() != gltf2::Accessor::Type::VEC3) {
+            continue;
+        }
+        size_t stride = 0;
+        const ubyte* positions = accessorData(gPosition, sizeof(float) * 3, stride);
+        std::vector<uint32_t> indices;
+        if (positions == nullptr || !loadIndices(indicesIndex, indices)) {
+            continue;
+        }
+        size_t vertexCount = gPosition.count();
+        auto outOfRange = [vertexCount](uint32_t index) { return index >= vertexCount; };
+        if (std::any_of(indices.begin(), indices.end(), outOfRange)) {
+            loge("ACCESSOR::INDEX_OUT_OF_RANGE");
+            continue;
+        }
+        auto primLods = kepler::generateLods(reinterpret_cast<const float*>(positions), vertexCount, stride,
+            indices.data(), indices.size(), _lodLevels, 0.5f, LOD_MAX_ERROR);
+        auto remap = _vertexRemaps.find(prim.get());
+        if (remap != _vertexRemaps.end()) {
+            // The primitive was optimized so its vertices were renumbered after the LODs were made from the file.
+            const auto& table = remap->second;
+            vertexCount = 0;
+            for (auto& lod : primLods) {
+                for (auto& index : lod.indices) {
+                    index = table[index];
+                    vertexCount = std::max<size_t>(vertexCount, index + 1);
+                }
+                lod.indices = optimizeVertexCache(lod.indices.data(), lod.indices.size(), vertexCount);
+            }
+        }
+        if (primLods.empty()) {
+            continue;
+        }
+
+        // Put every level in one index buffer.
+        const bool shortIndices = vertexCount <= 0xFFFF;
+        const size_t indexSize = shortIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+        std::vector<ubyte> data;
+        for (const auto& lod : primLods) {
+            size_t offset = data.size();
+            data.resize(offset + lod.indices.size() * indexSize);
+            if (shortIndices) {
+                auto dst = reinterpret_cast<uint16_t*>(&data[offset]);
+                for (uint32_t index : lod.indices) {
+                    *dst++ = static_cast<uint16_t>(index);
+                }
+            }
+            else {
+                memcpy(&data[offset], lod.indices.data(), lod.indices.size() * indexSize);
+            }
+        }
+        auto indexBuffer = IndexBuffer::create(data.size(), data.data(), GL_STATIC_DRAW);
+        const GLenum type = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        GLintptr offset = 0;
+        for (size_t level = 0; level < primLods.size(); ++level) {
+            const auto& lod = primLods[level];
+            const auto count = static_cast<GLsizei>(lod.indices.size());
+            auto indexAccessor = IndexAccessor::create(indexBuffer, count, type, offset);
+            offset += count * indexSize;
+            if (lods.size() <= level) {
+                lods.resize(level + 1, std::vector<shared_ptr<MeshPrimitive>>(primCount));
+                errors.resize(level + 1, 0.0f);
+            }
+            lods[level][i] = prim->createWithIndices(indexAccessor);
+            errors[level] = std::max(errors[level], lod.error);
+        }
+    }
+
+    float screenSize = 1.0f;
+    for (size_t level = 0; level < lods.size(); ++level) {
+        auto lodMesh = Mesh::create();
+        for (size_t i = 0; i < primCount; ++i) {
+            // Primitives that ran out of levels keep drawing their least detailed level.
+            shared_ptr<MeshPrimitive> prim = mesh.primitiveAt(i);
+            for (size_t l = 0; l <= level; ++l) {
+                if (lods[l][i]) {
+                    prim = lods[l][i];
+                }
+            }
+            lodMesh->addMeshPrimitive(prim);
+        }
+        if (errors[level] > 0.0f) {
+            screenSize = std::min(screenSize, LOD_PIXEL_ERROR / (errors[level] * LOD_REFERENCE_HEIGHT));
+        }
+        mesh.addLod(lodMesh, screenSize);
+    }
+    _vertexRemaps.clear();
+    _primitiveIndices.clear();
+}
+
 shared_ptr<Camera> GLTF2Loader::Impl::loadCamera(size_t index) {
     if (auto gCamera = _gltf.camera(index)) {
         switch (gCamera.type()) {
@@ -424,57 +1586,171 @@ shared_ptr<Camera> GLTF2Loader::Impl::loadCamera(size_t index) {
     return nullptr;
 }
 
-shared_ptr<std::vector<ubyte>> GLTF2Loader::Impl::loadBuffer(size_t index) {
-    RETURN_IF_FOUND(_buffers, index);
-    if (auto gBuffer = _gltf.buffer(index)) {
-        auto byteLength = gBuffer.byteLength();
-        auto buffer = std::make_shared<std::vector<ubyte>>();
-        if (gBuffer.load(*buffer)) {
-            _buffers[index] = buffer;
-            return buffer;
+ByteSpan GLTF2Loader::Impl::loadBuffer(size_t index) {
+    auto found = _buffers.find(index);
+    if (found != _buffers.end()) {
+        return found->second.span;
+    }
+    auto gBuffer = _gltf.buffer(index);
+    if (!gBuffer) {
+        return ByteSpan();
+    }
+    BufferData& buffer = _buffers[index];
+    string path;
+    size_t offset;
+    if (_memoryMapping && gBuffer.fileLocation(path, offset)) {
+        auto& file = _mappedFiles[path];
+        if (file == nullptr) {
+            file = MappedFile::open(path.c_str());
+        }
+        if (file) {
+            buffer.span = file->span().subspan(offset, gBuffer.byteLength());
+            if (!buffer.span.empty()) {
+                buffer.file = file;
+                return buffer.span;
+            }
         }
     }
-    return nullptr;
+    if (gBuffer.load(buffer.bytes)) {
+        buffer.span = ByteSpan(buffer.bytes.data(), buffer.bytes.size());
+        return buffer.span;
+    }
+    _buffers.erase(index);
+    return ByteSpan();
 }
 
-shared_ptr<VertexBuffer> GLTF2Loader::Impl::loadVertexBuffer(size_t index) {
-    RETURN_IF_FOUND(_vbos, index);
-    if (auto gBufferView = _gltf.bufferView(index)) {
+ByteSpan GLTF2Loader::Impl::bufferViewData(size_t index) {
+    auto decoded = _decodedViews.find(index);
+    if (decoded != _decodedViews.end()) {
+        return ByteSpan(decoded->second.data(), decoded->second.size());
+    }
+    auto gBufferView = _gltf.bufferView(index);
+    if (gBufferView && gBufferView.meshoptCompression()) {
+        // Views that weren't decoded by the staged loading are decoded on first use.
+        decodeBufferViews({index});
+        decoded = _decodedViews.find(index);
+        return decoded != _decodedViews.end() ? ByteSpan(decoded->second.data(), decoded->second.size()) : ByteSpan();
+    }
+    size_t bufferIndex;
+    if (!gBufferView || !gBufferView.buffer(bufferIndex)) {
+        return ByteSpan();
+    }
+    return loadBuffer(bufferIndex).subspan(gBufferView.byteOffset(), gBufferView.byteLength());
+}
+
+void GLTF2Loader::Impl::decodeBufferViews(const std::set<size_t>& views) {
+    struct Job {
+        size_t index;
+        gltf2::MeshoptCompression meshopt;
+        ByteSpan source;
+        std::vector<ubyte>* destination;
+        bool decoded;
+    };
+    std::vector<Job> jobs;
+    for (size_t index : views) {
+        if (_decodedViews.find(index) != _decodedViews.end()) {
+            continue;
+        }
+        auto gBufferView = _gltf.bufferView(index);
+        auto meshopt = gBufferView.meshoptCompression();
         size_t bufferIndex;
-        if (gBufferView.buffer(bufferIndex)) {
-            if (auto buffer = loadBuffer(bufferIndex)) {
-                auto byteLength = gBufferView.byteLength();
-                auto byteOffset = gBufferView.byteOffset();
-                //auto byteStride = gBufferView.byteStride(); // TODO is this needed?
-                auto vbo = VertexBuffer::create(byteLength, &(*buffer)[0] + byteOffset, GL_STATIC_DRAW);
-                _vbos[index] = vbo;
-                return vbo;
+        if (!meshopt || !meshopt.buffer(bufferIndex)) {
+            continue;
+        }
+        // The decoded elements fill the view. Checking that first keeps a corrupt count or stride from wrapping
+        // around or allocating more than the file describes.
+        const size_t count = meshopt.count();
+        const size_t stride = meshopt.byteStride();
+        if (stride == 0 || count > std::numeric_limits<size_t>::max() / stride
+            || count * stride != gBufferView.byteLength()) {
+            loge("GLTF2_LOADER::MESHOPT_SIZE ", std::to_string(index).c_str());
+            continue;
+        }
+        // The buffers were read by readBuffers() so this only looks them up.
+        const ByteSpan source = loadBuffer(bufferIndex).subspan(meshopt.byteOffset(), meshopt.byteLength());
+        if (source.empty()) {
+            loge("GLTF2_LOADER::MESHOPT_BUFFER ", std::to_string(index).c_str());
+            continue;
+        }
+        // The map nodes don't move so the workers can fill the vectors while other views are added.
+        std::vector<ubyte>& destination = _decodedViews[index];
+        destination.resize(count * stride);
+        jobs.push_back(Job{index, meshopt, source, &destination, false});
+    }
+    if (jobs.empty()) {
+        return;
+    }
+    std::atomic<size_t> next(0);
+    auto work = [&jobs, &next]() {
+        using Mode = gltf2::MeshoptCompression::Mode;
+        using Filter = gltf2::MeshoptCompression::Filter;
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            Job& job = jobs[i];
+            const size_t count = job.meshopt.count();
+            const size_t stride = job.meshopt.byteStride();
+            void* destination = job.destination->data();
+            switch (job.meshopt.mode()) {
+            case Mode::ATTRIBUTES:
+                job.decoded = meshopt::decodeVertexBuffer(destination, count, stride, job.source.data, job.source.size);
+                break;
+            case Mode::TRIANGLES:
+                job.decoded = meshopt::decodeIndexBuffer(destination, count, stride, job.source.data, job.source.size);
+                break;
+            case Mode::INDICES:
+                job.decoded = meshopt::decodeIndexSequence(destination, count, stride, job.source.data, job.source.size);
+                break;
+            }
+            if (!job.decoded) {
+                continue;
+            }
+            switch (job.meshopt.filter()) {
+            case Filter::OCTAHEDRAL:  meshopt::decodeFilterOct(destination, count, stride); break;
+            case Filter::QUATERNION:  meshopt::decodeFilterQuat(destination, count, stride); break;
+            case Filter::EXPONENTIAL: meshopt::decodeFilterExp(destination, count, stride); break;
+            case Filter::NONE: break;
             }
         }
+    };
+    const size_t threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), jobs.size()));
+    std::vector<std::future<void>> workers;
+    for (size_t i = 1; i < threads; ++i) {
+        workers.push_back(std::async(std::launch::async, work));
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.get();
+    }
+    for (const auto& job : jobs) {
+        if (!job.decoded) {
+            // A view that fails to decode is left out rather than drawn as garbage.
+            loge("GLTF2_LOADER::MESHOPT_DECODE ", std::to_string(job.index).c_str());
+            _decodedViews.erase(job.index);
+        }
     }
-    return nullptr;
+}
+
+shared_ptr<VertexBuffer> GLTF2Loader::Impl::loadVertexBuffer(size_t index) {
+    RETURN_IF_FOUND(_vbos, index);
+    const ByteSpan data = bufferViewData(index);
+    if (data.empty()) {
+        return nullptr;
+    }
+    // Uploaded straight from the mapped file when memory mapping is enabled.
+    auto vbo = VertexBuffer::create(data.size, data.data, GL_STATIC_DRAW);
+    _vbos[index] = vbo;
+    return vbo;
 }
 
 shared_ptr<IndexBuffer> GLTF2Loader::Impl::loadIndexBuffer(size_t index) {
     // TODO is it possible to have more than 1 of the same index buffer?
     RETURN_IF_FOUND(_indexBuffers, index);
-
-    // TODO this is very similar to loadVertexBuffer. Move to common function.
-
-    if (auto gBufferView = _gltf.bufferView(index)) {
-        size_t bufferIndex;
-        if (gBufferView.buffer(bufferIndex)) {
-            if (auto buffer = loadBuffer(bufferIndex)) {
-                auto byteLength = gBufferView.byteLength();
-                auto byteOffset = gBufferView.byteOffset();
-                //auto byteStride = gBufferView.byteStride(); // TODO is this needed?
-                auto indexBuffer = IndexBuffer::create(byteLength, &(*buffer)[0] + byteOffset, GL_STATIC_DRAW);
-                _indexBuffers[index] = indexBuffer;
-                return indexBuffer;
-            }
-        }
+    const ByteSpan data = bufferViewData(index);
+    if (data.empty()) {
+        return nullptr;
     }
-    return nullptr;
+    auto indexBuffer = IndexBuffer::create(data.size, data.data, GL_STATIC_DRAW);
+    _indexBuffers[index] = indexBuffer;
+    return indexBuffer;
 }
 
 shared_ptr<IndexAccessor> GLTF2Loader::Impl::loadIndexAccessor(size_t index) {
@@ -517,8 +1793,60 @@ shared_ptr<VertexAttributeAccessor> GLTF2Loader::Impl::loadVertexAttributeAccess
     return nullptr;
 }
 
-shared_ptr<Material> GLTF2Loader::Impl::loadMaterial(size_t index, MeshPrimitive& primitive) {
-    RETURN_IF_FOUND(_materials, index);
+const ubyte* GLTF2Loader::Impl::accessorData(const gltf2::Accessor& gAccessor, size_t elementSize, size_t& byteStride) {
+    size_t bufferViewIndex;
+    if (!gAccessor.bufferView(bufferViewIndex)) {
+        return nullptr;
+    }
+    const ByteSpan view = bufferViewData(bufferViewIndex);
+    if (view.empty()) {
+        return nullptr;
+    }
+    const size_t viewStride = _gltf.bufferView(bufferViewIndex).byteStride();
+    byteStride = viewStride != 0 ? viewStride : elementSize;
+    const size_t offset = gAccessor.byteOffset();
+    const size_t count = gAccessor.count();
+    if (count > 0 && offset + (count - 1) * byteStride + elementSize > view.size) {
+        loge("ACCESSOR::OUT_OF_BOUNDS");
+        return nullptr;
+    }
+    return view.data + offset;
+}
+
+bool GLTF2Loader::Impl::loadIndices(size_t index, std::vector<uint32_t>& indices) {
+    auto gAccessor = _gltf.accessor(index);
+    if (!gAccessor) {
+        return false;
+    }
+    size_t elementSize;
+    switch (gAccessor.componentType()) {
+    case gltf2::Accessor::ComponentType::UNSIGNED_BYTE:  elementSize = sizeof(uint8_t); break;
+    case gltf2::Accessor::ComponentType::UNSIGNED_SHORT: elementSize = sizeof(uint16_t); break;
+    case gltf2::Accessor::ComponentType::UNSIGNED_INT:   elementSize = sizeof(uint32_t); break;
+    default:
+        return false;
+    }
+    size_t stride = 0;
+    const ubyte* data = accessorData(gAccessor, elementSize, stride);
+    if (data == nullptr) {
+        return false;
+    }
+    const size_t count = gAccessor.count();
+    indices.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const ubyte* p = data + i * stride;
+        switch (elementSize) {
+        case sizeof(uint8_t):  indices[i] = *p; break;
+        case sizeof(uint16_t): indices[i] = *reinterpret_cast<const uint16_t*>(p); break;
+        default:               indices[i] = *reinterpret_cast<const uint32_t*>(p); break;
+        }
+    }
+    return true;
+}
+
+shared_ptr<Material> GLTF2Loader::Impl::loadMaterial(size_t index, MeshPrimitive& primitive, bool octNormals) {
+    auto& materials = octNormals ? _octNormalMaterials : _materials;
+    RETURN_IF_FOUND(materials, index);
     if (_useDefaultMaterial) {
         return loadDefaultMaterial();
     }
@@ -527,105 +1855,125 @@ shared_ptr<Material> GLTF2Loader::Impl::loadMaterial(size_t index, MeshPrimitive
         if (const char* name = gMaterial.name()) {
             material->setName(name);
         }
-        // load basic shader
-
-        std::vector<const char*> defines;
-        if (primitive.hasAttribute(AttributeSemantic::TEXCOORD_0)) {
-            defines.push_back(HAS_UV);
-        }
-
-        shared_ptr<Texture> baseMapTexture;
-        vec4 baseColorFactor(1);
+        BasicMaterialParams params;
+        params.texCoords = primitive.hasAttribute(AttributeSemantic::TEXCOORD_0);
+        params.octNormals = octNormals;
+        params.doubleSided = gMaterial.doubleSided();
+        params.bindless = _bindlessTextures;
         auto gPbr = gMaterial.pbrMetallicRoughness();
         if (gPbr) {
             size_t textureIndex;
             if (gPbr.baseColorTexture().index(textureIndex)) {
-                if (baseMapTexture = loadTexture(textureIndex)) {
-                    defines.push_back(HAS_BASE_COLOR_MAP);
+                if (!(params.baseMap = loadTextureLayer(textureIndex, params.baseMapLayer))) {
+                    params.baseMap = loadTexture(textureIndex);
                 }
             }
-            gPbr.baseColorFactor(glm::value_ptr(baseColorFactor));
+            gPbr.baseColorFactor(glm::value_ptr(params.baseColorFactor));
         }
-
-        shared_ptr<Effect> effect;
-        if (fileExists(BASIC_VERT_PATH) && fileExists(BASIC_FRAG_PATH)) {
-            effect = Effect::createFromFile(BASIC_VERT_PATH, BASIC_FRAG_PATH, defines.data(), defines.size());
-        }
-        else {
-            // try one directory back
-            string vPath{concat("../", BASIC_VERT_PATH)};
-            string fPath{concat("../", BASIC_FRAG_PATH)};
-            if (fileExists(vPath.c_str()) && fileExists(fPath.c_str())) {
-                effect = Effect::createFromFile(vPath.c_str(), fPath.c_str(), defines.data(), defines.size());
-            }
-        }
-        if (!effect) {
+        auto tech = createBasicTechnique(params, _clusteredLighting.get(), _asyncShaders);
+        if (!tech) {
             return nullptr;
         }
-        auto tech = Technique::create(effect);
-
-        if (baseMapTexture) {
-            tech->setUniform("s_baseMap", MaterialParameter::create("s_baseMap", baseMapTexture));
-        }
-
-        tech->setAttribute("a_position", AttributeSemantic::POSITION);
-        tech->setAttribute("a_normal", AttributeSemantic::NORMAL);
-        tech->setAttribute("a_texcoord0", AttributeSemantic::TEXCOORD_0);
-
-        tech->setSemanticUniform("mvp", MaterialParameter::Semantic::MODELVIEWPROJECTION);
-        tech->setSemanticUniform("modelView", MaterialParameter::Semantic::MODELVIEW);
-        tech->setSemanticUniform("normalMatrix", MaterialParameter::Semantic::MODELVIEWINVERSETRANSPOSE);
-
-        tech->setUniform("lightPos", MaterialParameter::create("lightPos", vec3(1, 1, 1)));
-        tech->setUniform("lightColor", MaterialParameter::create("lightColor", vec3(1, 1, 1)));
-        tech->setUniform("shininess", MaterialParameter::create("shininess", 64.0f));
-        tech->setUniform("specularStrength", MaterialParameter::create("specularStrength", 0.2f));
-        tech->setUniform("ambient", MaterialParameter::create("ambient", vec3(0.2f)));
-
-        tech->setUniform("constantAttenuation", MaterialParameter::create("constantAttenuation", 1.f));
-        tech->setUniform("linearAttenuation", MaterialParameter::create("linearAttenuation", 0.f));
-        tech->setUniform("quadraticAttenuation", MaterialParameter::create("quadraticAttenuation", 0.0025f));
-
-        // gltf 2.0
-        tech->setUniform("baseColorFactor", MaterialParameter::create("baseColorFactor", baseColorFactor));
-
-        auto& state = tech->renderState();
-        state.setDepthTest(true);
-        state.setCulling(!gMaterial.doubleSided());
-
         material->setTechnique(tech);
-        _materials[index] = material;
+        materials[index] = material;
         return material;
     }
     return nullptr;
 }
 
+shared_ptr<Material> GLTF2Loader::Impl::loadPlaceholderMaterial(size_t index, MeshPrimitive& primitive, bool octNormals) {
+    auto gMaterial = _gltf.material(index);
+    auto gPbr = gMaterial.pbrMetallicRoughness();
+    size_t textureIndex;
+    if (_useDefaultMaterial || !gMaterial || !gPbr || !gPbr.baseColorTexture().index(textureIndex)) {
+        return loadMaterial(index, primitive, octNormals);
+    }
+    const auto key = std::make_pair(index, octNormals);
+    RETURN_IF_FOUND(_placeholderMaterials, key);
+    BasicMaterialParams params;
+    params.octNormals = octNormals;
+    params.doubleSided = gMaterial.doubleSided();
+    gPbr.baseColorFactor(glm::value_ptr(params.baseColorFactor));
+    auto tech = createBasicTechnique(params, _clusteredLighting.get(), _asyncShaders);
+    if (!tech) {
+        return loadMaterial(index, primitive, octNormals);
+    }
+    auto material = Material::create();
+    if (const char* name = gMaterial.name()) {
+        material->setName(name);
+    }
+    material->setTechnique(tech);
+    _placeholderMaterials[key] = material;
+    _placeholders[material.get()] = key;
+    return material;
+}
+
+void GLTF2Loader::Impl::resolveMaterials(Mesh& mesh) {
+    for (size_t i = 0; i < mesh.primitiveCount(); ++i) {
+        MeshPrimitive* prim = mesh.primitivePtr(i);
+        auto placeholder = _placeholders.find(prim->material().get());
+        if (placeholder != _placeholders.end()) {
+            if (auto material = loadMaterial(placeholder->second.first, *prim, placeholder->second.second)) {
+                prim->setMaterial(material);
+            }
+        }
+    }
+    for (size_t i = 0; i < mesh.lodCount(); ++i) {
+        resolveMaterials(*mesh.lodPtr(i));
+    }
+}
+
 shared_ptr<Texture> GLTF2Loader::Impl::loadTexture(size_t index) {
     RETURN_IF_FOUND(_textures, index);
     if (auto gTexture = _gltf.texture(index)) {
         size_t imageIndex;
-        if (gTexture.source(imageIndex)) {
-            if (auto image = loadImage(imageIndex)) {
-                auto texture = Texture::create2D(image.get(), DEFAULT_FORMAT, true);
-                shared_ptr<Sampler> sampler;
-                size_t samplerIndex;
-                if (gTexture.sampler(samplerIndex)) {
-                    if (sampler = loadSampler(samplerIndex)) {
-                        texture->setSampler(sampler);
-                    }
-                }
-                if (sampler == nullptr) {
-                    sampler = loadDefaultSampler();
-                }
-                texture->setSampler(sampler);
-                _textures[index] = texture;
-                return texture;
-            }
+        shared_ptr<Texture> image;
+        // KHR_texture_basisu points to a KTX2 image. Only KTX2 files that are already in a GPU format can be used
+        // since there is no Basis Universal transcoder, so fall back to the regular source for the others.
+        if (gTexture.basisuSource(imageIndex)) {
+            image = loadImage(imageIndex);
+        }
+        if (image == nullptr && gTexture.source(imageIndex)) {
+            image = loadImage(imageIndex);
+        }
+        if (image) {
+            auto texture = Texture::createShared(image);
+            texture->setSampler(loadTextureSampler(gTexture));
+            _textures[index] = texture;
+            return texture;
         }
     }
     return nullptr;
 }
 
+shared_ptr<Texture> GLTF2Loader::Impl::loadTextureLayer(size_t index, int& layer) {
+    auto gTexture = _gltf.texture(index);
+    size_t imageIndex;
+    // Textures with a KTX2 source keep their compressed texture.
+    if (!gTexture || gTexture.basisuSource(imageIndex) || !gTexture.source(imageIndex)) {
+        return nullptr;
+    }
+    auto imageLayer = _imageLayers.find(imageIndex);
+    if (imageLayer == _imageLayers.end()) {
+        return nullptr;
+    }
+    layer = imageLayer->second.second;
+    RETURN_IF_FOUND(_layerTextures, index);
+    auto texture = Texture::createShared(imageLayer->second.first);
+    texture->setSampler(loadTextureSampler(gTexture));
+    _layerTextures[index] = texture;
+    return texture;
+}
+
+shared_ptr<Sampler> GLTF2Loader::Impl::loadTextureSampler(const gltf2::Texture& gTexture) {
+    shared_ptr<Sampler> sampler;
+    size_t samplerIndex;
+    if (gTexture.sampler(samplerIndex)) {
+        sampler = loadSampler(samplerIndex);
+    }
+    return sampler ? sampler : loadDefaultSampler();
+}
+
 shared_ptr<Sampler> GLTF2Loader::Impl::loadSampler(size_t index) {
     RETURN_IF_FOUND(_samplers, index);
     if (auto gSampler = _gltf.sampler(index)) {
@@ -647,42 +1995,207 @@ shared_ptr<Sampler> GLTF2Loader::Impl::loadSampler(size_t index) {
     return nullptr;
 }
 
-shared_ptr<Image> GLTF2Loader::Impl::loadImage(size_t index) {
-    RETURN_IF_FOUND(_images, index);
-    shared_ptr<Image> image = nullptr;
-
-    auto start = high_resolution_clock::now();
-
+bool GLTF2Loader::Impl::imageSource(size_t index, TextureCache::ImageSource& source) {
+    source = TextureCache::ImageSource();
     if (auto gImage = _gltf.image(index)) {
         if (const char* uri = gImage.uri()) {
             if (gImage.isBase64()) {
-                std::vector<unsigned char> imageData;
-                if (gImage.loadBase64(imageData)) {
-                    image = Image::createFromFileMemory(imageData.data(), static_cast<int>(imageData.size()));
+                auto it = _base64Images.find(index);
+                if (it == _base64Images.end()) {
+                    std::vector<unsigned char> imageData;
+                    if (!gImage.loadBase64(imageData)) {
+                        return false;
+                    }
+                    it = _base64Images.emplace(index, std::move(imageData)).first;
                 }
+                source.buffer = it->second.data();
+                source.length = it->second.size();
             }
             else {
-                std::string imagePath = _gltf.baseDir() + gImage.uri();
-                image = Image::createFromFile(imagePath.c_str());
+                source.path = _gltf.baseDir() + uri;
             }
+            return true;
         }
-        else if (auto gBufferView = gImage.bufferView()) {
-            size_t bufferIndex;
-            if (gBufferView.buffer(bufferIndex)) {
-                if (auto buffer = loadBuffer(bufferIndex)) {
-                    int bufferLength = static_cast<int>(gBufferView.byteLength());
-                    image = Image::createFromFileMemory(buffer->data() + gBufferView.byteOffset(), bufferLength);
+        else {
+            size_t bufferViewIndex;
+            if (gImage.bufferView(bufferViewIndex)) {
+                const ByteSpan data = bufferViewData(bufferViewIndex);
+                if (!data.empty()) {
+                    source.buffer = data.data;
+                    source.length = data.size;
+                    return true;
                 }
             }
         }
-        if (image) {
-            _images[index] = image;
+    }
+    return false;
+}
+
+shared_ptr<Texture> GLTF2Loader::Impl::loadImage(size_t index) {
+    RETURN_IF_FOUND(_images, index);
+    shared_ptr<Texture> texture = nullptr;
+
+    auto start = high_resolution_clock::now();
+
+    TextureCache::ImageSource source;
+    if (imageSource(index, source)) {
+        if (source.buffer) {
+            texture = TextureCache::textureFromFileMemory(source.buffer, source.length, DEFAULT_FORMAT, true);
+        }
+        else {
+            texture = TextureCache::textureFromFile(source.path.c_str(), DEFAULT_FORMAT, true);
+        }
+        if (texture) {
+            _images[index] = texture;
         }
     }
 
     auto end = high_resolution_clock::now();
     printTime(start, end, " ms to load image");
-    return image;
+    return texture;
+}
+
+void GLTF2Loader::Impl::collectTextures(size_t nodeIndex, std::set<size_t>& textures) const {
+    auto gNode = _gltf.node(nodeIndex);
+    if (!gNode) {
+        return;
+    }
+    size_t meshIndex;
+    if (gNode.mesh(meshIndex)) {
+        if (auto gMesh = _gltf.mesh(meshIndex)) {
+            for (const auto& gPrimitive : gMesh.primitives()) {
+                auto gMaterial = gPrimitive.material();
+                if (!gMaterial) {
+                    continue;
+                }
+                // Only the base color texture is used by loadMaterial().
+                size_t textureIndex;
+                auto gPbr = gMaterial.pbrMetallicRoughness();
+                if (gPbr && gPbr.baseColorTexture().index(textureIndex)) {
+                    textures.insert(textureIndex);
+                }
+            }
+        }
+    }
+    for (size_t lod : gNode.lods()) {
+        collectTextures(lod, textures);
+    }
+    for (size_t child : gNode.children()) {
+        collectTextures(child, textures);
+    }
+}
+
+void GLTF2Loader::Impl::collectImages(size_t sceneIndex, std::set<size_t>& images) const {
+    auto gScene = _gltf.scene(sceneIndex);
+    if (!gScene) {
+        return;
+    }
+    std::set<size_t> textures;
+    for (size_t node : gScene.nodes()) {
+        collectTextures(node, textures);
+    }
+    for (size_t textureIndex : textures) {
+        if (auto gTexture = _gltf.texture(textureIndex)) {
+            size_t imageIndex;
+            if (gTexture.basisuSource(imageIndex)) {
+                images.insert(imageIndex);
+            }
+            if (gTexture.source(imageIndex)) {
+                images.insert(imageIndex);
+            }
+        }
+    }
+}
+
+void GLTF2Loader::Impl::decodeImages(size_t sceneIndex) {
+    auto gScene = _gltf.scene(sceneIndex);
+    if (!gScene || !_parallelImageDecode || !_autoLoadMaterials || _useDefaultMaterial) {
+        return;
+    }
+    auto start = high_resolution_clock::now();
+    std::set<size_t> images;
+    collectImages(sceneIndex, images);
+    std::vector<TextureCache::ImageSource> sources;
+    for (size_t index : images) {
+        if (_images.find(index) != _images.end()) {
+            continue;
+        }
+        TextureCache::ImageSource source;
+        if (imageSource(index, source)) {
+            sources.push_back(std::move(source));
+        }
+    }
+    if (sources.size() < 2) {
+        // Nothing to gain from threads.
+        return;
+    }
+    _decodedImages = TextureCache::decodeImages(sources, DEFAULT_FORMAT, true);
+    auto end = high_resolution_clock::now();
+    std::clog << "    decoded " << _decodedImages.size() << " of " << sources.size() << " images in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms on "
+        << std::min<size_t>(std::thread::hardware_concurrency(), sources.size()) << " threads" << std::endl;
+}
+
+void GLTF2Loader::Impl::packTextureArrays(size_t sceneIndex) {
+    auto gScene = _gltf.scene(sceneIndex);
+    if (!gScene || !_textureArrays || (_bindlessTextures && bindless::supported()) || !_autoLoadMaterials || _useDefaultMaterial) {
+        return;
+    }
+    auto start = high_resolution_clock::now();
+    std::set<size_t> textures;
+    for (size_t node : gScene.nodes()) {
+        collectTextures(node, textures);
+    }
+    std::set<size_t> images;
+    for (size_t textureIndex : textures) {
+        auto gTexture = _gltf.texture(textureIndex);
+        size_t imageIndex;
+        if (gTexture && !gTexture.basisuSource(imageIndex) && gTexture.source(imageIndex)
+            && _imageLayers.find(imageIndex) == _imageLayers.end()) {
+            images.insert(imageIndex);
+        }
+    }
+    // The images were decoded by decodeImages() so these are cache hits.
+    std::map<std::pair<int, int>, std::vector<std::pair<size_t, shared_ptr<Image>>>> sizes;
+    for (size_t imageIndex : images) {
+        TextureCache::ImageSource source;
+        if (!imageSource(imageIndex, source)) {
+            continue;
+        }
+        auto image = source.buffer ? TextureCache::imageFromFileMemory(source.buffer, source.length)
+            : TextureCache::imageFromFile(source.path.c_str());
+        if (image) {
+            sizes[std::make_pair(image->width(), image->height())].emplace_back(imageIndex, image);
+        }
+    }
+    size_t arrayCount = 0;
+    size_t packedCount = 0;
+    for (const auto& size : sizes) {
+        const auto& sameSize = size.second;
+        if (sameSize.size() < 2) {
+            // A single image is no better off in an array.
+            continue;
+        }
+        auto array = TextureArray::create(size.first.first, size.first.second, static_cast<int>(sameSize.size()));
+        if (!array) {
+            continue;
+        }
+        for (const auto& image : sameSize) {
+            const int layer = array->add(*image.second);
+            if (layer >= 0) {
+                _imageLayers[image.first] = std::make_pair(array->texture(), layer);
+                ++packedCount;
+            }
+        }
+        array->generateMipmaps();
+        ++arrayCount;
+    }
+    if (arrayCount > 0) {
+        auto end = high_resolution_clock::now();
+        std::clog << "    packed " << packedCount << " of " << images.size() << " images into " << arrayCount
+            << " texture arrays in " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+            << " ms" << std::endl;
+    }
 }
 
 shared_ptr<Material> GLTF2Loader::Impl::loadDefaultMaterial() {
@@ -705,7 +2218,7 @@ shared_ptr<Technique> GLTF2Loader::Impl::loadDefaultTechnique() {
         return _defaultTechnique;
     }
 
-    auto effect = Effect::createFromSource(DEFAULT_VERT_SHADER, DEFAULT_FRAG_SHADER);
+    auto effect = EffectCache::createFromSource(DEFAULT_VERT_SHADER, DEFAULT_FRAG_SHADER);
     if (effect == nullptr) {
         loge("LOAD_DEFAULT_EFFECT");
         return nullptr;
@@ -753,6 +2266,23 @@ void GLTF2Loader::Impl::setAutoLoadMaterials(bool value) {
     _autoLoadMaterials = value;
 }
 
+void GLTF2Loader::Impl::copySettings(const Impl& other) {
+    _useDefaultMaterial = other._useDefaultMaterial;
+    _autoLoadMaterials = other._autoLoadMaterials;
+    _aspectRatio = other._aspectRatio;
+    _lodLevels = other._lodLevels;
+    _optimizeMeshes = other._optimizeMeshes;
+    _quantizeVertices = other._quantizeVertices;
+    _clusteredLighting = other._clusteredLighting;
+    _asyncShaders = other._asyncShaders;
+    _parallelImageDecode = other._parallelImageDecode;
+    _textureArrays = other._textureArrays;
+    _bindlessTextures = other._bindlessTextures;
+    _memoryMapping = other._memoryMapping;
+    _stagedLoading = other._stagedLoading;
+    _progressiveLoading = other._progressiveLoading;
+}
+
 void GLTF2Loader::Impl::loadTransform(const gltf2::Node& gNode, const shared_ptr<Node>& node) {
     std::array<float, 16> matrix;
     if (gNode.matrix(matrix.data())) {
@@ -923,6 +2453,19 @@ Sampler::MagFilter toMagFilterMode(gltf2::Sampler::MagFilter filter) {
     }
 }
 
+size_t componentSize(gltf2::Accessor::ComponentType type) {
+    switch (type) {
+    case gltf2::Accessor::ComponentType::BYTE:
+    case gltf2::Accessor::ComponentType::UNSIGNED_BYTE:
+        return 1;
+    case gltf2::Accessor::ComponentType::SHORT:
+    case gltf2::Accessor::ComponentType::UNSIGNED_SHORT:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
 GLint numComponentsOfType(const string& type) {
     if (type.length() == 4) {
         char c0 = type[0];
@@ -31,6 +31,15 @@ public:
     /// @return A reference to the newly loaded scene. Will be empty if there was an error.
     shared_ptr<Scene> loadSceneFromFile(const char* path);
 
+    /// Starts loading the default scene of the given GLTF file without blocking.
+    /// The json is parsed, buffers are read and images are decoded on a background thread. The GL objects and
+    /// nodes are then created by SceneLoad::update() a few at a time so the app keeps drawing frames.
+    /// The load uses the current settings of the loader but has its own state, so the loader can load other files,
+    /// be cleared, change settings or be destroyed while the load is running.
+    /// @param[in] path The file path.
+    /// @return The load. Never null; check SceneLoad::failed().
+    shared_ptr<SceneLoad> loadSceneFromFileAsync(const char* path);
+
     shared_ptr<Mesh> findMeshByIndex(size_t index);
 
     /// Clears all of the data held by this loader.
@@ -48,12 +57,107 @@ public:
     /// @param[in] aspectRatio The aspect ratio to use. Zero means use what is found in the glTF file.
     void setCameraAspectRatio(float aspectRatio);
 
+    /// Sets the number of levels of detail to generate for each mesh. Zero disables generating LODs.
+    /// Each level has about half of the triangles of the previous level and shares its vertex buffers.
+    /// Nodes that use the MSFT_lod extension draw the LODs from the file instead.
+    /// @param[in] levels The max number of levels to generate, not counting the original mesh. 3 to 5 is typical.
+    void setGenerateLods(size_t levels);
+
+    /// Sets if indexed triangle lists are reordered for the post transform vertex cache, overdraw and vertex fetch.
+    /// Optimized primitives get their own vertex and index buffers.
+    /// The ACMR and ATVR of each primitive before and after are printed. Disabled by default.
+    void setOptimizeMeshes(bool value);
+
+    /// Sets if float vertex attributes are quantized to 16 bit integers. Disabled by default.
+    /// Positions are stored relative to the bounding box and the primitive's position transform restores them.
+    /// Normals are octahedral encoded and texture coordinates in [0, 1] become normalized integers.
+    /// Tangents stay as floats.
+    /// The memory saved and the largest error of each asset are printed.
+    void setQuantizeVertices(bool value);
+
+    /// Sets the lights that loaded materials are shaded with. May be null.
+    /// Materials use the CLUSTERED_LIGHTS variant of the basic shader instead of the single default light.
+    /// ClusteredLighting::update() must be called every frame before drawing.
+    void setClusteredLighting(const shared_ptr<ClusteredLighting>& lighting);
+
+    /// Sets if material shaders compile in the background. Disabled by default.
+    /// Primitives are not drawn until their effect is ready so loading a scene doesn't stall on shader compiles.
+    /// Uses GL_KHR_parallel_shader_compile when the driver supports it.
+    void setAsyncShaderCompile(bool value);
+
+    /// Sets if the images of a scene are decoded on worker threads before the scene is loaded. Enabled by default.
+    /// Textures are still uploaded on the calling thread.
+    void setParallelImageDecode(bool value);
+
+    /// Sets if base color images of the same size are packed into the layers of texture arrays. Disabled by default.
+    /// Materials that share an array bind the same texture and only differ by the layer uniform.
+    /// KTX2 textures are not packed. Ignored when bindless textures are used.
+    void setTextureArrays(bool value);
+
+    /// Sets if base color textures are passed to shaders as GL_ARB_bindless_texture handles. Disabled by default.
+    /// Materials don't bind texture units at all. Ignored if the driver doesn't support the extension.
+    /// Don't combine with the TextureStreamer since the parameters of a texture can't change once it has a handle.
+    void setBindlessTextures(bool value);
+
+    /// Sets if GLB files and external .bin buffers are memory mapped instead of read into memory. Enabled by default.
+    /// Vertex and index buffers are uploaded straight from the mapped pages. Buffers that can't be mapped are read.
+    void setMemoryMapping(bool value);
+
+    /// Sets if scenes are loaded in stages. Enabled by default.
+    /// The buffers, textures and images the scene needs are found first. Buffers are read and images decoded on
+    /// worker threads, then the GL objects are created together before the nodes are assembled. The time of each
+    /// stage is printed. When disabled the nodes are loaded one at a time and each loads what it needs.
+    void setStagedLoading(bool value);
+
+    /// Sets if loadSceneFromFileAsync() adds nodes to the scene as soon as their meshes are created. Disabled by default.
+    /// The vertex and index buffers are created before any texture and materials with a base color texture start
+    /// out without the texture. Each mesh gets its real materials once every texture of the scene is uploaded.
+    /// When disabled SceneLoad::scene() is null until the whole scene is loaded.
+    void setProgressiveLoading(bool value);
+
     /// Prints the time spent loading GLTF files so far.
     static void printTotalTime();
 
 private:
+    friend class SceneLoad;
     class Impl;
     std::unique_ptr<Impl> _impl;
 };
+
+/// A scene that is being loaded by GLTF2Loader::loadSceneFromFileAsync().
+class SceneLoad final {
+public:
+    /// Use GLTF2Loader::loadSceneFromFileAsync()
+    explicit SceneLoad(const shared_ptr<GLTF2Loader::Impl>& loader);
+    ~SceneLoad() noexcept;
+    SceneLoad(const SceneLoad&) = delete;
+    SceneLoad& operator=(const SceneLoad&) = delete;
+
+    /// Creates GL objects and nodes until the time budget is used up. Call once per frame on the GL thread.
+    /// Does nothing while the background thread is still reading the file.
+    /// @param[in] budgetMilliseconds The time to spend. At least one object is created if there is work.
+    /// @return True once the load is done or failed.
+    bool update(double budgetMilliseconds = 4.0);
+
+    /// Waits for the background thread and does the rest of the GL work now.
+    /// @return The scene. Null if the load failed.
+    shared_ptr<Scene> finish();
+
+    /// Returns the scene. With progressive loading the scene is returned as soon as the background work is done
+    /// and nodes are added to it by update(). Otherwise it is null until the load is done.
+    shared_ptr<Scene> scene() const;
+
+    /// Returns how much of the load is done from 0 to 1.
+    float progress() const;
+
+    /// Returns true if the load is done or failed.
+    bool done() const;
+
+    /// Returns true if the file couldn't be loaded or has no scene.
+    bool failed() const;
+
+private:
+    shared_ptr<GLTF2Loader::Impl> _loader;
+};
 }
 }
@@ -0,0 +1,93 @@
+#include "stdafx.h"
+#include "GpuTimer.hpp"
+#include "Performance.hpp"
+
+namespace kepler {
+namespace gl {
+
+GpuTimer::GpuTimer(size_t frameLatency) : _frames(std::max<size_t>(1, frameLatency) + 1) {
+}
+
+GpuTimer::~GpuTimer() noexcept {
+    for (auto& frame : _frames) {
+        for (auto& query : frame.queries) {
+            glDeleteQueries(1, &query.begin);
+            glDeleteQueries(1, &query.end);
+        }
+    }
+}
+
+shared_ptr<GpuTimer> GpuTimer::create(size_t frameLatency) {
+    return std::make_shared<GpuTimer>(frameLatency);
+}
+
+void GpuTimer::beginFrame() {
+    // Scopes that were never ended are dropped.
+    while (!_open.empty()) {
+        end();
+    }
+    const uint64_t number = FrameProfiler::frameNumber();
+    _current = &_frames[number % _frames.size()];
+    collect(*_current);
+    _current->number = number;
+}
+
+void GpuTimer::begin(const char* name) {
+    if (_current == nullptr) {
+        return;
+    }
+    Frame& frame = *_current;
+    if (frame.used == frame.queries.size()) {
+        Query query;
+        glGenQueries(1, &query.begin);
+        glGenQueries(1, &query.end);
+        frame.queries.push_back(query);
+    }
+    Query& query = frame.queries[frame.used];
+    query.name = name;
+    glQueryCounter(query.begin, GL_TIMESTAMP);
+    _open.push_back(frame.used++);
+}
+
+void GpuTimer::end() {
+    if (_current == nullptr || _open.empty()) {
+        return;
+    }
+    glQueryCounter(_current->queries[_open.back()].end, GL_TIMESTAMP);
+    _open.pop_back();
+}
+
+size_t GpuTimer::droppedFrames() const {
+    return _droppedFrames;
+}
+
+void GpuTimer::collect(Frame& frame) {
+    if (frame.used == 0) {
+        return;
+    }
+    // Nested scopes end out of order so every end timestamp is checked. Asking for the result of a query that
+    // isn't available would wait for the GPU.
+    GLint available = 1;
+    for (size_t i = 0; i < frame.used && available; ++i) {
+        glGetQueryObjectiv(frame.queries[i].end, GL_QUERY_RESULT_AVAILABLE, &available);
+    }
+    if (available) {
+        for (size_t i = 0; i < frame.used; ++i) {
+            const Query& query = frame.queries[i];
+            GLuint64 begin = 0;
+            GLuint64 end = 0;
+            glGetQueryObjectui64v(query.begin, GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(query.end, GL_QUERY_RESULT, &end);
+            if (end >= begin) {
+                FrameProfiler::addGpuTime(frame.number, query.name, static_cast<double>(end - begin) / 1000000.0);
+            }
+        }
+    }
+    else {
+        ++_droppedFrames;
+    }
+    frame.used = 0;
+}
+
+} // namespace gl
+} // namespace kepler
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <BaseGL.hpp>
+#include <OpenGL.hpp>
+
+#include <vector>
+
+namespace kepler {
+namespace gl {
+
+/// GpuTimer measures how long the GPU takes to run named scopes of GL commands and reports the times to the
+/// FrameProfiler next to the CPU times of the same frame.
+///
+/// Each scope writes a GL_TIMESTAMP query when it begins and ends so scopes can be nested. The queries of a frame
+/// are only read once the frame is several frames old, and only if their results are available, so reading them
+/// never stalls the pipeline. The query objects of a frame are reused once it has been read.
+class GpuTimer {
+public:
+    /// Use GpuTimer::create()
+    explicit GpuTimer(size_t frameLatency);
+    virtual ~GpuTimer() noexcept;
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    /// Creates a timer.
+    /// @param[in] frameLatency The number of frames to wait before reading the results of a frame.
+    ///                         Must be less than FrameProfiler::HISTORY or the results are dropped.
+    static shared_ptr<GpuTimer> create(size_t frameLatency = 4);
+
+    /// Reads the results of the oldest frame and starts recording the current frame.
+    /// Call once per frame after FrameProfiler::beginFrame() and before any scope.
+    void beginFrame();
+
+    /// Begins a scope. The name must be a string literal or live until the results are read.
+    void begin(const char* name);
+
+    /// Ends the last scope that was begun.
+    void end();
+
+    /// Returns the number of frames whose results were discarded because they weren't ready in time.
+    size_t droppedFrames() const;
+
+    /// Begins a scope when constructed and ends it when destroyed.
+    class Scope final {
+    public:
+        Scope(GpuTimer& timer, const char* name) : _timer(timer) {
+            _timer.begin(name);
+        }
+        ~Scope() {
+            _timer.end();
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        GpuTimer& _timer;
+    };
+
+private:
+    struct Query {
+        const char* name = nullptr;
+        GLuint begin = 0;
+        GLuint end = 0;
+    };
+
+    struct Frame {
+        uint64_t number = 0;
+        /// The query pairs are kept between frames so they are only created once.
+        std::vector<Query> queries;
+        size_t used = 0;
+    };
+
+    /// Reads the results of the frame if they are available and releases its queries.
+    void collect(Frame& frame);
+
+private:
+    std::vector<Frame> _frames;
+    Frame* _current = nullptr;
+    std::vector<size_t> _open;
+    size_t _droppedFrames = 0;
+};
+
+} // namespace gl
+} // namespace kepler
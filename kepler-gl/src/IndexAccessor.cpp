@@ -31,5 +31,9 @@ GLenum IndexAccessor::type() const {
 GLintptr IndexAccessor::offset() const {
     return _offset;
 }
+
+const shared_ptr<IndexBuffer>& IndexAccessor::buffer() const {
+    return _buffer;
+}
 }
 }
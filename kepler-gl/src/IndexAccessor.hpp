@@ -32,6 +32,8 @@ public:
     GLsizei count() const;
     GLenum type() const;
     GLintptr offset() const;
+    /// Returns the buffer that holds the indices.
+    const shared_ptr<IndexBuffer>& buffer() const;
 
 private:
     shared_ptr<IndexBuffer> _buffer;
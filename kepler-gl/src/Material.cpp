@@ -51,6 +51,17 @@ shared_ptr<MaterialParameter> Material::param(const std::string& name) const {
     return nullptr;
 }
 
+void Material::findTextures(std::vector<shared_ptr<Texture>>& textures) const {
+    for (const auto& p : _parameters) {
+        if (p.second->texture()) {
+            textures.push_back(p.second->texture());
+        }
+    }
+    if (_technique) {
+        _technique->findTextures(textures);
+    }
+}
+
 void Material::bind() {
     if (_technique) {
         _technique->bind();
@@ -5,6 +5,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace kepler {
 namespace gl {
@@ -33,6 +34,9 @@ public:
     /// Returns the MaterialParameter matching the given name.
     shared_ptr<MaterialParameter> param(const std::string& name) const;
 
+    /// Appends the textures used by the parameters of this material and its technique.
+    void findTextures(std::vector<shared_ptr<Texture>>& textures) const;
+
     void bind();
 
 private:
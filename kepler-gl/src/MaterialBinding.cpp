@@ -36,10 +36,12 @@ void MaterialBinding::bind(const Node& node, const Material& material) {
     }
 }
 
-void MaterialBinding::updateBindings(const Material& material) {
+void MaterialBinding::updateBindings(const Material& material, const mat4* positionTransform) {
+    _functions.clear();
     updateValues(material);
     auto tech = material.technique();
     auto effect = tech->effect();
+    tech->updateSemanticUniforms();
     for (const auto& semantic : tech->semantics()) {
         const shared_ptr<MaterialParameter>& materialParam = semantic.second;
         if (materialParam->uniform() == nullptr) {
@@ -49,11 +51,25 @@ void MaterialBinding::updateBindings(const Material& material) {
 
         switch (materialParam->semantic()) {
         case MaterialParameter::Semantic::LOCAL:
+            if (positionTransform) {
+                const mat4 transform = *positionTransform;
+                _functions.emplace_back([materialParam, transform](const Effect& effect, const Node& node, const Camera* camera) {
+                    effect.setValue(materialParam->uniform(), node.localTransform().matrix() * transform);
+                });
+                break;
+            }
             _functions.emplace_back([materialParam](const Effect& effect, const Node& node, const Camera* camera) {
                 effect.setValue(materialParam->uniform(), node.localTransform().matrix());
             });
             break;
         case MaterialParameter::Semantic::MODEL:
+            if (positionTransform) {
+                const mat4 transform = *positionTransform;
+                _functions.emplace_back([materialParam, transform](const Effect& effect, const Node& node, const Camera* camera) {
+                    effect.setValue(materialParam->uniform(), node.worldMatrix() * transform);
+                });
+                break;
+            }
             _functions.emplace_back([materialParam](const Effect& effect, const Node& node, const Camera* camera) {
                 effect.setValue(materialParam->uniform(), node.worldMatrix());
             });
@@ -69,11 +85,25 @@ void MaterialBinding::updateBindings(const Material& material) {
             });
             break;
         case MaterialParameter::Semantic::MODELVIEW:
+            if (positionTransform) {
+                const mat4 transform = *positionTransform;
+                _functions.emplace_back([materialParam, transform](const Effect& effect, const Node& node, const Camera* camera) {
+                    effect.setValue(materialParam->uniform(), node.modelViewMatrix(camera) * transform);
+                });
+                break;
+            }
             _functions.emplace_back([materialParam](const Effect& effect, const Node& node, const Camera* camera) {
                 effect.setValue(materialParam->uniform(), node.modelViewMatrix(camera));
             });
             break;
         case MaterialParameter::Semantic::MODELVIEWPROJECTION:
+            if (positionTransform) {
+                const mat4 transform = *positionTransform;
+                _functions.emplace_back([materialParam, transform](const Effect& effect, const Node& node, const Camera* camera) {
+                    effect.setValue(materialParam->uniform(), node.modelViewProjectionMatrix(camera) * transform);
+                });
+                break;
+            }
             _functions.emplace_back([materialParam](const Effect& effect, const Node& node, const Camera* camera) {
                 effect.setValue(materialParam->uniform(), node.modelViewProjectionMatrix(camera));
             });
@@ -24,7 +24,11 @@ public:
 
     void bind(const Node& node, const Material& material);
 
-    void updateBindings(const Material& material);
+    /// Creates the uniform bindings of the material.
+    /// @param[in] material          The material.
+    /// @param[in] positionTransform Transforms the vertex positions before the model matrix. May be null.
+    ///                              Used to dequantize positions without changing the shader.
+    void updateBindings(const Material& material, const mat4* positionTransform = nullptr);
 
 private:
     void updateValues(const Material& material);
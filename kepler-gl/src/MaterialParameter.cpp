@@ -28,46 +28,84 @@ void MaterialParameter::setValue(float value) {
     _function = [value](Effect& effect, const Uniform* uniform) {
         effect.setValue(uniform, value);
     };
+    _texture.reset();
+    _vector = vec4(value, 0, 0, 0);
+    _components = 1;
 }
 
 void MaterialParameter::setValue(int value) {
     _function = [value](Effect& effect, const Uniform* uniform) {
         effect.setValue(uniform, value);
     };
+    _texture.reset();
+    _components = 0;
 }
 
 void MaterialParameter::setValue(const mat4& value) {
     _function = [value](Effect& effect, const Uniform* uniform) {
         effect.setValue(uniform, value);
     };
+    _texture.reset();
+    _components = 0;
 }
 
 void MaterialParameter::setValue(const vec2& value) {
     _function = [value](Effect& effect, const Uniform* uniform) {
         effect.setValue(uniform, value);
     };
+    _texture.reset();
+    _vector = vec4(value, 0, 0);
+    _components = 2;
 }
 
 void MaterialParameter::setValue(const vec3& value) {
     _function = [value](Effect& effect, const Uniform* uniform) {
         effect.setValue(uniform, value);
     };
+    _texture.reset();
+    _vector = vec4(value, 0);
+    _components = 3;
 }
 
 void MaterialParameter::setValue(const vec4& value) {
     _function = [value](Effect& effect, const Uniform* uniform) {
         effect.setValue(uniform, value);
     };
+    _texture.reset();
+    _vector = value;
+    _components = 4;
 }
 
 void MaterialParameter::setValue(const FunctionBinding& func) {
     _function = func;
+    _texture.reset();
+    _components = 0;
 }
 
 void MaterialParameter::setValue(const shared_ptr<Texture>& texture) {
     _function = [texture](Effect& effect, const Uniform* uniform) {
         effect.setTexture(uniform, texture);
     };
+    _texture = texture;
+    _components = 0;
+}
+
+void MaterialParameter::setBindlessTexture(const shared_ptr<Texture>& texture) {
+    _function = [texture](Effect& effect, const Uniform* uniform) {
+        // The handle changes once when the texture stops using its placeholder.
+        effect.setTextureHandle(uniform, texture->bindlessHandle());
+    };
+    _texture = texture;
+    _components = 0;
+}
+
+const shared_ptr<Texture>& MaterialParameter::texture() const {
+    return _texture;
+}
+
+int MaterialParameter::vectorValue(vec4& value) const {
+    value = _components > 0 ? _vector : vec4(0);
+    return _components;
 }
 
 MaterialParameter::Semantic MaterialParameter::semantic() const {
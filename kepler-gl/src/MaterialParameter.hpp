@@ -61,6 +61,17 @@ public:
     void setValue(const FunctionBinding& func);
     void setValue(const shared_ptr<Texture>& texture);
 
+    /// Sets the value to the bindless handle of the texture. The uniform must be a layout(bindless_sampler) sampler.
+    /// Requires GL_ARB_bindless_texture; see bindless::supported().
+    void setBindlessTexture(const shared_ptr<Texture>& texture);
+
+    /// Returns the texture if the value was set to a texture; null otherwise.
+    const shared_ptr<Texture>& texture() const;
+
+    /// Gets the value if it was set to a float or a vector. The unused components are 0.
+    /// @return The number of components or 0 if the value is something else.
+    int vectorValue(vec4& value) const;
+
     Semantic semantic() const;
     void setSemantic(Semantic semantic);
 
@@ -80,6 +91,10 @@ private:
     Uniform* _uniform;
 
     std::function<void(Effect&, const Uniform* uniform)> _function;
+    shared_ptr<Texture> _texture;
+    // A copy of float and vector values so they can be read back. The closure can't be inspected.
+    vec4 _vector;
+    int _components = 0;
 };
 
 template<typename T>
@@ -58,10 +58,56 @@ const BoundingBox& Mesh::boundingBox() const {
     return _box;
 }
 
+void Mesh::addLod(const shared_ptr<Mesh>& lod, float screenSize) {
+    _lods.push_back(lod);
+    _lodScreenSizes.push_back(screenSize);
+    updateSelectionThresholds();
+}
+
+size_t Mesh::lodCount() const {
+    return _lods.size();
+}
+
+shared_ptr<Mesh> Mesh::lodAt(size_t index) const {
+    return _lods.at(index);
+}
+
+Mesh* Mesh::lodPtr(size_t index) const {
+    return _lods[index].get();
+}
+
+const std::vector<float>& Mesh::lodScreenSizes() const {
+    return _lodScreenSizes;
+}
+
+void Mesh::setCullScreenSize(float screenSize) {
+    _cullScreenSize = screenSize;
+    updateSelectionThresholds();
+}
+
+float Mesh::cullScreenSize() const {
+    return _cullScreenSize;
+}
+
+const std::vector<float>& Mesh::selectionThresholds() const {
+    return _selectionThresholds;
+}
+
+void Mesh::updateSelectionThresholds() {
+    _selectionThresholds = _lodScreenSizes;
+    if (_cullScreenSize > 0.0f) {
+        // The cull size acts as one more level that draws nothing.
+        _selectionThresholds.push_back(_cullScreenSize);
+    }
+}
+
 void Mesh::setNode(const shared_ptr<Node>& node) {
     for (const auto& primitive : _primitives) {
         primitive->setNode(node);
     }
+    for (const auto& lod : _lods) {
+        lod->setNode(node);
+    }
 }
 }
 }
@@ -40,16 +40,47 @@ public:
 
     const BoundingBox& Mesh::boundingBox() const;
 
+    /// Adds a lower detail version of this mesh. LODs must be added from the most to the least detailed.
+    /// @param[in] lod        The mesh that is drawn instead of this one.
+    /// @param[in] screenSize The LOD is drawn when the screen size of the mesh is below this value.
+    ///                       This is always the diameter of the bounding sphere as a fraction of the viewport height
+    ///                       from LodSelector::screenSize(). Convert screen area fractions with
+    ///                       LodSelector::screenSizeFromCoverage().
+    void addLod(const shared_ptr<Mesh>& lod, float screenSize);
+
+    /// Returns the number of LODs, not counting this mesh.
+    size_t lodCount() const;
+
+    /// Returns the LOD at the given index. Index 0 is the most detailed LOD after this mesh.
+    shared_ptr<Mesh> lodAt(size_t index) const;
+    Mesh* lodPtr(size_t index) const;
+
+    /// Returns the screen size thresholds of the LODs. There is one threshold per LOD.
+    const std::vector<float>& lodScreenSizes() const;
+
+    /// Sets the screen size below which the mesh is not drawn at all. Zero disables culling.
+    void setCullScreenSize(float screenSize);
+    float cullScreenSize() const;
+
+    /// Returns the thresholds that LodSelector::select() picks a level from: the LOD screen sizes followed by the
+    /// cull screen size if culling is enabled. A level past the last LOD means the mesh is culled.
+    const std::vector<float>& selectionThresholds() const;
+
     Mesh(const Mesh&) = delete;
     Mesh& operator=(const Mesh&) = delete;
 
 private:
 
     void setNode(const shared_ptr<Node>& node);
+    void updateSelectionThresholds();
 
     std::vector<shared_ptr<MeshPrimitive>> _primitives;
     //std::unique_ptr<std::string> _name;
     BoundingBox _box;
+    std::vector<shared_ptr<Mesh>> _lods;
+    std::vector<float> _lodScreenSizes;
+    float _cullScreenSize = 0.0f;
+    std::vector<float> _selectionThresholds;
 };
 }
 }
@@ -6,6 +6,7 @@
 #include "VertexAttributeAccessor.hpp"
 #include "VertexAttributeBinding.hpp"
 #include "IndexAccessor.hpp"
+#include "GLStats.hpp"
 
 namespace kepler {
 namespace gl {
@@ -17,6 +18,20 @@ shared_ptr<MeshPrimitive> MeshPrimitive::create(Mode mode) {
     return std::make_shared<MeshPrimitive>(mode);
 }
 
+shared_ptr<MeshPrimitive> MeshPrimitive::createWithIndices(const shared_ptr<IndexAccessor>& indices) const {
+    auto prim = MeshPrimitive::create(_mode);
+    prim->_attributes = _attributes;
+    prim->_indices = indices;
+    prim->_box = _box;
+    prim->_positionTransform = _positionTransform;
+    prim->_hasPositionTransform = _hasPositionTransform;
+    if (_material) {
+        // creates the vertex binding for the new indices
+        prim->setMaterial(_material);
+    }
+    return prim;
+}
+
 shared_ptr<VertexAttributeAccessor> MeshPrimitive::attribute(AttributeSemantic semantic) const {
     auto it = _attributes.find(semantic);
     if (it != _attributes.end()) {
@@ -43,6 +58,14 @@ void MeshPrimitive::setIndices(const shared_ptr<IndexAccessor>& indices) {
     _indices = indices;
 }
 
+shared_ptr<IndexAccessor> MeshPrimitive::indices() const {
+    return _indices;
+}
+
+MeshPrimitive::Mode MeshPrimitive::mode() const {
+    return _mode;
+}
+
 shared_ptr<Material> MeshPrimitive::material() const {
     return _material;
 }
@@ -74,6 +97,13 @@ void MeshPrimitive::setMaterial(const shared_ptr<Material>& material) {
     // TODO should this be a weak reference?
     // should attributes be in another object? A geometry?
     _material = material;
+    if (!effect->ready()) {
+        // The bindings are created by draw() once the effect has finished compiling.
+        _effectPending = true;
+        _vertexBinding = VertexAttributeBinding();
+        return;
+    }
+    _effectPending = false;
     _vertexBinding = VertexAttributeBinding(*this, *tech, *effect);
     updateBindings();
 }
@@ -86,7 +116,22 @@ void MeshPrimitive::setBoundingBox(const vec3& min, const vec3& max) {
     _box.set(min, max);
 }
 
+void MeshPrimitive::setPositionTransform(const mat4& transform) {
+    _positionTransform = transform;
+    _hasPositionTransform = true;
+    if (_materialBinding) {
+        updateBindings();
+    }
+}
+
+const mat4& MeshPrimitive::positionTransform() const {
+    return _positionTransform;
+}
+
 void MeshPrimitive::draw() {
+    if (_effectPending && !updatePendingEffect()) {
+        return;
+    }
     auto node = _node.lock();
     if (!_vertexBinding || !node) {
         return;
@@ -95,11 +140,13 @@ void MeshPrimitive::draw() {
     _materialBinding->bind(*node, material);
     _vertexBinding.bind();
     if (_indices) {
+        KEPLER_GL_COUNT(DRAW_CALLS);
         glDrawElements(_mode, _indices->count(), _indices->type(), (const GLvoid*)_indices->offset());
     }
     else {
         auto attrib = _attributes.begin();
         if (attrib != _attributes.end()) {
+            KEPLER_GL_COUNT(DRAW_CALLS);
             glDrawArrays(_mode, 0, attrib->second->count());
         }
     }
@@ -114,7 +161,19 @@ void MeshPrimitive::updateBindings() {
     if (_materialBinding == nullptr) {
         _materialBinding = std::make_unique<MaterialBinding>();
     }
-    _materialBinding->updateBindings(*_material);
+    _materialBinding->updateBindings(*_material, _hasPositionTransform ? &_positionTransform : nullptr);
+}
+
+bool MeshPrimitive::updatePendingEffect() {
+    auto tech = _material->technique();
+    auto effect = tech->effect();
+    if (!effect->ready()) {
+        return false;
+    }
+    _effectPending = false;
+    _vertexBinding = VertexAttributeBinding(*this, *tech, *effect);
+    updateBindings();
+    return true;
 }
 
 void MeshPrimitive::setNode(const shared_ptr<Node>& node) {
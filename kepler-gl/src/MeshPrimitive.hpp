@@ -33,6 +33,11 @@ public:
 
     static shared_ptr<MeshPrimitive> create(Mode mode);
 
+    /// Creates a primitive that shares the attributes and material of this primitive but draws the given indices.
+    /// Used for levels of detail that reuse the vertex buffers of the original primitive.
+    /// @param[in] indices The indices to draw.
+    shared_ptr<MeshPrimitive> createWithIndices(const shared_ptr<IndexAccessor>& indices) const;
+
     /// Returns the attribute with the given semantic. May be null.
     shared_ptr<VertexAttributeAccessor> attribute(AttributeSemantic semantic) const;
 
@@ -45,6 +50,11 @@ public:
     void setAttribute(AttributeSemantic semantic, const shared_ptr<VertexAttributeAccessor>& accessor);
     /// Sets the IndexAccessor.
     void setIndices(const shared_ptr<IndexAccessor>& indices);
+    /// Returns the IndexAccessor. May be null.
+    shared_ptr<IndexAccessor> indices() const;
+
+    /// Returns the primitive mode.
+    Mode mode() const;
 
     /// Returns the material this primitive is bound to. May return null.
     shared_ptr<Material> material() const;
@@ -56,10 +66,20 @@ public:
 
     void setBoundingBox(const vec3& min, const vec3& max);
 
+    /// Sets the matrix that transforms the position attribute to model space.
+    /// Quantized positions are stored relative to the bounding box and this matrix scales them back.
+    /// The matrix is folded into the LOCAL, MODEL, MODELVIEW and MODELVIEWPROJECTION uniforms.
+    void setPositionTransform(const mat4& transform);
+
+    /// Returns the position transform. Identity unless setPositionTransform() was called.
+    const mat4& positionTransform() const;
+
     void draw();
 
 private:
     void updateBindings();
+    /// Creates the bindings if the effect finished compiling. Returns false if it is still compiling.
+    bool updatePendingEffect();
     void setNode(const shared_ptr<Node>& node);
 
 private:
@@ -72,6 +92,9 @@ private:
     VertexAttributeBinding _vertexBinding;
     std::weak_ptr<Node> _node;
     BoundingBox _box;
+    mat4 _positionTransform;
+    bool _hasPositionTransform = false;
+    bool _effectPending = false;
 };
 
 } // namespace gl
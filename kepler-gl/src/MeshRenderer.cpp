@@ -2,6 +2,9 @@
 #include "MeshRenderer.hpp"
 #include "Mesh.hpp"
 #include "MeshPrimitive.hpp"
+#include "Node.hpp"
+#include "Scene.hpp"
+#include "Camera.hpp"
 
 namespace kepler {
 namespace gl {
@@ -17,9 +20,13 @@ shared_ptr<MeshRenderer> MeshRenderer::create(const shared_ptr<Mesh>& mesh) {
 
 void MeshRenderer::draw() {
     if (_mesh) {
-        size_t count = _mesh->primitiveCount();
+        Mesh* mesh = selectLod();
+        if (mesh == nullptr) {
+            return;
+        }
+        size_t count = mesh->primitiveCount();
         for (size_t i = 0; i < count; ++i) {
-            _mesh->primitivePtr(i)->draw();
+            mesh->primitivePtr(i)->draw();
         }
     }
 }
@@ -42,6 +49,38 @@ bool MeshRenderer::getBoundingBox(BoundingBox& box) {
     return false;
 }
 
+void MeshRenderer::setLodHysteresis(float hysteresis) {
+    _lodSelector.setHysteresis(hysteresis);
+}
+
+size_t MeshRenderer::lodLevel() const {
+    return _lodSelector.level();
+}
+
+Mesh* MeshRenderer::selectLod() {
+    const size_t lodCount = _mesh->lodCount();
+    const float cullScreenSize = _mesh->cullScreenSize();
+    if (lodCount == 0 && cullScreenSize <= 0.0f) {
+        return _mesh.get();
+    }
+    auto node = this->node();
+    Scene* scene = node ? node->scene() : nullptr;
+    auto camera = scene ? scene->activeCamera() : nullptr;
+    if (!camera) {
+        return _mesh.get();
+    }
+    BoundingBox box = _mesh->boundingBox();
+    box.transform(node->worldMatrix());
+    const float screenSize = LodSelector::screenSize(box, *camera);
+
+    const auto& thresholds = _mesh->selectionThresholds();
+    const size_t level = _lodSelector.select(screenSize, thresholds.data(), thresholds.size());
+    if (level > lodCount) {
+        return nullptr;
+    }
+    return level == 0 ? _mesh.get() : _mesh->lodPtr(level - 1);
+}
+
 const std::string& MeshRenderer::typeName() const {
     static std::string typeName("MeshRenderer");
     return typeName;
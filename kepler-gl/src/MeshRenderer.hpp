@@ -3,6 +3,7 @@
 #include <BaseGL.hpp>
 #include "DrawableComponent.hpp"
 #include <Bounded.hpp>
+#include <LodSelector.hpp>
 
 namespace kepler {
 namespace gl {
@@ -10,6 +11,8 @@ namespace gl {
 class Mesh;
 
 // DrawableComponent for rendering a Mesh.
+// If the mesh has levels of detail then the level is selected from the screen size of the mesh
+// as seen by the active camera of the scene.
 class MeshRenderer : public virtual DrawableComponent, public Bounded {
 public:
     /// Use MeshRenderer::create()
@@ -25,6 +28,13 @@ public:
     /// Returns the shared_ptr to the mesh.
     shared_ptr<Mesh> mesh() const;
 
+    /// Sets the hysteresis used when switching between levels of detail. See LodSelector::setHysteresis().
+    void setLodHysteresis(float hysteresis);
+
+    /// Returns the level of detail drawn by the last call to draw().
+    /// 0 is the mesh itself and lodCount() + 1 means the mesh was culled.
+    size_t lodLevel() const;
+
     /// Gets the boundings box if found.
     bool getBoundingBox(BoundingBox& box) override;
 
@@ -34,9 +44,14 @@ public:
     MeshRenderer(const MeshRenderer&) = delete;
     MeshRenderer& operator=(const MeshRenderer&) = delete;
 
+private:
+    /// Returns the mesh to draw for the current level of detail. Returns null if the mesh is culled.
+    Mesh* selectLod();
+
 private:
     // for now, only have 1 mesh per renderer
     shared_ptr<Mesh> _mesh;
+    LodSelector _lodSelector;
 };
 }
 }
@@ -113,6 +113,26 @@ shared_ptr<MeshPrimitive> createWireframeBoxPrimitive(const BoundingBox& box) {
     prim->setIndices(indexAccessor);
     return prim;
 }
+void optimizeMesh(std::vector<GLfloat>& vertices, size_t vertexSize, size_t positionOffset, std::vector<GLuint>& indices,
+    VertexCacheStats* before, VertexCacheStats* after) {
+    const size_t vertexCount = vertices.size() / vertexSize;
+    if (before) {
+        *before = analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+    }
+    std::vector<uint32_t> clusters;
+    auto cacheOptimized = optimizeVertexCache(indices.data(), indices.size(), vertexCount, 16, &clusters);
+    indices = optimizeOverdraw(cacheOptimized.data(), cacheOptimized.size(), &vertices[positionOffset], vertexCount,
+        vertexSize * sizeof(GLfloat), clusters);
+
+    size_t uniqueCount = 0;
+    auto remap = optimizeVertexFetch(indices.data(), indices.size(), vertexCount, uniqueCount);
+    std::vector<GLfloat> remapped(uniqueCount * vertexSize);
+    remapVertices(remapped.data(), vertices.data(), vertexCount, vertexSize * sizeof(GLfloat), 0, remap);
+    vertices.swap(remapped);
+    if (after) {
+        *after = analyzeVertexCache(indices.data(), indices.size(), uniqueCount);
+    }
+}
 
 }
 }
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include <BaseGL.hpp>
 #include <OpenGL.hpp>
 #include <BaseMath.hpp>
+#include <MeshOptimizer.hpp>
+
+#include <vector>
 
 namespace kepler {
 namespace gl {
@@ -16,5 +19,16 @@ shared_ptr<MeshPrimitive> createTexturedLitQuadPrimitive(vec2 maxTexCoords);
 
 shared_ptr<MeshPrimitive> createWireframeBoxPrimitive(const BoundingBox& box);
 
+/// Optimizes an indexed triangle list for the post transform vertex cache, overdraw and vertex fetch.
+/// Call this on procedurally built geometry before creating its buffers.
+/// @param[in,out] vertices       Interleaved vertex data. Vertices that are not used are removed.
+/// @param[in]     vertexSize     The number of floats per vertex.
+/// @param[in]     positionOffset The offset of the position from the start of a vertex in floats.
+/// @param[in,out] indices        Triangle list indices.
+/// @param[out]    before         The vertex cache statistics before optimizing. May be null.
+/// @param[out]    after          The vertex cache statistics after optimizing. May be null.
+void optimizeMesh(std::vector<GLfloat>& vertices, size_t vertexSize, size_t positionOffset, std::vector<GLuint>& indices,
+    VertexCacheStats* before = nullptr, VertexCacheStats* after = nullptr);
+
 } // namespace gl
 } // namespace kepler
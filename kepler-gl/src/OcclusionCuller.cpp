@@ -0,0 +1,303 @@
+#include "stdafx.h"
+#include "OcclusionCuller.hpp"
+#include "Effect.hpp"
+#include "Scene.hpp"
+#include "Node.hpp"
+#include "Camera.hpp"
+#include "DrawableComponent.hpp"
+#include "OcclusionBuffer.hpp"
+
+#include <array>
+
+namespace kepler {
+namespace gl {
+
+static constexpr GLuint POSITION_INDEX = 0;
+
+static constexpr char* proxyVertSource =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 a_position;\n"
+    "uniform mat4 u_mvp;\n"
+    "void main() {\n"
+    "    gl_Position = u_mvp * vec4(a_position, 1.0);\n"
+    "}\n";
+
+static constexpr char* proxyFragSource =
+    "#version 330 core\n"
+    "out vec4 color;\n"
+    "void main() {\n"
+    "    color = vec4(1.0);\n"
+    "}\n";
+
+/// Returns true if the point is inside the box after growing the box by the given margin.
+static bool contains(const BoundingBox& box, const vec3& p, float margin) {
+    return p.x >= box.min.x - margin && p.x <= box.max.x + margin
+        && p.y >= box.min.y - margin && p.y <= box.max.y + margin
+        && p.z >= box.min.z - margin && p.z <= box.max.z + margin;
+}
+
+OcclusionCuller::OcclusionCuller() {
+    // The proxy only writes to the query, never to the color or depth buffers.
+    _proxyState.setColorMask(false, false, false, false);
+    _proxyState.setDepthMask(false);
+    _proxyState.setDepthTest(true);
+    _proxyState.setDepthFunc(GL_LEQUAL);
+    _proxyState.setCulling(false);
+}
+
+OcclusionCuller::~OcclusionCuller() noexcept {
+    clear();
+    glDeleteVertexArrays(1, &_vao);
+    glDeleteBuffers(1, &_vbo);
+    glDeleteBuffers(1, &_ibo);
+}
+
+shared_ptr<OcclusionCuller> OcclusionCuller::create() {
+    return std::make_shared<OcclusionCuller>();
+}
+
+void OcclusionCuller::drawScene(const Scene& scene) {
+    auto camera = scene.activeCamera();
+    if (!camera) {
+        return;
+    }
+    if (_vao == 0) {
+        createProxy();
+    }
+    ++_frame;
+    _stats = Stats();
+    _latencySum = 0;
+    _latencyCount = 0;
+
+    const mat4& viewProjection = camera->viewProjectionMatrix();
+    const vec3 eye = vec3(glm::inverse(camera->viewMatrix())[3]);
+    collect(scene, eye);
+    if (_occlusionBuffer) {
+        _occlusionBuffer->wait();
+    }
+
+    // Front to back so near occluders are in the depth buffer before far objects are tested.
+    std::sort(_items.begin(), _items.end(), [](const DrawItem& a, const DrawItem& b) {
+        return a.distance < b.distance;
+    });
+
+    const float nearMargin = camera->near() * 2.f;
+    for (auto& item : _items) {
+        Entry& entry = *item.entry;
+        if (entry.pending) {
+            fetchResult(entry);
+        }
+
+        // The proxy would be clipped by the near plane if the camera is inside the box.
+        if (contains(item.box, eye, nearMargin)) {
+            entry.visible = true;
+            item.drawable->draw();
+            ++_stats.objectsRendered;
+            continue;
+        }
+
+        if (_occlusionBuffer && !_occlusionBuffer->isVisible(item.box)) {
+            ++_stats.objectsSkipped;
+            ++_stats.softwareCulled;
+            continue;
+        }
+        if (!_hardwareQueries) {
+            item.drawable->draw();
+            ++_stats.objectsRendered;
+            continue;
+        }
+
+        if (entry.visible) {
+            bool retest = !entry.pending && _frame - entry.lastTestedFrame >= _visibleInterval;
+            if (retest) {
+                // Wrap the real draw in a query. Costs nothing extra since the object is being drawn anyway.
+                glBeginQuery(GL_ANY_SAMPLES_PASSED, entry.query);
+                item.drawable->draw();
+                glEndQuery(GL_ANY_SAMPLES_PASSED);
+                entry.pending = true;
+                entry.issuedFrame = _frame;
+                entry.lastTestedFrame = _frame;
+                ++_stats.queriesIssued;
+            }
+            else {
+                item.drawable->draw();
+            }
+            ++_stats.objectsRendered;
+        }
+        else {
+            // Occluded last time it was tested. Keep testing the proxy until it shows up again.
+            if (!entry.pending) {
+                _proxyEffect->bind();
+                _proxyState.bind();
+                glBeginQuery(GL_ANY_SAMPLES_PASSED, entry.query);
+                drawProxy(item.box, viewProjection);
+                glEndQuery(GL_ANY_SAMPLES_PASSED);
+                entry.pending = true;
+                entry.issuedFrame = _frame;
+                entry.lastTestedFrame = _frame;
+                ++_stats.queriesIssued;
+            }
+            // The draw is conditional on the query that is in flight, whether it was issued this frame or earlier.
+            if (_conditionalRender && entry.pending) {
+                glBeginConditionalRender(entry.query, GL_QUERY_NO_WAIT);
+                item.drawable->draw();
+                glEndConditionalRender();
+            }
+            ++_stats.objectsSkipped;
+        }
+    }
+
+    for (const auto& entry : _entries) {
+        if (entry.second.pending) {
+            ++_stats.queriesPending;
+        }
+    }
+    if (_latencyCount > 0) {
+        _stats.averageLatency = static_cast<float>(_latencySum) / static_cast<float>(_latencyCount);
+    }
+}
+
+void OcclusionCuller::setVisibleQueryInterval(unsigned int frames) {
+    _visibleInterval = std::max(1u, frames);
+}
+
+void OcclusionCuller::setConditionalRender(bool enabled) {
+    _conditionalRender = enabled;
+}
+
+void OcclusionCuller::setOcclusionBuffer(const shared_ptr<OcclusionBuffer>& buffer) {
+    _occlusionBuffer = buffer;
+}
+
+void OcclusionCuller::setHardwareQueries(bool enabled) {
+    _hardwareQueries = enabled;
+}
+
+const OcclusionCuller::Stats& OcclusionCuller::stats() const {
+    return _stats;
+}
+
+void OcclusionCuller::clear() {
+    for (auto& entry : _entries) {
+        glDeleteQueries(1, &entry.second.query);
+    }
+    _entries.clear();
+    _items.clear();
+}
+
+void OcclusionCuller::collect(const Scene& scene, const vec3& eye) {
+    _items.clear();
+    const unsigned int frame = _frame;
+    scene.visit([this, &eye, frame](Node* node) {
+        auto drawable = node->drawable();
+        if (!drawable) {
+            return;
+        }
+        const BoundingBox& box = node->boundingBox();
+        auto it = _entries.find(node);
+        if (it != _entries.end() && it->second.node.expired()) {
+            // The node was deleted and this is a new node at the same address.
+            glDeleteQueries(1, &it->second.query);
+            _entries.erase(it);
+            it = _entries.end();
+        }
+        if (it == _entries.end()) {
+            it = _entries.emplace(node, Entry()).first;
+            it->second.node = node->shared_from_this();
+            glGenQueries(1, &it->second.query);
+            // Spread the re-tests of visible objects across frames.
+            it->second.lastTestedFrame = frame - static_cast<unsigned int>(_entries.size() % _visibleInterval);
+        }
+        Entry& entry = it->second;
+        entry.touchedFrame = frame;
+        if (box.empty()) {
+            // Nothing to test against; always draw it.
+            drawable->draw();
+            ++_stats.objectsRendered;
+            return;
+        }
+        vec3 d = box.center() - eye;
+        _items.push_back({node, drawable.get(), &entry, box, glm::dot(d, d)});
+    });
+
+    // Forget nodes that are no longer in the scene.
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        if (it->second.touchedFrame != frame) {
+            glDeleteQueries(1, &it->second.query);
+            it = _entries.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+bool OcclusionCuller::readQuery(GLuint query, GLuint& samples) {
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_FALSE) {
+        return false;
+    }
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT, &samples);
+    return true;
+}
+
+void OcclusionCuller::fetchResult(Entry& entry) {
+    GLuint samples = 0;
+    if (!readQuery(entry.query, samples)) {
+        // Keep using the previous visibility instead of waiting on the GPU.
+        return;
+    }
+    entry.visible = samples != 0;
+    entry.pending = false;
+    _latencySum += _frame - entry.issuedFrame;
+    ++_latencyCount;
+}
+
+void OcclusionCuller::drawProxy(const BoundingBox& box, const mat4& viewProjection) {
+    // The proxy is a unit cube that is scaled and translated to the world space box.
+    mat4 model = glm::translate(box.min) * glm::scale(box.max - box.min);
+    _proxyEffect->setValue(_mvpLocation, viewProjection * model);
+    glBindVertexArray(_vao);
+    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, 0);
+    glBindVertexArray(0);
+}
+
+void OcclusionCuller::createProxy() {
+    _proxyEffect = Effect::createFromSource(proxyVertSource, proxyFragSource);
+    _mvpLocation = _proxyEffect->getUniformLocation("u_mvp");
+
+    static constexpr std::array<GLfloat, 24> vertices = {
+        0, 0, 0,
+        1, 0, 0,
+        1, 1, 0,
+        0, 1, 0,
+        0, 0, 1,
+        1, 0, 1,
+        1, 1, 1,
+        0, 1, 1,
+    };
+    static constexpr std::array<GLubyte, 36> indices = {
+        0, 2, 1, 0, 3, 2, // back
+        4, 5, 6, 4, 6, 7, // front
+        0, 1, 5, 0, 5, 4, // bottom
+        3, 7, 6, 3, 6, 2, // top
+        0, 4, 7, 0, 7, 3, // left
+        1, 2, 6, 1, 6, 5  // right
+    };
+    glGenVertexArrays(1, &_vao);
+    glGenBuffers(1, &_vbo);
+    glGenBuffers(1, &_ibo);
+    glBindVertexArray(_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(POSITION_INDEX);
+    glVertexAttribPointer(POSITION_INDEX, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+} // namespace gl
+} // namespace kepler
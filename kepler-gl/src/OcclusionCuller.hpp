@@ -0,0 +1,131 @@
+#pragma once
+
+#include <BaseGL.hpp>
+#include <OpenGL.hpp>
+#include <BaseMath.hpp>
+#include <BoundingBox.hpp>
+#include "RenderState.hpp"
+
+#include <vector>
+#include <unordered_map>
+
+namespace kepler {
+namespace gl {
+
+/// OcclusionCuller draws the drawables of a scene and skips the ones that are hidden behind other geometry.
+///
+/// Visibility is determined with hardware occlusion queries in the style of CHC++:
+/// - Query results are read back in later frames so the CPU never waits on the GPU.
+/// - Objects that were visible last frame are drawn and only re-queried every few frames.
+/// - Objects that were occluded last frame are not drawn; their world space bounding box
+///   is rasterized with a cheap proxy shader (no color or depth writes) to find out when they become visible again.
+///
+/// Drawables are sorted front to back so that near objects fill the depth buffer before far objects are tested.
+///
+/// An OcclusionBuffer can be added to reject objects on the CPU before any queries are issued.
+class OcclusionCuller {
+public:
+    /// Statistics for the last frame drawn with drawScene().
+    struct Stats {
+        /// Number of occlusion queries issued this frame.
+        size_t queriesIssued = 0;
+        /// Number of drawables that were not drawn because they were occluded.
+        size_t objectsSkipped = 0;
+        /// Number of the skipped drawables that were rejected by the OcclusionBuffer.
+        size_t softwareCulled = 0;
+        /// Number of drawables that were drawn.
+        size_t objectsRendered = 0;
+        /// Number of queries whose results were still not available this frame.
+        size_t queriesPending = 0;
+        /// Average number of frames between issuing a query and reading its result.
+        float averageLatency = 0.f;
+    };
+
+    /// Use OcclusionCuller::create()
+    OcclusionCuller();
+    virtual ~OcclusionCuller() noexcept;
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    static shared_ptr<OcclusionCuller> create();
+
+    /// Draws every drawable component in the scene using the active camera of the scene.
+    /// Occluded drawables are skipped based on the query results from previous frames.
+    void drawScene(const Scene& scene);
+
+    /// Sets the number of frames to wait before re-testing an object that was visible.
+    /// Larger values issue fewer queries but take longer to detect newly occluded objects.
+    void setVisibleQueryInterval(unsigned int frames);
+
+    /// Enables drawing occluded objects with glBeginConditionalRender instead of skipping them outright.
+    /// While the proxy query of an object is in flight, the GPU discards the draw if the query found no samples.
+    /// Uses GL_QUERY_NO_WAIT so the GPU will never stall waiting for the result.
+    void setConditionalRender(bool enabled);
+
+    /// Sets the software occlusion buffer that is tested before the hardware queries. May be null.
+    /// drawScene() waits for OcclusionBuffer::renderAsync() to finish before testing against it.
+    void setOcclusionBuffer(const shared_ptr<OcclusionBuffer>& buffer);
+
+    /// Enables or disables the hardware occlusion queries.
+    /// When disabled, only the OcclusionBuffer is used and there is no readback latency.
+    void setHardwareQueries(bool enabled);
+
+    /// Returns the statistics of the last frame.
+    const Stats& stats() const;
+
+    /// Deletes all of the queries and forgets the visibility history.
+    void clear();
+
+protected:
+    /// Reads the result of a query without waiting for the GPU.
+    /// Virtual so the tests can decide when results become available.
+    /// @param[out] samples Nonzero if any samples passed.
+    /// @return False if the result is not available yet.
+    virtual bool readQuery(GLuint query, GLuint& samples);
+
+private:
+    struct Entry {
+        /// The node the entry was made for. A new node can be allocated at the address of a deleted one.
+        std::weak_ptr<const Node> node;
+        GLuint query = 0;
+        bool visible = true;
+        bool pending = false;
+        unsigned int issuedFrame = 0;
+        unsigned int lastTestedFrame = 0;
+        unsigned int touchedFrame = 0;
+    };
+
+    struct DrawItem {
+        Node* node;
+        DrawableComponent* drawable;
+        Entry* entry;
+        BoundingBox box;
+        float distance;
+    };
+
+    void collect(const Scene& scene, const vec3& eye);
+    void fetchResult(Entry& entry);
+    void drawProxy(const BoundingBox& box, const mat4& viewProjection);
+    void createProxy();
+
+private:
+    std::unordered_map<const Node*, Entry> _entries;
+    std::vector<DrawItem> _items;
+    shared_ptr<OcclusionBuffer> _occlusionBuffer;
+    shared_ptr<Effect> _proxyEffect;
+    GLint _mvpLocation = -1;
+    GLuint _vao = 0;
+    GLuint _vbo = 0;
+    GLuint _ibo = 0;
+    RenderState _proxyState;
+    unsigned int _frame = 0;
+    unsigned int _visibleInterval = 4;
+    bool _conditionalRender = false;
+    bool _hardwareQueries = true;
+    Stats _stats;
+    size_t _latencySum = 0;
+    size_t _latencyCount = 0;
+};
+
+} // namespace gl
+} // namespace kepler
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include <OpenGL.hpp>
 #include <iostream>
+#include <cstring>
 
 namespace kepler {
 namespace gl {
@@ -21,5 +22,40 @@ void replace_glad_callbacks() {
 #endif
 }
 
+bool hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension && strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace bindless {
+GetTextureHandleProc getTextureHandle = nullptr;
+GetTextureSamplerHandleProc getTextureSamplerHandle = nullptr;
+MakeTextureHandleResidentProc makeTextureHandleResident = nullptr;
+MakeTextureHandleResidentProc makeTextureHandleNonResident = nullptr;
+UniformHandleProc uniformHandle = nullptr;
+
+bool supported() {
+    return getTextureHandle && getTextureSamplerHandle && makeTextureHandleResident
+        && makeTextureHandleNonResident && uniformHandle;
+}
+} // namespace bindless
+
+void loadExtensions(GLADloadproc load) {
+    if (hasExtension("GL_ARB_bindless_texture")) {
+        bindless::getTextureHandle = reinterpret_cast<bindless::GetTextureHandleProc>(load("glGetTextureHandleARB"));
+        bindless::getTextureSamplerHandle = reinterpret_cast<bindless::GetTextureSamplerHandleProc>(load("glGetTextureSamplerHandleARB"));
+        bindless::makeTextureHandleResident = reinterpret_cast<bindless::MakeTextureHandleResidentProc>(load("glMakeTextureHandleResidentARB"));
+        bindless::makeTextureHandleNonResident = reinterpret_cast<bindless::MakeTextureHandleResidentProc>(load("glMakeTextureHandleNonResidentARB"));
+        bindless::uniformHandle = reinterpret_cast<bindless::UniformHandleProc>(load("glUniformHandleui64ARB"));
+    }
+}
+
 } // namespace gl
 } // namespace kepler
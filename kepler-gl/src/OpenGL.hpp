@@ -22,5 +22,28 @@ using ShaderHandle = GLuint;
 
 void replace_glad_callbacks();
 
+/// Returns true if the current context supports the extension. Like "GL_EXT_texture_compression_s3tc".
+bool hasExtension(const char* name);
+
+/// Loads the functions of the extensions that glad wasn't generated with. Call after gladLoadGLLoader().
+void loadExtensions(GLADloadproc load);
+
+/// GL_ARB_bindless_texture. The functions are null if the extension isn't supported.
+namespace bindless {
+using GetTextureHandleProc = GLuint64 (APIENTRY*)(GLuint texture);
+using GetTextureSamplerHandleProc = GLuint64 (APIENTRY*)(GLuint texture, GLuint sampler);
+using MakeTextureHandleResidentProc = void (APIENTRY*)(GLuint64 handle);
+using UniformHandleProc = void (APIENTRY*)(GLint location, GLuint64 value);
+
+extern GetTextureHandleProc getTextureHandle;
+extern GetTextureSamplerHandleProc getTextureSamplerHandle;
+extern MakeTextureHandleResidentProc makeTextureHandleResident;
+extern MakeTextureHandleResidentProc makeTextureHandleNonResident;
+extern UniformHandleProc uniformHandle;
+
+/// Returns true if bindless textures were loaded by loadExtensions().
+bool supported();
+} // namespace bindless
+
 } // namespace gl
 } // namespace kepler
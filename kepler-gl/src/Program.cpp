@@ -39,6 +39,16 @@ bool Program::link(const Shader& vert, const Shader& frag) const {
     return link();
 }
 
+void Program::linkAsync(const Shader& vert, const Shader& frag) const {
+    glAttachShader(_handle, vert);
+    glAttachShader(_handle, frag);
+    glLinkProgram(_handle);
+}
+
+bool Program::linked() const {
+    return getInt(GL_LINK_STATUS) != 0;
+}
+
 void Program::destroy() {
     if (_handle) {
         glDeleteProgram(_handle);
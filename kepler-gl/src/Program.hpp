@@ -31,6 +31,12 @@ public:
     bool link() const;
     bool link(const Shader& vert, const Shader& frag) const;
 
+    /// Attaches the shaders and starts linking without waiting for the result. Call linked() to get the result.
+    void linkAsync(const Shader& vert, const Shader& frag) const;
+
+    /// Returns true if the program linked successfully. Waits for the link to finish.
+    bool linked() const;
+
     void destroy();
 
     GLint getInt(GLenum pname) const;
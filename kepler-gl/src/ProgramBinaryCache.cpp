@@ -0,0 +1,155 @@
+#include "stdafx.h"
+#include "ProgramBinaryCache.hpp"
+#include "FileSystem.hpp"
+#include "Logging.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace kepler {
+namespace gl {
+
+// File layout: magic, format, key, binary length, binary.
+static constexpr uint32_t BINARY_MAGIC = 0x3142504B; // "KPB1"
+static constexpr size_t HEADER_SIZE = sizeof(uint32_t) * 2 + sizeof(uint64_t) + sizeof(uint32_t);
+
+static constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+static std::mutex __mutex;
+static std::string __directory;
+static ProgramBinaryCache::Stats __stats;
+
+/// FNV-1a hash. Includes the terminating zero so that consecutive strings can't run together.
+static uint64_t hashString(uint64_t hash, const char* str) {
+    if (str) {
+        for (; *str; ++str) {
+            hash = (hash ^ static_cast<unsigned char>(*str)) * FNV_PRIME;
+        }
+    }
+    return hash * FNV_PRIME;
+}
+
+static uint64_t hashString(uint64_t hash, const std::string& str) {
+    for (char c : str) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * FNV_PRIME;
+    }
+    return hash * FNV_PRIME;
+}
+
+void ProgramBinaryCache::setDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(__mutex);
+    __directory = directory;
+    if (!__directory.empty() && __directory.back() != '/' && __directory.back() != '\\') {
+        __directory.push_back('/');
+    }
+}
+
+bool ProgramBinaryCache::enabled() {
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+        if (__directory.empty()) {
+            return false;
+        }
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+uint64_t ProgramBinaryCache::key(const std::string& vertSource, const std::string& fragSource) {
+    uint64_t hash = FNV_OFFSET;
+    hash = hashString(hash, vertSource);
+    hash = hashString(hash, fragSource);
+    hash = hashString(hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+    hash = hashString(hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    hash = hashString(hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+    hash = hashString(hash, reinterpret_cast<const char*>(glGetString(GL_SHADING_LANGUAGE_VERSION)));
+    return hash;
+}
+
+Program ProgramBinaryCache::load(uint64_t key) {
+    const std::string filePath = path(key);
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<unsigned char> data;
+    if (!fileExists(filePath) || !readBinaryFile(filePath.c_str(), data) || data.size() < HEADER_SIZE) {
+        std::lock_guard<std::mutex> lock(__mutex);
+        ++__stats.misses;
+        return Program();
+    }
+    uint32_t magic;
+    uint32_t format;
+    uint64_t fileKey;
+    uint32_t length;
+    const unsigned char* p = data.data();
+    memcpy(&magic, p, sizeof(magic));
+    memcpy(&format, p + 4, sizeof(format));
+    memcpy(&fileKey, p + 8, sizeof(fileKey));
+    memcpy(&length, p + 16, sizeof(length));
+
+    Program program;
+    if (magic == BINARY_MAGIC && fileKey == key && length == data.size() - HEADER_SIZE) {
+        program = Program(glCreateProgram());
+        glProgramBinary(program, format, p + HEADER_SIZE, static_cast<GLsizei>(length));
+        if (program.getInt(GL_LINK_STATUS) == 0) {
+            program.destroy();
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::lock_guard<std::mutex> lock(__mutex);
+    if (!program) {
+        // The file is corrupt or the driver changed in a way the key didn't catch. Compile it again.
+        ++__stats.rejected;
+        ++__stats.misses;
+        std::remove(filePath.c_str());
+        return Program();
+    }
+    ++__stats.hits;
+    __stats.loadMilliseconds += std::chrono::duration<double, std::milli>(end - start).count();
+    return program;
+}
+
+void ProgramBinaryCache::save(uint64_t key, const Program& program) {
+    const GLint length = program.getInt(GL_PROGRAM_BINARY_LENGTH);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<unsigned char> data(HEADER_SIZE + static_cast<size_t>(length));
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, data.data() + HEADER_SIZE);
+    if (written <= 0) {
+        return;
+    }
+    data.resize(HEADER_SIZE + static_cast<size_t>(written));
+    const uint32_t magic = BINARY_MAGIC;
+    const uint32_t binaryFormat = format;
+    const uint32_t binaryLength = static_cast<uint32_t>(written);
+    memcpy(data.data(), &magic, sizeof(magic));
+    memcpy(data.data() + 4, &binaryFormat, sizeof(binaryFormat));
+    memcpy(data.data() + 8, &key, sizeof(key));
+    memcpy(data.data() + 16, &binaryLength, sizeof(binaryLength));
+    if (writeBinaryFile(path(key).c_str(), data)) {
+        std::lock_guard<std::mutex> lock(__mutex);
+        ++__stats.saves;
+    }
+}
+
+ProgramBinaryCache::Stats ProgramBinaryCache::stats() {
+    std::lock_guard<std::mutex> lock(__mutex);
+    return __stats;
+}
+
+std::string ProgramBinaryCache::path(uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    std::lock_guard<std::mutex> lock(__mutex);
+    return __directory + name;
+}
+
+} // namespace gl
+} // namespace kepler
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <BaseGL.hpp>
+#include <OpenGL.hpp>
+#include "Program.hpp"
+
+#include <string>
+#include <cstdint>
+
+namespace kepler {
+namespace gl {
+
+/// ProgramBinaryCache saves linked programs to disk with glGetProgramBinary and loads them with glProgramBinary
+/// so that later runs don't have to compile the same shaders again.
+///
+/// Binaries are keyed by a hash of the preprocessed shader sources and the GL vendor, renderer and version strings,
+/// so a driver update or a different GPU doesn't load an old binary. Drivers may still reject a binary. When that
+/// happens the file is deleted and the program is compiled from source as usual.
+///
+/// The cache is disabled until setDirectory() is called. Effect::createFromSource() uses it automatically.
+class ProgramBinaryCache final {
+public:
+    /// Counters since the start of the process.
+    struct Stats {
+        /// Number of programs that were loaded from a binary.
+        size_t hits = 0;
+        /// Number of programs that had no binary and were compiled.
+        size_t misses = 0;
+        /// Number of binaries that the driver rejected.
+        size_t rejected = 0;
+        /// Number of binaries that were written.
+        size_t saves = 0;
+        /// Time spent loading binaries in milliseconds.
+        double loadMilliseconds = 0.0;
+    };
+
+    ProgramBinaryCache() = delete;
+
+    /// Sets the directory the binaries are stored in and enables the cache. The directory must exist.
+    /// An empty string disables the cache.
+    static void setDirectory(const std::string& directory);
+
+    /// Returns true if the cache is enabled and the driver supports at least one program binary format.
+    /// Must be called with a current GL context.
+    static bool enabled();
+
+    /// Returns the cache key of the preprocessed vertex and fragment sources for the current driver.
+    static uint64_t key(const std::string& vertSource, const std::string& fragSource);
+
+    /// Loads the program with the given key. Returns an empty Program if there is no binary or it was rejected.
+    static Program load(uint64_t key);
+
+    /// Saves the binary of a linked program.
+    /// The program should be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+    static void save(uint64_t key, const Program& program);
+
+    /// Returns the counters.
+    static Stats stats();
+
+private:
+    static std::string path(uint64_t key);
+};
+
+} // namespace gl
+} // namespace kepler
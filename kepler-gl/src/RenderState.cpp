@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "RenderState.hpp"
 #include "MaterialParameter.hpp"
+#include "GLStats.hpp"
 
 namespace kepler {
 namespace gl {
@@ -32,10 +33,12 @@ static RenderState g_renderState;
 static inline void bindState(const int& state, const int flag, const int cap) {
     if ((g_current_state & flag) != (state & flag)) {
         if ((state & flag) != 0) {
+            KEPLER_GL_COUNT(STATE_CHANGES);
             glEnable(cap);
             g_current_state |= flag;
         }
         else {
+            KEPLER_GL_COUNT(STATE_CHANGES);
             glDisable(cap);
             g_current_state &= ~flag;
         }
@@ -67,11 +70,13 @@ RenderState::BlendState::BlendState() :
 void RenderState::BlendState::bind() const noexcept {
     auto& gBlend = g_renderState._blend;
     if (modeRGB != gBlend.modeRGB || modeAlpha != gBlend.modeAlpha) {
+        KEPLER_GL_COUNT(STATE_CHANGES);
         glBlendEquationSeparate(modeRGB, modeAlpha);
         gBlend.modeRGB = modeRGB;
         gBlend.modeAlpha = modeAlpha;
     }
     if (srcRGB != gBlend.srcRGB || dstRGB != gBlend.dstRGB || srcAlpha != gBlend.srcAlpha || dstAlpha != gBlend.dstAlpha) {
+        KEPLER_GL_COUNT(STATE_CHANGES);
         glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
         gBlend.srcRGB = srcRGB;
         gBlend.dstRGB = dstRGB;
@@ -79,6 +84,7 @@ void RenderState::BlendState::bind() const noexcept {
         gBlend.dstAlpha = dstAlpha;
     }
     if (red != gBlend.red || green != gBlend.green || blue != gBlend.blue || alpha != gBlend.alpha) {
+        KEPLER_GL_COUNT(STATE_CHANGES);
         glBlendColor(red, green, blue, alpha);
         gBlend.red = red;
         gBlend.green = green;
@@ -91,14 +97,17 @@ RenderState::DepthState::DepthState() : func(GL_LESS), near(0.f), far(0.f), mask
 
 void RenderState::DepthState::bind() const noexcept {
     if (g_renderState._depth.mask != mask) {
+        KEPLER_GL_COUNT(STATE_CHANGES);
         glDepthMask(mask);
         g_renderState._depth.mask = mask;
     }
     if (g_renderState._depth.func != func) {
+        KEPLER_GL_COUNT(STATE_CHANGES);
         glDepthFunc(func);
         g_renderState._depth.func = func;
     }
     if (g_renderState._depth.near != near || g_renderState._depth.far != far) {
+        KEPLER_GL_COUNT(STATE_CHANGES);
         glDepthRange(near, far);
         g_renderState._depth.near = near;
         g_renderState._depth.far = far;
@@ -109,10 +118,12 @@ RenderState::CullState::CullState() : cullFace(GL_BACK), frontFace(GL_CCW) {}
 
 void RenderState::CullState::bind() const noexcept {
     if (cullFace != g_renderState._cull.cullFace) {
+        KEPLER_GL_COUNT(STATE_CHANGES);
         glCullFace(cullFace);
         g_renderState._cull.cullFace = cullFace;
     }
     if (frontFace != g_renderState._cull.frontFace) {
+        KEPLER_GL_COUNT(STATE_CHANGES);
         glFrontFace(frontFace);
         g_renderState._cull.frontFace = frontFace;
     }
@@ -123,6 +134,7 @@ RenderState::PolygonOffset::PolygonOffset() : factor(0.f), units(0.f) {}
 void RenderState::PolygonOffset::bind() const noexcept {
     auto& gPoly = g_renderState._polygonOffset;
     if (factor != gPoly.factor || units != gPoly.units) {
+        KEPLER_GL_COUNT(STATE_CHANGES);
         glPolygonOffset(factor, units);
         gPoly = *this;
     }
@@ -155,14 +167,19 @@ void RenderState::bind() const noexcept {
         _polygonOffset.bind();
     }
     if (isScissorTestEnabled()) {
+        KEPLER_GL_COUNT(STATE_CHANGES);
         glScissor(_scissor.x, _scissor.y, _scissor.width, _scissor.height);
         g_renderState._scissor = _scissor;
     }
     if (_colorMask != g_renderState._colorMask) {
-        glColorMask(isSet(_colorMask, RED_MASK), isSet(_colorMask, BLUE_MASK), isSet(_colorMask, GREEN_MASK), isSet(_colorMask, ALPHA_MASK));
+        KEPLER_GL_COUNT(STATE_CHANGES);
+        glColorMask(isSet(_colorMask, RED_MASK), isSet(_colorMask, GREEN_MASK), isSet(_colorMask, BLUE_MASK), isSet(_colorMask, ALPHA_MASK));
+        g_renderState._colorMask = _colorMask;
     }
     if (_lineWidth != g_renderState._lineWidth) {
+        KEPLER_GL_COUNT(STATE_CHANGES);
         glLineWidth(_lineWidth);
+        g_renderState._lineWidth = _lineWidth;
     }
 }
 
@@ -304,6 +321,7 @@ void RenderState::setStencilTest(bool value) {
 }
 void RenderState::setGlobalDepthMask(bool flag) {
     if ((g_renderState._depth.mask != GL_FALSE) != flag) {
+        KEPLER_GL_COUNT(STATE_CHANGES);
         glDepthMask(flag);
         g_renderState._depth.mask = flag;
     }
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "Sampler.hpp"
+#include "GLStats.hpp"
 
 namespace kepler {
 namespace gl {
@@ -26,11 +27,16 @@ shared_ptr<Sampler> Sampler::create() {
 
 void Sampler::bind(GLenum textureUnit) const {
     if (_handle != __currentSamplerId) {
+        KEPLER_GL_COUNT(SAMPLER_BINDS);
         glBindSampler(textureUnit, _handle);
         __currentSamplerId = _handle;
     }
 }
 
+SamplerHandle Sampler::handle() const {
+    return _handle;
+}
+
 void Sampler::setWrapMode(Sampler::Wrap wrapS, Sampler::Wrap wrapT, Sampler::Wrap wrapR) {
     glSamplerParameteri(_handle, GL_TEXTURE_WRAP_S, (GLint)wrapS);
     glSamplerParameteri(_handle, GL_TEXTURE_WRAP_T, (GLint)wrapT);
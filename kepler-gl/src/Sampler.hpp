@@ -43,6 +43,8 @@ public:
 
     void bind(GLenum textureUnit) const;
 
+    SamplerHandle handle() const;
+
     void setWrapMode(Sampler::Wrap wrapS, Sampler::Wrap wrapT, Sampler::Wrap wrapR = DEFAULT_WRAP);
     void setFilterMode(Sampler::MinFilter minFilter, Sampler::MagFilter magFilter);
 
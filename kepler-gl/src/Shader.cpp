@@ -41,6 +41,20 @@ bool Shader::compile() const {
     return false;
 }
 
+void Shader::compileAsync() const {
+    if (_handle) {
+        glCompileShader(_handle);
+    }
+}
+
+bool Shader::compiled() const {
+    GLint success = GL_FALSE;
+    if (_handle) {
+        glGetShaderiv(_handle, GL_COMPILE_STATUS, &success);
+    }
+    return success == GL_TRUE;
+}
+
 void Shader::destroy() {
     if (_handle) {
         glDeleteShader(_handle);
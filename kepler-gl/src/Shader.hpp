@@ -30,6 +30,13 @@ public:
     /// Compiles the shader. Returns true on success; false otherwise.
     bool compile() const;
 
+    /// Starts compiling the shader without waiting for the result.
+    /// With GL_KHR_parallel_shader_compile the driver compiles on another thread. Call compiled() to get the result.
+    void compileAsync() const;
+
+    /// Returns true if the shader compiled successfully. Waits for the compile to finish.
+    bool compiled() const;
+
     void destroy();
 
     /// Retruns the shader type: GL_VERTEX_SHADER, GL_FRAGMENT_SHADER or GL_GEOMETRY_SHADER
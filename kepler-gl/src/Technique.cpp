@@ -78,6 +78,14 @@ void Technique::bind() {
     }
 }
 
+void Technique::findTextures(std::vector<shared_ptr<Texture>>& textures) const {
+    for (const auto& value : _values) {
+        if (value.second->texture()) {
+            textures.push_back(value.second->texture());
+        }
+    }
+}
+
 void Technique::findValues(std::vector<shared_ptr<MaterialParameter>>& values) {
     values.clear();
     if (_effect) {
@@ -108,6 +116,12 @@ void Technique::findValues(std::vector<shared_ptr<MaterialParameter>>& values) {
     }
 }
 
+void Technique::updateSemanticUniforms() {
+    for (auto& semantic : _semantics) {
+        updateUniform(*semantic.second, semantic.first);
+    }
+}
+
 shared_ptr<MaterialParameter> Technique::findValueParameter(const std::string& paramName) {
     auto p = _values.find(paramName);
     if (p != _values.end()) {
@@ -44,6 +44,13 @@ public:
     void bind(); // TODO remove and use a pass?
     void findValues(std::vector<shared_ptr<MaterialParameter>>& values);
 
+    /// Appends the textures used by the uniforms of this technique.
+    void findTextures(std::vector<shared_ptr<Texture>>& textures) const;
+
+    /// Looks up the uniforms of the semantic parameters again.
+    /// Needed when the semantics were set before an asynchronously compiled effect was ready.
+    void updateSemanticUniforms();
+
     /// Finds the material parameter with the given name.
     shared_ptr<MaterialParameter> findValueParameter(const std::string& paramName);
 
@@ -2,20 +2,58 @@
 #include "Texture.hpp"
 #include "Image.hpp"
 #include "Sampler.hpp"
+#include "GLStats.hpp"
 
 namespace kepler {
 namespace gl {
 
 static TextureHandle __currentTextureId = 0;
 
+// GL_EXT_texture_compression_s3tc and GL_EXT_texture_sRGB. Not core so glad doesn't define them.
+static constexpr GLenum COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+static constexpr GLenum COMPRESSED_RGBA_S3TC_DXT1 = 0x83F1;
+static constexpr GLenum COMPRESSED_RGBA_S3TC_DXT3 = 0x83F2;
+static constexpr GLenum COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+static constexpr GLenum COMPRESSED_SRGB_S3TC_DXT1 = 0x8C4C;
+static constexpr GLenum COMPRESSED_SRGB_ALPHA_S3TC_DXT1 = 0x8C4D;
+static constexpr GLenum COMPRESSED_SRGB_ALPHA_S3TC_DXT3 = 0x8C4E;
+static constexpr GLenum COMPRESSED_SRGB_ALPHA_S3TC_DXT5 = 0x8C4F;
+
+GLenum Texture::toInternalFormat(Ktx2Format format) {
+    switch (format) {
+    case Ktx2Format::R8G8B8A8_UNORM: return GL_RGBA8;
+    case Ktx2Format::R8G8B8A8_SRGB: return GL_SRGB8_ALPHA8;
+    case Ktx2Format::BC1_RGB_UNORM: return COMPRESSED_RGB_S3TC_DXT1;
+    case Ktx2Format::BC1_RGB_SRGB: return COMPRESSED_SRGB_S3TC_DXT1;
+    case Ktx2Format::BC1_RGBA_UNORM: return COMPRESSED_RGBA_S3TC_DXT1;
+    case Ktx2Format::BC1_RGBA_SRGB: return COMPRESSED_SRGB_ALPHA_S3TC_DXT1;
+    case Ktx2Format::BC2_UNORM: return COMPRESSED_RGBA_S3TC_DXT3;
+    case Ktx2Format::BC2_SRGB: return COMPRESSED_SRGB_ALPHA_S3TC_DXT3;
+    case Ktx2Format::BC3_UNORM: return COMPRESSED_RGBA_S3TC_DXT5;
+    case Ktx2Format::BC3_SRGB: return COMPRESSED_SRGB_ALPHA_S3TC_DXT5;
+    case Ktx2Format::BC4_UNORM: return GL_COMPRESSED_RED_RGTC1;
+    case Ktx2Format::BC4_SNORM: return GL_COMPRESSED_SIGNED_RED_RGTC1;
+    case Ktx2Format::BC5_UNORM: return GL_COMPRESSED_RG_RGTC2;
+    case Ktx2Format::BC5_SNORM: return GL_COMPRESSED_SIGNED_RG_RGTC2;
+    case Ktx2Format::BC6H_UFLOAT: return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+    case Ktx2Format::BC6H_SFLOAT: return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+    case Ktx2Format::BC7_UNORM: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    case Ktx2Format::BC7_SRGB: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+    default: return 0;
+    }
+}
+
 Texture::Texture(TextureHandle handle, Type type, int width, int height)
     : _handle(handle), _type(type), _width(width), _height(height) {
 }
 
 void Texture::bind(GLenum textureUnit) const noexcept {
-    //if (_handle != __currentTextureId) {
-    glBindTexture(static_cast<GLenum>(_type), _handle);
-    __currentTextureId = _handle;
+    const Texture* storage = _owner ? _owner.get() : this;
+    const TextureHandle handle = storage->_placeholder ? storage->_placeholder->_handle : _handle;
+    //if (handle != __currentTextureId) {
+    KEPLER_GL_COUNT(TEXTURE_BINDS);
+    glBindTexture(static_cast<GLenum>(_type), handle);
+    __currentTextureId = handle;
     //}
 
     if (_sampler != nullptr) {
@@ -47,8 +85,35 @@ void Texture::setSampler(const shared_ptr<Sampler>& sampler) {
     _sampler = sampler;
 }
 
+void Texture::setPlaceholder(const shared_ptr<Texture>& placeholder) {
+    _placeholder = placeholder;
+}
+
+bool Texture::resident() const {
+    const Texture* storage = _owner ? _owner.get() : this;
+    return storage->_placeholder == nullptr;
+}
+
+GLuint64 Texture::bindlessHandle() const {
+    const Texture* storage = _owner ? _owner.get() : this;
+    if (storage->_placeholder) {
+        return storage->_placeholder->bindlessHandle();
+    }
+    if (_bindlessHandle == 0 && _handle && bindless::supported()) {
+        _bindlessHandle = _sampler ? bindless::getTextureSamplerHandle(_handle, _sampler->handle())
+            : bindless::getTextureHandle(_handle);
+        if (_bindlessHandle) {
+            bindless::makeTextureHandleResident(_bindlessHandle);
+        }
+    }
+    return _bindlessHandle;
+}
+
 Texture::~Texture() noexcept {
-    if (_handle) {
+    if (_bindlessHandle) {
+        bindless::makeTextureHandleNonResident(_bindlessHandle);
+    }
+    if (_handle && _owner == nullptr) {
         glDeleteTextures(1, &_handle);
     }
 }
@@ -73,5 +138,65 @@ shared_ptr<Texture> Texture::create2D(Image* image, int internalFormat, bool gen
     return std::make_shared<Texture>(handle, Type::TEXTURE_2D, image->width(), image->height());
 }
 
+shared_ptr<Texture> Texture::create2D(const Ktx2Texture& ktx) {
+    if (!ktx.uploadable() || ktx.levels.empty() || !isFormatSupported(ktx.format)) {
+        return nullptr;
+    }
+    const GLenum internalFormat = toInternalFormat(ktx.format);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    TextureHandle handle;
+    glGenTextures(1, &handle);
+    if (handle == 0) {
+        return nullptr;
+    }
+    glBindTexture(GL_TEXTURE_2D, handle);
+    const GLint levelCount = static_cast<GLint>(ktx.levels.size());
+    for (GLint level = 0; level < levelCount; ++level) {
+        const GLsizei w = std::max(1, static_cast<GLsizei>(ktx.width >> level));
+        const GLsizei h = std::max(1, static_cast<GLsizei>(ktx.height >> level));
+        if (isBlockCompressed(ktx.format)) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, w, h, 0,
+                static_cast<GLsizei>(ktx.levels[level].length), ktx.levelData(level));
+        }
+        else {
+            glTexImage2D(GL_TEXTURE_2D, level, internalFormat, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, ktx.levelData(level));
+        }
+    }
+    // An incomplete mip chain would make the texture incomplete.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return std::make_shared<Texture>(handle, Type::TEXTURE_2D, static_cast<int>(ktx.width), static_cast<int>(ktx.height));
+}
+
+bool Texture::isFormatSupported(Ktx2Format format) {
+    static const bool s3tc = hasExtension("GL_EXT_texture_compression_s3tc");
+    static const bool s3tcSrgb = s3tc && hasExtension("GL_EXT_texture_sRGB");
+    switch (format) {
+    case Ktx2Format::BC1_RGB_UNORM:
+    case Ktx2Format::BC1_RGBA_UNORM:
+    case Ktx2Format::BC2_UNORM:
+    case Ktx2Format::BC3_UNORM:
+        return s3tc;
+    case Ktx2Format::BC1_RGB_SRGB:
+    case Ktx2Format::BC1_RGBA_SRGB:
+    case Ktx2Format::BC2_SRGB:
+    case Ktx2Format::BC3_SRGB:
+        return s3tcSrgb;
+    default:
+        // RGTC and BPTC are core in GL 4.2.
+        return toInternalFormat(format) != 0;
+    }
+}
+
+shared_ptr<Texture> Texture::createShared(const shared_ptr<Texture>& texture) {
+    if (texture == nullptr) {
+        return nullptr;
+    }
+    auto shared = std::make_shared<Texture>(texture->_handle, texture->_type, texture->_width, texture->_height);
+    shared->_owner = texture->_owner ? texture->_owner : texture;
+    shared->_sampler = texture->_sampler;
+    return shared;
+}
+
 } // namespace gl
 } // namespace kepler
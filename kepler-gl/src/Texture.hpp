@@ -2,6 +2,7 @@
 
 #include <BaseGL.hpp>
 #include <OpenGL.hpp>
+#include <Ktx2.hpp>
 
 namespace kepler {
 namespace gl {
@@ -41,7 +42,36 @@ public:
     /// @return Shared ptr to the texture. May be null if there was an error.
     static shared_ptr<Texture> create2D(Image* image, int internalFormat, bool generateMipmaps = false);
 
-    // TODO immutable 2D texture
+    /// Creates a 2D texture from a KTX2 texture. Block compressed levels are uploaded with glCompressedTexImage2D.
+    /// Every level in the file is uploaded and no mipmaps are generated.
+    /// @return Shared ptr to the texture. Null if the format isn't supported by the driver or the texture is supercompressed.
+    static shared_ptr<Texture> create2D(const Ktx2Texture& ktx);
+
+    /// Returns true if textures of the KTX2 format can be uploaded by create2D().
+    static bool isFormatSupported(Ktx2Format format);
+
+    /// Returns the GL internal format of a KTX2 format or 0 if there isn't one.
+    static GLenum toInternalFormat(Ktx2Format format);
+
+    /// Creates a texture that uses the same GL texture as the given texture but has its own sampler.
+    /// The GL texture is deleted once every texture that shares it is deleted.
+    /// Used for textures from the TextureCache since each user may want a different sampler.
+    /// @return Shared ptr to the texture. Null if texture is null.
+    static shared_ptr<Texture> createShared(const shared_ptr<Texture>& texture);
+
+    /// Binds the placeholder instead of this texture until the placeholder is set to null.
+    /// Used while the texture is being uploaded over several frames by the TextureUploader.
+    /// Textures created with createShared() use the placeholder of the texture they share.
+    void setPlaceholder(const shared_ptr<Texture>& placeholder);
+
+    /// Returns false if the placeholder is bound instead of this texture.
+    bool resident() const;
+
+    /// Returns the GL_ARB_bindless_texture handle of this texture and its sampler and makes it resident.
+    /// The handle is created on the first call. Returns the handle of the placeholder while there is one.
+    /// The parameters of the GL texture and sampler can't change once a handle exists.
+    /// @return The handle or 0 if bindless textures aren't supported.
+    GLuint64 bindlessHandle() const;
 
 private:
     TextureHandle _handle;
@@ -49,6 +79,10 @@ private:
     int _width;
     int _height;
     shared_ptr<Sampler> _sampler;
+    /// The texture that owns the GL texture if this texture was created with createShared().
+    shared_ptr<Texture> _owner;
+    shared_ptr<Texture> _placeholder;
+    mutable GLuint64 _bindlessHandle = 0;
 };
 
 } // namespace gl
@@ -0,0 +1,70 @@
+#include "stdafx.h"
+#include "TextureArray.hpp"
+#include "Texture.hpp"
+#include "Image.hpp"
+
+namespace kepler {
+namespace gl {
+
+TextureArray::TextureArray(const shared_ptr<Texture>& texture, int layerCount, bool mipmaps)
+    : _texture(texture), _layerCount(layerCount), _mipmaps(mipmaps) {
+}
+
+shared_ptr<TextureArray> TextureArray::create(int width, int height, int layerCount, GLenum internalFormat, bool mipmaps) {
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (width <= 0 || height <= 0 || layerCount <= 0 || layerCount > maxLayers) {
+        return nullptr;
+    }
+    GLsizei levels = 1;
+    if (mipmaps) {
+        for (int size = std::max(width, height); size > 1; size >>= 1) {
+            ++levels;
+        }
+    }
+    TextureHandle handle;
+    glGenTextures(1, &handle);
+    if (handle == 0) {
+        return nullptr;
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, handle);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internalFormat, width, height, layerCount);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    auto texture = std::make_shared<Texture>(handle, Texture::Type::TEXTURE_2D_ARRAY, width, height);
+    return std::make_shared<TextureArray>(texture, layerCount, mipmaps);
+}
+
+int TextureArray::add(const Image& image) {
+    if (_size == _layerCount || image.width() != _texture->width() || image.height() != _texture->height()) {
+        return -1;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, _texture->handle());
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, _size, image.width(), image.height(), 1,
+        static_cast<GLenum>(image.format()), image.type(), image.data());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return _size++;
+}
+
+void TextureArray::generateMipmaps() {
+    if (_mipmaps) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, _texture->handle());
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+}
+
+shared_ptr<Texture> TextureArray::texture() const {
+    return _texture;
+}
+
+int TextureArray::size() const {
+    return _size;
+}
+
+int TextureArray::layerCount() const {
+    return _layerCount;
+}
+
+} // namespace gl
+} // namespace kepler
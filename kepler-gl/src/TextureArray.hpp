@@ -0,0 +1,55 @@
+#pragma once
+
+#include <BaseGL.hpp>
+#include <OpenGL.hpp>
+
+namespace kepler {
+namespace gl {
+
+/// TextureArray packs images of the same size into the layers of one GL_TEXTURE_2D_ARRAY.
+///
+/// Materials that sample different layers of the same array bind the same texture, so draws that only differ by
+/// their texture can share texture state and the layer becomes a plain per material value.
+class TextureArray {
+public:
+    /// Use TextureArray::create()
+    TextureArray(const shared_ptr<Texture>& texture, int layerCount, bool mipmaps);
+    virtual ~TextureArray() noexcept = default;
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+
+    /// Creates an array with immutable storage for every layer.
+    /// @param[in] width          The width of every layer.
+    /// @param[in] height         The height of every layer.
+    /// @param[in] layerCount     The number of layers.
+    /// @param[in] internalFormat The sized internal format. GL_RGBA8, GL_SRGB8_ALPHA8...
+    /// @param[in] mipmaps        True if the array has mipmaps. Call generateMipmaps() after the layers are added.
+    /// @return The array. Null if the layer count is larger than GL_MAX_ARRAY_TEXTURE_LAYERS.
+    static shared_ptr<TextureArray> create(int width, int height, int layerCount, GLenum internalFormat = GL_RGBA8,
+        bool mipmaps = true);
+
+    /// Copies the image to the next free layer.
+    /// @return The layer or -1 if the array is full or the image has a different size.
+    int add(const Image& image);
+
+    /// Generates the mipmaps of every layer. Call once after the layers are added.
+    void generateMipmaps();
+
+    /// Returns the array texture.
+    shared_ptr<Texture> texture() const;
+
+    /// Returns the number of layers that were added.
+    int size() const;
+
+    /// Returns the number of layers.
+    int layerCount() const;
+
+private:
+    shared_ptr<Texture> _texture;
+    int _layerCount;
+    int _size = 0;
+    bool _mipmaps;
+};
+
+} // namespace gl
+} // namespace kepler
@@ -0,0 +1,557 @@
+#include "stdafx.h"
+#include "TextureCache.hpp"
+#include "Texture.hpp"
+#include "Image.hpp"
+#include "FileSystem.hpp"
+#include "TextureCompression.hpp"
+#include "TextureUploader.hpp"
+#include "TextureStreamer.hpp"
+#include "StringUtils.hpp"
+#include "Logging.hpp"
+
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <tuple>
+#include <cstdio>
+#include <cstring>
+
+namespace kepler {
+namespace gl {
+
+namespace {
+
+static constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+/// Identifies an image by its canonical path or by the hash and length of its encoded bytes.
+struct ImageKey {
+    std::string path;
+    uint64_t hash;
+    size_t length;
+
+    bool operator<(const ImageKey& rhs) const {
+        return std::tie(path, hash, length) < std::tie(rhs.path, rhs.hash, rhs.length);
+    }
+};
+
+struct TextureKey {
+    ImageKey image;
+    int internalFormat;
+    bool mipmaps;
+
+    bool operator<(const TextureKey& rhs) const {
+        return std::tie(image, internalFormat, mipmaps) < std::tie(rhs.image, rhs.internalFormat, rhs.mipmaps);
+    }
+};
+
+/// An image or texture of the cache.
+template<typename T>
+struct Cached {
+    std::weak_ptr<T> object;
+    size_t bytes = 0;
+    /// True while a thread decodes or uploads it. Other requests for it wait instead of doing the same work.
+    bool pending = false;
+};
+
+struct Upload {
+    shared_ptr<Texture> texture;
+    size_t bytes;
+};
+
+/// The settings of an upload. They are copied while the mutex is locked so the upload can run without it.
+struct Settings {
+    std::string compressionDirectory;
+    shared_ptr<TextureUploader> uploader;
+    shared_ptr<TextureStreamer> streamer;
+};
+
+static constexpr size_t MIN_PRUNE_SIZE = 64;
+
+// The mutex only guards the maps, counters and settings. Files are read, decoded, compressed and uploaded
+// without it so one slow texture doesn't block the other threads that use the cache.
+std::mutex __mutex;
+/// Notified when a pending image or texture is finished.
+std::condition_variable __finished;
+std::map<ImageKey, Cached<Image>> __images;
+std::map<TextureKey, Cached<Texture>> __textures;
+// The sizes of the maps at which the next lookup removes the entries of deleted images and textures.
+size_t __imagePruneSize = MIN_PRUNE_SIZE;
+size_t __texturePruneSize = MIN_PRUNE_SIZE;
+TextureCache::Stats __stats;
+std::string __compressionDirectory;
+std::weak_ptr<TextureUploader> __uploader;
+std::weak_ptr<TextureStreamer> __streamer;
+
+uint64_t hashBytes(const unsigned char* data, size_t length) {
+    uint64_t hash = FNV_OFFSET;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ data[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+size_t imageBytes(const Image& image) {
+    size_t channels = 4;
+    switch (image.format()) {
+    case Image::Format::L: channels = 1; break;
+    case Image::Format::LA: channels = 2; break;
+    case Image::Format::RGB: channels = 3; break;
+    case Image::Format::RGBA: channels = 4; break;
+    }
+    return static_cast<size_t>(image.width()) * static_cast<size_t>(image.height()) * channels;
+}
+
+/// Estimates the video memory of a texture. Drivers usually pad RGB to 4 bytes per pixel.
+size_t textureBytes(const Texture& texture, int internalFormat, bool mipmaps) {
+    size_t bytesPerPixel = 4;
+    switch (internalFormat) {
+    case GL_RED:
+    case GL_R8:
+        bytesPerPixel = 1;
+        break;
+    case GL_RG:
+    case GL_RG8:
+        bytesPerPixel = 2;
+        break;
+    case GL_RGBA16F:
+        bytesPerPixel = 8;
+        break;
+    case GL_RGBA32F:
+        bytesPerPixel = 16;
+        break;
+    }
+    size_t bytes = static_cast<size_t>(texture.width()) * static_cast<size_t>(texture.height()) * bytesPerPixel;
+    // A full mip chain adds a third.
+    return mipmaps ? bytes + bytes / 3 : bytes;
+}
+
+/// Adds one to a counter.
+void countStat(size_t TextureCache::Stats::* counter) {
+    std::lock_guard<std::mutex> lock(__mutex);
+    ++(__stats.*counter);
+}
+
+/// Removes the entries whose image or texture was deleted once the map has doubled in size since the last time,
+/// which keeps the maps from growing with every image ever loaded without walking them on every lookup.
+/// Expects the mutex to be locked.
+template<typename Map>
+void pruneExpired(Map& map, size_t& pruneSize) {
+    if (map.size() < pruneSize) {
+        return;
+    }
+    for (auto it = map.begin(); it != map.end();) {
+        if (!it->second.pending && it->second.object.expired()) {
+            it = map.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    pruneSize = std::max(MIN_PRUNE_SIZE, map.size() * 2);
+}
+
+/// Returns the cached object or null after marking the entry as pending so the caller creates it.
+/// Waits while another thread creates the same object. Expects the lock to be locked.
+template<typename Key, typename T>
+shared_ptr<T> findOrReserve(std::map<Key, Cached<T>>& map, size_t& pruneSize, const Key& key,
+    std::unique_lock<std::mutex>& lock) {
+    pruneExpired(map, pruneSize);
+    for (;;) {
+        auto& cached = map[key];
+        if (auto object = cached.object.lock()) {
+            return object;
+        }
+        if (!cached.pending) {
+            cached.pending = true;
+            return nullptr;
+        }
+        __finished.wait(lock);
+    }
+}
+
+/// Stores the object of a reserved entry and wakes the threads that wait for it. Entries of objects that
+/// couldn't be created are removed. Expects the mutex to be locked.
+template<typename Key, typename T>
+void publish(std::map<Key, Cached<T>>& map, const Key& key, const shared_ptr<T>& object, size_t bytes) {
+    if (object) {
+        auto& cached = map[key];
+        cached.object = object;
+        cached.bytes = bytes;
+        cached.pending = false;
+    }
+    else {
+        map.erase(key);
+    }
+    __finished.notify_all();
+}
+
+/// Returns the cached image or decodes it.
+shared_ptr<Image> findOrDecode(const ImageKey& key, const std::function<shared_ptr<Image>()>& decode) {
+    std::unique_lock<std::mutex> lock(__mutex);
+    ++__stats.imageRequests;
+    if (auto image = findOrReserve(__images, __imagePruneSize, key, lock)) {
+        ++__stats.imageHits;
+        return image;
+    }
+    lock.unlock();
+    auto image = decode();
+    lock.lock();
+    ++__stats.decodes;
+    publish(__images, key, image, image ? imageBytes(*image) : 0);
+    return image;
+}
+
+shared_ptr<Texture> findOrUpload(const TextureKey& key, const std::function<Upload(const Settings&)>& upload) {
+    std::unique_lock<std::mutex> lock(__mutex);
+    ++__stats.textureRequests;
+    if (auto texture = findOrReserve(__textures, __texturePruneSize, key, lock)) {
+        ++__stats.textureHits;
+        return texture;
+    }
+    const Settings settings{__compressionDirectory, __uploader.lock(), __streamer.lock()};
+    lock.unlock();
+    Upload result = upload(settings);
+    lock.lock();
+    if (result.texture) {
+        ++__stats.uploads;
+    }
+    publish(__textures, key, result.texture, result.bytes);
+    return result.texture;
+}
+
+/// Uploads the decoded image. The image is only held until the texture is uploaded unless something else uses it.
+Upload uploadImage(const TextureKey& key, const std::function<shared_ptr<Image>()>& decode, const Settings& settings) {
+    auto image = findOrDecode(key.image, decode);
+    if (image == nullptr) {
+        return Upload{nullptr, 0};
+    }
+    auto texture = settings.uploader ? settings.uploader->upload(image, key.internalFormat, key.mipmaps)
+        : Texture::create2D(image.get(), key.internalFormat, key.mipmaps);
+    return Upload{texture, texture ? textureBytes(*texture, key.internalFormat, key.mipmaps) : 0};
+}
+
+Upload uploadKtx2(Ktx2Texture&& ktx, const Settings& settings) {
+    const size_t bytes = ktx.data.size();
+    const bool compressed = isBlockCompressed(ktx.format);
+    shared_ptr<Texture> texture;
+    // The streamer and uploader keep the levels until they are uploaded.
+    if (settings.streamer && ktx.levels.size() > 1) {
+        texture = settings.streamer->load(std::make_shared<const Ktx2Texture>(std::move(ktx)));
+    }
+    else if (settings.uploader) {
+        texture = settings.uploader->upload(std::make_shared<const Ktx2Texture>(std::move(ktx)));
+    }
+    else {
+        texture = Texture::create2D(ktx);
+    }
+    if (texture == nullptr) {
+        return Upload{nullptr, 0};
+    }
+    if (compressed) {
+        countStat(&TextureCache::Stats::compressedUploads);
+    }
+    return Upload{texture, bytes};
+}
+
+/// Copies the image to tightly packed RGBA8 pixels.
+std::vector<uint8_t> toRgba(const Image& image) {
+    const size_t count = static_cast<size_t>(image.width()) * static_cast<size_t>(image.height());
+    std::vector<uint8_t> rgba(count * 4);
+    const unsigned char* data = image.data();
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t* p = &rgba[i * 4];
+        switch (image.format()) {
+        case Image::Format::L:
+            p[0] = p[1] = p[2] = data[i];
+            p[3] = 255;
+            break;
+        case Image::Format::LA:
+            p[0] = p[1] = p[2] = data[i * 2];
+            p[3] = data[i * 2 + 1];
+            break;
+        case Image::Format::RGB:
+            p[0] = data[i * 3];
+            p[1] = data[i * 3 + 1];
+            p[2] = data[i * 3 + 2];
+            p[3] = 255;
+            break;
+        case Image::Format::RGBA:
+            memcpy(p, data + i * 4, 4);
+            break;
+        }
+    }
+    return rgba;
+}
+
+bool isSrgb(int internalFormat) {
+    return internalFormat == GL_SRGB8_ALPHA8 || internalFormat == GL_SRGB8;
+}
+
+/// Returns the path of the compressed texture of an encoded image in the compression directory.
+std::string compressedPath(const std::string& directory, const unsigned char* buffer, size_t bufferLength,
+    bool srgb, bool mipmaps) {
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx-%llx%s%s.ktx2", static_cast<unsigned long long>(hashBytes(buffer, bufferLength)),
+        static_cast<unsigned long long>(bufferLength), srgb ? "-srgb" : "", mipmaps ? "-mips" : "");
+    return joinPath(directory, name);
+}
+
+/// Uploads the block compressed version of an encoded image.
+/// The compressed texture is read from the compression directory or compressed and written there.
+/// Falls back to an uncompressed upload if the driver doesn't support the format.
+Upload uploadCompressed(const TextureKey& key, const unsigned char* buffer, size_t bufferLength,
+    const Settings& settings) {
+    auto decode = [buffer, bufferLength]() {
+        return Image::createFromFileMemory(buffer, static_cast<int>(bufferLength));
+    };
+    const bool srgb = isSrgb(key.internalFormat);
+    if (!Texture::isFormatSupported(srgb ? Ktx2Format::BC3_SRGB : Ktx2Format::BC3_UNORM)) {
+        return uploadImage(key, decode, settings);
+    }
+    const std::string path = compressedPath(settings.compressionDirectory, buffer, bufferLength, srgb, key.mipmaps);
+
+    Ktx2Texture ktx;
+    std::vector<uint8_t> file;
+    if (fileExists(path) && readBinaryFile(path.c_str(), file) && readKtx2(file.data(), file.size(), ktx)) {
+        countStat(&TextureCache::Stats::compressedReads);
+    }
+    else {
+        auto image = findOrDecode(key.image, decode);
+        if (image == nullptr) {
+            return Upload{nullptr, 0};
+        }
+        const std::vector<uint8_t> rgba = toRgba(*image);
+        compressTexture(rgba.data(), static_cast<uint32_t>(image->width()), static_cast<uint32_t>(image->height()),
+            srgb, key.mipmaps, 0, ktx);
+        countStat(&TextureCache::Stats::compressions);
+        if (writeKtx2(ktx, file) && !writeBinaryFile(path.c_str(), file)) {
+            loge("TEXTURE_CACHE::WRITE ", path.c_str());
+        }
+    }
+    return uploadKtx2(std::move(ktx), settings);
+}
+
+/// Uploads an encoded image. KTX2 files are uploaded as is and other images are decoded.
+Upload uploadEncoded(const TextureKey& key, const unsigned char* buffer, size_t bufferLength, const Settings& settings) {
+    if (isKtx2(buffer, bufferLength)) {
+        Ktx2Texture ktx;
+        if (!readKtx2(buffer, bufferLength, ktx)) {
+            loge("TEXTURE_CACHE::READ_KTX2");
+            return Upload{nullptr, 0};
+        }
+        return uploadKtx2(std::move(ktx), settings);
+    }
+    if (!settings.compressionDirectory.empty()) {
+        return uploadCompressed(key, buffer, bufferLength, settings);
+    }
+    return uploadImage(key, [buffer, bufferLength]() {
+        return Image::createFromFileMemory(buffer, static_cast<int>(bufferLength));
+    }, settings);
+}
+
+ImageKey fileKey(const char* path) {
+    return ImageKey{canonicalPath(path), 0, 0};
+}
+
+ImageKey memoryKey(const unsigned char* buffer, size_t bufferLength) {
+    return ImageKey{std::string(), hashBytes(buffer, bufferLength), bufferLength};
+}
+
+} // anonymous namespace
+
+shared_ptr<Image> TextureCache::imageFromFile(const char* path) {
+    if (path == nullptr) {
+        return nullptr;
+    }
+    return findOrDecode(fileKey(path), [path]() {
+        return Image::createFromFile(path);
+    });
+}
+
+shared_ptr<Image> TextureCache::imageFromFileMemory(const unsigned char* buffer, size_t bufferLength) {
+    if (buffer == nullptr || bufferLength == 0) {
+        return nullptr;
+    }
+    return findOrDecode(memoryKey(buffer, bufferLength), [buffer, bufferLength]() {
+        return Image::createFromFileMemory(buffer, static_cast<int>(bufferLength));
+    });
+}
+
+std::vector<shared_ptr<Image>> TextureCache::decodeImages(const std::vector<ImageSource>& sources, int internalFormat,
+    bool generateMipmaps, size_t threadCount) {
+    struct Job {
+        ImageKey key;
+        const ImageSource* source;
+        shared_ptr<Image> image;
+    };
+    std::vector<Job> jobs;
+    std::vector<shared_ptr<Image>> result;
+    std::string compressionDirectory;
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+        compressionDirectory = __compressionDirectory;
+        pruneExpired(__images, __imagePruneSize);
+        for (const auto& source : sources) {
+            if (!source.buffer && endsWith(source.path, ".ktx2")) {
+                continue;
+            }
+            ImageKey key = source.buffer ? memoryKey(source.buffer, source.length) : fileKey(source.path.c_str());
+            auto& cached = __images[key];
+            if (auto image = cached.object.lock()) {
+                result.push_back(image);
+            }
+            else if (!cached.pending) {
+                // Texture requests for the image wait for the worker instead of decoding it again.
+                // Images that another thread is decoding are left to it.
+                cached.pending = true;
+                jobs.push_back(Job{std::move(key), &source, nullptr});
+            }
+        }
+    }
+    const bool srgb = isSrgb(internalFormat);
+    // Returns null for the images that don't need to be decoded.
+    auto decode = [&compressionDirectory, srgb, generateMipmaps](const ImageSource& source,
+        std::vector<unsigned char>& file) -> shared_ptr<Image> {
+        const unsigned char* buffer = source.buffer;
+        size_t length = source.length;
+        if (buffer == nullptr) {
+            if (!readBinaryFile(source.path.c_str(), file)) {
+                return nullptr;
+            }
+            buffer = file.data();
+            length = file.size();
+        }
+        if (isKtx2(buffer, length)) {
+            return nullptr;
+        }
+        if (!compressionDirectory.empty()
+            && fileExists(compressedPath(compressionDirectory, buffer, length, srgb, generateMipmaps))) {
+            return nullptr;
+        }
+        return Image::createFromFileMemory(buffer, static_cast<int>(length));
+    };
+    std::atomic<size_t> next(0);
+    // Images vary a lot in size so each worker takes the next image instead of a fixed range.
+    auto work = [&jobs, &next, &decode]() {
+        std::vector<unsigned char> file;
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            Job& job = jobs[i];
+            job.image = decode(*job.source, file);
+            // Every reserved entry is finished, even if it wasn't decoded, so nothing waits for it forever.
+            std::lock_guard<std::mutex> lock(__mutex);
+            if (job.image) {
+                ++__stats.imageRequests;
+                ++__stats.decodes;
+            }
+            publish(__images, job.key, job.image, job.image ? imageBytes(*job.image) : 0);
+        }
+    };
+    size_t threads = threadCount == 0 ? std::thread::hardware_concurrency() : threadCount;
+    threads = std::max<size_t>(1, std::min(threads, jobs.size()));
+    std::vector<std::future<void>> workers;
+    for (size_t i = 1; i < threads; ++i) {
+        workers.push_back(std::async(std::launch::async, work));
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.get();
+    }
+    for (auto& job : jobs) {
+        if (job.image) {
+            result.push_back(std::move(job.image));
+        }
+    }
+    return result;
+}
+
+shared_ptr<Texture> TextureCache::textureFromFile(const char* path, int internalFormat, bool generateMipmaps) {
+    if (path == nullptr) {
+        return nullptr;
+    }
+    const TextureKey key{fileKey(path), internalFormat, generateMipmaps};
+    return findOrUpload(key, [&key, path](const Settings& settings) {
+        if (settings.compressionDirectory.empty() && !endsWith(path, ".ktx2")) {
+            return uploadImage(key, [path]() {
+                return Image::createFromFile(path);
+            }, settings);
+        }
+        std::vector<unsigned char> file;
+        if (!readBinaryFile(path, file)) {
+            return Upload{nullptr, 0};
+        }
+        return uploadEncoded(key, file.data(), file.size(), settings);
+    });
+}
+
+shared_ptr<Texture> TextureCache::textureFromFileMemory(const unsigned char* buffer, size_t bufferLength,
+    int internalFormat, bool generateMipmaps) {
+    if (buffer == nullptr || bufferLength == 0) {
+        return nullptr;
+    }
+    const TextureKey key{memoryKey(buffer, bufferLength), internalFormat, generateMipmaps};
+    return findOrUpload(key, [&key, buffer, bufferLength](const Settings& settings) {
+        return uploadEncoded(key, buffer, bufferLength, settings);
+    });
+}
+
+void TextureCache::setCompressionDirectory(const char* directory) {
+    std::lock_guard<std::mutex> lock(__mutex);
+    __compressionDirectory = directory ? directory : "";
+}
+
+void TextureCache::setUploader(const shared_ptr<TextureUploader>& uploader) {
+    std::lock_guard<std::mutex> lock(__mutex);
+    __uploader = uploader;
+}
+
+void TextureCache::setStreamer(const shared_ptr<TextureStreamer>& streamer) {
+    std::lock_guard<std::mutex> lock(__mutex);
+    __streamer = streamer;
+}
+
+TextureCache::Stats TextureCache::stats() {
+    std::lock_guard<std::mutex> lock(__mutex);
+    return __stats;
+}
+
+TextureCache::Memory TextureCache::memory() {
+    std::lock_guard<std::mutex> lock(__mutex);
+    Memory memory;
+    for (auto it = __images.begin(); it != __images.end();) {
+        if (it->second.object.expired()) {
+            // Pending entries are still being created.
+            it = it->second.pending ? std::next(it) : __images.erase(it);
+            continue;
+        }
+        ++memory.images;
+        memory.imageBytes += it->second.bytes;
+        ++it;
+    }
+    for (auto it = __textures.begin(); it != __textures.end();) {
+        if (it->second.object.expired()) {
+            // Pending entries are still being created.
+            it = it->second.pending ? std::next(it) : __textures.erase(it);
+            continue;
+        }
+        ++memory.textures;
+        memory.textureBytes += it->second.bytes;
+        ++it;
+    }
+    return memory;
+}
+
+void TextureCache::clear() {
+    std::lock_guard<std::mutex> lock(__mutex);
+    __images.clear();
+    __textures.clear();
+    __imagePruneSize = MIN_PRUNE_SIZE;
+    __texturePruneSize = MIN_PRUNE_SIZE;
+    __stats = Stats();
+}
+
+} // namespace gl
+} // namespace kepler
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <BaseGL.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace kepler {
+namespace gl {
+
+/// TextureCache shares decoded Images and uploaded Textures across the whole process.
+///
+/// KTX2 files are uploaded with their prebuilt mip chain. Other images are decoded and uploaded as RGBA8
+/// unless a compression directory is set, in which case they are block compressed first.
+///
+/// Files are keyed by their canonical path and images in memory, like glTF embedded or GLB images,
+/// are keyed by a hash of their encoded bytes. Textures are keyed by their image and the upload options.
+/// Two models that use the same image only decode and upload it once.
+/// The cache only keeps weak references; an Image or Texture is deleted once nothing else uses it.
+/// The cache is thread safe, but Textures must still be created on the thread that owns the GL context.
+/// Images are decoded and textures uploaded without holding the lock of the cache. A request for an image or texture
+/// that another thread is creating waits for that thread instead of creating it again.
+class TextureCache final {
+public:
+    /// Counters since the start of the process or the last clear().
+    struct Stats {
+        /// Number of textures that were requested.
+        size_t textureRequests = 0;
+        /// Number of texture requests that returned an existing texture.
+        size_t textureHits = 0;
+        /// Number of textures that were uploaded.
+        size_t uploads = 0;
+        /// Number of images that were requested, including the ones requested for textures.
+        size_t imageRequests = 0;
+        /// Number of image requests that returned an existing image.
+        size_t imageHits = 0;
+        /// Number of images that were decoded.
+        size_t decodes = 0;
+        /// Number of uploaded textures that were block compressed.
+        size_t compressedUploads = 0;
+        /// Number of images that were block compressed because they weren't in the compression directory.
+        size_t compressions = 0;
+        /// Number of block compressed textures that were read from the compression directory.
+        size_t compressedReads = 0;
+    };
+
+    /// Memory used by the images and textures that are still alive.
+    struct Memory {
+        size_t images = 0;
+        size_t imageBytes = 0;
+        size_t textures = 0;
+        /// Estimated from the size, internal format and mipmaps of each texture.
+        size_t textureBytes = 0;
+    };
+
+    /// An encoded image for decodeImages(). Either a file path or memory that stays valid during the call.
+    struct ImageSource {
+        std::string path;
+        const unsigned char* buffer = nullptr;
+        size_t length = 0;
+    };
+
+    TextureCache() = delete;
+
+    /// Returns the decoded image file. Returns null if the file can't be loaded.
+    static shared_ptr<Image> imageFromFile(const char* path);
+
+    /// Returns the decoded image from the encoded image file in memory, like a PNG or JPEG.
+    /// Returns null if the image can't be decoded.
+    static shared_ptr<Image> imageFromFileMemory(const unsigned char* buffer, size_t bufferLength);
+
+    /// Decodes images on worker threads so the texture requests that follow don't have to decode on the GL thread.
+    /// Images that are already cached or being decoded by another thread, KTX2 files and images whose compressed
+    /// texture is already in the compression directory are skipped. Textures are still uploaded by textureFromFile() and
+    /// textureFromFileMemory() on the thread that owns the GL context.
+    /// @param[in] sources         The images.
+    /// @param[in] internalFormat  The internal format the textures will be created with.
+    /// @param[in] generateMipmaps True if the textures will have mipmaps.
+    /// @param[in] threadCount     The number of threads to use. Zero uses one per core.
+    /// @return The decoded images. The cache only keeps weak references so keep them until the textures are created.
+    static std::vector<shared_ptr<Image>> decodeImages(const std::vector<ImageSource>& sources, int internalFormat,
+        bool generateMipmaps, size_t threadCount = 0);
+
+    /// Returns a 2D texture of the image file.
+    /// @param[in] path            The image path.
+    /// @param[in] internalFormat  Internal format of the texture. GL_RGB, GL_RGBA...
+    /// @param[in] generateMipmaps True if mipmaps should be generated.
+    /// @return The texture. May be null if there was an error.
+    static shared_ptr<Texture> textureFromFile(const char* path, int internalFormat, bool generateMipmaps = true);
+
+    /// Returns a 2D texture of the encoded image file in memory.
+    static shared_ptr<Texture> textureFromFileMemory(const unsigned char* buffer, size_t bufferLength,
+        int internalFormat, bool generateMipmaps = true);
+
+    /// Enables block compression of PNG and JPEG textures when they are imported. Disabled by default.
+    /// Opaque images are compressed to BC1 and images with alpha to BC3 on all cores, which uses a quarter
+    /// or less of the memory of RGBA8. The results are written to the directory as KTX2 files named by a hash
+    /// of the source image so the next import only reads them.
+    /// @param[in] directory The existing directory of the compressed textures. Null or "" disables compression.
+    static void setCompressionDirectory(const char* directory);
+
+    /// Sends new uploads through the uploader so they are spread over several frames.
+    /// Textures are returned right away and bind a placeholder until TextureUploader::update() has copied them.
+    /// The cache only keeps a weak reference so the caller must keep the uploader alive.
+    /// @param[in] uploader The uploader or null to upload textures immediately.
+    static void setUploader(const shared_ptr<TextureUploader>& uploader);
+
+    /// Loads KTX2 textures that have a mip chain through the streamer so only the levels that are needed are uploaded.
+    /// Takes precedence over the uploader for those textures. The cache only keeps a weak reference.
+    /// @param[in] streamer The streamer or null to upload every level.
+    static void setStreamer(const shared_ptr<TextureStreamer>& streamer);
+
+    /// Returns the counters.
+    static Stats stats();
+
+    /// Returns the memory used by the cached images and textures that are still alive.
+    static Memory memory();
+
+    /// Forgets every cached image and texture and resets the counters.
+    /// Images and textures that are still in use are not deleted.
+    static void clear();
+};
+
+} // namespace gl
+} // namespace kepler
@@ -0,0 +1,271 @@
+#include "stdafx.h"
+#include "TextureStreamer.hpp"
+#include "Texture.hpp"
+#include "Scene.hpp"
+#include "Node.hpp"
+#include "Camera.hpp"
+#include "MeshRenderer.hpp"
+#include "Mesh.hpp"
+#include "MeshPrimitive.hpp"
+#include "Material.hpp"
+#include "LodSelector.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace kepler {
+namespace gl {
+
+TextureStreamer::TextureStreamer(size_t budget) : _budget(budget) {
+}
+
+shared_ptr<TextureStreamer> TextureStreamer::create(size_t budget) {
+    return std::make_shared<TextureStreamer>(budget);
+}
+
+shared_ptr<Texture> TextureStreamer::load(const shared_ptr<const Ktx2Texture>& ktx) {
+    if (ktx == nullptr || !ktx->uploadable() || ktx->levels.empty() || !Texture::isFormatSupported(ktx->format)) {
+        return nullptr;
+    }
+    if (ktx->levels.size() == 1) {
+        return Texture::create2D(*ktx);
+    }
+    Entry entry;
+    entry.ktx = ktx;
+    entry.internalFormat = Texture::toInternalFormat(ktx->format);
+    entry.compressed = isBlockCompressed(ktx->format);
+    const size_t lastLevel = ktx->levels.size() - 1;
+    entry.minLevel = 0;
+    while (entry.minLevel < lastLevel && std::max(ktx->width, ktx->height) >> entry.minLevel > _initialSize) {
+        ++entry.minLevel;
+    }
+    entry.baseLevel = entry.minLevel;
+    entry.requestedLevel = entry.minLevel;
+    entry.lastNeeded = _updates;
+
+    TextureHandle handle;
+    glGenTextures(1, &handle);
+    if (handle == 0) {
+        return nullptr;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, handle);
+    for (size_t level = entry.minLevel; level <= lastLevel; ++level) {
+        uploadLevel(entry, level);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(entry.baseLevel));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(lastLevel));
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    auto texture = std::make_shared<Texture>(handle, Texture::Type::TEXTURE_2D,
+        static_cast<int>(ktx->width), static_cast<int>(ktx->height));
+    entry.texture = texture;
+    _entries[handle] = std::move(entry);
+    return texture;
+}
+
+void TextureStreamer::requestScene(const Scene& scene, int viewportHeight) {
+    auto camera = scene.activeCamera();
+    if (camera == nullptr) {
+        return;
+    }
+    std::vector<shared_ptr<Texture>> textures;
+    scene.visit([&](Node* node) {
+        auto renderer = std::dynamic_pointer_cast<MeshRenderer>(node->drawable());
+        if (renderer == nullptr || renderer->mesh() == nullptr) {
+            return;
+        }
+        // The screen size is the diameter of the bounding sphere as a fraction of the viewport height.
+        const float pixels = LodSelector::screenSize(node->boundingBox(), *camera) * static_cast<float>(viewportHeight);
+        const Mesh& mesh = *renderer->mesh();
+        for (size_t i = 0; i < mesh.primitiveCount(); ++i) {
+            if (auto material = mesh.primitivePtr(i)->material()) {
+                textures.clear();
+                material->findTextures(textures);
+                for (const auto& texture : textures) {
+                    request(*texture, pixels);
+                }
+            }
+        }
+    });
+}
+
+void TextureStreamer::request(const Texture& texture, float pixels) {
+    auto it = _entries.find(texture.handle());
+    if (it == _entries.end() || it->second.texture.expired()) {
+        return;
+    }
+    Entry& entry = it->second;
+    const size_t level = std::min(entry.minLevel,
+        requiredLevel(entry.ktx->width, entry.ktx->height, pixels, entry.ktx->levels.size()));
+    entry.requestedLevel = entry.requested ? std::min(entry.requestedLevel, level) : level;
+    entry.requested = true;
+    entry.lastNeeded = _updates;
+}
+
+void TextureStreamer::update(size_t byteBudget) {
+    std::vector<std::pair<TextureHandle, Entry*>> entries;
+    entries.reserve(_entries.size());
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        if (it->second.texture.expired()) {
+            it = _entries.erase(it);
+            continue;
+        }
+        entries.emplace_back(it->first, &it->second);
+        ++it;
+    }
+
+    // Textures that weren't requested keep their levels unless the budget needs them.
+    std::vector<size_t> targets(entries.size());
+    size_t total = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = *entries[i].second;
+        targets[i] = entry.requested ? entry.requestedLevel : entry.baseLevel;
+        total += bytesFrom(entry, targets[i]);
+    }
+    // Over budget: drop levels of the least recently needed textures first, the largest level first.
+    while (total > _budget) {
+        size_t victim = entries.size();
+        size_t victimBytes = 0;
+        size_t victimNeeded = 0;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const Entry& entry = *entries[i].second;
+            if (targets[i] >= entry.minLevel) {
+                continue;
+            }
+            const size_t bytes = entry.ktx->levels[targets[i]].length;
+            if (victim == entries.size() || entry.lastNeeded < victimNeeded
+                || (entry.lastNeeded == victimNeeded && bytes > victimBytes)) {
+                victim = i;
+                victimBytes = bytes;
+                victimNeeded = entry.lastNeeded;
+            }
+        }
+        if (victim == entries.size()) {
+            break;
+        }
+        total -= victimBytes;
+        ++targets[victim];
+    }
+
+    std::vector<size_t> streaming;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        Entry& entry = *entries[i].second;
+        if (targets[i] > entry.baseLevel) {
+            glBindTexture(GL_TEXTURE_2D, entries[i].first);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(targets[i]));
+            for (size_t level = entry.baseLevel; level < targets[i]; ++level) {
+                freeLevel(entry, level);
+                ++_evictedLevels;
+            }
+            entry.baseLevel = targets[i];
+        }
+        else if (targets[i] < entry.baseLevel) {
+            streaming.push_back(i);
+        }
+        entry.requested = false;
+    }
+
+    // Stream in the textures that are the furthest from their level first, one level at a time.
+    std::sort(streaming.begin(), streaming.end(), [&](size_t a, size_t b) {
+        return entries[a].second->baseLevel - targets[a] > entries[b].second->baseLevel - targets[b];
+    });
+    size_t used = 0;
+    for (size_t i : streaming) {
+        Entry& entry = *entries[i].second;
+        glBindTexture(GL_TEXTURE_2D, entries[i].first);
+        while (entry.baseLevel > targets[i] && (used == 0 || used < byteBudget)) {
+            const size_t level = entry.baseLevel - 1;
+            uploadLevel(entry, level);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(level));
+            entry.baseLevel = level;
+            used += entry.ktx->levels[level].length;
+            ++_streamedLevels;
+        }
+        if (used >= byteBudget) {
+            break;
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    ++_updates;
+}
+
+void TextureStreamer::setBudget(size_t budget) {
+    _budget = budget;
+}
+
+void TextureStreamer::setInitialSize(uint32_t size) {
+    _initialSize = size;
+}
+
+TextureStreamer::Stats TextureStreamer::stats() const {
+    Stats stats;
+    stats.budget = _budget;
+    stats.streamedLevels = _streamedLevels;
+    stats.evictedLevels = _evictedLevels;
+    for (const auto& it : _entries) {
+        const Entry& entry = it.second;
+        if (entry.texture.expired()) {
+            continue;
+        }
+        ++stats.textures;
+        stats.residentBytes += bytesFrom(entry, entry.baseLevel);
+        stats.totalBytes += bytesFrom(entry, 0);
+        stats.residentLevels += entry.ktx->levels.size() - entry.baseLevel;
+        stats.totalLevels += entry.ktx->levels.size();
+    }
+    return stats;
+}
+
+size_t TextureStreamer::requiredLevel(uint32_t width, uint32_t height, float pixels, size_t levelCount) {
+    if (levelCount == 0) {
+        return 0;
+    }
+    const float size = static_cast<float>(std::max(width, height));
+    if (!(pixels > 0.0f)) {
+        return levelCount - 1;
+    }
+    if (pixels >= size) {
+        return 0;
+    }
+    // Round down so the level has at least as many texels as there are pixels.
+    const size_t level = static_cast<size_t>(std::floor(std::log2(size / pixels)));
+    return std::min(level, levelCount - 1);
+}
+
+size_t TextureStreamer::bytesFrom(const Entry& entry, size_t level) {
+    size_t bytes = 0;
+    for (size_t i = level; i < entry.ktx->levels.size(); ++i) {
+        bytes += entry.ktx->levels[i].length;
+    }
+    return bytes;
+}
+
+void TextureStreamer::uploadLevel(const Entry& entry, size_t level) {
+    const Ktx2Texture& ktx = *entry.ktx;
+    const GLsizei w = std::max(1, static_cast<GLsizei>(ktx.width >> level));
+    const GLsizei h = std::max(1, static_cast<GLsizei>(ktx.height >> level));
+    if (entry.compressed) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), entry.internalFormat, w, h, 0,
+            static_cast<GLsizei>(ktx.levels[level].length), ktx.levelData(level));
+    }
+    else {
+        glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), entry.internalFormat, w, h, 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, ktx.levelData(level));
+    }
+}
+
+void TextureStreamer::freeLevel(const Entry& entry, size_t level) {
+    // Levels below the base level are ignored by sampling and completeness so an empty image releases the memory.
+    if (entry.compressed) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), entry.internalFormat, 0, 0, 0, 0, nullptr);
+    }
+    else {
+        glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), entry.internalFormat, 0, 0, 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+}
+
+} // namespace gl
+} // namespace kepler
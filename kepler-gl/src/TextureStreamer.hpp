@@ -0,0 +1,122 @@
+#pragma once
+
+#include <BaseGL.hpp>
+#include <OpenGL.hpp>
+#include <Ktx2.hpp>
+
+#include <vector>
+#include <unordered_map>
+
+namespace kepler {
+namespace gl {
+
+/// TextureStreamer keeps only the mip levels of KTX2 textures that are needed to draw the scene at its current size
+/// on screen, within a video memory budget.
+///
+/// load() uploads the small levels right away. requestScene() estimates the level each texture needs from the
+/// projected size of the meshes that use it and update() streams in the larger levels a few at a time, then frees
+/// levels when the budget is exceeded, starting with the textures that were needed the longest time ago. The levels in use are selected with
+/// GL_TEXTURE_BASE_LEVEL so the texture stays complete the whole time.
+class TextureStreamer {
+public:
+    struct Stats {
+        /// Number of streamed textures that are alive.
+        size_t textures = 0;
+        /// Bytes of the levels that are uploaded.
+        size_t residentBytes = 0;
+        /// Bytes of every level of every texture.
+        size_t totalBytes = 0;
+        /// Number of levels that are uploaded.
+        size_t residentLevels = 0;
+        /// Number of levels of every texture.
+        size_t totalLevels = 0;
+        /// The memory budget in bytes.
+        size_t budget = 0;
+        /// Number of levels uploaded by update() since the streamer was created.
+        size_t streamedLevels = 0;
+        /// Number of levels freed by update() since the streamer was created.
+        size_t evictedLevels = 0;
+    };
+
+    /// Use TextureStreamer::create()
+    explicit TextureStreamer(size_t budget);
+    virtual ~TextureStreamer() noexcept = default;
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    /// Creates a streamer.
+    /// @param[in] budget The max number of bytes of the uploaded levels. The small levels are always uploaded
+    ///                   even if they don't fit.
+    static shared_ptr<TextureStreamer> create(size_t budget = 256 * 1024 * 1024);
+
+    /// Creates a texture from a KTX2 texture that only has its small levels uploaded.
+    /// Textures without a mip chain are uploaded completely and are not streamed.
+    /// @return The texture. Null if the format is not supported by the driver.
+    shared_ptr<Texture> load(const shared_ptr<const Ktx2Texture>& ktx);
+
+    /// Requests the level of each texture needed by the meshes of the scene as seen by its active camera.
+    /// Call once per frame before update().
+    /// @param[in] viewportHeight The height of the viewport in pixels.
+    void requestScene(const Scene& scene, int viewportHeight);
+
+    /// Requests the level of the texture needed to cover the given number of pixels.
+    /// The most detailed level requested since the last update() is used. Ignored if the texture isn't streamed.
+    void request(const Texture& texture, float pixels);
+
+    /// Uploads the requested levels until the byte budget is used up and frees levels when over the memory budget.
+    /// The largest levels of the least recently requested textures are freed first.
+    /// Call once per frame on the GL thread.
+    /// @param[in] byteBudget The max number of bytes to upload. At least one level is uploaded if one is needed.
+    void update(size_t byteBudget = 4 * 1024 * 1024);
+
+    /// Sets the memory budget in bytes.
+    void setBudget(size_t budget);
+
+    /// Sets the largest width or height of the levels that load() uploads. The default is 64.
+    void setInitialSize(uint32_t size);
+
+    /// Returns the statistics. Counts are for the textures that are still alive.
+    Stats stats() const;
+
+    /// Returns the level of a texture that has at least one texel per pixel when it covers the given number of pixels.
+    /// @param[in] width      The width of level 0.
+    /// @param[in] height     The height of level 0.
+    /// @param[in] pixels     The size of the texture on screen in pixels.
+    /// @param[in] levelCount The number of levels of the texture.
+    static size_t requiredLevel(uint32_t width, uint32_t height, float pixels, size_t levelCount);
+
+private:
+    struct Entry {
+        std::weak_ptr<Texture> texture;
+        shared_ptr<const Ktx2Texture> ktx;
+        GLenum internalFormat = 0;
+        bool compressed = false;
+        /// The most detailed level that is uploaded.
+        size_t baseLevel = 0;
+        /// The least detailed level that is always uploaded.
+        size_t minLevel = 0;
+        /// The level requested since the last update().
+        size_t requestedLevel = 0;
+        bool requested = false;
+        /// The update() that the texture was last requested for or loaded before.
+        size_t lastNeeded = 0;
+    };
+
+    /// Returns the bytes of the levels from the given level to the last level.
+    static size_t bytesFrom(const Entry& entry, size_t level);
+    /// Uploads or frees the level of the bound texture.
+    static void uploadLevel(const Entry& entry, size_t level);
+    static void freeLevel(const Entry& entry, size_t level);
+
+private:
+    std::unordered_map<TextureHandle, Entry> _entries;
+    size_t _budget;
+    uint32_t _initialSize = 64;
+    size_t _streamedLevels = 0;
+    size_t _evictedLevels = 0;
+    /// Number of calls to update().
+    size_t _updates = 0;
+};
+
+} // namespace gl
+} // namespace kepler
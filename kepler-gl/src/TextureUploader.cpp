@@ -0,0 +1,284 @@
+#include "stdafx.h"
+#include "TextureUploader.hpp"
+#include "Texture.hpp"
+#include "Image.hpp"
+
+#include <limits>
+#include <cstring>
+
+namespace kepler {
+namespace gl {
+
+static constexpr GLuint64 FENCE_TIMEOUT = 1000000000; // 1 second in nanoseconds
+
+static size_t channelCount(Image::Format format) {
+    switch (format) {
+    case Image::Format::L: return 1;
+    case Image::Format::LA: return 2;
+    case Image::Format::RGB: return 3;
+    default: return 4;
+    }
+}
+
+/// Immutable storage needs a sized internal format.
+static GLenum toSizedFormat(int internalFormat) {
+    switch (internalFormat) {
+    case GL_RED: return GL_R8;
+    case GL_RG: return GL_RG8;
+    case GL_RGB: return GL_RGB8;
+    case GL_RGBA: return GL_RGBA8;
+    case GL_SRGB: return GL_SRGB8;
+    case GL_SRGB_ALPHA: return GL_SRGB8_ALPHA8;
+    default: return static_cast<GLenum>(internalFormat);
+    }
+}
+
+static GLsizei mipLevelCount(int width, int height) {
+    GLsizei levels = 1;
+    for (int size = std::max(width, height); size > 1; size >>= 1) {
+        ++levels;
+    }
+    return levels;
+}
+
+TextureUploader::TextureUploader(size_t bufferSize, size_t bufferCount)
+    : _staging(std::max<size_t>(1, bufferCount)), _bufferSize(bufferSize) {
+    for (auto& staging : _staging) {
+        glGenBuffers(1, &staging.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(_bufferSize), nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+TextureUploader::~TextureUploader() noexcept {
+    for (auto& staging : _staging) {
+        if (staging.fence) {
+            glDeleteSync(staging.fence);
+        }
+        glDeleteBuffers(1, &staging.buffer);
+    }
+}
+
+shared_ptr<TextureUploader> TextureUploader::create(size_t bufferSize, size_t bufferCount) {
+    return std::make_shared<TextureUploader>(bufferSize, bufferCount);
+}
+
+shared_ptr<Texture> TextureUploader::upload(const shared_ptr<Image>& image, int internalFormat, bool generateMipmaps) {
+    if (image == nullptr || image->width() <= 0 || image->height() <= 0) {
+        return nullptr;
+    }
+    Job job;
+    job.internalFormat = toSizedFormat(internalFormat);
+    const GLsizei levels = generateMipmaps ? mipLevelCount(image->width(), image->height()) : 1;
+    auto texture = createStorage(job.internalFormat, image->width(), image->height(), levels);
+    if (texture == nullptr) {
+        return nullptr;
+    }
+    job.texture = texture;
+    job.image = image;
+    job.format = static_cast<GLenum>(image->format());
+    job.type = image->type();
+    job.mipmaps = generateMipmaps;
+    job.remaining = static_cast<size_t>(image->width()) * static_cast<size_t>(image->height()) * channelCount(image->format());
+    _stats.bytesPending += job.remaining;
+    _jobs.push_back(std::move(job));
+    return texture;
+}
+
+shared_ptr<Texture> TextureUploader::upload(const shared_ptr<const Ktx2Texture>& ktx) {
+    if (ktx == nullptr || !ktx->uploadable() || ktx->levels.empty() || !Texture::isFormatSupported(ktx->format)) {
+        return nullptr;
+    }
+    Job job;
+    job.internalFormat = Texture::toInternalFormat(ktx->format);
+    auto texture = createStorage(job.internalFormat, static_cast<int>(ktx->width), static_cast<int>(ktx->height),
+        static_cast<GLsizei>(ktx->levels.size()));
+    if (texture == nullptr) {
+        return nullptr;
+    }
+    job.texture = texture;
+    job.ktx = ktx;
+    job.format = GL_RGBA;
+    job.type = GL_UNSIGNED_BYTE;
+    job.compressed = isBlockCompressed(ktx->format);
+    for (const auto& level : ktx->levels) {
+        job.remaining += level.length;
+    }
+    _stats.bytesPending += job.remaining;
+    _jobs.push_back(std::move(job));
+    return texture;
+}
+
+void TextureUploader::update(size_t byteBudget) {
+    process(byteBudget, false);
+}
+
+void TextureUploader::finish() {
+    process(std::numeric_limits<size_t>::max(), true);
+}
+
+bool TextureUploader::busy() const {
+    return !_jobs.empty();
+}
+
+const TextureUploader::Stats& TextureUploader::stats() const {
+    return _stats;
+}
+
+void TextureUploader::process(size_t byteBudget, bool wait) {
+    if (_jobs.empty()) {
+        return;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    size_t used = 0;
+    while (!_jobs.empty() && used < byteBudget) {
+        Job& job = _jobs.front();
+        if (job.texture.expired()) {
+            _stats.bytesPending -= job.remaining;
+            _jobs.pop_front();
+            continue;
+        }
+        const size_t copied = copyRows(job, byteBudget - used, wait);
+        if (copied == 0) {
+            ++_stats.stalls;
+            break;
+        }
+        used += copied;
+        const size_t levelCount = job.ktx ? job.ktx->levels.size() : 1;
+        if (job.level == levelCount) {
+            finishJob(job);
+            _jobs.pop_front();
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool TextureUploader::available(Staging& staging, bool wait) {
+    if (staging.fence == 0) {
+        return true;
+    }
+    GLenum result = glClientWaitSync(staging.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? FENCE_TIMEOUT : 0);
+    while (wait && result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync(staging.fence, 0, FENCE_TIMEOUT);
+    }
+    if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+        glDeleteSync(staging.fence);
+        staging.fence = 0;
+        return true;
+    }
+    return false;
+}
+
+size_t TextureUploader::copyRows(Job& job, size_t maxBytes, bool wait) {
+    auto texture = job.texture.lock();
+    const GLint level = static_cast<GLint>(job.level);
+    const GLsizei width = std::max(1, texture->width() >> level);
+    const GLsizei height = std::max(1, texture->height() >> level);
+
+    // Compressed textures are copied in rows of 4x4 blocks.
+    const uint32_t rowHeight = job.compressed ? 4 : 1;
+    const uint32_t rowCount = (static_cast<uint32_t>(height) + rowHeight - 1) / rowHeight;
+    size_t rowBytes;
+    const uint8_t* source;
+    if (job.ktx) {
+        rowBytes = job.ktx->levels[job.level].length / rowCount;
+        source = job.ktx->levelData(job.level);
+    }
+    else {
+        rowBytes = static_cast<size_t>(width) * channelCount(job.image->format());
+        source = job.image->data();
+    }
+    source += job.row * rowBytes;
+
+    const size_t chunkBytes = std::min(maxBytes, _bufferSize);
+    const uint32_t rows = std::min(rowCount - job.row, std::max(1u, static_cast<uint32_t>(chunkBytes / rowBytes)));
+    const size_t bytes = rows * rowBytes;
+
+    // A row that doesn't fit in a staging buffer is copied from client memory.
+    const bool staged = bytes <= _bufferSize;
+    Staging* staging = nullptr;
+    if (staged) {
+        staging = &_staging[_next];
+        if (!available(*staging, wait)) {
+            return 0;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging->buffer);
+        // The fence guarantees the GPU is done with the buffer so the driver doesn't need to synchronize.
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (mapped == nullptr) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return 0;
+        }
+        memcpy(mapped, source, bytes);
+        if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE) {
+            // The buffer was corrupted. Copy the rows again next time.
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return 0;
+        }
+        // The pixels are read from offset 0 of the bound buffer.
+        source = nullptr;
+    }
+
+    const GLint y = static_cast<GLint>(job.row * rowHeight);
+    const GLsizei h = std::min(static_cast<GLsizei>(rows * rowHeight), height - y);
+    glBindTexture(GL_TEXTURE_2D, texture->handle());
+    if (job.compressed) {
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, y, width, h, job.internalFormat, static_cast<GLsizei>(bytes), source);
+    }
+    else {
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, y, width, h, job.format, job.type, source);
+    }
+
+    if (staged) {
+        staging->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        _next = (_next + 1) % _staging.size();
+    }
+
+    job.row += rows;
+    if (job.row == rowCount) {
+        job.row = 0;
+        ++job.level;
+    }
+    job.remaining -= bytes;
+    _stats.bytesPending -= bytes;
+    _stats.bytesUploaded += bytes;
+    return bytes;
+}
+
+void TextureUploader::finishJob(Job& job) {
+    auto texture = job.texture.lock();
+    if (job.mipmaps) {
+        glBindTexture(GL_TEXTURE_2D, texture->handle());
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    texture->setPlaceholder(nullptr);
+    ++_stats.texturesUploaded;
+}
+
+shared_ptr<Texture> TextureUploader::createStorage(GLenum internalFormat, int width, int height, GLsizei levels) {
+    if (_placeholder == nullptr) {
+        static constexpr unsigned char white[] = {255, 255, 255, 255};
+        TextureHandle handle;
+        glGenTextures(1, &handle);
+        glBindTexture(GL_TEXTURE_2D, handle);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+        _placeholder = std::make_shared<Texture>(handle, Texture::Type::TEXTURE_2D, 1, 1);
+    }
+    TextureHandle handle;
+    glGenTextures(1, &handle);
+    if (handle == 0) {
+        return nullptr;
+    }
+    glBindTexture(GL_TEXTURE_2D, handle);
+    glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    auto texture = std::make_shared<Texture>(handle, Texture::Type::TEXTURE_2D, width, height);
+    texture->setPlaceholder(_placeholder);
+    return texture;
+}
+
+} // namespace gl
+} // namespace kepler
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <BaseGL.hpp>
+#include <OpenGL.hpp>
+#include <Ktx2.hpp>
+
+#include <vector>
+#include <deque>
+
+namespace kepler {
+namespace gl {
+
+/// TextureUploader streams texture data to the GPU over several frames so large textures don't cause hitches.
+///
+/// upload() allocates immutable storage and returns the texture right away. The pixel data is copied into a ring
+/// of pixel buffer objects by update(), a few rows at a time, and glTexSubImage2D reads it from the buffer so the
+/// driver doesn't have to copy from client memory. Each buffer is fenced and only written again once the GPU is
+/// done with it. update() stops once the per frame byte budget is used up.
+///
+/// A texture binds a 1x1 white placeholder until all of its rows have been submitted. GL orders the copies before
+/// any draw that follows them so the texture is complete from then on.
+class TextureUploader {
+public:
+    /// Counters since the uploader was created.
+    struct Stats {
+        /// Number of textures that are fully uploaded.
+        size_t texturesUploaded = 0;
+        /// Number of bytes copied to the staging buffers.
+        size_t bytesUploaded = 0;
+        /// Number of bytes that are still waiting to be copied.
+        size_t bytesPending = 0;
+        /// Number of calls to update() that stopped early because every staging buffer was still in use.
+        size_t stalls = 0;
+    };
+
+    /// Use TextureUploader::create()
+    TextureUploader(size_t bufferSize, size_t bufferCount);
+    virtual ~TextureUploader() noexcept;
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader& operator=(const TextureUploader&) = delete;
+
+    /// Creates an uploader.
+    /// @param[in] bufferSize  The size of each staging buffer in bytes. A row of a texture that is larger
+    ///                        than this is uploaded directly from client memory.
+    /// @param[in] bufferCount The number of staging buffers. 3 lets the GPU be up to 2 frames behind.
+    static shared_ptr<TextureUploader> create(size_t bufferSize = 4 * 1024 * 1024, size_t bufferCount = 3);
+
+    /// Queues the upload of an image. The image is kept until it has been copied.
+    /// @param[in] internalFormat  Internal format of the texture. GL_RGB, GL_RGBA...
+    /// @param[in] generateMipmaps True if mipmaps should be generated after the last row is uploaded.
+    /// @return The texture. It binds a placeholder until the upload is finished. Null if there was an error.
+    shared_ptr<Texture> upload(const shared_ptr<Image>& image, int internalFormat, bool generateMipmaps);
+
+    /// Queues the upload of every level of a KTX2 texture.
+    /// @return The texture. Null if the format is not supported by the driver.
+    shared_ptr<Texture> upload(const shared_ptr<const Ktx2Texture>& ktx);
+
+    /// Copies queued data to the GPU until the byte budget is used up. Call once per frame on the GL thread.
+    /// @param[in] byteBudget The max number of bytes to copy. At least one chunk is copied if there is work.
+    void update(size_t byteBudget = 2 * 1024 * 1024);
+
+    /// Uploads everything that is queued, waiting for staging buffers if needed.
+    void finish();
+
+    /// Returns true if there are uploads that haven't finished.
+    bool busy() const;
+
+    /// Returns the counters.
+    const Stats& stats() const;
+
+private:
+    struct Job {
+        /// Weak so the upload is dropped if nothing uses the texture anymore.
+        std::weak_ptr<Texture> texture;
+        shared_ptr<Image> image;
+        shared_ptr<const Ktx2Texture> ktx;
+        GLenum format = 0;
+        GLenum type = 0;
+        GLenum internalFormat = 0;
+        bool compressed = false;
+        bool mipmaps = false;
+        /// The level and row that will be copied next. Rows are block rows for compressed textures.
+        size_t level = 0;
+        uint32_t row = 0;
+        /// Bytes left to copy.
+        size_t remaining = 0;
+    };
+
+    struct Staging {
+        GLuint buffer = 0;
+        GLsync fence = 0;
+    };
+
+    /// Copies jobs in order until the budget is used up or a staging buffer isn't available.
+    void process(size_t byteBudget, bool wait);
+    /// Waits for the fence if wait is true. Returns true if the buffer can be written.
+    bool available(Staging& staging, bool wait);
+    /// Copies the next rows of the job. Returns the number of bytes copied.
+    size_t copyRows(Job& job, size_t maxBytes, bool wait);
+    void finishJob(Job& job);
+    /// Creates the texture with immutable storage and the placeholder bound in its place.
+    shared_ptr<Texture> createStorage(GLenum internalFormat, int width, int height, GLsizei levels);
+
+private:
+    std::vector<Staging> _staging;
+    size_t _next = 0;
+    size_t _bufferSize;
+    std::deque<Job> _jobs;
+    shared_ptr<Texture> _placeholder;
+    Stats _stats;
+};
+
+} // namespace gl
+} // namespace kepler
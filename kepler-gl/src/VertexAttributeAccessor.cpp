@@ -24,5 +24,29 @@ GLsizei VertexAttributeAccessor::count() const {
     return _count;
 }
 
+const shared_ptr<VertexBuffer>& VertexAttributeAccessor::buffer() const {
+    return _vbo;
+}
+
+GLint VertexAttributeAccessor::componentSize() const {
+    return _componentSize;
+}
+
+GLenum VertexAttributeAccessor::type() const {
+    return _type;
+}
+
+GLboolean VertexAttributeAccessor::normalized() const {
+    return _normalized;
+}
+
+GLsizei VertexAttributeAccessor::stride() const {
+    return _stride;
+}
+
+GLintptr VertexAttributeAccessor::offset() const {
+    return _offset;
+}
+
 } // namespace gl
 } // namespace kepler
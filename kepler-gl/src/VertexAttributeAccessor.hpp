@@ -21,6 +21,15 @@ public:
 
     GLsizei count() const;
 
+    /// Returns the buffer that holds the vertices.
+    const shared_ptr<VertexBuffer>& buffer() const;
+    /// Returns the parameters of glVertexAttribPointer.
+    GLint componentSize() const;
+    GLenum type() const;
+    GLboolean normalized() const;
+    GLsizei stride() const;
+    GLintptr offset() const;
+
 private:
     shared_ptr<VertexBuffer> _vbo;
     GLint _componentSize;
@@ -2,6 +2,7 @@
 
 #include <BaseGL.hpp>
 #include <OpenGL.hpp>
+#include <GLStats.hpp>
 
 namespace kepler {
 namespace gl {
@@ -25,6 +26,7 @@ public:
     VertexAttributeBinding& operator=(VertexAttributeBinding&& other) noexcept;
 
     void bind() {
+        KEPLER_GL_COUNT(VERTEX_ARRAY_BINDS);
         glBindVertexArray(_handle);
     }
 
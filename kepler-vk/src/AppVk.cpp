@@ -2,6 +2,7 @@
 #include <GLFW/glfw3.h>
 #include <AppVk.hpp>
 #include <VulkanState.hpp>
+#include <Performance.hpp>
 
 #include <string>
 
@@ -260,8 +261,13 @@ void App::Impl::mainLoop() {
         // If depth writes were disabled then glClear won't clear the depth buffer.
         // This can happen if the last object to be drawn disabled depth writes.
         //RenderState::setGlobalDepthMask(true);
+        FrameProfiler::beginFrame();
         if (_delegate) {
-            _delegate->update();
+            {
+                ProfileScope scope("update");
+                _delegate->update();
+            }
+            ProfileScope scope("render");
             _delegate->render();
         }
     }
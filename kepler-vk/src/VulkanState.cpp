@@ -3,6 +3,7 @@
 #include "Shader.hpp"
 
 #include <VulkanUtils.hpp>
+#include <Performance.hpp>
 
 // Vulkan hello world from https://vulkan-tutorial.com
 // This is only for learning about Vulkan
@@ -140,6 +141,10 @@ void VulkanState::cleanupSwapChain() {
     }
 
     g_device.freeCommandBuffers(_commandPool, _commandBuffers);
+    if (_timestampPool) {
+        g_device.destroyQueryPool(_timestampPool);
+        _timestampPool = nullptr;
+    }
 
     g_device.destroyPipeline(_graphicsPipeline);
     g_device.destroyPipelineLayout(_pipelineLayout);
@@ -603,6 +608,15 @@ void VulkanState::createCommandBuffers() {
 
     _commandBuffers = g_device.allocateCommandBuffers(allocInfo);
 
+    const auto properties = g_physicalDevice.getProperties();
+    if (properties.limits.timestampComputeAndGraphics) {
+        vk::QueryPoolCreateInfo queryPoolInfo;
+        queryPoolInfo.queryType = vk::QueryType::eTimestamp;
+        queryPoolInfo.queryCount = static_cast<uint32_t>(_commandBuffers.size() * 2);
+        _timestampPool = g_device.createQueryPool(queryPoolInfo);
+        _timestampPeriod = properties.limits.timestampPeriod;
+    }
+
     for (size_t i = 0; i < _commandBuffers.size(); i++) {
         vk::CommandBufferBeginInfo beginInfo;
         beginInfo.flags = vk::CommandBufferUsageFlagBits::eSimultaneousUse;
@@ -611,6 +625,13 @@ void VulkanState::createCommandBuffers() {
 
         commandBuffer.begin(beginInfo);
 
+        const uint32_t firstQuery = static_cast<uint32_t>(i * 2);
+        if (_timestampPool) {
+            // Queries must be reset outside of a render pass before they are written again.
+            commandBuffer.resetQueryPool(_timestampPool, firstQuery, 2);
+            commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, _timestampPool, firstQuery);
+        }
+
         vk::RenderPassBeginInfo renderPassInfo;
         renderPassInfo.renderPass = _renderPass;
         renderPassInfo.framebuffer = _swapChainFramebuffers[i];
@@ -634,6 +655,9 @@ void VulkanState::createCommandBuffers() {
         commandBuffer.drawIndexed(static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
 
         commandBuffer.endRenderPass();
+        if (_timestampPool) {
+            commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, _timestampPool, firstQuery + 1);
+        }
         commandBuffer.end();
     }
 }
@@ -722,6 +746,16 @@ void VulkanState::drawFrame() {
     }
 
     _presentQueue.waitIdle();
+
+    if (_timestampPool) {
+        // The queue is idle so the results are ready. Don't wait in case the image was never drawn.
+        uint64_t timestamps[2] = {};
+        if (g_device.getQueryPoolResults(_timestampPool, imageIndex * 2, 2, sizeof(timestamps), timestamps,
+            sizeof(uint64_t), vk::QueryResultFlagBits::e64) == vk::Result::eSuccess && timestamps[1] >= timestamps[0]) {
+            const double ms = static_cast<double>(timestamps[1] - timestamps[0]) * _timestampPeriod / 1000000.0;
+            FrameProfiler::addGpuTime(FrameProfiler::frameNumber(), "render", ms);
+        }
+    }
     _currentFrame = (_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
@@ -88,6 +88,12 @@ private:
 
     std::vector<vk::CommandBuffer> _commandBuffers;
 
+    /// Two timestamps per swapchain image that measure the GPU time of its command buffer.
+    /// Null if the graphics queue doesn't support timestamps.
+    vk::QueryPool _timestampPool;
+    /// Nanoseconds per timestamp tick.
+    float _timestampPeriod = 0.0f;
+
     std::vector<vk::Semaphore> _imageAvailableSemaphores;
     std::vector<vk::Semaphore> _renderFinishedSemaphores;
     std::vector<vk::Fence> _inFlightFences;
@@ -1,9 +1,21 @@
 #version 330 core
+#ifdef BINDLESS_TEXTURES
+#extension GL_ARB_bindless_texture : require
+#endif
 precision mediump float;
 
 #ifdef HAS_BASE_COLOR_MAP
+#ifdef BINDLESS_TEXTURES
+layout(bindless_sampler) uniform sampler2D s_baseMap;
+#else
 uniform sampler2D s_baseMap;
 #endif
+#endif
+
+#ifdef HAS_BASE_COLOR_ARRAY
+uniform sampler2DArray s_baseMaps;
+uniform float baseMapLayer;
+#endif
 
 uniform vec3 lightPos;
 uniform vec3 lightColor;
@@ -17,6 +29,18 @@ uniform float quadraticAttenuation;
 
 uniform vec4 baseColorFactor;
 
+#ifdef CLUSTERED_LIGHTS
+// 2 texels per light: view space position and range, color
+uniform samplerBuffer u_lights;
+// 1 texel per cluster: offset into u_lightIndices and light count
+uniform usamplerBuffer u_clusters;
+uniform usamplerBuffer u_lightIndices;
+// tile width and height in pixels, tiles x and y
+uniform vec4 clusterGrid;
+// slice scale, slice bias, slice count and 1 if the slices are linear
+uniform vec4 clusterSlices;
+#endif
+
 vec2 u_MetallicRoughness;
 
 in vec3 v_fragPos;
@@ -31,8 +55,45 @@ in vec2 v_texcoord0;
 
 layout(location = 0) out vec4 fragColor;
 
+#ifdef CLUSTERED_LIGHTS
+// Returns the diffuse and specular light of the lights in the cluster of this fragment.
+vec3 clusteredLights(vec3 normal, vec3 viewDir) {
+    float depth = -v_fragPos.z;
+    float f = clusterSlices.w > 0.5 ? depth : log(max(depth, 1e-6));
+    int slice = int(clamp(floor(f * clusterSlices.x + clusterSlices.y), 0.0, clusterSlices.z - 1.0));
+    ivec2 tile = ivec2(clamp(floor(gl_FragCoord.xy / clusterGrid.xy), vec2(0.0), clusterGrid.zw - 1.0));
+    int cluster = (slice * int(clusterGrid.w) + tile.y) * int(clusterGrid.z) + tile.x;
+
+    uvec2 range = texelFetch(u_clusters, cluster).xy;
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < range.y; ++i) {
+        int light = int(texelFetch(u_lightIndices, int(range.x + i)).x);
+        vec4 positionRange = texelFetch(u_lights, light * 2);
+        vec3 color = texelFetch(u_lights, light * 2 + 1).rgb;
+
+        vec3 toLight = positionRange.xyz - v_fragPos;
+        float lightDistance = length(toLight);
+        vec3 lightDir = toLight / max(lightDistance, 1e-6);
+        // inverse square falloff that smoothly reaches zero at the range of the light
+        float window = clamp(1.0 - pow(lightDistance / positionRange.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (lightDistance * lightDistance + 1.0);
+
+        float d = max(dot(normal, lightDir), 0.0);
+        float s = 0.0;
+        if (d > 0.0) {
+            s = pow(max(dot(normal, normalize(lightDir + viewDir)), 0.0), shininess) * specularStrength;
+        }
+        result += (d + s) * color * attenuation;
+    }
+    return result;
+}
+#endif
+
 void main() {
     vec3 normal = normalize(v_normal);
+#ifdef CLUSTERED_LIGHTS
+    vec3 color = (ambient + clusteredLights(normal, normalize(-v_fragPos))) * vec3(baseColorFactor);
+#else
     vec3 lightDir = normalize(lightPos - v_fragPos);
 
     float lightDistance = length(lightDir);
@@ -58,9 +119,12 @@ void main() {
     vec3 specular = s * lightColor * attenuation;
 
     vec3 color = (ambient + diffuse + specular) * vec3(baseColorFactor);
+#endif
 
     #if defined(HAS_UV) && defined(HAS_BASE_COLOR_MAP)
         color *= vec3(texture(s_baseMap, v_texcoord0));
+    #elif defined(HAS_UV) && defined(HAS_BASE_COLOR_ARRAY)
+        color *= vec3(texture(s_baseMaps, vec3(v_texcoord0, baseMapLayer)));
     #endif
 
     fragColor = vec4(color, 1.0);
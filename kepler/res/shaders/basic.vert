@@ -1,6 +1,10 @@
 #version 330 core
 layout (location = 0) in vec3 a_position;
+#ifdef OCT_NORMALS
+layout (location = 1) in vec2 a_normal;
+#else
 layout (location = 1) in vec3 a_normal;
+#endif
 layout (location = 2) in vec2 a_texcoord0;
 
 uniform mat4 mvp;
@@ -14,11 +18,25 @@ out vec3 v_normal;
 out vec2 v_texcoord0;
 #endif
 
+#ifdef OCT_NORMALS
+// Decodes an octahedral encoded unit vector.
+vec3 octDecode(vec2 e) {
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.xy += mix(vec2(t), vec2(-t), greaterThanEqual(v.xy, vec2(0.0)));
+    return normalize(v);
+}
+#endif
+
 void main() {
     vec4 position = vec4(a_position, 1.0);
     gl_Position = mvp * position;
     v_fragPos = vec3(modelView * position);
+    #ifdef OCT_NORMALS
+    v_normal = normalize(normalMatrix * octDecode(a_normal));
+    #else
     v_normal = normalize(normalMatrix * a_normal);
+    #endif
 
     #ifdef HAS_UV
     v_texcoord0 = a_texcoord0;
@@ -11,6 +11,10 @@ class Bounded;
 class DrawableComponent;
 class Button;
 class BoundingBox;
+class OcclusionBuffer;
+class Occluder;
+class LodSelector;
+class LightClusters;
 
 class App;
 class AppDelegate;
@@ -0,0 +1,321 @@
+#include "stdafx.h"
+#include "CookedFormat.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace kepler {
+namespace cooked {
+
+static constexpr uint8_t IDENTIFIER[8] = {0xAB, 'K', 'C', 'S', 'N', '\r', '\n', 0x1A};
+
+static size_t alignUp(size_t value) {
+    return (value + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+/// Appends the records as a table on a 16 byte boundary. The records are copied as is since every platform the
+/// engine runs on is little endian.
+template<typename T>
+static void writeTable(const std::vector<T>& records, Section& section, std::vector<uint8_t>& out) {
+    out.resize(alignUp(out.size()));
+    section.offset = out.size();
+    section.count = records.size();
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(records.data());
+    out.insert(out.end(), bytes, bytes + records.size() * sizeof(T));
+}
+
+/// Points table at the records of the section. Returns false if they aren't in the file.
+template<typename T>
+static bool readTable(ByteSpan file, const Section& section, const T*& table, size_t& count) {
+    if (section.offset % ALIGNMENT != 0 || section.count > file.size / sizeof(T)) {
+        return false;
+    }
+    ByteSpan span = file.subspan(static_cast<size_t>(section.offset), static_cast<size_t>(section.count) * sizeof(T));
+    if (span.data == nullptr) {
+        return false;
+    }
+    table = reinterpret_cast<const T*>(span.data);
+    count = static_cast<size_t>(section.count);
+    return true;
+}
+
+/// Returns true if the range [first, first + count) is in [0, size).
+static bool inRange(uint64_t first, uint64_t count, size_t size) {
+    return first <= size && count <= size - first;
+}
+
+static bool indexValid(uint32_t index, size_t count) {
+    return index == NONE || index < count;
+}
+
+// The core library doesn't include GL so the enums that the checks need are spelled out.
+
+/// Returns the size of a component of a vertex attribute type or 0 if the type isn't one the engine uses.
+static uint64_t componentTypeSize(uint32_t type) {
+    switch (type) {
+    case 0x1400: // GL_BYTE
+    case 0x1401: // GL_UNSIGNED_BYTE
+        return 1;
+    case 0x1402: // GL_SHORT
+    case 0x1403: // GL_UNSIGNED_SHORT
+    case 0x140B: // GL_HALF_FLOAT
+        return 2;
+    case 0x1404: // GL_INT
+    case 0x1405: // GL_UNSIGNED_INT
+    case 0x1406: // GL_FLOAT
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+/// Returns the size of an index type or 0 if it isn't an index type.
+static uint64_t indexTypeSize(uint32_t type) {
+    switch (type) {
+    case 0x1401: // GL_UNSIGNED_BYTE
+        return 1;
+    case 0x1403: // GL_UNSIGNED_SHORT
+        return 2;
+    case 0x1405: // GL_UNSIGNED_INT
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+static constexpr uint32_t GL_ELEMENT_ARRAY_BUFFER_TARGET = 0x8893;
+
+/// Returns the size of a 4x4 block of a compressed internal format or 0 if the format isn't known.
+static uint64_t compressedBlockSize(uint32_t internalFormat) {
+    switch (internalFormat) {
+    case 0x83F0: // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    case 0x83F1: // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+    case 0x8C4C: // GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+    case 0x8C4D: // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+    case 0x8DBB: // GL_COMPRESSED_RED_RGTC1
+    case 0x8DBC: // GL_COMPRESSED_SIGNED_RED_RGTC1
+        return 8;
+    case 0x83F2: // GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+    case 0x83F3: // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+    case 0x8C4E: // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT
+    case 0x8C4F: // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+    case 0x8DBD: // GL_COMPRESSED_RG_RGTC2
+    case 0x8DBE: // GL_COMPRESSED_SIGNED_RG_RGTC2
+    case 0x8E8C: // GL_COMPRESSED_RGBA_BPTC_UNORM
+    case 0x8E8D: // GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+    case 0x8E8E: // GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT
+    case 0x8E8F: // GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+// Larger than any texture GL supports, which keeps the level sizes from overflowing.
+static constexpr uint32_t MAX_TEXTURE_SIZE = 1 << 16;
+
+/// Returns the number of bytes that are uploaded for a level of a texture or 0 if the format isn't known.
+static uint64_t levelSize(const Texture& texture, uint32_t level) {
+    const uint64_t w = std::max(1u, texture.width >> level);
+    const uint64_t h = std::max(1u, texture.height >> level);
+    if (texture.flags & Texture::COMPRESSED) {
+        return (w + 3) / 4 * ((h + 3) / 4) * texture.depth * compressedBlockSize(texture.internalFormat);
+    }
+    // Uncompressed levels are uploaded as RGBA8.
+    return w * h * texture.depth * 4;
+}
+
+/// Returns false if the attributes of a primitive or its indices read outside of their buffers.
+static bool primitiveValid(const SceneView& view, const Primitive& prim) {
+    // Every attribute has an element per vertex.
+    uint64_t vertexCount = 0;
+    for (uint32_t i = 0; i < prim.attributeCount; ++i) {
+        const Attribute& attribute = view.attributes[prim.firstAttribute + i];
+        if (i > 0 && attribute.count != vertexCount) {
+            return false;
+        }
+        vertexCount = attribute.count;
+    }
+    if (prim.indexBuffer == NONE) {
+        return true;
+    }
+    const Buffer& buffer = view.buffers[prim.indexBuffer];
+    const uint64_t indexSize = indexTypeSize(prim.indexType);
+    if (buffer.target != GL_ELEMENT_ARRAY_BUFFER_TARGET || indexSize == 0 || prim.indexOffset % indexSize != 0
+        || !inRange(prim.indexOffset, prim.indexCount * indexSize, static_cast<size_t>(buffer.size))) {
+        return false;
+    }
+    const uint8_t* indices = view.data.data + buffer.offset + prim.indexOffset;
+    for (uint32_t i = 0; i < prim.indexCount; ++i) {
+        uint32_t index = 0;
+        if (indexSize == 2) {
+            uint16_t index16;
+            memcpy(&index16, indices + i * indexSize, sizeof(index16));
+            index = index16;
+        }
+        else {
+            memcpy(&index, indices + i * indexSize, static_cast<size_t>(indexSize));
+        }
+        if (index >= vertexCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t SceneData::addString(const char* str) {
+    if (str == nullptr || *str == '\0') {
+        return 0;
+    }
+    const uint32_t offset = static_cast<uint32_t>(strings.size());
+    strings.append(str);
+    strings.push_back('\0');
+    return offset;
+}
+
+uint64_t SceneData::addData(const void* bytes, size_t size) {
+    const size_t offset = alignUp(data.size());
+    data.resize(offset + size);
+    if (bytes != nullptr && size > 0) {
+        memcpy(data.data() + offset, bytes, size);
+    }
+    return offset;
+}
+
+bool isCooked(const uint8_t* data, size_t length) {
+    return length >= sizeof(IDENTIFIER) && memcmp(data, IDENTIFIER, sizeof(IDENTIFIER)) == 0;
+}
+
+void write(const SceneData& scene, std::vector<uint8_t>& destination) {
+    Header header = {};
+    memcpy(header.magic, IDENTIFIER, sizeof(IDENTIFIER));
+    header.version = VERSION;
+
+    destination.clear();
+    destination.resize(sizeof(Header));
+    writeTable(scene.nodes, header.sections[NODES], destination);
+    writeTable(scene.meshes, header.sections[MESHES], destination);
+    writeTable(scene.primitives, header.sections[PRIMITIVES], destination);
+    writeTable(scene.attributes, header.sections[ATTRIBUTES], destination);
+    writeTable(scene.materials, header.sections[MATERIALS], destination);
+    writeTable(scene.textures, header.sections[TEXTURES], destination);
+    writeTable(scene.levels, header.sections[LEVELS], destination);
+    writeTable(scene.buffers, header.sections[BUFFERS], destination);
+    std::vector<uint8_t> strings(scene.strings.begin(), scene.strings.end());
+    writeTable(strings, header.sections[STRINGS], destination);
+    writeTable(scene.data, header.sections[DATA], destination);
+    destination.resize(alignUp(destination.size()));
+
+    header.fileSize = destination.size();
+    memcpy(destination.data(), &header, sizeof(Header));
+}
+
+bool read(ByteSpan file, SceneView& view) {
+    if (file.size < sizeof(Header) || !isCooked(file.data, file.size)
+        || reinterpret_cast<uintptr_t>(file.data) % ALIGNMENT != 0) {
+        return false;
+    }
+    const Header& header = *reinterpret_cast<const Header*>(file.data);
+    if (header.version != VERSION || header.fileSize > file.size) {
+        return false;
+    }
+    file.size = static_cast<size_t>(header.fileSize);
+
+    const uint8_t* strings = nullptr;
+    const uint8_t* data = nullptr;
+    size_t stringsSize = 0;
+    size_t dataSize = 0;
+    const Section* sections = header.sections;
+    if (!readTable(file, sections[NODES], view.nodes, view.nodeCount)
+        || !readTable(file, sections[MESHES], view.meshes, view.meshCount)
+        || !readTable(file, sections[PRIMITIVES], view.primitives, view.primitiveCount)
+        || !readTable(file, sections[ATTRIBUTES], view.attributes, view.attributeCount)
+        || !readTable(file, sections[MATERIALS], view.materials, view.materialCount)
+        || !readTable(file, sections[TEXTURES], view.textures, view.textureCount)
+        || !readTable(file, sections[LEVELS], view.levels, view.levelCount)
+        || !readTable(file, sections[BUFFERS], view.buffers, view.bufferCount)
+        || !readTable(file, sections[STRINGS], strings, stringsSize)
+        || !readTable(file, sections[DATA], data, dataSize)) {
+        return false;
+    }
+    // Every name must end inside the strings.
+    if (stringsSize == 0 || strings[stringsSize - 1] != '\0') {
+        return false;
+    }
+    view.strings = ByteSpan(strings, stringsSize);
+    view.data = ByteSpan(data, dataSize);
+
+    for (size_t i = 0; i < view.nodeCount; ++i) {
+        const Node& node = view.nodes[i];
+        if ((node.parent != NONE && node.parent >= i) || !indexValid(node.mesh, view.meshCount) || node.name >= stringsSize) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < view.meshCount; ++i) {
+        const Mesh& mesh = view.meshes[i];
+        if (!inRange(mesh.firstPrimitive, mesh.primitiveCount, view.primitiveCount) || mesh.name >= stringsSize) {
+            return false;
+        }
+    }
+    // Buffers and levels are checked first since the records below point into them.
+    for (size_t i = 0; i < view.bufferCount; ++i) {
+        if (!inRange(view.buffers[i].offset, view.buffers[i].size, dataSize)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < view.levelCount; ++i) {
+        if (!inRange(view.levels[i].offset, view.levels[i].size, dataSize)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < view.attributeCount; ++i) {
+        const Attribute& attribute = view.attributes[i];
+        const uint64_t elementSize = componentTypeSize(attribute.type) * attribute.componentSize;
+        if (attribute.buffer >= view.bufferCount || elementSize == 0 || attribute.componentSize > 4) {
+            return false;
+        }
+        // The last element ends at offset + stride * (count - 1) + elementSize.
+        const uint64_t stride = attribute.stride != 0 ? attribute.stride : elementSize;
+        const uint64_t span = attribute.count == 0 ? 0 : stride * (attribute.count - 1) + elementSize;
+        if (!inRange(attribute.offset, span, static_cast<size_t>(view.buffers[attribute.buffer].size))) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < view.primitiveCount; ++i) {
+        const Primitive& prim = view.primitives[i];
+        if (!inRange(prim.firstAttribute, prim.attributeCount, view.attributeCount)
+            || !indexValid(prim.material, view.materialCount) || !indexValid(prim.indexBuffer, view.bufferCount)
+            || !primitiveValid(view, prim)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < view.materialCount; ++i) {
+        const Material& material = view.materials[i];
+        if (!indexValid(material.baseMap, view.textureCount) || material.name >= stringsSize) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < view.textureCount; ++i) {
+        const Texture& texture = view.textures[i];
+        if (texture.levelCount == 0 || !inRange(texture.firstLevel, texture.levelCount, view.levelCount)
+            || texture.width == 0 || texture.height == 0 || texture.depth == 0 || texture.width > MAX_TEXTURE_SIZE
+            || texture.height > MAX_TEXTURE_SIZE || texture.depth > MAX_TEXTURE_SIZE) {
+            return false;
+        }
+        // Every level is uploaded with the size GL expects so the driver never reads past the end of one.
+        for (uint32_t level = 0; level < texture.levelCount; ++level) {
+            if (level > 0 && (texture.width >> level) == 0 && (texture.height >> level) == 0) {
+                // More levels than the mip chain has.
+                return false;
+            }
+            const uint64_t size = levelSize(texture, level);
+            if (size == 0 || view.levels[texture.firstLevel + level].size != size) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace cooked
+} // namespace kepler
@@ -0,0 +1,235 @@
+#pragma once
+
+#include "Base.hpp"
+#include "MappedFile.hpp"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace kepler {
+
+/// The cooked scene format is an engine native binary file that holds a scene ready to be uploaded.
+///
+/// The file is a header followed by tables of fixed size records and a data blob. Every table and every blob in
+/// the data section starts on a 16 byte boundary. Tables are located by offsets from the start of the file and the
+/// records refer to each other by index and to the data by offsets from the start of the data section, so the file
+/// has no pointers and can be used in place wherever it is mapped. Values are stored little endian.
+///
+/// GL enums are stored as is since the vertex, index and texture data is already in the layout it is drawn with.
+namespace cooked {
+
+static constexpr uint32_t VERSION = 1;
+static constexpr size_t ALIGNMENT = 16;
+/// Index value that means there is no record.
+static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+enum SectionType {
+    NODES,
+    MESHES,
+    PRIMITIVES,
+    ATTRIBUTES,
+    MATERIALS,
+    TEXTURES,
+    LEVELS,
+    BUFFERS,
+    STRINGS,
+    DATA,
+    SECTION_COUNT
+};
+
+struct Section {
+    /// Offset from the start of the file.
+    uint64_t offset;
+    /// Number of records or bytes for STRINGS and DATA.
+    uint64_t count;
+};
+
+struct Header {
+    uint8_t magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t fileSize;
+    uint64_t reserved2;
+    Section sections[SECTION_COUNT];
+};
+
+/// Nodes are stored parents first.
+struct Node {
+    float matrix[16];
+    /// Index of the parent node or NONE for the nodes at the root of the scene.
+    uint32_t parent;
+    uint32_t mesh;
+    /// Offset of the name in the strings.
+    uint32_t name;
+    uint32_t reserved;
+};
+
+struct Mesh {
+    uint32_t firstPrimitive;
+    uint32_t primitiveCount;
+    uint32_t name;
+    uint32_t reserved;
+};
+
+struct Primitive {
+    enum Flags : uint32_t {
+        POSITION_TRANSFORM = 1,
+        BOUNDING_BOX = 2
+    };
+    float positionTransform[16];
+    float boxMin[4];
+    float boxMax[4];
+    uint32_t mode;
+    uint32_t material;
+    uint32_t firstAttribute;
+    uint32_t attributeCount;
+    /// NONE if the primitive isn't indexed.
+    uint32_t indexBuffer;
+    uint32_t indexType;
+    uint32_t indexCount;
+    uint32_t flags;
+    /// Offset of the first index in the index buffer.
+    uint64_t indexOffset;
+    uint64_t reserved;
+};
+
+/// The parameters of glVertexAttribPointer.
+struct Attribute {
+    uint32_t semantic;
+    uint32_t buffer;
+    uint32_t componentSize;
+    uint32_t type;
+    uint32_t normalized;
+    uint32_t stride;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t reserved2;
+};
+
+/// The parameters of a basic material.
+struct Material {
+    enum Flags : uint32_t {
+        DOUBLE_SIDED = 1
+    };
+    float baseColorFactor[4];
+    uint32_t baseMap;
+    int32_t baseMapLayer;
+    uint32_t flags;
+    uint32_t name;
+};
+
+struct Texture {
+    enum Flags : uint32_t {
+        COMPRESSED = 1
+    };
+    uint32_t target;
+    uint32_t internalFormat;
+    uint32_t width;
+    uint32_t height;
+    /// The number of layers of array textures; 1 otherwise.
+    uint32_t depth;
+    uint32_t firstLevel;
+    uint32_t levelCount;
+    uint32_t flags;
+    uint32_t wrapS;
+    uint32_t wrapT;
+    uint32_t minFilter;
+    uint32_t magFilter;
+};
+
+/// The pixels of a mip level. Every layer of an array texture is in one level.
+struct Level {
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct Buffer {
+    uint32_t target;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t reserved2;
+};
+
+static_assert(sizeof(Header) % ALIGNMENT == 0, "Records must keep the tables aligned");
+static_assert(sizeof(Node) % ALIGNMENT == 0, "Records must keep the tables aligned");
+static_assert(sizeof(Mesh) % ALIGNMENT == 0, "Records must keep the tables aligned");
+static_assert(sizeof(Primitive) % ALIGNMENT == 0, "Records must keep the tables aligned");
+static_assert(sizeof(Attribute) % ALIGNMENT == 0, "Records must keep the tables aligned");
+static_assert(sizeof(Material) % ALIGNMENT == 0, "Records must keep the tables aligned");
+static_assert(sizeof(Texture) % ALIGNMENT == 0, "Records must keep the tables aligned");
+static_assert(sizeof(Level) % ALIGNMENT == 0, "Records must keep the tables aligned");
+static_assert(sizeof(Buffer) % ALIGNMENT == 0, "Records must keep the tables aligned");
+
+/// The contents of a cooked file while it is being built.
+struct SceneData {
+    std::vector<Node> nodes;
+    std::vector<Mesh> meshes;
+    std::vector<Primitive> primitives;
+    std::vector<Attribute> attributes;
+    std::vector<Material> materials;
+    std::vector<Texture> textures;
+    std::vector<Level> levels;
+    std::vector<Buffer> buffers;
+    /// Null terminated strings. Starts with an empty string so a name of 0 is empty.
+    std::string strings = std::string(1, '\0');
+    std::vector<uint8_t> data;
+
+    /// Appends a string and returns its offset.
+    uint32_t addString(const char* str);
+
+    /// Appends bytes to the data on a 16 byte boundary and returns their offset.
+    /// @param[in] bytes Copied if not null; otherwise the bytes are zero so they can be filled in later.
+    uint64_t addData(const void* bytes, size_t size);
+};
+
+/// A cooked file that was checked by read(). The pointers point into the file.
+struct SceneView {
+    const Node* nodes = nullptr;
+    const Mesh* meshes = nullptr;
+    const Primitive* primitives = nullptr;
+    const Attribute* attributes = nullptr;
+    const Material* materials = nullptr;
+    const Texture* textures = nullptr;
+    const Level* levels = nullptr;
+    const Buffer* buffers = nullptr;
+    size_t nodeCount = 0;
+    size_t meshCount = 0;
+    size_t primitiveCount = 0;
+    size_t attributeCount = 0;
+    size_t materialCount = 0;
+    size_t textureCount = 0;
+    size_t levelCount = 0;
+    size_t bufferCount = 0;
+    ByteSpan strings;
+    ByteSpan data;
+
+    /// Returns the string at the offset.
+    const char* string(uint32_t offset) const {
+        return reinterpret_cast<const char*>(strings.data) + offset;
+    }
+
+    /// Returns the bytes of a buffer or level.
+    ByteSpan bytes(uint64_t offset, uint64_t size) const {
+        return data.subspan(static_cast<size_t>(offset), static_cast<size_t>(size));
+    }
+};
+
+/// Returns true if the memory starts with the cooked scene identifier.
+bool isCooked(const uint8_t* data, size_t length);
+
+/// Lays out the file.
+/// @param[out] destination The file data.
+void write(const SceneData& scene, std::vector<uint8_t>& destination);
+
+/// Checks that every table, index and range of the file is in bounds and points the view at the tables.
+/// Vertex attributes and indices must be inside their buffers, every index must refer to a vertex of the primitive
+/// and every texture level must have the size it is uploaded with, so nothing GL reads from the file is out of bounds.
+/// The file must be 16 byte aligned in memory, which mapped files always are.
+/// @return False if the file is not a valid cooked scene of this version.
+bool read(ByteSpan file, SceneView& view);
+
+} // namespace cooked
+} // namespace kepler
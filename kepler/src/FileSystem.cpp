@@ -1,6 +1,9 @@
 #include "stdafx.h"
 #include "FileSystem.hpp"
 
+#include <cstdlib>
+#include <climits>
+
 namespace kepler {
 
 using std::string;
@@ -55,6 +58,73 @@ string joinPath(const string& path1, const string& path2) {
     return path1 + '/' + path2;
 }
 
+/// Removes "." and ".." segments and duplicate slashes. Expects forward slashes.
+static string normalizePath(const string& path) {
+    const bool absolute = !path.empty() && path[0] == '/';
+    std::vector<string> segments;
+    size_t start = 0;
+    while (start <= path.length()) {
+        size_t end = path.find('/', start);
+        if (end == string::npos) {
+            end = path.length();
+        }
+        string segment = path.substr(start, end - start);
+        if (segment == "..") {
+            if (!segments.empty() && segments.back() != "..") {
+                segments.pop_back();
+            }
+            else if (!absolute) {
+                segments.push_back(segment);
+            }
+        }
+        else if (!segment.empty() && segment != ".") {
+            segments.push_back(segment);
+        }
+        start = end + 1;
+    }
+    string result = absolute ? "/" : "";
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (i > 0) {
+            result.push_back('/');
+        }
+        result.append(segments[i]);
+    }
+    return result;
+}
+
+string canonicalPath(const string& path) {
+    if (path.empty()) {
+        return "";
+    }
+    string result;
+#ifdef _WIN32
+    char full[_MAX_PATH];
+    if (fileExists(path) && _fullpath(full, path.c_str(), _MAX_PATH) != nullptr) {
+        result.assign(full);
+    }
+    else {
+        result = path;
+    }
+    std::replace(result.begin(), result.end(), '\\', '/');
+    std::transform(result.begin(), result.end(), result.begin(), [](char c) {
+        return static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    });
+    // Keep the drive letter out of normalizePath().
+    if (result.length() >= 2 && result[1] == ':') {
+        return result.substr(0, 2) + normalizePath(result.substr(2));
+    }
+    return normalizePath(result);
+#else
+    char full[PATH_MAX];
+    if (realpath(path.c_str(), full) != nullptr) {
+        return string(full);
+    }
+    result = path;
+    std::replace(result.begin(), result.end(), '\\', '/');
+    return normalizePath(result);
+#endif
+}
+
 bool fileExists(const char* path) {
     struct stat s;
     return stat(path, &s) == 0;
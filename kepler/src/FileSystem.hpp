@@ -26,6 +26,19 @@ std::string directoryName(const char* path);
 
 std::string joinPath(const std::string& path1, const std::string& path2);
 
+/// @ingroup filesystem
+/// Returns a path that is the same for every spelling of the same file.
+///
+/// Existing files are resolved to an absolute path. Back slashes are converted to forward slashes
+/// and `"."` and `".."` segments are removed. Windows paths are converted to lower case.
+/// If the file doesn't exist the path is only normalized lexically.
+///
+/// - `"res/./textures/../image.png"` will return the same path as `"res/image.png"`
+///
+/// @param[in] path The file path. May be relative or absolute.
+/// @return The canonical path. Returns "" if path is empty.
+std::string canonicalPath(const std::string& path);
+
 bool fileExists(const char* path);
 bool fileExists(const std::string& path);
 
@@ -0,0 +1,273 @@
+#include "stdafx.h"
+#include "Ktx2.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace kepler {
+
+static constexpr uint8_t IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+// Identifier, 9 header words, 4 index words and 2 64 bit index values.
+static constexpr size_t HEADER_SIZE = 12 + 9 * 4 + 4 * 4 + 2 * 8;
+static constexpr size_t LEVEL_INDEX_SIZE = 3 * 8;
+
+// Data format descriptor values from the Khronos Data Format Specification.
+static constexpr uint32_t KHR_DF_MODEL_RGBSDA = 1;
+static constexpr uint32_t KHR_DF_MODEL_BC1A = 128;
+static constexpr uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+static constexpr uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+static constexpr uint32_t KHR_DF_TRANSFER_SRGB = 2;
+static constexpr uint32_t KHR_DF_CHANNEL_ALPHA = 15;
+static constexpr uint32_t KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10;
+static constexpr uint32_t KHR_DF_SAMPLE_DATATYPE_SIGNED = 0x40;
+
+static uint32_t readU32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+static uint64_t readU64(const uint8_t* p) {
+    return static_cast<uint64_t>(readU32(p)) | static_cast<uint64_t>(readU32(p + 4)) << 32;
+}
+
+static void writeU32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+static void writeU64(std::vector<uint8_t>& out, uint64_t value) {
+    writeU32(out, static_cast<uint32_t>(value));
+    writeU32(out, static_cast<uint32_t>(value >> 32));
+}
+
+static void patchU64(std::vector<uint8_t>& out, size_t offset, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[offset + i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+static bool isSrgb(Ktx2Format format) {
+    switch (format) {
+    case Ktx2Format::R8G8B8A8_SRGB:
+    case Ktx2Format::BC1_RGB_SRGB:
+    case Ktx2Format::BC1_RGBA_SRGB:
+    case Ktx2Format::BC2_SRGB:
+    case Ktx2Format::BC3_SRGB:
+    case Ktx2Format::BC7_SRGB:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// Writes the basic data format descriptor that KTX 2.0 requires.
+static void writeDataFormatDescriptor(Ktx2Format format, std::vector<uint8_t>& out) {
+    struct Sample {
+        uint32_t bitOffset;
+        uint32_t bitLength;
+        uint32_t channel;
+    };
+    std::vector<Sample> samples;
+    uint32_t model = KHR_DF_MODEL_RGBSDA;
+    uint32_t blockDimensions = 0;
+    uint32_t bytesPlane0 = static_cast<uint32_t>(ktx2BlockSize(format));
+    if (isBlockCompressed(format)) {
+        const uint32_t value = static_cast<uint32_t>(format);
+        // BC1A to BC7 have consecutive model numbers. BC1 has 4 formats and the rest have 2.
+        model = value < static_cast<uint32_t>(Ktx2Format::BC2_UNORM) ? KHR_DF_MODEL_BC1A
+            : KHR_DF_MODEL_BC1A + 1 + (value - static_cast<uint32_t>(Ktx2Format::BC2_UNORM)) / 2;
+        blockDimensions = 3 | 3 << 8;
+        if (format == Ktx2Format::BC2_UNORM || format == Ktx2Format::BC2_SRGB
+            || format == Ktx2Format::BC3_UNORM || format == Ktx2Format::BC3_SRGB) {
+            samples.push_back({0, 64, KHR_DF_CHANNEL_ALPHA});
+            samples.push_back({64, 64, 0});
+        }
+        else {
+            samples.push_back({0, bytesPlane0 * 8, 0});
+        }
+    }
+    else {
+        for (uint32_t i = 0; i < 4; ++i) {
+            samples.push_back({i * 8, 8, i == 3 ? KHR_DF_CHANNEL_ALPHA : i});
+        }
+    }
+    const uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+    writeU32(out, 4 + blockSize);
+    writeU32(out, 0); // vendor and descriptor type
+    writeU32(out, 2 | blockSize << 16); // version 1.3
+    writeU32(out, model | KHR_DF_PRIMARIES_BT709 << 8 | (isSrgb(format) ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR) << 16);
+    writeU32(out, blockDimensions);
+    writeU32(out, bytesPlane0);
+    writeU32(out, 0);
+    const bool isSigned = format == Ktx2Format::BC4_SNORM || format == Ktx2Format::BC5_SNORM || format == Ktx2Format::BC6H_SFLOAT;
+    for (const auto& sample : samples) {
+        uint32_t channel = sample.channel;
+        if (channel == KHR_DF_CHANNEL_ALPHA && isSrgb(format)) {
+            // Alpha is always linear.
+            channel |= KHR_DF_SAMPLE_DATATYPE_LINEAR;
+        }
+        if (isSigned) {
+            channel |= KHR_DF_SAMPLE_DATATYPE_SIGNED;
+        }
+        writeU32(out, sample.bitOffset | (sample.bitLength - 1) << 16 | channel << 24);
+        writeU32(out, 0);
+        writeU32(out, 0);
+        writeU32(out, sample.bitLength >= 32 ? 0xFFFFFFFF : (1u << sample.bitLength) - 1);
+    }
+}
+
+bool isKtx2(const uint8_t* data, size_t length) {
+    return data != nullptr && length >= sizeof(IDENTIFIER) && memcmp(data, IDENTIFIER, sizeof(IDENTIFIER)) == 0;
+}
+
+bool isBlockCompressed(Ktx2Format format) {
+    const uint32_t value = static_cast<uint32_t>(format);
+    return value >= static_cast<uint32_t>(Ktx2Format::BC1_RGB_UNORM) && value <= static_cast<uint32_t>(Ktx2Format::BC7_SRGB);
+}
+
+size_t ktx2BlockSize(Ktx2Format format) {
+    switch (format) {
+    case Ktx2Format::R8G8B8A8_UNORM:
+    case Ktx2Format::R8G8B8A8_SRGB:
+        return 4;
+    case Ktx2Format::BC1_RGB_UNORM:
+    case Ktx2Format::BC1_RGB_SRGB:
+    case Ktx2Format::BC1_RGBA_UNORM:
+    case Ktx2Format::BC1_RGBA_SRGB:
+    case Ktx2Format::BC4_UNORM:
+    case Ktx2Format::BC4_SNORM:
+        return 8;
+    case Ktx2Format::UNDEFINED:
+        return 0;
+    default:
+        return isBlockCompressed(format) ? 16 : 0;
+    }
+}
+
+size_t ktx2LevelSize(Ktx2Format format, uint32_t width, uint32_t height) {
+    if (isBlockCompressed(format)) {
+        return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * ktx2BlockSize(format);
+    }
+    return static_cast<size_t>(width) * height * ktx2BlockSize(format);
+}
+
+bool readKtx2(const uint8_t* data, size_t length, Ktx2Texture& texture) {
+    if (!isKtx2(data, length) || length < HEADER_SIZE) {
+        return false;
+    }
+    const uint8_t* header = data + sizeof(IDENTIFIER);
+    const uint32_t format = readU32(header + 0);
+    const uint32_t width = readU32(header + 8);
+    const uint32_t height = readU32(header + 12);
+    const uint32_t depth = readU32(header + 16);
+    const uint32_t layers = readU32(header + 20);
+    const uint32_t faces = readU32(header + 24);
+    const uint32_t levelCount = std::max(1u, readU32(header + 28));
+    const uint32_t supercompression = readU32(header + 32);
+    if (width == 0 || height == 0 || depth > 1 || layers > 1 || faces != 1) {
+        return false;
+    }
+    uint32_t maxLevels = 1;
+    while ((std::max(width, height) >> maxLevels) != 0) {
+        ++maxLevels;
+    }
+    if (levelCount > maxLevels) {
+        return false;
+    }
+    if (length < HEADER_SIZE + levelCount * LEVEL_INDEX_SIZE) {
+        return false;
+    }
+    texture.format = static_cast<Ktx2Format>(format);
+    texture.width = width;
+    texture.height = height;
+    texture.supercompression = supercompression;
+    texture.levels.clear();
+    texture.data.clear();
+
+    const uint8_t* index = data + HEADER_SIZE;
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        const uint64_t offset = readU64(index + i * LEVEL_INDEX_SIZE);
+        const uint64_t byteLength = readU64(index + i * LEVEL_INDEX_SIZE + 8);
+        if (offset > length || byteLength > length - offset) {
+            return false;
+        }
+        // Levels that are uploaded as is must have exactly the size of the level.
+        if (supercompression == Ktx2Texture::NONE && ktx2BlockSize(texture.format) != 0) {
+            const uint32_t w = std::max(1u, width >> i);
+            const uint32_t h = std::max(1u, height >> i);
+            if (byteLength != ktx2LevelSize(texture.format, w, h)) {
+                return false;
+            }
+        }
+        total += byteLength;
+    }
+    texture.data.reserve(static_cast<size_t>(total));
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        const size_t offset = static_cast<size_t>(readU64(index + i * LEVEL_INDEX_SIZE));
+        const size_t byteLength = static_cast<size_t>(readU64(index + i * LEVEL_INDEX_SIZE + 8));
+        Ktx2Texture::Level level;
+        level.offset = texture.data.size();
+        level.length = byteLength;
+        texture.data.insert(texture.data.end(), data + offset, data + offset + byteLength);
+        texture.levels.push_back(level);
+    }
+    return true;
+}
+
+bool writeKtx2(const Ktx2Texture& texture, std::vector<uint8_t>& destination) {
+    if (texture.levels.empty() || texture.supercompression != Ktx2Texture::NONE || ktx2BlockSize(texture.format) == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < texture.levels.size(); ++i) {
+        const uint32_t w = std::max(1u, texture.width >> i);
+        const uint32_t h = std::max(1u, texture.height >> i);
+        const auto& level = texture.levels[i];
+        if (level.length != ktx2LevelSize(texture.format, w, h) || level.offset + level.length > texture.data.size()) {
+            return false;
+        }
+    }
+    const uint32_t levelCount = static_cast<uint32_t>(texture.levels.size());
+    destination.clear();
+    destination.insert(destination.end(), IDENTIFIER, IDENTIFIER + sizeof(IDENTIFIER));
+    writeU32(destination, static_cast<uint32_t>(texture.format));
+    writeU32(destination, isBlockCompressed(texture.format) ? 1 : static_cast<uint32_t>(ktx2BlockSize(texture.format) / 4));
+    writeU32(destination, texture.width);
+    writeU32(destination, texture.height);
+    writeU32(destination, 0); // depth
+    writeU32(destination, 0); // layers
+    writeU32(destination, 1); // faces
+    writeU32(destination, levelCount);
+    writeU32(destination, Ktx2Texture::NONE);
+
+    std::vector<uint8_t> dfd;
+    writeDataFormatDescriptor(texture.format, dfd);
+    const size_t dfdOffset = HEADER_SIZE + levelCount * LEVEL_INDEX_SIZE;
+    writeU32(destination, static_cast<uint32_t>(dfdOffset));
+    writeU32(destination, static_cast<uint32_t>(dfd.size()));
+    writeU32(destination, 0); // key/value data
+    writeU32(destination, 0);
+    writeU64(destination, 0); // supercompression global data
+    writeU64(destination, 0);
+
+    const size_t levelIndex = destination.size();
+    destination.resize(levelIndex + levelCount * LEVEL_INDEX_SIZE, 0);
+    destination.insert(destination.end(), dfd.begin(), dfd.end());
+
+    // Levels are aligned to the block size and stored from the smallest to the largest.
+    const size_t alignment = std::max<size_t>(4, ktx2BlockSize(texture.format));
+    for (size_t i = levelCount; i-- > 0;) {
+        while (destination.size() % alignment != 0) {
+            destination.push_back(0);
+        }
+        const auto& level = texture.levels[i];
+        patchU64(destination, levelIndex + i * LEVEL_INDEX_SIZE, destination.size());
+        patchU64(destination, levelIndex + i * LEVEL_INDEX_SIZE + 8, level.length);
+        patchU64(destination, levelIndex + i * LEVEL_INDEX_SIZE + 16, level.length);
+        const uint8_t* levelData = texture.data.data() + level.offset;
+        destination.insert(destination.end(), levelData, levelData + level.length);
+    }
+    return true;
+}
+
+} // namespace kepler
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Base.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace kepler {
+
+/// The VkFormat values of KTX2 that the engine knows about.
+enum class Ktx2Format : uint32_t {
+    UNDEFINED = 0, ///< Used by Basis Universal supercompressed textures.
+    R8G8B8A8_UNORM = 37,
+    R8G8B8A8_SRGB = 43,
+    BC1_RGB_UNORM = 131,
+    BC1_RGB_SRGB = 132,
+    BC1_RGBA_UNORM = 133,
+    BC1_RGBA_SRGB = 134,
+    BC2_UNORM = 135,
+    BC2_SRGB = 136,
+    BC3_UNORM = 137,
+    BC3_SRGB = 138,
+    BC4_UNORM = 139,
+    BC4_SNORM = 140,
+    BC5_UNORM = 141,
+    BC5_SNORM = 142,
+    BC6H_UFLOAT = 143,
+    BC6H_SFLOAT = 144,
+    BC7_UNORM = 145,
+    BC7_SRGB = 146
+};
+
+/// A 2D texture in a KTX 2.0 container.
+///
+/// Only what is needed to upload a prebuilt mip chain is kept. Array layers, cube faces and 3D textures
+/// are not supported and are rejected by readKtx2().
+struct Ktx2Texture {
+    enum Supercompression : uint32_t {
+        NONE = 0,
+        BASIS_LZ = 1,
+        ZSTD = 2,
+        ZLIB = 3
+    };
+
+    struct Level {
+        /// Offset of the level in data.
+        size_t offset = 0;
+        size_t length = 0;
+    };
+
+    Ktx2Format format = Ktx2Format::UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t supercompression = NONE;
+    /// Level 0 is the largest.
+    std::vector<Level> levels;
+    std::vector<uint8_t> data;
+
+    /// Returns a pointer to the data of a level.
+    const uint8_t* levelData(size_t level) const {
+        return data.data() + levels[level].offset;
+    }
+
+    /// Returns true if the texture can be uploaded as is. Supercompressed textures need to be transcoded first.
+    bool uploadable() const {
+        return supercompression == NONE && format != Ktx2Format::UNDEFINED;
+    }
+};
+
+/// Returns true if the memory starts with the KTX 2.0 file identifier.
+bool isKtx2(const uint8_t* data, size_t length);
+
+/// Returns true if the format is one of the BC block compressed formats.
+bool isBlockCompressed(Ktx2Format format);
+
+/// Returns the number of bytes per 4x4 block of a block compressed format or per pixel of an uncompressed format.
+size_t ktx2BlockSize(Ktx2Format format);
+
+/// Returns the number of bytes of a level of a texture of the format.
+size_t ktx2LevelSize(Ktx2Format format, uint32_t width, uint32_t height);
+
+/// Reads a KTX 2.0 file from memory. The level data is copied.
+/// @return False if the data is not a valid 2D KTX 2.0 file or a level that isn't supercompressed doesn't have
+///         the size of the level.
+bool readKtx2(const uint8_t* data, size_t length, Ktx2Texture& texture);
+
+/// Writes a KTX 2.0 file without supercompression. Levels are written smallest first as the specification requires.
+/// @param[out] destination The file data.
+/// @return False if the texture has no levels or a level doesn't have the expected size.
+bool writeKtx2(const Ktx2Texture& texture, std::vector<uint8_t>& destination);
+
+} // namespace kepler
@@ -0,0 +1,319 @@
+#include "stdafx.h"
+#include "LightClusters.hpp"
+#include "Camera.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <thread>
+
+#if defined(_M_X64) || defined(__x86_64__)
+// SSE2 is part of x64 so there is no need to check the CPU.
+#define KEPLER_CLUSTERS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace kepler {
+
+// Below this many lights the work is too small to be worth starting threads.
+static constexpr size_t MIN_LIGHTS_PER_THREAD = 32;
+
+static inline size_t roundUp4(size_t n) {
+    return (n + 3) & ~static_cast<size_t>(3);
+}
+
+LightClusters::LightClusters(int tilesX, int tilesY, int slices)
+    : _tilesX(std::max(tilesX, 1)), _tilesY(std::max(tilesY, 1)), _slices(std::max(slices, 1)), _simd(simdSupported()) {
+    _clusters.assign(clusterCount() * 2, 0);
+    _sliceResults.resize(_slices);
+}
+
+shared_ptr<LightClusters> LightClusters::create(int tilesX, int tilesY, int slices) {
+    return std::make_shared<LightClusters>(tilesX, tilesY, slices);
+}
+
+void LightClusters::update(const PointLight* lights, size_t count, const mat4& view, const mat4& projection, float near, float far) {
+    _perspective = projection[3][3] != 1.0f;
+    _scaleX = projection[0][0];
+    _scaleY = projection[1][1];
+    // ndc = scale * x / depth - P[2] for perspective and scale * x + P[3] for orthographic
+    _offsetX = _perspective ? -projection[2][0] : projection[3][0];
+    _offsetY = _perspective ? -projection[2][1] : projection[3][1];
+
+    if (_perspective) {
+        near = std::max(near, std::numeric_limits<float>::min());
+        far = std::max(far, near * 1.0001f);
+        const float logRatio = std::log(far / near);
+        _sliceScale = _slices / logRatio;
+        _sliceBias = -_slices * std::log(near) / logRatio;
+    }
+    else {
+        far = std::max(far, near + 0.0001f);
+        _sliceScale = _slices / (far - near);
+        _sliceBias = -near * _sliceScale;
+    }
+    _sliceDepths.resize(_slices + 1);
+    for (int s = 0; s <= _slices; ++s) {
+        float t = static_cast<float>(s) / _slices;
+        _sliceDepths[s] = _perspective ? near * std::pow(far / near, t) : near + (far - near) * t;
+    }
+
+    _lightCount = count;
+    const size_t padded = roundUp4(count);
+    _lightX.assign(padded, 0.0f);
+    _lightY.assign(padded, 0.0f);
+    // Padding lights are infinitely far behind the camera so they never overlap a slice.
+    _lightDepth.assign(padded, -std::numeric_limits<float>::max());
+    _lightRange.assign(padded, 0.0f);
+    _lightData.resize(count * 2);
+    for (size_t i = 0; i < count; ++i) {
+        const PointLight& light = lights[i];
+        vec3 p = vec3(view * vec4(light.position, 1.0f));
+        _lightX[i] = p.x;
+        _lightY[i] = p.y;
+        _lightDepth[i] = -p.z;
+        _lightRange[i] = light.range;
+        _lightData[i * 2] = vec4(p, light.range);
+        _lightData[i * 2 + 1] = vec4(light.color * light.intensity, 0.0f);
+    }
+
+    size_t threads = _threadCount == 0 ? std::thread::hardware_concurrency() : _threadCount;
+    threads = std::min(threads, count / MIN_LIGHTS_PER_THREAD);
+    threads = std::max<size_t>(1, std::min(threads, static_cast<size_t>(_slices)));
+    if (threads == 1) {
+        assignSlices(0, _slices);
+    }
+    else {
+        std::vector<std::future<void>> workers;
+        workers.reserve(threads - 1);
+        const int slicesPerThread = static_cast<int>((_slices + threads - 1) / threads);
+        for (int first = slicesPerThread; first < _slices; first += slicesPerThread) {
+            workers.push_back(std::async(std::launch::async, &LightClusters::assignSlices, this,
+                first, std::min(first + slicesPerThread, _slices)));
+        }
+        assignSlices(0, std::min(slicesPerThread, _slices));
+        for (auto& worker : workers) {
+            worker.get();
+        }
+    }
+
+    // Concatenate the slices. Clusters are ordered by slice, then tile row, then tile column.
+    const size_t tileCount = static_cast<size_t>(_tilesX) * _tilesY;
+    _lightIndices.clear();
+    for (int s = 0; s < _slices; ++s) {
+        const SliceResult& result = _sliceResults[s];
+        uint32_t offset = static_cast<uint32_t>(_lightIndices.size());
+        for (size_t t = 0; t < tileCount; ++t) {
+            size_t cluster = s * tileCount + t;
+            _clusters[cluster * 2] = offset;
+            _clusters[cluster * 2 + 1] = result.counts[t];
+            offset += result.counts[t];
+        }
+        _lightIndices.insert(_lightIndices.end(), result.hits.begin(), result.hits.end());
+    }
+}
+
+void LightClusters::update(const std::vector<PointLight>& lights, const Camera& camera) {
+    update(lights.data(), lights.size(), camera.viewMatrix(), camera.projectionMatrix(), camera.near(), camera.far());
+}
+
+int LightClusters::tilesX() const {
+    return _tilesX;
+}
+
+int LightClusters::tilesY() const {
+    return _tilesY;
+}
+
+int LightClusters::slices() const {
+    return _slices;
+}
+
+size_t LightClusters::clusterCount() const {
+    return static_cast<size_t>(_tilesX) * _tilesY * _slices;
+}
+
+size_t LightClusters::clusterIndex(int tileX, int tileY, int slice) const {
+    return (static_cast<size_t>(slice) * _tilesY + tileY) * _tilesX + tileX;
+}
+
+int LightClusters::slice(float depth) const {
+    float f = _perspective ? std::log(std::max(depth, std::numeric_limits<float>::min())) : depth;
+    int s = static_cast<int>(std::floor(f * _sliceScale + _sliceBias));
+    return std::min(std::max(s, 0), _slices - 1);
+}
+
+float LightClusters::sliceScale() const {
+    return _sliceScale;
+}
+
+float LightClusters::sliceBias() const {
+    return _sliceBias;
+}
+
+bool LightClusters::linearSlices() const {
+    return !_perspective;
+}
+
+const std::vector<uint32_t>& LightClusters::clusters() const {
+    return _clusters;
+}
+
+const std::vector<uint32_t>& LightClusters::lightIndices() const {
+    return _lightIndices;
+}
+
+const std::vector<vec4>& LightClusters::lightData() const {
+    return _lightData;
+}
+
+size_t LightClusters::lightCount() const {
+    return _lightCount;
+}
+
+void LightClusters::setThreadCount(size_t count) {
+    _threadCount = count;
+}
+
+void LightClusters::setSimdEnabled(bool enabled) {
+    _simd = enabled && simdSupported();
+}
+
+bool LightClusters::simdSupported() {
+#ifdef KEPLER_CLUSTERS_SSE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void LightClusters::assignSlices(int first, int last) {
+    for (int s = first; s < last; ++s) {
+        assignSlice(s, _sliceResults[s]);
+    }
+}
+
+void LightClusters::assignSlice(int slice, SliceResult& result) const {
+    const size_t tileCount = static_cast<size_t>(_tilesX) * _tilesY;
+    const float nearDepth = _sliceDepths[slice];
+    const float farDepth = _sliceDepths[slice + 1];
+    result.counts.assign(tileCount, 0);
+    result.hits.clear();
+    findLights(nearDepth, farDepth, result.candidates);
+    if (result.candidates.empty()) {
+        return;
+    }
+
+    // (tile, light) pairs that are sorted by tile below
+    std::vector<uint32_t> pairs;
+    const float tileNdcX = 2.0f / _tilesX;
+    const float tileNdcY = 2.0f / _tilesY;
+    for (uint32_t light : result.candidates) {
+        const float x = _lightX[light];
+        const float y = _lightY[light];
+        const float depth = _lightDepth[light];
+        const float range = _lightRange[light];
+        // The part of the bounding box of the sphere that is inside of the slice.
+        const float d0 = std::max(depth - range, nearDepth);
+        const float d1 = std::min(depth + range, farDepth);
+        float minX = std::min(std::min(ndcX(x - range, d0), ndcX(x - range, d1)), std::min(ndcX(x + range, d0), ndcX(x + range, d1)));
+        float maxX = std::max(std::max(ndcX(x - range, d0), ndcX(x - range, d1)), std::max(ndcX(x + range, d0), ndcX(x + range, d1)));
+        float minY = std::min(std::min(ndcY(y - range, d0), ndcY(y - range, d1)), std::min(ndcY(y + range, d0), ndcY(y + range, d1)));
+        float maxY = std::max(std::max(ndcY(y - range, d0), ndcY(y - range, d1)), std::max(ndcY(y + range, d0), ndcY(y + range, d1)));
+        if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f) {
+            continue;
+        }
+        const int x0 = std::max(static_cast<int>(std::floor((minX + 1.0f) / tileNdcX)), 0);
+        const int x1 = std::min(static_cast<int>(std::floor((maxX + 1.0f) / tileNdcX)), _tilesX - 1);
+        const int y0 = std::max(static_cast<int>(std::floor((minY + 1.0f) / tileNdcY)), 0);
+        const int y1 = std::min(static_cast<int>(std::floor((maxY + 1.0f) / tileNdcY)), _tilesY - 1);
+        const float rangeSquared = range * range;
+        const float dz = depth < nearDepth ? nearDepth - depth : (depth > farDepth ? depth - farDepth : 0.0f);
+        for (int ty = y0; ty <= y1; ++ty) {
+            // Bounds of the cluster in view space
+            const float n0 = -1.0f + ty * tileNdcY;
+            const float n1 = n0 + tileNdcY;
+            const float cy0 = std::min(std::min(viewY(n0, nearDepth), viewY(n0, farDepth)), std::min(viewY(n1, nearDepth), viewY(n1, farDepth)));
+            const float cy1 = std::max(std::max(viewY(n0, nearDepth), viewY(n0, farDepth)), std::max(viewY(n1, nearDepth), viewY(n1, farDepth)));
+            const float dy = y < cy0 ? cy0 - y : (y > cy1 ? y - cy1 : 0.0f);
+            for (int tx = x0; tx <= x1; ++tx) {
+                const float m0 = -1.0f + tx * tileNdcX;
+                const float m1 = m0 + tileNdcX;
+                const float cx0 = std::min(std::min(viewX(m0, nearDepth), viewX(m0, farDepth)), std::min(viewX(m1, nearDepth), viewX(m1, farDepth)));
+                const float cx1 = std::max(std::max(viewX(m0, nearDepth), viewX(m0, farDepth)), std::max(viewX(m1, nearDepth), viewX(m1, farDepth)));
+                const float dx = x < cx0 ? cx0 - x : (x > cx1 ? x - cx1 : 0.0f);
+                if (dx * dx + dy * dy + dz * dz <= rangeSquared) {
+                    const uint32_t tile = static_cast<uint32_t>(ty * _tilesX + tx);
+                    ++result.counts[tile];
+                    pairs.push_back(tile);
+                    pairs.push_back(light);
+                }
+            }
+        }
+    }
+
+    // Counting sort by tile. The lights of each tile stay in increasing order.
+    std::vector<uint32_t> offsets(tileCount, 0);
+    uint32_t total = 0;
+    for (size_t t = 0; t < tileCount; ++t) {
+        offsets[t] = total;
+        total += result.counts[t];
+    }
+    result.hits.resize(total);
+    for (size_t i = 0; i < pairs.size(); i += 2) {
+        result.hits[offsets[pairs[i]]++] = pairs[i + 1];
+    }
+}
+
+void LightClusters::findLights(float nearDepth, float farDepth, std::vector<uint32_t>& candidates) const {
+    candidates.clear();
+    const size_t count = _lightDepth.size();
+#ifdef KEPLER_CLUSTERS_SSE
+    if (_simd) {
+        const __m128 n = _mm_set1_ps(nearDepth);
+        const __m128 f = _mm_set1_ps(farDepth);
+        for (size_t i = 0; i < count; i += 4) {
+            const __m128 depth = _mm_loadu_ps(&_lightDepth[i]);
+            const __m128 range = _mm_loadu_ps(&_lightRange[i]);
+            // depth - range < far && depth + range > near
+            const __m128 overlap = _mm_and_ps(
+                _mm_cmplt_ps(_mm_sub_ps(depth, range), f),
+                _mm_cmpgt_ps(_mm_add_ps(depth, range), n));
+            int mask = _mm_movemask_ps(overlap);
+            while (mask != 0) {
+                int bit = 0;
+                while ((mask & (1 << bit)) == 0) {
+                    ++bit;
+                }
+                candidates.push_back(static_cast<uint32_t>(i + bit));
+                mask &= mask - 1;
+            }
+        }
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; ++i) {
+        if (_lightDepth[i] - _lightRange[i] < farDepth && _lightDepth[i] + _lightRange[i] > nearDepth) {
+            candidates.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+float LightClusters::viewX(float ndc, float depth) const {
+    return _perspective ? (ndc - _offsetX) * depth / _scaleX : (ndc - _offsetX) / _scaleX;
+}
+
+float LightClusters::viewY(float ndc, float depth) const {
+    return _perspective ? (ndc - _offsetY) * depth / _scaleY : (ndc - _offsetY) / _scaleY;
+}
+
+float LightClusters::ndcX(float x, float depth) const {
+    return _perspective ? _scaleX * x / depth + _offsetX : _scaleX * x + _offsetX;
+}
+
+float LightClusters::ndcY(float y, float depth) const {
+    return _perspective ? _scaleY * y / depth + _offsetY : _scaleY * y + _offsetY;
+}
+
+} // namespace kepler
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Base.hpp"
+#include "BaseMath.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace kepler {
+
+/// A point light that is assigned to clusters by LightClusters.
+struct PointLight {
+    /// World space position.
+    vec3 position;
+    /// The distance at which the light no longer has any effect.
+    float range = 10.0f;
+    vec3 color = vec3(1.0f);
+    float intensity = 1.0f;
+};
+
+/// LightClusters divides the view frustum into a 3D grid of clusters and finds the lights that touch each cluster.
+///
+/// The grid is tilesX by tilesY screen tiles and slices depth slices. Perspective cameras use exponentially spaced
+/// slices so that near clusters are roughly as deep as they are wide. Orthographic cameras use linear slices.
+/// A fragment finds its cluster from gl_FragCoord and its view space depth and only shades the lights of that cluster.
+///
+/// Lights are assigned on the CPU. Each worker thread handles a range of depth slices and SSE is used to
+/// find the lights that overlap a slice 4 at a time. Each light is then tested against the clusters of the slice
+/// that its bounding sphere projects to.
+class LightClusters {
+public:
+    /// Use LightClusters::create()
+    LightClusters(int tilesX, int tilesY, int slices);
+    virtual ~LightClusters() noexcept = default;
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+    static shared_ptr<LightClusters> create(int tilesX = 16, int tilesY = 9, int slices = 24);
+
+    /// Assigns the lights to clusters.
+    /// @param[in] lights     The lights in world space.
+    /// @param[in] count      The number of lights.
+    /// @param[in] view       The view matrix of the camera.
+    /// @param[in] projection The perspective or orthographic projection matrix of the camera.
+    /// @param[in] near       The near plane distance.
+    /// @param[in] far        The far plane distance.
+    void update(const PointLight* lights, size_t count, const mat4& view, const mat4& projection, float near, float far);
+
+    /// Assigns the lights to clusters using the camera.
+    void update(const std::vector<PointLight>& lights, const Camera& camera);
+
+    int tilesX() const;
+    int tilesY() const;
+    int slices() const;
+    size_t clusterCount() const;
+
+    /// Returns the index of the cluster at the given screen tile and depth slice.
+    /// Tile (0, 0) is the bottom left of the screen like gl_FragCoord.
+    size_t clusterIndex(int tileX, int tileY, int slice) const;
+
+    /// Returns the depth slice of a view space depth. The depth is the positive distance in front of the camera.
+    /// The result is clamped to the valid slices.
+    int slice(float depth) const;
+
+    /// Returns the scale used to find the depth slice.
+    /// slice = log(depth) * scale + bias for perspective cameras and depth * scale + bias for orthographic cameras.
+    float sliceScale() const;
+    /// Returns the bias used to find the depth slice. See sliceScale().
+    float sliceBias() const;
+    /// Returns true if the depth slices are linear because the projection is orthographic.
+    bool linearSlices() const;
+
+    /// Returns 2 values per cluster: the offset of its first light in lightIndices() and the number of lights.
+    const std::vector<uint32_t>& clusters() const;
+
+    /// Returns the light indices of all of the clusters.
+    const std::vector<uint32_t>& lightIndices() const;
+
+    /// Returns 2 vec4 per light: the view space position and range followed by the color times the intensity.
+    const std::vector<vec4>& lightData() const;
+
+    /// Returns the number of lights passed to the last update().
+    size_t lightCount() const;
+
+    /// Sets the number of worker threads. 0 uses the number of hardware threads. The default is 0.
+    void setThreadCount(size_t count);
+
+    /// Enables or disables the SSE slice test. It is only used if the CPU supports it.
+    void setSimdEnabled(bool enabled);
+
+    /// Returns true if the SSE slice test is supported.
+    static bool simdSupported();
+
+private:
+    struct SliceResult {
+        std::vector<uint32_t> counts;
+        // (tile, light) pairs in the order they were found
+        std::vector<uint32_t> hits;
+        std::vector<uint32_t> candidates;
+    };
+
+    void assignSlices(int first, int last);
+    void assignSlice(int slice, SliceResult& result) const;
+    void findLights(float nearDepth, float farDepth, std::vector<uint32_t>& candidates) const;
+    float viewX(float ndc, float depth) const;
+    float viewY(float ndc, float depth) const;
+    float ndcX(float x, float depth) const;
+    float ndcY(float y, float depth) const;
+
+private:
+    int _tilesX;
+    int _tilesY;
+    int _slices;
+    size_t _threadCount = 0;
+    bool _simd;
+    bool _perspective = true;
+    float _sliceScale = 0.0f;
+    float _sliceBias = 0.0f;
+    // projection terms that map view space x and y to normalized device coordinates
+    float _scaleX = 1.0f;
+    float _scaleY = 1.0f;
+    float _offsetX = 0.0f;
+    float _offsetY = 0.0f;
+    std::vector<float> _sliceDepths;
+    // view space lights as structure of arrays. Padded to a multiple of 4.
+    std::vector<float> _lightX;
+    std::vector<float> _lightY;
+    std::vector<float> _lightDepth;
+    std::vector<float> _lightRange;
+    std::vector<SliceResult> _sliceResults;
+    std::vector<uint32_t> _clusters;
+    std::vector<uint32_t> _lightIndices;
+    std::vector<vec4> _lightData;
+    size_t _lightCount = 0;
+};
+
+} // namespace kepler
@@ -0,0 +1,74 @@
+#include "stdafx.h"
+#include "LodSelector.hpp"
+#include "Camera.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace kepler {
+
+float LodSelector::screenSize(const BoundingBox& box, const mat4& view, const mat4& projection) {
+    if (box.empty()) {
+        return std::numeric_limits<float>::max();
+    }
+    const vec3 center = vec3(view * vec4(box.center(), 1.0f));
+    // The view matrix may be scaled so measure the radius in view space.
+    const vec3 halfSize = (box.max - box.min) * 0.5f;
+    const float radius = glm::length(mat3(view) * halfSize);
+    // projection[1][1] is cot(fov / 2) for a perspective camera and 2 / height for an orthographic camera.
+    const float scale = projection[1][1];
+    if (projection[3][3] == 1.0f) {
+        return radius * scale;
+    }
+    const float distance = glm::length(center);
+    if (distance <= radius) {
+        // The camera is inside the sphere.
+        return std::numeric_limits<float>::max();
+    }
+    return radius * scale / distance;
+}
+
+float LodSelector::screenSize(const BoundingBox& box, const Camera& camera) {
+    return screenSize(box, camera.viewMatrix(), camera.projectionMatrix());
+}
+
+float LodSelector::screenSizeFromCoverage(float coverage, float aspectRatio) {
+    // A sphere with a screen size of s covers pi * s^2 / 4 of a square viewport.
+    return std::sqrt(std::max(coverage, 0.0f) * aspectRatio * 4.0f / PI);
+}
+
+size_t LodSelector::select(float screenSize, const float* thresholds, size_t count) {
+    if (!_valid) {
+        // No history so pick the exact level.
+        _level = 0;
+        while (_level < count && screenSize < thresholds[_level]) {
+            ++_level;
+        }
+        _valid = true;
+        return _level;
+    }
+    _level = std::min(_level, count);
+    while (_level < count && screenSize < thresholds[_level] * (1.0f - _hysteresis)) {
+        ++_level;
+    }
+    while (_level > 0 && screenSize > thresholds[_level - 1] * (1.0f + _hysteresis)) {
+        --_level;
+    }
+    return _level;
+}
+
+size_t LodSelector::level() const {
+    return _level;
+}
+
+void LodSelector::setHysteresis(float hysteresis) {
+    _hysteresis = std::max(0.0f, std::min(hysteresis, 1.0f));
+}
+
+void LodSelector::reset() {
+    _level = 0;
+    _valid = false;
+}
+
+} // namespace kepler
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Base.hpp"
+#include "BaseMath.hpp"
+#include "BoundingBox.hpp"
+
+namespace kepler {
+
+/// LodSelector picks a level of detail based on how large an object appears on screen.
+///
+/// The screen size is the diameter of the projected bounding sphere as a fraction of the viewport height.
+/// The selector remembers the current level and only switches once the screen size moves past a threshold
+/// by more than the hysteresis. This stops objects from flickering between levels near a threshold.
+class LodSelector {
+public:
+    LodSelector() = default;
+    ~LodSelector() = default;
+    LodSelector(const LodSelector&) = default;
+    LodSelector& operator=(const LodSelector&) = default;
+
+    /// Returns the screen size of the bounding sphere of the world space box.
+    /// @param[in] box        The world space bounding box.
+    /// @param[in] view       The view matrix of the camera.
+    /// @param[in] projection The perspective or orthographic projection matrix.
+    static float screenSize(const BoundingBox& box, const mat4& view, const mat4& projection);
+
+    /// Returns the screen size of the bounding sphere of the world space box.
+    static float screenSize(const BoundingBox& box, const Camera& camera);
+
+    /// Converts a fraction of the screen area, like the MSFT_screencoverage glTF extension uses, to the screen size
+    /// of a sphere that covers that much of the screen.
+    /// @param[in] coverage    The fraction of the viewport area.
+    /// @param[in] aspectRatio The width of the viewport divided by its height.
+    static float screenSizeFromCoverage(float coverage, float aspectRatio = 1.0f);
+
+    /// Selects a level of detail.
+    /// Level 0 is the most detailed. Level i + 1 is selected when the screen size is below thresholds[i].
+    /// @param[in] screenSize The screen size returned by screenSize().
+    /// @param[in] thresholds Decreasing screen sizes.
+    /// @param[in] count      The number of thresholds.
+    /// @return The selected level. Will be equal to count if the screen size is below every threshold.
+    size_t select(float screenSize, const float* thresholds, size_t count);
+
+    /// Returns the level selected by the last call to select().
+    size_t level() const;
+
+    /// Sets the hysteresis as a fraction of each threshold. The default is 0.1.
+    /// A level is only switched to a coarser level once the screen size drops below threshold * (1 - hysteresis)
+    /// and back to a finer level once it grows above threshold * (1 + hysteresis).
+    void setHysteresis(float hysteresis);
+
+    /// Forgets the current level. The next call to select() will not apply any hysteresis.
+    void reset();
+
+private:
+    size_t _level = 0;
+    float _hysteresis = 0.1f;
+    bool _valid = false;
+};
+
+} // namespace kepler
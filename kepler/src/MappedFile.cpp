@@ -0,0 +1,72 @@
+#include "stdafx.h"
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace kepler {
+
+MappedFile::MappedFile(const uint8_t* data, size_t size) : _data(data), _size(size) {
+}
+
+MappedFile::~MappedFile() noexcept {
+#ifdef _WIN32
+    UnmapViewOfFile(_data);
+#else
+    munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+}
+
+shared_ptr<MappedFile> MappedFile::open(const char* path) {
+    if (path == nullptr) {
+        return nullptr;
+    }
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    // The view keeps the mapping and the file open.
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    if (data == nullptr) {
+        return nullptr;
+    }
+    return std::make_shared<MappedFile>(static_cast<const uint8_t*>(data), static_cast<size_t>(size.QuadPart));
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat s;
+    if (fstat(fd, &s) != 0 || s.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    const size_t size = static_cast<size_t>(s.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file open.
+    close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    return std::make_shared<MappedFile>(static_cast<const uint8_t*>(data), size);
+#endif
+}
+
+} // namespace kepler
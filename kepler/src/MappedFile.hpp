@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Base.hpp"
+
+#include <cstdint>
+
+namespace kepler {
+
+/// A view of a range of bytes that are owned by something else.
+struct ByteSpan {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    ByteSpan() = default;
+    ByteSpan(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    bool empty() const noexcept {
+        return size == 0;
+    }
+
+    /// Returns a part of the span. Returns an empty span if the range doesn't fit.
+    ByteSpan subspan(size_t offset, size_t length) const noexcept {
+        if (offset > size || length > size - offset) {
+            return ByteSpan();
+        }
+        return ByteSpan(data + offset, length);
+    }
+};
+
+/// MappedFile maps a whole file into read only memory.
+///
+/// The OS reads the pages on first access and can drop them again under memory pressure because they are backed
+/// by the file, so large files don't need a heap copy and only the parts that are used take memory.
+/// The mapping is released when the object is destroyed; spans into it must not outlive it.
+class MappedFile final {
+public:
+    /// Use MappedFile::open()
+    MappedFile(const uint8_t* data, size_t size);
+    ~MappedFile() noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// Maps a file.
+    /// @return The mapped file. Null if the file couldn't be opened or is empty.
+    static shared_ptr<MappedFile> open(const char* path);
+
+    const uint8_t* data() const noexcept {
+        return _data;
+    }
+
+    size_t size() const noexcept {
+        return _size;
+    }
+
+    /// Returns the whole file.
+    ByteSpan span() const noexcept {
+        return ByteSpan(_data, _size);
+    }
+
+private:
+    const uint8_t* _data;
+    size_t _size;
+};
+
+} // namespace kepler
@@ -0,0 +1,251 @@
+#include "stdafx.h"
+#include "MeshOptimizer.hpp"
+#include "BaseMath.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <limits>
+
+namespace kepler {
+
+static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize) {
+    VertexCacheStats stats;
+    if (indexCount < 3 || vertexCount == 0) {
+        return stats;
+    }
+    // Each vertex remembers when it entered the FIFO. It is still in the cache if fewer than cacheSize vertices came after it.
+    std::vector<size_t> timestamps(vertexCount, 0);
+    std::vector<bool> used(vertexCount, false);
+    size_t time = cacheSize + 1;
+    size_t misses = 0;
+    size_t unique = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t v = indices[i];
+        if (time - timestamps[v] > cacheSize) {
+            timestamps[v] = time++;
+            ++misses;
+        }
+        if (!used[v]) {
+            used[v] = true;
+            ++unique;
+        }
+    }
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(unique);
+    return stats;
+}
+
+std::vector<uint32_t> optimizeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+    size_t cacheSize, std::vector<uint32_t>* clusters) {
+    // Tipsify: Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007.
+    std::vector<uint32_t> result;
+    if (clusters) {
+        clusters->clear();
+    }
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return result;
+    }
+    result.reserve(triangleCount * 3);
+
+    // triangles adjacent to each vertex
+    std::vector<uint32_t> live(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        ++live[indices[i]];
+    }
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        offsets[v + 1] = offsets[v] + live[v];
+    }
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<size_t> timestamps(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    deadEnds.reserve(triangleCount * 3);
+    size_t time = cacheSize + 1;
+    size_t cursor = 0;
+
+    // Returns the next vertex with live triangles when the fan ran into a dead end.
+    auto skipDeadEnd = [&]() -> uint32_t {
+        while (!deadEnds.empty()) {
+            uint32_t d = deadEnds.back();
+            deadEnds.pop_back();
+            if (live[d] > 0) {
+                return d;
+            }
+        }
+        while (cursor < vertexCount) {
+            if (live[cursor] > 0) {
+                return static_cast<uint32_t>(cursor);
+            }
+            ++cursor;
+        }
+        return INVALID_INDEX;
+    };
+
+    uint32_t fan = skipDeadEnd();
+    if (clusters) {
+        clusters->push_back(0);
+    }
+    while (fan != INVALID_INDEX) {
+        candidates.clear();
+        for (uint32_t i = offsets[fan]; i < offsets[fan + 1]; ++i) {
+            uint32_t t = adjacency[i];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = true;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = indices[t * 3 + k];
+                result.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - timestamps[v] > cacheSize) {
+                    timestamps[v] = time++;
+                }
+            }
+        }
+
+        // Pick the candidate that will still be in the cache after its remaining triangles are emitted.
+        uint32_t next = INVALID_INDEX;
+        size_t best = 0;
+        bool found = false;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) {
+                continue;
+            }
+            size_t priority = 0;
+            size_t age = time - timestamps[v];
+            if (age + 2 * live[v] <= cacheSize) {
+                priority = age;
+            }
+            if (!found || priority > best) {
+                best = priority;
+                next = v;
+                found = true;
+            }
+        }
+        if (!found) {
+            next = skipDeadEnd();
+            if (clusters && next != INVALID_INDEX && result.size() < triangleCount * 3) {
+                clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+            }
+        }
+        fan = next;
+    }
+    return result;
+}
+
+std::vector<uint32_t> optimizeOverdraw(const uint32_t* indices, size_t indexCount, const float* positions,
+    size_t vertexCount, size_t stride, const std::vector<uint32_t>& clusters, float threshold) {
+    std::vector<uint32_t> input(indices, indices + indexCount);
+    const size_t triangleCount = indexCount / 3;
+    if (clusters.size() < 2 || triangleCount == 0) {
+        return input;
+    }
+    if (stride == 0) {
+        stride = sizeof(float) * 3;
+    }
+    const auto* bytes = reinterpret_cast<const unsigned char*>(positions);
+    auto position = [bytes, stride](uint32_t v) {
+        const float* p = reinterpret_cast<const float*>(bytes + v * stride);
+        return vec3(p[0], p[1], p[2]);
+    };
+
+    struct Cluster {
+        uint32_t begin;
+        uint32_t end;
+        vec3 centroid;
+        vec3 normal;
+        float sortKey;
+    };
+    std::vector<Cluster> sorted(clusters.size());
+    vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        Cluster& cluster = sorted[c];
+        cluster.begin = clusters[c];
+        cluster.end = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<uint32_t>(triangleCount);
+        cluster.centroid = vec3(0.0f);
+        cluster.normal = vec3(0.0f);
+        float area = 0.0f;
+        for (uint32_t t = cluster.begin; t < cluster.end; ++t) {
+            vec3 p0 = position(indices[t * 3 + 0]);
+            vec3 p1 = position(indices[t * 3 + 1]);
+            vec3 p2 = position(indices[t * 3 + 2]);
+            vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float a = glm::length(n);
+            cluster.centroid += (p0 + p1 + p2) * (a / 3.0f);
+            cluster.normal += n;
+            area += a;
+        }
+        meshCentroid += cluster.centroid;
+        meshArea += area;
+        if (area > 0.0f) {
+            cluster.centroid /= area;
+        }
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+    for (auto& cluster : sorted) {
+        float length = glm::length(cluster.normal);
+        cluster.sortKey = length > 0.0f ? glm::dot(cluster.centroid - meshCentroid, cluster.normal / length) : 0.0f;
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& lhs, const Cluster& rhs) {
+        return lhs.sortKey > rhs.sortKey;
+    });
+
+    std::vector<uint32_t> result;
+    result.reserve(indexCount);
+    for (const auto& cluster : sorted) {
+        result.insert(result.end(), indices + cluster.begin * 3, indices + cluster.end * 3);
+    }
+    // Don't give up too much of the vertex cache optimization.
+    float before = analyzeVertexCache(input.data(), input.size(), vertexCount).acmr;
+    float after = analyzeVertexCache(result.data(), result.size(), vertexCount).acmr;
+    if (after > before * threshold) {
+        return input;
+    }
+    return result;
+}
+
+std::vector<uint32_t> optimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount, size_t& uniqueCount) {
+    std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t& v = remap[indices[i]];
+        if (v == INVALID_INDEX) {
+            v = next++;
+        }
+        indices[i] = v;
+    }
+    uniqueCount = next;
+    return remap;
+}
+
+void remapVertices(void* destination, const void* vertices, size_t vertexCount, size_t elementSize, size_t stride,
+    const std::vector<uint32_t>& remap) {
+    if (stride == 0) {
+        stride = elementSize;
+    }
+    auto* dst = reinterpret_cast<unsigned char*>(destination);
+    const auto* src = reinterpret_cast<const unsigned char*>(vertices);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        if (remap[i] != INVALID_INDEX) {
+            memcpy(dst + remap[i] * elementSize, src + i * stride, elementSize);
+        }
+    }
+}
+
+} // namespace kepler
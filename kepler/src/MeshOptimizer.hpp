@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Base.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace kepler {
+
+/// Post transform vertex cache statistics of an indexed triangle list.
+struct VertexCacheStats {
+    /// Average cache miss ratio. The number of transformed vertices per triangle. 0.5 is ideal and 3 is the worst.
+    float acmr = 0.0f;
+    /// Average transform to vertex ratio. The number of transformed vertices per unique vertex. 1 is ideal.
+    float atvr = 0.0f;
+};
+
+/// Simulates a FIFO post transform vertex cache and returns the ACMR and ATVR.
+/// @param[in] indices     Triangle list indices.
+/// @param[in] indexCount  The number of indices.
+/// @param[in] vertexCount The number of vertices.
+/// @param[in] cacheSize   The number of entries in the simulated cache.
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize = 16);
+
+/// Reorders triangles to reduce post transform vertex cache misses using Tipsify.
+/// Tipsify runs in linear time and doesn't depend on the exact cache size of the GPU.
+/// @param[in]  indices     Triangle list indices.
+/// @param[in]  indexCount  The number of indices.
+/// @param[in]  vertexCount The number of vertices.
+/// @param[in]  cacheSize   The cache size to optimize for.
+/// @param[out] clusters    The first triangle of each cluster that starts after a cache flush. May be null.
+///                         These clusters can be reordered by optimizeOverdraw() without hurting the cache much.
+/// @return The reordered indices.
+std::vector<uint32_t> optimizeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+    size_t cacheSize = 16, std::vector<uint32_t>* clusters = nullptr);
+
+/// Reorders the clusters from optimizeVertexCache() to reduce overdraw.
+/// Clusters that face away from the center of the mesh are drawn first since they are likely to occlude the others.
+/// @param[in] indices   Triangle list indices returned by optimizeVertexCache().
+/// @param[in] positions Pointer to the position of the first vertex (3 floats).
+/// @param[in] stride    The number of bytes between positions. Zero means tightly packed.
+/// @param[in] clusters  The clusters returned by optimizeVertexCache().
+/// @param[in] threshold The max ACMR of the result relative to the input. The input order is kept if it would be worse.
+/// @return The reordered indices.
+std::vector<uint32_t> optimizeOverdraw(const uint32_t* indices, size_t indexCount, const float* positions,
+    size_t vertexCount, size_t stride, const std::vector<uint32_t>& clusters, float threshold = 1.05f);
+
+/// Renumbers the vertices in the order they are first used by the indices to improve vertex fetch locality.
+/// Vertices that are not used are removed.
+/// @param[in,out] indices     Triangle list indices. Rewritten to use the new vertex numbers.
+/// @param[in]     indexCount  The number of indices.
+/// @param[in]     vertexCount The number of vertices.
+/// @param[out]    uniqueCount The number of vertices after removing unused vertices.
+/// @return The remap table from the old vertex number to the new one. Unused vertices map to UINT32_MAX.
+std::vector<uint32_t> optimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount, size_t& uniqueCount);
+
+/// Copies vertex data in the order given by a remap table from optimizeVertexFetch().
+/// @param[out] destination Tightly packed output with room for the unique vertex count.
+/// @param[in]  vertices    The source vertex data.
+/// @param[in]  vertexCount The number of source vertices.
+/// @param[in]  elementSize The number of bytes to copy per vertex.
+/// @param[in]  stride      The number of bytes between source vertices. Zero means elementSize.
+/// @param[in]  remap       The remap table.
+void remapVertices(void* destination, const void* vertices, size_t vertexCount, size_t elementSize, size_t stride,
+    const std::vector<uint32_t>& remap);
+
+} // namespace kepler
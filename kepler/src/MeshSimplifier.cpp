@@ -0,0 +1,449 @@
+#include "stdafx.h"
+#include "MeshSimplifier.hpp"
+#include "BaseMath.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+namespace kepler {
+
+// Open borders are weighted heavier than faces so the silhouette of the mesh is preserved.
+static constexpr double BORDER_WEIGHT = 10.0;
+// A collapse is rejected if it rotates a triangle normal by more than about 75 degrees.
+static constexpr float MIN_NORMAL_DOT = 0.25f;
+static constexpr int MAX_PASSES = 100;
+
+namespace {
+
+/// The sum of the squared distances to a set of planes.
+/// Stored as the upper half of a symmetric 4x4 matrix.
+struct Quadric {
+    double a00 = 0, a11 = 0, a22 = 0, a10 = 0, a20 = 0, a21 = 0;
+    double b0 = 0, b1 = 0, b2 = 0;
+    double c = 0;
+    double weight = 0;
+
+    void addPlane(const vec3& n, float d, double w) {
+        a00 += w * n.x * n.x;
+        a11 += w * n.y * n.y;
+        a22 += w * n.z * n.z;
+        a10 += w * n.y * n.x;
+        a20 += w * n.z * n.x;
+        a21 += w * n.z * n.y;
+        b0 += w * n.x * d;
+        b1 += w * n.y * d;
+        b2 += w * n.z * d;
+        c += w * d * d;
+        weight += w;
+    }
+
+    void add(const Quadric& q) {
+        a00 += q.a00;
+        a11 += q.a11;
+        a22 += q.a22;
+        a10 += q.a10;
+        a20 += q.a20;
+        a21 += q.a21;
+        b0 += q.b0;
+        b1 += q.b1;
+        b2 += q.b2;
+        c += q.c;
+        weight += q.weight;
+    }
+
+    /// Returns the weighted sum of the squared distances from the point to the planes.
+    double evaluate(const vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double rx = a00 * x + a10 * y + a20 * z;
+        double ry = a10 * x + a11 * y + a21 * z;
+        double rz = a20 * x + a21 * y + a22 * z;
+        return rx * x + ry * y + rz * z + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+    }
+};
+
+struct PositionKey {
+    uint32_t x, y, z;
+    bool operator==(const PositionKey& other) const {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+
+struct PositionKeyHash {
+    size_t operator()(const PositionKey& key) const {
+        size_t h = key.x;
+        h = h * 73856093u ^ key.y;
+        h = h * 19349663u ^ key.z;
+        return h;
+    }
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    float cost;
+};
+
+enum VertexKind : uint8_t {
+    MANIFOLD,
+    BORDER,
+    LOCKED
+};
+
+} // anonymous namespace
+
+static inline uint64_t edgeKey(uint32_t a, uint32_t b) {
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+static PositionKey toKey(const vec3& p) {
+    PositionKey key;
+    memcpy(&key.x, &p.x, sizeof(float));
+    memcpy(&key.y, &p.y, sizeof(float));
+    memcpy(&key.z, &p.z, sizeof(float));
+    return key;
+}
+
+/// The mesh being simplified.
+/// Topology is tracked on the first vertex of each unique position so that duplicated vertices
+/// along attribute seams are treated as one vertex.
+class Simplifier {
+public:
+    Simplifier(const float* positions, size_t vertexCount, size_t stride, const uint32_t* indices, size_t indexCount)
+        : _indices(indices, indices + indexCount) {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(positions);
+        _positions.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            const float* p = reinterpret_cast<const float*>(bytes + i * stride);
+            _positions[i] = vec3(p[0], p[1], p[2]);
+        }
+        normalizePositions();
+        findUniquePositions();
+        computeQuadrics();
+    }
+
+    std::vector<uint32_t> simplify(size_t targetIndexCount, float targetError, float& resultError) {
+        const double maxCost = static_cast<double>(targetError) * static_cast<double>(targetError);
+        double worst = 0.0;
+        for (int pass = 0; pass < MAX_PASSES && _indices.size() > targetIndexCount; ++pass) {
+            buildAdjacency();
+            findCollapses();
+            if (_collapses.empty() || _collapses.front().cost > maxCost) {
+                break;
+            }
+            size_t applied = applyCollapses(targetIndexCount, maxCost, worst);
+            if (applied == 0) {
+                break;
+            }
+            removeDegenerateTriangles();
+        }
+        resultError = static_cast<float>(std::sqrt(worst));
+        return std::move(_indices);
+    }
+
+private:
+    void normalizePositions() {
+        if (_positions.empty()) {
+            return;
+        }
+        vec3 min = _positions[0];
+        vec3 max = _positions[0];
+        for (const auto& p : _positions) {
+            min = glm::min(min, p);
+            max = glm::max(max, p);
+        }
+        vec3 size = max - min;
+        float extent = std::max(size.x, std::max(size.y, size.z));
+        float scale = extent > 0.f ? 1.f / extent : 1.f;
+        for (auto& p : _positions) {
+            p = (p - min) * scale;
+        }
+    }
+
+    void findUniquePositions() {
+        const size_t vertexCount = _positions.size();
+        _unique.resize(vertexCount);
+        std::vector<uint32_t> wedges(vertexCount, 0);
+        std::vector<bool> referenced(vertexCount, false);
+        for (uint32_t index : _indices) {
+            referenced[index] = true;
+        }
+        std::unordered_map<PositionKey, uint32_t, PositionKeyHash> lookup;
+        lookup.reserve(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; ++i) {
+            _unique[i] = i;
+            if (referenced[i]) {
+                auto it = lookup.emplace(toKey(_positions[i]), i).first;
+                _unique[i] = it->second;
+                ++wedges[it->second];
+            }
+        }
+        // Collapsing a vertex on a seam would stretch the attributes on one side of it.
+        _kinds.assign(vertexCount, MANIFOLD);
+        _locked.assign(vertexCount, false);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            if (wedges[i] > 1) {
+                _locked[i] = true;
+            }
+        }
+    }
+
+    void computeQuadrics() {
+        _quadrics.assign(_positions.size(), Quadric());
+        buildAdjacency();
+        const size_t triangleCount = _indices.size() / 3;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            uint32_t v[3];
+            triangle(t, v);
+            const vec3& p0 = _positions[v[0]];
+            const vec3& p1 = _positions[v[1]];
+            const vec3& p2 = _positions[v[2]];
+            vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(normal);
+            if (length == 0.f) {
+                continue;
+            }
+            normal /= length;
+            float d = -glm::dot(normal, p0);
+            double area = 0.5 * length;
+            for (int i = 0; i < 3; ++i) {
+                _quadrics[v[i]].addPlane(normal, d, area);
+            }
+            // Add a plane perpendicular to each open edge so that borders keep their shape.
+            for (int i = 0; i < 3; ++i) {
+                uint32_t a = v[i];
+                uint32_t b = v[(i + 1) % 3];
+                if (_edges.count(edgeKey(b, a)) == 0) {
+                    vec3 edge = _positions[b] - _positions[a];
+                    float edgeLength = glm::length(edge);
+                    if (edgeLength == 0.f) {
+                        continue;
+                    }
+                    vec3 borderNormal = glm::normalize(glm::cross(edge, normal));
+                    float borderD = -glm::dot(borderNormal, _positions[a]);
+                    double weight = BORDER_WEIGHT * edgeLength * edgeLength;
+                    _quadrics[a].addPlane(borderNormal, borderD, weight);
+                    _quadrics[b].addPlane(borderNormal, borderD, weight);
+                }
+            }
+        }
+    }
+
+    /// Gets the unique position vertices of the triangle.
+    void triangle(size_t t, uint32_t* v) const {
+        v[0] = _unique[_indices[t * 3 + 0]];
+        v[1] = _unique[_indices[t * 3 + 1]];
+        v[2] = _unique[_indices[t * 3 + 2]];
+    }
+
+    void buildAdjacency() {
+        const size_t vertexCount = _positions.size();
+        const size_t triangleCount = _indices.size() / 3;
+        _offsets.assign(vertexCount + 1, 0);
+        for (uint32_t index : _indices) {
+            ++_offsets[_unique[index] + 1];
+        }
+        for (size_t i = 0; i < vertexCount; ++i) {
+            _offsets[i + 1] += _offsets[i];
+        }
+        _triangles.resize(_indices.size());
+        std::vector<uint32_t> fill(_offsets.begin(), _offsets.end() - 1);
+        _edges.clear();
+        _edges.reserve(_indices.size());
+        for (size_t t = 0; t < triangleCount; ++t) {
+            uint32_t v[3];
+            triangle(t, v);
+            for (int i = 0; i < 3; ++i) {
+                _triangles[fill[v[i]]++] = static_cast<uint32_t>(t);
+                _edges.insert(edgeKey(v[i], v[(i + 1) % 3]));
+            }
+        }
+        for (size_t i = 0; i < vertexCount; ++i) {
+            _kinds[i] = _locked[i] ? LOCKED : MANIFOLD;
+        }
+        for (const auto& edge : _edges) {
+            uint32_t a = static_cast<uint32_t>(edge >> 32);
+            uint32_t b = static_cast<uint32_t>(edge & 0xFFFFFFFF);
+            if (_edges.count(edgeKey(b, a)) == 0) {
+                if (_kinds[a] != LOCKED) {
+                    _kinds[a] = BORDER;
+                }
+                if (_kinds[b] != LOCKED) {
+                    _kinds[b] = BORDER;
+                }
+            }
+        }
+    }
+
+    void findCollapses() {
+        _collapses.clear();
+        const size_t triangleCount = _indices.size() / 3;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            for (int i = 0; i < 3; ++i) {
+                uint32_t a = _indices[t * 3 + i];
+                uint32_t b = _indices[t * 3 + (i + 1) % 3];
+                uint32_t ua = _unique[a];
+                uint32_t ub = _unique[b];
+                if (ua == ub) {
+                    continue;
+                }
+                bool border = _edges.count(edgeKey(ub, ua)) == 0;
+                addCollapse(a, b, border);
+                addCollapse(b, a, border);
+            }
+        }
+        std::sort(_collapses.begin(), _collapses.end(), [](const Collapse& lhs, const Collapse& rhs) {
+            return lhs.cost < rhs.cost;
+        });
+    }
+
+    void addCollapse(uint32_t from, uint32_t to, bool borderEdge) {
+        uint32_t u0 = _unique[from];
+        uint32_t u1 = _unique[to];
+        VertexKind kind = static_cast<VertexKind>(_kinds[u0]);
+        if (kind == LOCKED || (kind == BORDER && !borderEdge)) {
+            return;
+        }
+        const Quadric& q0 = _quadrics[u0];
+        const Quadric& q1 = _quadrics[u1];
+        const vec3& p = _positions[u1];
+        double weight = q0.weight + q1.weight;
+        double cost = weight > 0.0 ? (q0.evaluate(p) + q1.evaluate(p)) / weight : 0.0;
+        _collapses.push_back({from, to, static_cast<float>(std::max(cost, 0.0))});
+    }
+
+    /// Returns true if moving vertex u0 onto u1 would flip one of the triangles around u0.
+    bool flips(uint32_t u0, uint32_t u1) const {
+        const vec3& target = _positions[u1];
+        for (uint32_t i = _offsets[u0]; i < _offsets[u0 + 1]; ++i) {
+            uint32_t v[3];
+            triangle(_triangles[i], v);
+            if (v[0] == u1 || v[1] == u1 || v[2] == u1) {
+                continue; // this triangle is removed by the collapse
+            }
+            vec3 p[3] = {_positions[v[0]], _positions[v[1]], _positions[v[2]]};
+            vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            for (int k = 0; k < 3; ++k) {
+                if (v[k] == u0) {
+                    p[k] = target;
+                }
+            }
+            vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+            if (glm::dot(before, after) < MIN_NORMAL_DOT * glm::length(before) * glm::length(after)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t applyCollapses(size_t targetIndexCount, double maxCost, double& worst) {
+        // Vertices near a collapse can't be collapsed again in the same pass because the adjacency is stale.
+        std::vector<bool> touched(_positions.size(), false);
+        std::vector<uint32_t> remap(_positions.size());
+        for (uint32_t i = 0; i < remap.size(); ++i) {
+            remap[i] = i;
+        }
+        size_t indexCount = _indices.size();
+        size_t applied = 0;
+        for (const auto& collapse : _collapses) {
+            if (collapse.cost > maxCost || indexCount <= targetIndexCount) {
+                break;
+            }
+            uint32_t u0 = _unique[collapse.from];
+            uint32_t u1 = _unique[collapse.to];
+            if (touched[u0] || touched[u1] || flips(u0, u1)) {
+                continue;
+            }
+            for (uint32_t i = _offsets[u0]; i < _offsets[u0 + 1]; ++i) {
+                uint32_t v[3];
+                triangle(_triangles[i], v);
+                if (v[0] == u1 || v[1] == u1 || v[2] == u1) {
+                    indexCount -= 3;
+                }
+                touched[v[0]] = touched[v[1]] = touched[v[2]] = true;
+            }
+            remap[collapse.from] = collapse.to;
+            _quadrics[u1].add(_quadrics[u0]);
+            worst = std::max(worst, static_cast<double>(collapse.cost));
+            ++applied;
+        }
+        for (auto& index : _indices) {
+            index = remap[index];
+        }
+        return applied;
+    }
+
+    void removeDegenerateTriangles() {
+        size_t write = 0;
+        const size_t triangleCount = _indices.size() / 3;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            uint32_t v[3];
+            triangle(t, v);
+            if (v[0] != v[1] && v[1] != v[2] && v[0] != v[2]) {
+                _indices[write++] = _indices[t * 3 + 0];
+                _indices[write++] = _indices[t * 3 + 1];
+                _indices[write++] = _indices[t * 3 + 2];
+            }
+        }
+        _indices.resize(write);
+    }
+
+private:
+    std::vector<vec3> _positions;
+    std::vector<uint32_t> _indices;
+    std::vector<uint32_t> _unique;
+    std::vector<uint8_t> _kinds;
+    std::vector<bool> _locked;
+    std::vector<Quadric> _quadrics;
+    std::vector<uint32_t> _offsets;
+    std::vector<uint32_t> _triangles;
+    std::unordered_set<uint64_t> _edges;
+    std::vector<Collapse> _collapses;
+};
+
+std::vector<uint32_t> simplifyMesh(const float* positions, size_t vertexCount, size_t stride,
+    const uint32_t* indices, size_t indexCount, size_t targetIndexCount, float targetError, float* resultError) {
+    if (resultError) {
+        *resultError = 0.f;
+    }
+    if (indexCount % 3 != 0 || indexCount <= targetIndexCount) {
+        return std::vector<uint32_t>(indices, indices + indexCount);
+    }
+    if (stride == 0) {
+        stride = sizeof(float) * 3;
+    }
+    Simplifier simplifier(positions, vertexCount, stride, indices, indexCount);
+    float error = 0.f;
+    auto result = simplifier.simplify(targetIndexCount, targetError, error);
+    if (resultError) {
+        *resultError = error;
+    }
+    return result;
+}
+
+std::vector<MeshLod> generateLods(const float* positions, size_t vertexCount, size_t stride,
+    const uint32_t* indices, size_t indexCount, size_t levels, float ratio, float maxError) {
+    std::vector<MeshLod> lods;
+    size_t previous = indexCount;
+    double target = static_cast<double>(indexCount);
+    for (size_t level = 0; level < levels; ++level) {
+        target *= ratio;
+        size_t targetIndexCount = static_cast<size_t>(target) / 3 * 3;
+        // Always simplify the original mesh so the error is measured against it.
+        float error = 0.f;
+        auto result = simplifyMesh(positions, vertexCount, stride, indices, indexCount, targetIndexCount, maxError, &error);
+        if (result.empty() || result.size() * 10 > previous * 9) {
+            break; // simplification stalled
+        }
+        previous = result.size();
+        if (!lods.empty()) {
+            error = std::max(error, lods.back().error);
+        }
+        lods.push_back({std::move(result), error});
+    }
+    return lods;
+}
+
+} // namespace kepler
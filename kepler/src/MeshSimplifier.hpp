@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Base.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace kepler {
+
+/// One level of detail created by generateLods().
+struct MeshLod {
+    /// Triangle list indices into the original vertex data.
+    std::vector<uint32_t> indices;
+    /// The error of this level relative to the size of the mesh.
+    float error;
+};
+
+/// Simplifies a triangle list using quadric error metric edge collapses.
+///
+/// Vertices are never moved or created. The returned indices refer to the original vertices
+/// so every level of detail can share the same vertex buffers.
+/// Vertices that share a position but not their other attributes (UV or normal seams) are never collapsed
+/// and open borders are only collapsed along the border.
+///
+/// @param[in]  positions        Pointer to the position of the first vertex (3 floats).
+/// @param[in]  vertexCount      The number of vertices.
+/// @param[in]  stride           The number of bytes between positions. Zero means tightly packed.
+/// @param[in]  indices          Triangle list indices.
+/// @param[in]  indexCount       The number of indices.
+/// @param[in]  targetIndexCount Simplification stops once there are at most this many indices.
+/// @param[in]  targetError      The max error relative to the size of the mesh. 0.01 is 1% of the extent of the mesh.
+/// @param[out] resultError      The relative error of the simplified mesh. May be null.
+/// @return The simplified triangle list.
+std::vector<uint32_t> simplifyMesh(const float* positions, size_t vertexCount, size_t stride,
+    const uint32_t* indices, size_t indexCount, size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+/// Generates a chain of levels of detail. Each level has about ratio times the indices of the previous level.
+/// Stops early when the mesh can't be simplified any further without going over maxError.
+/// @param[in] levels   The max number of levels to create, not counting the original mesh.
+/// @param[in] ratio    The target index count of each level relative to the previous level.
+/// @param[in] maxError The max error of any level relative to the size of the mesh.
+/// @return The levels ordered from the most to the least detailed.
+std::vector<MeshLod> generateLods(const float* positions, size_t vertexCount, size_t stride,
+    const uint32_t* indices, size_t indexCount, size_t levels, float ratio = 0.5f, float maxError = 0.05f);
+
+} // namespace kepler
@@ -0,0 +1,398 @@
+#include "stdafx.h"
+#include "MeshoptDecoder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace kepler {
+namespace meshopt {
+
+// The layout of the streams is described in the EXT_meshopt_compression specification.
+
+static constexpr uint8_t VERTEX_HEADER = 0xA0;
+static constexpr uint8_t INDEX_HEADER = 0xE0;
+static constexpr uint8_t SEQUENCE_HEADER = 0xD0;
+
+// Vertices are decoded in blocks of up to 256 vertices that fit in 8 KB.
+static constexpr size_t VERTEX_BLOCK_SIZE_BYTES = 8192;
+static constexpr size_t VERTEX_BLOCK_MAX_SIZE = 256;
+// Each byte of a vertex is delta encoded in groups of 16.
+static constexpr size_t BYTE_GROUP_SIZE = 16;
+// The most bytes a group can take: 8 bytes of 4 bit values and 16 escaped bytes.
+static constexpr size_t BYTE_GROUP_DECODE_LIMIT = 24;
+// The first vertex is stored in a tail that is padded to this size.
+static constexpr size_t TAIL_MAX_SIZE = 32;
+
+static size_t vertexBlockSize(size_t stride) {
+    size_t result = VERTEX_BLOCK_SIZE_BYTES / stride;
+    result &= ~(BYTE_GROUP_SIZE - 1);
+    return std::min(result, VERTEX_BLOCK_MAX_SIZE);
+}
+
+static uint8_t unzigzag8(uint8_t v) {
+    return static_cast<uint8_t>(-(v & 1) ^ (v >> 1));
+}
+
+/// Decodes one group of 16 bytes stored with 0, 2, 4 or 8 bits each. Values that don't fit in 2 or 4 bits are
+/// stored as the max value followed by the byte after the packed bits.
+static const uint8_t* decodeBytesGroup(const uint8_t* data, uint8_t* destination, int bitsLog2) {
+    switch (bitsLog2) {
+    case 0:
+        memset(destination, 0, BYTE_GROUP_SIZE);
+        return data;
+    case 1:
+    case 2: {
+        const int bits = 1 << bitsLog2;
+        const uint8_t escape = static_cast<uint8_t>((1 << bits) - 1);
+        const int perByte = 8 / bits;
+        const uint8_t* extra = data + BYTE_GROUP_SIZE / perByte;
+        for (size_t i = 0; i < BYTE_GROUP_SIZE; i += perByte) {
+            uint8_t byte = *data++;
+            for (int j = 0; j < perByte; ++j) {
+                const uint8_t value = static_cast<uint8_t>(byte >> (8 - bits));
+                byte = static_cast<uint8_t>(byte << bits);
+                if (value == escape) {
+                    *destination++ = *extra++;
+                }
+                else {
+                    *destination++ = value;
+                }
+            }
+        }
+        return extra;
+    }
+    default:
+        memcpy(destination, data, BYTE_GROUP_SIZE);
+        return data + BYTE_GROUP_SIZE;
+    }
+}
+
+/// Decodes size bytes, a multiple of 16, that are preceded by a header of 2 bits per group.
+static const uint8_t* decodeBytes(const uint8_t* data, const uint8_t* end, uint8_t* destination, size_t size) {
+    const uint8_t* header = data;
+    const size_t headerSize = (size / BYTE_GROUP_SIZE + 3) / 4;
+    if (static_cast<size_t>(end - data) < headerSize) {
+        return nullptr;
+    }
+    data += headerSize;
+    for (size_t i = 0; i < size; i += BYTE_GROUP_SIZE) {
+        if (static_cast<size_t>(end - data) < BYTE_GROUP_DECODE_LIMIT) {
+            return nullptr;
+        }
+        const size_t group = i / BYTE_GROUP_SIZE;
+        const int bitsLog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+        data = decodeBytesGroup(data, destination + i, bitsLog2);
+    }
+    return data;
+}
+
+static const uint8_t* decodeVertexBlock(const uint8_t* data, const uint8_t* end, uint8_t* destination, size_t count,
+    size_t stride, uint8_t lastVertex[256]) {
+    uint8_t deltas[VERTEX_BLOCK_MAX_SIZE];
+    const size_t alignedCount = (count + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+    // Each byte of the vertex is stored separately as deltas from the same byte of the previous vertex.
+    for (size_t k = 0; k < stride; ++k) {
+        data = decodeBytes(data, end, deltas, alignedCount);
+        if (data == nullptr) {
+            return nullptr;
+        }
+        uint8_t previous = lastVertex[k];
+        uint8_t* out = destination + k;
+        for (size_t i = 0; i < count; ++i) {
+            previous = static_cast<uint8_t>(unzigzag8(deltas[i]) + previous);
+            *out = previous;
+            out += stride;
+        }
+    }
+    memcpy(lastVertex, destination + (count - 1) * stride, stride);
+    return data;
+}
+
+bool decodeVertexBuffer(void* destination, size_t count, size_t stride, const uint8_t* data, size_t size) {
+    if (stride == 0 || stride > 256 || stride % 4 != 0 || size < 1 + stride) {
+        return false;
+    }
+    const uint8_t* end = data + size;
+    if (*data++ != VERTEX_HEADER) {
+        return false;
+    }
+    uint8_t lastVertex[256];
+    memcpy(lastVertex, end - stride, stride);
+
+    uint8_t* vertices = static_cast<uint8_t*>(destination);
+    const size_t blockSize = vertexBlockSize(stride);
+    for (size_t offset = 0; offset < count; offset += blockSize) {
+        const size_t blockCount = std::min(blockSize, count - offset);
+        data = decodeVertexBlock(data, end, vertices + offset * stride, blockCount, stride, lastVertex);
+        if (data == nullptr) {
+            return false;
+        }
+    }
+    return static_cast<size_t>(end - data) == std::max(stride, TAIL_MAX_SIZE);
+}
+
+static uint32_t decodeVByte(const uint8_t*& data) {
+    const uint8_t lead = *data++;
+    if (lead < 128) {
+        return lead;
+    }
+    uint32_t result = lead & 127;
+    uint32_t shift = 7;
+    for (int i = 0; i < 4; ++i) {
+        const uint8_t group = *data++;
+        result |= static_cast<uint32_t>(group & 127) << shift;
+        shift += 7;
+        if (group < 128) {
+            break;
+        }
+    }
+    return result;
+}
+
+static uint32_t decodeIndex(const uint8_t*& data, uint32_t last) {
+    const uint32_t v = decodeVByte(data);
+    const uint32_t delta = (v >> 1) ^ (0u - (v & 1));
+    return last + delta;
+}
+
+static void writeIndex(void* destination, size_t i, size_t stride, uint32_t index) {
+    if (stride == 2) {
+        static_cast<uint16_t*>(destination)[i] = static_cast<uint16_t>(index);
+    }
+    else {
+        static_cast<uint32_t*>(destination)[i] = index;
+    }
+}
+
+/// The recently used edges and vertices that triangles refer to instead of storing their indices.
+struct TriangleFifo {
+    uint32_t edges[16][2];
+    uint32_t vertices[16];
+    size_t edgeOffset = 0;
+    size_t vertexOffset = 0;
+
+    TriangleFifo() {
+        memset(edges, -1, sizeof(edges));
+        memset(vertices, -1, sizeof(vertices));
+    }
+    /// Returns the edge that was pushed i + 1 pushes ago.
+    const uint32_t* edge(int i) const {
+        return edges[(edgeOffset - 1 - i) & 15];
+    }
+    uint32_t vertex(int i) const {
+        return vertices[(vertexOffset - 1 - i) & 15];
+    }
+    void pushEdge(uint32_t a, uint32_t b) {
+        edges[edgeOffset][0] = a;
+        edges[edgeOffset][1] = b;
+        edgeOffset = (edgeOffset + 1) & 15;
+    }
+    void pushVertex(uint32_t v, bool condition = true) {
+        vertices[vertexOffset] = v;
+        vertexOffset = (vertexOffset + (condition ? 1 : 0)) & 15;
+    }
+};
+
+bool decodeIndexBuffer(void* destination, size_t count, size_t stride, const uint8_t* data, size_t size) {
+    // The smallest stream is the header, a code per triangle and the 16 byte table of auxiliary codes.
+    if (count % 3 != 0 || (stride != 2 && stride != 4) || size < 1 + count / 3 + 16) {
+        return false;
+    }
+    if ((data[0] & 0xF0) != INDEX_HEADER) {
+        return false;
+    }
+    const int version = data[0] & 0x0F;
+    if (version > 1) {
+        return false;
+    }
+    // Version 1 uses the codes 13 and 14 for the last free index minus and plus one.
+    const int fecMax = version >= 1 ? 13 : 15;
+
+    TriangleFifo fifo;
+    uint32_t next = 0;
+    uint32_t last = 0;
+    const uint8_t* code = data + 1;
+    const uint8_t* extra = code + count / 3;
+    // A triangle reads at most 16 bytes of extra data so the table at the end doubles as padding.
+    const uint8_t* safeEnd = data + size - 16;
+    const uint8_t* auxTable = safeEnd;
+
+    for (size_t i = 0; i < count; i += 3) {
+        if (extra > safeEnd) {
+            return false;
+        }
+        const uint8_t codeTri = *code++;
+        uint32_t a;
+        uint32_t b;
+        uint32_t c;
+        if (codeTri < 0xF0) {
+            // An edge from the FIFO and a new, recent or free third vertex.
+            const uint32_t* edge = fifo.edge(codeTri >> 4);
+            a = edge[0];
+            b = edge[1];
+            const int fec = codeTri & 15;
+            if (fec < fecMax) {
+                c = fec == 0 ? next++ : fifo.vertex(fec);
+                fifo.pushVertex(c, fec == 0);
+            }
+            else {
+                c = last = fec != 15 ? last + (fec - (fec ^ 3)) : decodeIndex(extra, last);
+                fifo.pushVertex(c);
+            }
+            fifo.pushEdge(c, b);
+            fifo.pushEdge(a, c);
+            writeIndex(destination, i + 0, stride, a);
+            writeIndex(destination, i + 1, stride, b);
+            writeIndex(destination, i + 2, stride, c);
+            continue;
+        }
+        int feb;
+        int fec;
+        bool pushB;
+        bool pushC;
+        if (codeTri < 0xFE) {
+            // The first vertex is new and the other two are described by the table.
+            const uint8_t codeAux = auxTable[codeTri & 15];
+            feb = codeAux >> 4;
+            fec = codeAux & 15;
+            a = next++;
+            b = feb == 0 ? next++ : fifo.vertex(feb - 1);
+            c = fec == 0 ? next++ : fifo.vertex(fec - 1);
+            pushB = feb == 0;
+            pushC = fec == 0;
+        }
+        else {
+            const uint8_t codeAux = *extra++;
+            const int fea = codeTri == 0xFE ? 0 : 15;
+            feb = codeAux >> 4;
+            fec = codeAux & 15;
+            // A code of zero restarts the numbering of new vertices.
+            if (codeAux == 0) {
+                next = 0;
+            }
+            a = fea == 0 ? next++ : 0;
+            b = feb == 0 ? next++ : fifo.vertex(feb - 1);
+            c = fec == 0 ? next++ : fifo.vertex(fec - 1);
+            if (fea == 15) {
+                last = a = decodeIndex(extra, last);
+            }
+            if (feb == 15) {
+                last = b = decodeIndex(extra, last);
+            }
+            if (fec == 15) {
+                last = c = decodeIndex(extra, last);
+            }
+            pushB = feb == 0 || feb == 15;
+            pushC = fec == 0 || fec == 15;
+        }
+        fifo.pushVertex(a);
+        fifo.pushVertex(b, pushB);
+        fifo.pushVertex(c, pushC);
+        fifo.pushEdge(b, a);
+        fifo.pushEdge(c, b);
+        fifo.pushEdge(a, c);
+        writeIndex(destination, i + 0, stride, a);
+        writeIndex(destination, i + 1, stride, b);
+        writeIndex(destination, i + 2, stride, c);
+    }
+    return extra == safeEnd;
+}
+
+bool decodeIndexSequence(void* destination, size_t count, size_t stride, const uint8_t* data, size_t size) {
+    // The smallest stream is the header, a byte per index and a 4 byte tail.
+    if ((stride != 2 && stride != 4) || size < 1 + count + 4) {
+        return false;
+    }
+    if ((data[0] & 0xF0) != SEQUENCE_HEADER || (data[0] & 0x0F) > 1) {
+        return false;
+    }
+    const uint8_t* safeEnd = data + size - 4;
+    ++data;
+    // Each index is a delta from one of two previous indices, which suits interleaved sequences like strips.
+    uint32_t last[2] = {0, 0};
+    for (size_t i = 0; i < count; ++i) {
+        // An index is at most 5 bytes, which the tail covers.
+        if (data >= safeEnd) {
+            return false;
+        }
+        uint32_t v = decodeVByte(data);
+        const uint32_t baseline = v & 1;
+        v >>= 1;
+        const uint32_t delta = (v >> 1) ^ (0u - (v & 1));
+        last[baseline] += delta;
+        writeIndex(destination, i, stride, last[baseline]);
+    }
+    return data == safeEnd;
+}
+
+template<typename T>
+static void decodeOct(T* data, size_t count) {
+    const float max = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+    for (size_t i = 0; i < count; ++i, data += 4) {
+        // z holds the value of 1 at the same precision so the vector can be rebuilt from x and y.
+        float x = static_cast<float>(data[0]);
+        float y = static_cast<float>(data[1]);
+        const float z = static_cast<float>(data[2]) - std::fabs(x) - std::fabs(y);
+        // Fold the lower hemisphere back.
+        const float t = z >= 0.0f ? 0.0f : z;
+        x += x >= 0.0f ? t : -t;
+        y += y >= 0.0f ? t : -t;
+        const float scale = max / std::sqrt(x * x + y * y + z * z);
+        data[0] = static_cast<T>(static_cast<int>(x * scale + (x >= 0.0f ? 0.5f : -0.5f)));
+        data[1] = static_cast<T>(static_cast<int>(y * scale + (y >= 0.0f ? 0.5f : -0.5f)));
+        data[2] = static_cast<T>(static_cast<int>(z * scale + (z >= 0.0f ? 0.5f : -0.5f)));
+    }
+}
+
+void decodeFilterOct(void* data, size_t count, size_t stride) {
+    if (stride == 4) {
+        decodeOct(static_cast<int8_t*>(data), count);
+    }
+    else if (stride == 8) {
+        decodeOct(static_cast<int16_t*>(data), count);
+    }
+}
+
+void decodeFilterQuat(void* data, size_t count, size_t stride) {
+    if (stride != 8) {
+        return;
+    }
+    const float scale = 1.0f / std::sqrt(2.0f);
+    int16_t* q = static_cast<int16_t*>(data);
+    for (size_t i = 0; i < count; ++i, q += 4) {
+        // The fourth component holds the precision in its high bits and which component was dropped in the low 2.
+        const int sf = q[3] | 3;
+        const float s = scale / static_cast<float>(sf);
+        const float x = q[0] * s;
+        const float y = q[1] * s;
+        const float z = q[2] * s;
+        const float ww = 1.0f - x * x - y * y - z * z;
+        const float w = std::sqrt(ww >= 0.0f ? ww : 0.0f);
+        const int xf = static_cast<int>(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f));
+        const int yf = static_cast<int>(y * 32767.0f + (y >= 0.0f ? 0.5f : -0.5f));
+        const int zf = static_cast<int>(z * 32767.0f + (z >= 0.0f ? 0.5f : -0.5f));
+        const int wf = static_cast<int>(w * 32767.0f + 0.5f);
+        const int qc = q[3] & 3;
+        q[(qc + 1) & 3] = static_cast<int16_t>(xf);
+        q[(qc + 2) & 3] = static_cast<int16_t>(yf);
+        q[(qc + 3) & 3] = static_cast<int16_t>(zf);
+        q[(qc + 0) & 3] = static_cast<int16_t>(wf);
+    }
+}
+
+void decodeFilterExp(void* data, size_t count, size_t stride) {
+    uint32_t* values = static_cast<uint32_t*>(data);
+    const size_t valueCount = count * (stride / 4);
+    for (size_t i = 0; i < valueCount; ++i) {
+        // A 24 bit signed mantissa and an 8 bit signed exponent.
+        const uint32_t v = values[i];
+        const int mantissa = static_cast<int32_t>(v << 8) >> 8;
+        const int exponent = static_cast<int32_t>(v) >> 24;
+        const float f = std::ldexp(static_cast<float>(mantissa), exponent);
+        memcpy(&values[i], &f, sizeof(f));
+    }
+}
+
+} // namespace meshopt
+} // namespace kepler
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Base.hpp"
+
+#include <cstdint>
+
+namespace kepler {
+
+/// Decoders for the bitstreams of the EXT_meshopt_compression glTF extension.
+///
+/// Every function decodes straight into the destination, which must have room for count * stride bytes,
+/// and returns false if the data is truncated or isn't a stream it understands. Nothing is read outside of
+/// [data, data + size) even for corrupt input.
+namespace meshopt {
+
+/// Decodes the ATTRIBUTES mode. The stride must be a multiple of 4 and at most 256.
+bool decodeVertexBuffer(void* destination, size_t count, size_t stride, const uint8_t* data, size_t size);
+
+/// Decodes the TRIANGLES mode. The count is the number of indices and must be a multiple of 3.
+/// The stride is 2 or 4.
+bool decodeIndexBuffer(void* destination, size_t count, size_t stride, const uint8_t* data, size_t size);
+
+/// Decodes the INDICES mode. The stride is 2 or 4.
+bool decodeIndexSequence(void* destination, size_t count, size_t stride, const uint8_t* data, size_t size);
+
+/// Reconstructs unit vectors from the OCTAHEDRAL filter in place. The stride is 4 (8 bit) or 8 (16 bit).
+void decodeFilterOct(void* data, size_t count, size_t stride);
+
+/// Reconstructs unit quaternions from the QUATERNION filter in place. The stride is 8.
+void decodeFilterQuat(void* data, size_t count, size_t stride);
+
+/// Reconstructs 32 bit floats from the EXPONENTIAL filter in place. The stride is a multiple of 4.
+void decodeFilterExp(void* data, size_t count, size_t stride);
+
+} // namespace meshopt
+} // namespace kepler
@@ -0,0 +1,51 @@
+#include "stdafx.h"
+#include "Occluder.hpp"
+#include "Scene.hpp"
+#include "Node.hpp"
+
+namespace kepler {
+
+Occluder::Occluder(const shared_ptr<const OccluderMesh>& mesh) : _mesh(mesh) {
+}
+
+Occluder::~Occluder() noexcept = default;
+
+shared_ptr<Occluder> Occluder::create(const shared_ptr<const OccluderMesh>& mesh) {
+    return std::make_shared<Occluder>(mesh);
+}
+
+shared_ptr<Occluder> Occluder::createBox(const BoundingBox& box) {
+    auto mesh = std::make_shared<OccluderMesh>();
+    mesh->positions.resize(8);
+    box.corners(mesh->positions.data());
+    // see BoundingBox::corners() for the order of the corners
+    mesh->indices = {
+        0, 1, 2, 0, 2, 3, // front
+        4, 5, 6, 4, 6, 7, // back
+        7, 6, 1, 7, 1, 0, // left
+        3, 2, 5, 3, 5, 4, // right
+        7, 0, 3, 7, 3, 4, // top
+        1, 6, 5, 1, 5, 2  // bottom
+    };
+    return create(mesh);
+}
+
+const shared_ptr<const OccluderMesh>& Occluder::mesh() const {
+    return _mesh;
+}
+
+const std::string& Occluder::typeName() const {
+    static std::string typeName("Occluder");
+    return typeName;
+}
+
+void Occluder::gather(const Scene& scene, std::vector<OccluderInstance>& occluders) {
+    scene.visit([&occluders](Node* node) {
+        if (auto occluder = node->component<Occluder>()) {
+            if (occluder->mesh()) {
+                occluders.push_back({occluder->mesh(), node->worldMatrix()});
+            }
+        }
+    });
+}
+}
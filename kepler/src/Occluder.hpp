@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Base.hpp"
+#include "Component.hpp"
+#include "OcclusionBuffer.hpp"
+
+#include <vector>
+
+namespace kepler {
+
+/// Marks a node as an occluder for software occlusion culling.
+/// The occluder mesh is in the local space of the node.
+class Occluder : public Component {
+public:
+    /// Use Occluder::create()
+    explicit Occluder(const shared_ptr<const OccluderMesh>& mesh);
+    virtual ~Occluder() noexcept;
+
+    static shared_ptr<Occluder> create(const shared_ptr<const OccluderMesh>& mesh);
+
+    /// Creates an occluder that is the given box.
+    static shared_ptr<Occluder> createBox(const BoundingBox& box);
+
+    const shared_ptr<const OccluderMesh>& mesh() const;
+
+    const std::string& typeName() const override;
+
+    /// Appends every occluder in the scene, placed with the world matrix of its node.
+    static void gather(const Scene& scene, std::vector<OccluderInstance>& occluders);
+
+public:
+    Occluder(const Occluder&) = delete;
+    Occluder& operator=(const Occluder&) = delete;
+
+private:
+    shared_ptr<const OccluderMesh> _mesh;
+};
+}
@@ -0,0 +1,370 @@
+#include "stdafx.h"
+#include "OcclusionBuffer.hpp"
+
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define KEPLER_OCCLUSION_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(KEPLER_OCCLUSION_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+// MSVC allows AVX2 intrinsics without /arch:AVX2. The AVX2 functions are only called after checking the CPU.
+#define AVX2_TARGET
+#endif
+
+namespace kepler {
+
+static constexpr int TILE_SIZE = OcclusionBuffer::TILE_WIDTH * OcclusionBuffer::TILE_HEIGHT;
+static constexpr float FAR_DEPTH = 1.0f;
+// Vertices closer than this to the eye plane are treated as crossing the near plane.
+static constexpr float MIN_W = 0.00001f;
+// Pixels this close to an edge (in pixels) are inside so that rounding doesn't leave cracks between triangles.
+static constexpr float EDGE_BIAS = 1.0f / 1024.0f;
+
+#ifdef KEPLER_OCCLUSION_AVX2
+/// Rasterizes one triangle into one 8x4 tile. Each row of the tile is one AVX register.
+/// edges holds A, B, C for the three edge functions and plane holds A, B, C for depth.
+AVX2_TARGET static void rasterizeTileAvx2(float* tile, float x, float y, const float* edges, const float* plane) {
+    const __m256 offsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256 xs = _mm256_add_ps(_mm256_set1_ps(x), offsets);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(FAR_DEPTH);
+    __m256 e[3];
+    __m256 stepY[3];
+    for (int i = 0; i < 3; ++i) {
+        const float* edge = edges + i * 3;
+        e[i] = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(edge[0]), xs), _mm256_set1_ps(edge[1] * (y + 0.5f) + edge[2]));
+        stepY[i] = _mm256_set1_ps(edge[1]);
+    }
+    __m256 z = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane[0]), xs), _mm256_set1_ps(plane[1] * (y + 0.5f) + plane[2]));
+    const __m256 zStepY = _mm256_set1_ps(plane[1]);
+
+    for (int row = 0; row < OcclusionBuffer::TILE_HEIGHT; ++row) {
+        __m256 inside = _mm256_and_ps(_mm256_and_ps(
+            _mm256_cmp_ps(e[0], zero, _CMP_GE_OQ),
+            _mm256_cmp_ps(e[1], zero, _CMP_GE_OQ)),
+            _mm256_cmp_ps(e[2], zero, _CMP_GE_OQ));
+        if (_mm256_movemask_ps(inside) != 0) {
+            float* dst = tile + row * OcclusionBuffer::TILE_WIDTH;
+            __m256 depth = _mm256_loadu_ps(dst);
+            __m256 clamped = _mm256_min_ps(_mm256_max_ps(z, zero), one);
+            __m256 closer = _mm256_min_ps(depth, clamped);
+            _mm256_storeu_ps(dst, _mm256_blendv_ps(depth, closer, inside));
+        }
+        for (int i = 0; i < 3; ++i) {
+            e[i] = _mm256_add_ps(e[i], stepY[i]);
+        }
+        z = _mm256_add_ps(z, zStepY);
+    }
+}
+
+AVX2_TARGET static float tileMaxAvx2(const float* tile) {
+    __m256 m = _mm256_max_ps(
+        _mm256_max_ps(_mm256_loadu_ps(tile), _mm256_loadu_ps(tile + 8)),
+        _mm256_max_ps(_mm256_loadu_ps(tile + 16), _mm256_loadu_ps(tile + 24)));
+    __m128 h = _mm_max_ps(_mm256_castps256_ps128(m), _mm256_extractf128_ps(m, 1));
+    h = _mm_max_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_max_ss(h, _mm_shuffle_ps(h, h, 1));
+    return _mm_cvtss_f32(h);
+}
+#endif
+
+static float tileMaxScalar(const float* tile) {
+    float m = tile[0];
+    for (int i = 1; i < TILE_SIZE; ++i) {
+        m = std::max(m, tile[i]);
+    }
+    return m;
+}
+
+static int roundUp(int value, int multiple) {
+    return ((std::max(value, 1) + multiple - 1) / multiple) * multiple;
+}
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+    : _width(roundUp(width, TILE_WIDTH)), _height(roundUp(height, TILE_HEIGHT)), _simd(simdSupported()) {
+    _tilesX = _width / TILE_WIDTH;
+    _tilesY = _height / TILE_HEIGHT;
+    _depth.assign(static_cast<size_t>(_width) * _height, FAR_DEPTH);
+    _tileMax.assign(static_cast<size_t>(_tilesX) * _tilesY, FAR_DEPTH);
+}
+
+OcclusionBuffer::~OcclusionBuffer() noexcept {
+    wait();
+}
+
+shared_ptr<OcclusionBuffer> OcclusionBuffer::create(int width, int height) {
+    return std::make_shared<OcclusionBuffer>(width, height);
+}
+
+int OcclusionBuffer::width() const {
+    return _width;
+}
+
+int OcclusionBuffer::height() const {
+    return _height;
+}
+
+void OcclusionBuffer::clear(const mat4& viewProjection) {
+    _viewProjection = viewProjection;
+    std::fill(_depth.begin(), _depth.end(), FAR_DEPTH);
+    std::fill(_tileMax.begin(), _tileMax.end(), FAR_DEPTH);
+}
+
+void OcclusionBuffer::addOccluder(const OccluderMesh& mesh, const mat4& world) {
+    const mat4 mvp = _viewProjection * world;
+    _clip.resize(mesh.positions.size());
+    for (size_t i = 0; i < mesh.positions.size(); ++i) {
+        _clip[i] = mvp * vec4(mesh.positions[i], 1.0f);
+    }
+    const float halfWidth = static_cast<float>(_width) * 0.5f;
+    const float halfHeight = static_cast<float>(_height) * 0.5f;
+    const size_t vertexCount = _clip.size();
+    const size_t count = mesh.indices.size() - mesh.indices.size() % 3;
+    ScreenVertex v[3];
+    for (size_t i = 0; i < count; i += 3) {
+        bool valid = true;
+        for (int k = 0; k < 3; ++k) {
+            uint32_t index = mesh.indices[i + k];
+            if (index >= vertexCount || _clip[index].w < MIN_W) {
+                // Skipping triangles that cross the near plane only makes the occluder smaller.
+                valid = false;
+                break;
+            }
+            const vec4& c = _clip[index];
+            float invW = 1.0f / c.w;
+            v[k].x = (c.x * invW + 1.0f) * halfWidth;
+            v[k].y = (c.y * invW + 1.0f) * halfHeight;
+            v[k].z = c.z * invW * 0.5f + 0.5f;
+        }
+        if (valid) {
+            rasterizeTriangle(v[0], v[1], v[2]);
+        }
+    }
+}
+
+void OcclusionBuffer::finish() {
+    const size_t tileCount = _tileMax.size();
+    for (size_t i = 0; i < tileCount; ++i) {
+        const float* tile = _depth.data() + i * TILE_SIZE;
+#ifdef KEPLER_OCCLUSION_AVX2
+        _tileMax[i] = _simd ? tileMaxAvx2(tile) : tileMaxScalar(tile);
+#else
+        _tileMax[i] = tileMaxScalar(tile);
+#endif
+    }
+}
+
+void OcclusionBuffer::renderAsync(const mat4& viewProjection, std::vector<OccluderInstance> occluders) {
+    wait();
+    _pending = std::async(std::launch::async, [this, viewProjection, occluders = std::move(occluders)]() {
+        clear(viewProjection);
+        for (const auto& occluder : occluders) {
+            if (occluder.mesh) {
+                addOccluder(*occluder.mesh, occluder.world);
+            }
+        }
+        finish();
+    });
+}
+
+void OcclusionBuffer::wait() {
+    if (_pending.valid()) {
+        _pending.get();
+    }
+}
+
+bool OcclusionBuffer::isVisible(const BoundingBox& box) const {
+    vec3 corners[8];
+    box.corners(corners);
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxX = -std::numeric_limits<float>::max();
+    float maxY = -std::numeric_limits<float>::max();
+    float nearZ = FAR_DEPTH;
+    int behind = 0;
+    for (const auto& corner : corners) {
+        vec4 c = _viewProjection * vec4(corner, 1.0f);
+        if (c.w < MIN_W) {
+            ++behind;
+            continue;
+        }
+        float invW = 1.0f / c.w;
+        float x = (c.x * invW + 1.0f) * 0.5f * static_cast<float>(_width);
+        float y = (c.y * invW + 1.0f) * 0.5f * static_cast<float>(_height);
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearZ = std::min(nearZ, c.z * invW * 0.5f + 0.5f);
+    }
+    if (behind > 0) {
+        // Entirely behind the camera or crossing the near plane where it can't be hidden.
+        return behind < 8;
+    }
+    if (nearZ >= FAR_DEPTH) {
+        return false;
+    }
+    nearZ = std::max(nearZ, 0.0f);
+
+    int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+    int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+    int x1 = std::min(_width - 1, static_cast<int>(std::ceil(maxX)) - 1);
+    int y1 = std::min(_height - 1, static_cast<int>(std::ceil(maxY)) - 1);
+    x1 = std::max(x1, std::min(x0, _width - 1));
+    y1 = std::max(y1, std::min(y0, _height - 1));
+    if (x0 >= _width || y0 >= _height || maxX < 0.0f || maxY < 0.0f) {
+        return false;
+    }
+
+    for (int ty = y0 / TILE_HEIGHT; ty <= y1 / TILE_HEIGHT; ++ty) {
+        for (int tx = x0 / TILE_WIDTH; tx <= x1 / TILE_WIDTH; ++tx) {
+            const size_t tile = static_cast<size_t>(ty) * _tilesX + tx;
+            if (_tileMax[tile] <= nearZ) {
+                // every pixel in this tile is in front of the box
+                continue;
+            }
+            const float* depth = _depth.data() + tile * TILE_SIZE;
+            int px0 = std::max(x0, tx * TILE_WIDTH);
+            int px1 = std::min(x1, tx * TILE_WIDTH + TILE_WIDTH - 1);
+            int py0 = std::max(y0, ty * TILE_HEIGHT);
+            int py1 = std::min(y1, ty * TILE_HEIGHT + TILE_HEIGHT - 1);
+            for (int y = py0; y <= py1; ++y) {
+                const float* row = depth + (y - ty * TILE_HEIGHT) * TILE_WIDTH - tx * TILE_WIDTH;
+                for (int x = px0; x <= px1; ++x) {
+                    if (row[x] > nearZ) {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+float OcclusionBuffer::depth(int x, int y) const {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) {
+        return FAR_DEPTH;
+    }
+    return _depth[tileIndex(x / TILE_WIDTH, y / TILE_HEIGHT) + (y % TILE_HEIGHT) * TILE_WIDTH + (x % TILE_WIDTH)];
+}
+
+void OcclusionBuffer::setSimdEnabled(bool enabled) {
+    _simd = enabled && simdSupported();
+}
+
+bool OcclusionBuffer::simdSupported() {
+#if defined(KEPLER_OCCLUSION_AVX2) && defined(_MSC_VER)
+    static const bool supported = []() {
+        int info[4];
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+    return supported;
+#elif defined(KEPLER_OCCLUSION_AVX2)
+    static const bool supported = __builtin_cpu_supports("avx2") != 0;
+    return supported;
+#else
+    return false;
+#endif
+}
+
+void OcclusionBuffer::rasterizeTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c) {
+    const ScreenVertex* v0 = &a;
+    const ScreenVertex* v1 = &b;
+    const ScreenVertex* v2 = &c;
+    float area = (v1->x - v0->x) * (v2->y - v0->y) - (v1->y - v0->y) * (v2->x - v0->x);
+    if (area == 0.0f) {
+        return;
+    }
+    if (area < 0.0f) {
+        // Occluders are rendered double sided so flip the winding instead of culling.
+        std::swap(v1, v2);
+        area = -area;
+    }
+
+    float minX = std::min({v0->x, v1->x, v2->x});
+    float maxX = std::max({v0->x, v1->x, v2->x});
+    float minY = std::min({v0->y, v1->y, v2->y});
+    float maxY = std::max({v0->y, v1->y, v2->y});
+    if (maxX < 0.0f || maxY < 0.0f || minX >= _width || minY >= _height) {
+        return;
+    }
+    if (std::min({v0->z, v1->z, v2->z}) >= FAR_DEPTH) {
+        return;
+    }
+
+    // Edge function E(x, y) = A * x + B * y + C for edges v1v2, v2v0 and v0v1.
+    // E is positive inside the triangle and edge i is the barycentric weight of vertex i times the area.
+    const ScreenVertex* p[3] = {v0, v1, v2};
+    float edges[9];
+    for (int i = 0; i < 3; ++i) {
+        const ScreenVertex& s = *p[(i + 1) % 3];
+        const ScreenVertex& e = *p[(i + 2) % 3];
+        edges[i * 3 + 0] = -(e.y - s.y);
+        edges[i * 3 + 1] = e.x - s.x;
+        edges[i * 3 + 2] = (e.y - s.y) * s.x - (e.x - s.x) * s.y;
+    }
+    // Depth plane z(x, y) = A * x + B * y + C from the barycentric weights.
+    const float invArea = 1.0f / area;
+    float plane[3];
+    for (int j = 0; j < 3; ++j) {
+        plane[j] = (edges[j] * v0->z + edges[3 + j] * v1->z + edges[6 + j] * v2->z) * invArea;
+    }
+    for (int i = 0; i < 3; ++i) {
+        edges[i * 3 + 2] += EDGE_BIAS * std::sqrt(edges[i * 3] * edges[i * 3] + edges[i * 3 + 1] * edges[i * 3 + 1]);
+    }
+
+    int tileX0 = std::max(0, static_cast<int>(minX)) / TILE_WIDTH;
+    int tileY0 = std::max(0, static_cast<int>(minY)) / TILE_HEIGHT;
+    int tileX1 = std::min(_width - 1, static_cast<int>(maxX)) / TILE_WIDTH;
+    int tileY1 = std::min(_height - 1, static_cast<int>(maxY)) / TILE_HEIGHT;
+    for (int ty = tileY0; ty <= tileY1; ++ty) {
+        for (int tx = tileX0; tx <= tileX1; ++tx) {
+#ifdef KEPLER_OCCLUSION_AVX2
+            if (_simd) {
+                rasterizeTileAvx2(_depth.data() + tileIndex(tx, ty),
+                    static_cast<float>(tx * TILE_WIDTH), static_cast<float>(ty * TILE_HEIGHT), edges, plane);
+                continue;
+            }
+#endif
+            rasterizeTileScalar(tx, ty, edges, plane);
+        }
+    }
+}
+
+void OcclusionBuffer::rasterizeTileScalar(int tileX, int tileY, const float* edges, const float* plane) {
+    float* tile = _depth.data() + tileIndex(tileX, tileY);
+    for (int row = 0; row < TILE_HEIGHT; ++row) {
+        const float y = static_cast<float>(tileY * TILE_HEIGHT + row) + 0.5f;
+        for (int col = 0; col < TILE_WIDTH; ++col) {
+            const float x = static_cast<float>(tileX * TILE_WIDTH + col) + 0.5f;
+            if (edges[0] * x + edges[1] * y + edges[2] >= 0.0f
+                && edges[3] * x + edges[4] * y + edges[5] >= 0.0f
+                && edges[6] * x + edges[7] * y + edges[8] >= 0.0f) {
+                float z = std::min(std::max(plane[0] * x + plane[1] * y + plane[2], 0.0f), FAR_DEPTH);
+                float& d = tile[row * TILE_WIDTH + col];
+                d = std::min(d, z);
+            }
+        }
+    }
+}
+
+size_t OcclusionBuffer::tileIndex(int tileX, int tileY) const {
+    return (static_cast<size_t>(tileY) * _tilesX + tileX) * TILE_SIZE;
+}
+
+} // namespace kepler
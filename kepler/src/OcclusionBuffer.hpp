@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Base.hpp"
+#include "BaseMath.hpp"
+#include "BoundingBox.hpp"
+
+#include <vector>
+#include <future>
+#include <cstdint>
+
+namespace kepler {
+
+/// Triangle mesh used to fill an OcclusionBuffer.
+/// Occluders should be simple, closed, and fully inside the rendered geometry they represent.
+struct OccluderMesh {
+    std::vector<vec3> positions;
+    std::vector<uint32_t> indices;
+};
+
+/// An occluder mesh placed in the world.
+struct OccluderInstance {
+    shared_ptr<const OccluderMesh> mesh;
+    mat4 world;
+};
+
+/// OcclusionBuffer is a CPU software occlusion culler.
+///
+/// Occluder triangles are rasterized into a low resolution depth buffer and
+/// bounding boxes are tested against it. Nothing in this class touches the GPU
+/// so visibility is known without any readback latency and it works headless.
+///
+/// The depth buffer is stored as 8x4 pixel tiles. Each tile also keeps its farthest depth
+/// which is used to reject most occludees without looking at individual pixels.
+/// Rasterization uses AVX2 when the CPU supports it and a scalar loop otherwise.
+class OcclusionBuffer {
+public:
+    static constexpr int TILE_WIDTH = 8;
+    static constexpr int TILE_HEIGHT = 4;
+
+    /// Creates a buffer with the given resolution.
+    /// The width is rounded up to a multiple of 8 and the height to a multiple of 4.
+    OcclusionBuffer(int width, int height);
+    virtual ~OcclusionBuffer() noexcept;
+    OcclusionBuffer(const OcclusionBuffer&) = delete;
+    OcclusionBuffer& operator=(const OcclusionBuffer&) = delete;
+
+    static shared_ptr<OcclusionBuffer> create(int width = 256, int height = 128);
+
+    int width() const;
+    int height() const;
+
+    /// Clears the depth buffer to the far plane and sets the view projection matrix used
+    /// to rasterize occluders and test occludees.
+    void clear(const mat4& viewProjection);
+
+    /// Rasterizes the occluder into the depth buffer.
+    void addOccluder(const OccluderMesh& mesh, const mat4& world);
+
+    /// Updates the per tile depth after all of the occluders have been added.
+    void finish();
+
+    /// Clears, rasterizes all of the occluders and calls finish() on a worker thread.
+    /// This is meant to run in parallel with the scene update.
+    /// Call wait() before testing occludees.
+    void renderAsync(const mat4& viewProjection, std::vector<OccluderInstance> occluders);
+
+    /// Waits for renderAsync() to complete. Does nothing if nothing is running.
+    void wait();
+
+    /// Returns true if some part of the world space box may be visible.
+    /// Returns false if the box is completely hidden behind occluders or is outside of the view.
+    bool isVisible(const BoundingBox& box) const;
+
+    /// Returns the depth at the given pixel. 0 is the near plane and 1 is the far plane.
+    float depth(int x, int y) const;
+
+    /// Enables or disables the AVX2 rasterizer. It is only used if the CPU supports it.
+    void setSimdEnabled(bool enabled);
+
+    /// Returns true if the CPU supports the AVX2 rasterizer.
+    static bool simdSupported();
+
+private:
+    struct ScreenVertex {
+        float x;
+        float y;
+        float z;
+    };
+
+    void rasterizeTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2);
+    void rasterizeTileScalar(int tileX, int tileY, const float* edges, const float* plane);
+    size_t tileIndex(int tileX, int tileY) const;
+
+private:
+    int _width;
+    int _height;
+    int _tilesX;
+    int _tilesY;
+    mat4 _viewProjection;
+    std::vector<float> _depth;
+    std::vector<float> _tileMax;
+    std::vector<vec4> _clip;
+    std::future<void> _pending;
+    bool _simd;
+};
+
+} // namespace kepler
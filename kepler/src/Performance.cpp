@@ -1,10 +1,105 @@
 #include "stdafx.h"
 #include "Performance.hpp"
 
+#include <array>
+#include <iomanip>
+
 namespace kepler {
 
 constexpr size_t SIZE = 10;
 
 std::vector<std::chrono::nanoseconds> ProfileBlock::s_totals(SIZE);
 std::vector<size_t> ProfileBlock::s_counts(SIZE);
+
+namespace {
+
+std::array<FrameProfiler::Frame, FrameProfiler::HISTORY> __frames;
+uint64_t __frameNumber = 0;
+
+FrameProfiler::Scope& findScope(FrameProfiler::Frame& frame, const char* name) {
+    for (auto& scope : frame.scopes) {
+        if (scope.name == name) {
+            return scope;
+        }
+    }
+    frame.scopes.emplace_back();
+    frame.scopes.back().name = name;
+    return frame.scopes.back();
+}
+
+} // anonymous namespace
+
+void FrameProfiler::beginFrame() {
+    ++__frameNumber;
+    auto& frame = __frames[__frameNumber % HISTORY];
+    frame.number = __frameNumber;
+    frame.scopes.clear();
+}
+
+uint64_t FrameProfiler::frameNumber() {
+    return __frameNumber;
+}
+
+void FrameProfiler::addCpuTime(const char* name, double ms) {
+    auto& frame = __frames[__frameNumber % HISTORY];
+    if (frame.number != __frameNumber || __frameNumber == 0) {
+        return;
+    }
+    auto& scope = findScope(frame, name);
+    scope.cpuMs += ms;
+    ++scope.cpuCount;
+}
+
+void FrameProfiler::addGpuTime(uint64_t frameNumber, const char* name, double ms) {
+    if (frameNumber == 0 || frameNumber > __frameNumber || __frameNumber - frameNumber >= HISTORY) {
+        return;
+    }
+    auto& frame = __frames[frameNumber % HISTORY];
+    if (frame.number != frameNumber) {
+        return;
+    }
+    auto& scope = findScope(frame, name);
+    scope.gpuMs += ms;
+    ++scope.gpuCount;
+}
+
+FrameProfiler::Frame FrameProfiler::frame(size_t framesAgo) {
+    if (framesAgo >= HISTORY || framesAgo >= __frameNumber) {
+        return Frame();
+    }
+    const uint64_t number = __frameNumber - framesAgo;
+    const auto& frame = __frames[number % HISTORY];
+    return frame.number == number ? frame : Frame();
+}
+
+void FrameProfiler::print(size_t framesAgo, std::ostream& out) {
+    Frame f = frame(framesAgo);
+    if (f.number == 0) {
+        return;
+    }
+    out << "frame " << f.number << std::endl;
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    for (const auto& scope : f.scopes) {
+        out << "    " << std::left << std::setw(16) << scope.name << std::right;
+        if (scope.cpuCount > 0) {
+            out << " cpu " << std::setw(8) << scope.cpuMs << " ms";
+        }
+        else {
+            out << "                ";
+        }
+        if (scope.gpuCount > 0) {
+            out << " gpu " << std::setw(8) << scope.gpuMs << " ms";
+        }
+        out << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void FrameProfiler::clear() {
+    __frames = {};
+    __frameNumber = 0;
+}
 }
@@ -4,6 +4,7 @@
 
 #include <chrono>
 #include <vector>
+#include <string>
 #include <iostream>
 
 namespace kepler {
@@ -38,4 +39,72 @@ private:
     TimePoint _t1;
     TimePoint _t2;
 };
+
+/// FrameProfiler collects the CPU and GPU time of named scopes for each of the last few frames.
+///
+/// CPU times are added by ProfileScope during the frame. GPU times are added by gl::GpuTimer or the Vulkan state
+/// once the GPU has finished the frame, which is usually a few frames later, so the history keeps the frames around
+/// until their GPU results arrive. Only use from the main thread.
+class FrameProfiler final {
+public:
+    /// The number of frames that are kept.
+    static constexpr size_t HISTORY = 8;
+
+    struct Scope {
+        std::string name;
+        double cpuMs = 0.0;
+        double gpuMs = 0.0;
+        /// The number of times the scope was timed during the frame.
+        size_t cpuCount = 0;
+        size_t gpuCount = 0;
+    };
+
+    struct Frame {
+        /// Zero if the frame isn't in the history.
+        uint64_t number = 0;
+        std::vector<Scope> scopes;
+    };
+
+    FrameProfiler() = delete;
+
+    /// Starts a new frame. Called by the App at the start of every frame.
+    static void beginFrame();
+
+    /// Returns the number of the current frame. The first frame is 1.
+    static uint64_t frameNumber();
+
+    /// Adds CPU time to a scope of the current frame.
+    static void addCpuTime(const char* name, double ms);
+
+    /// Adds GPU time to a scope of an earlier frame. Ignored if the frame is no longer in the history.
+    static void addGpuTime(uint64_t frame, const char* name, double ms);
+
+    /// Returns a frame from the history. 0 is the current frame.
+    /// GPU times are usually complete for frames that are 3 or more frames ago.
+    static Frame frame(size_t framesAgo);
+
+    /// Prints the CPU and GPU time of each scope of a frame side by side.
+    static void print(size_t framesAgo, std::ostream& out = std::clog);
+
+    /// Clears the history.
+    static void clear();
+};
+
+/// Adds the CPU time between construction and destruction to the named scope of the current frame.
+class ProfileScope final {
+public:
+    /// The name must stay valid until the scope is destroyed.
+    explicit ProfileScope(const char* name) : _name(name), _start(std::chrono::high_resolution_clock::now()) {
+    }
+    ~ProfileScope() {
+        std::chrono::duration<double, std::milli> ms = std::chrono::high_resolution_clock::now() - _start;
+        FrameProfiler::addCpuTime(_name, ms.count());
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* _name;
+    TimePoint _start;
+};
 }
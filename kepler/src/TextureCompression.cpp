@@ -0,0 +1,397 @@
+#include "stdafx.h"
+#include "TextureCompression.hpp"
+#include "BaseMath.hpp"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <cstring>
+
+namespace kepler {
+
+// Below this many blocks the work is too small to be worth starting threads.
+static constexpr size_t MIN_BLOCKS_PER_THREAD = 256;
+
+static uint16_t toRgb565(const vec3& color) {
+    auto quantize = [](float value, float max) {
+        return static_cast<uint32_t>(std::min(std::max(value, 0.0f), 255.0f) * (max / 255.0f) + 0.5f);
+    };
+    const uint32_t r = quantize(color.x, 31.0f);
+    const uint32_t g = quantize(color.y, 63.0f);
+    const uint32_t b = quantize(color.z, 31.0f);
+    return static_cast<uint16_t>(r << 11 | g << 5 | b);
+}
+
+static vec3 fromRgb565(uint16_t color) {
+    const uint32_t r = color >> 11 & 31;
+    const uint32_t g = color >> 5 & 63;
+    const uint32_t b = color & 31;
+    return vec3(static_cast<float>(r << 3 | r >> 2), static_cast<float>(g << 2 | g >> 4), static_cast<float>(b << 3 | b >> 2));
+}
+
+static float distance2(const vec3& a, const vec3& b) {
+    const vec3 d = a - b;
+    return glm::dot(d, d);
+}
+
+/// Picks the nearest of the 4 colors for each pixel. Returns the total squared error.
+static float assignIndices(const vec3* colors, uint16_t c0, uint16_t c1, uint32_t& indices) {
+    const vec3 p0 = fromRgb565(c0);
+    const vec3 p1 = fromRgb565(c1);
+    const vec3 palette[4] = {p0, p1, (p0 * 2.0f + p1) / 3.0f, (p0 + p1 * 2.0f) / 3.0f};
+    float error = 0.0f;
+    indices = 0;
+    for (int i = 0; i < 16; ++i) {
+        uint32_t best = 0;
+        float bestDistance = distance2(colors[i], palette[0]);
+        for (uint32_t j = 1; j < 4; ++j) {
+            float d = distance2(colors[i], palette[j]);
+            if (d < bestDistance) {
+                bestDistance = d;
+                best = j;
+            }
+        }
+        indices |= best << (i * 2);
+        error += bestDistance;
+    }
+    return error;
+}
+
+/// Solves for the endpoints that best fit the colors with the given indices.
+/// Returns false if every pixel uses the same weight.
+static bool fitEndpoints(const vec3* colors, uint32_t indices, vec3& e0, vec3& e1) {
+    static constexpr float WEIGHTS[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    vec3 ax(0.0f), bx(0.0f);
+    for (int i = 0; i < 16; ++i) {
+        const float a = WEIGHTS[indices >> (i * 2) & 3];
+        const float b = 1.0f - a;
+        aa += a * a;
+        bb += b * b;
+        ab += a * b;
+        ax += colors[i] * a;
+        bx += colors[i] * b;
+    }
+    const float det = aa * bb - ab * ab;
+    if (std::abs(det) < 1e-6f) {
+        return false;
+    }
+    e0 = (ax * bb - bx * ab) / det;
+    e1 = (bx * aa - ax * ab) / det;
+    return true;
+}
+
+/// Compresses the colors of a block. The 4 color mode is always used.
+static void compressColorBlock(const uint8_t* pixels, uint8_t* block) {
+    vec3 colors[16];
+    vec3 mean(0.0f);
+    for (int i = 0; i < 16; ++i) {
+        colors[i] = vec3(pixels[i * 4], pixels[i * 4 + 1], pixels[i * 4 + 2]);
+        mean += colors[i];
+    }
+    mean /= 16.0f;
+
+    // The principal axis of the colors from a few power iterations of the covariance matrix.
+    float xx = 0.0f, xy = 0.0f, xz = 0.0f, yy = 0.0f, yz = 0.0f, zz = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        const vec3 d = colors[i] - mean;
+        xx += d.x * d.x;
+        xy += d.x * d.y;
+        xz += d.x * d.z;
+        yy += d.y * d.y;
+        yz += d.y * d.z;
+        zz += d.z * d.z;
+    }
+    // Start from the row of the channel with the most variance so the first iteration can't cancel out.
+    vec3 axis = xx >= yy && xx >= zz ? vec3(xx, xy, xz) : yy >= zz ? vec3(xy, yy, yz) : vec3(xz, yz, zz);
+    const float axisLength = glm::length(axis);
+    axis = axisLength > 1e-6f ? axis / axisLength : vec3(0.57735f);
+    for (int i = 0; i < 4; ++i) {
+        const vec3 next(xx * axis.x + xy * axis.y + xz * axis.z,
+            xy * axis.x + yy * axis.y + yz * axis.z,
+            xz * axis.x + yz * axis.y + zz * axis.z);
+        const float length = glm::length(next);
+        if (length < 1e-6f) {
+            break;
+        }
+        axis = next / length;
+    }
+    float minT = 0.0f;
+    float maxT = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        const float t = glm::dot(colors[i] - mean, axis);
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    uint16_t c0 = toRgb565(mean + axis * maxT);
+    uint16_t c1 = toRgb565(mean + axis * minT);
+    uint32_t indices;
+    float error = assignIndices(colors, c0, c1, indices);
+
+    // One least squares refinement of the endpoints. Keep it only if it helps.
+    vec3 e0, e1;
+    if (error > 0.0f && fitEndpoints(colors, indices, e0, e1)) {
+        const uint16_t r0 = toRgb565(e0);
+        const uint16_t r1 = toRgb565(e1);
+        uint32_t refined;
+        const float refinedError = assignIndices(colors, r0, r1, refined);
+        if (refinedError < error) {
+            c0 = r0;
+            c1 = r1;
+            indices = refined;
+        }
+    }
+
+    if (c0 < c1) {
+        // c0 > c1 selects the 4 color mode. Swapping the endpoints swaps index 0 with 1 and 2 with 3.
+        std::swap(c0, c1);
+        indices ^= 0x55555555;
+    }
+    else if (c0 == c1) {
+        indices = 0;
+    }
+    block[0] = static_cast<uint8_t>(c0);
+    block[1] = static_cast<uint8_t>(c0 >> 8);
+    block[2] = static_cast<uint8_t>(c1);
+    block[3] = static_cast<uint8_t>(c1 >> 8);
+    for (int i = 0; i < 4; ++i) {
+        block[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+}
+
+static void compressAlphaBlock(const uint8_t* pixels, uint8_t* block) {
+    uint8_t minAlpha = 255;
+    uint8_t maxAlpha = 0;
+    for (int i = 0; i < 16; ++i) {
+        minAlpha = std::min(minAlpha, pixels[i * 4 + 3]);
+        maxAlpha = std::max(maxAlpha, pixels[i * 4 + 3]);
+    }
+    block[0] = maxAlpha;
+    block[1] = minAlpha;
+    uint64_t indices = 0;
+    if (maxAlpha > minAlpha) {
+        // 8 value mode: index 0 is the max, 1 is the min and 2 to 7 are evenly spaced from max to min.
+        uint8_t palette[8] = {maxAlpha, minAlpha};
+        for (int i = 1; i < 7; ++i) {
+            palette[i + 1] = static_cast<uint8_t>(((7 - i) * maxAlpha + i * minAlpha + 3) / 7);
+        }
+        for (int i = 0; i < 16; ++i) {
+            const int alpha = pixels[i * 4 + 3];
+            uint64_t best = 0;
+            int bestDistance = 256;
+            for (int j = 0; j < 8; ++j) {
+                const int d = std::abs(alpha - palette[j]);
+                if (d < bestDistance) {
+                    bestDistance = d;
+                    best = static_cast<uint64_t>(j);
+                }
+            }
+            indices |= best << (i * 3);
+        }
+    }
+    for (int i = 0; i < 6; ++i) {
+        block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+}
+
+void compressBC1Block(const uint8_t* pixels, uint8_t* block) {
+    compressColorBlock(pixels, block);
+}
+
+void compressBC3Block(const uint8_t* pixels, uint8_t* block) {
+    compressAlphaBlock(pixels, block);
+    compressColorBlock(pixels, block + 8);
+}
+
+void decompressBC1Block(const uint8_t* block, uint8_t* pixels) {
+    const uint16_t c0 = static_cast<uint16_t>(block[0] | block[1] << 8);
+    const uint16_t c1 = static_cast<uint16_t>(block[2] | block[3] << 8);
+    const vec3 p0 = fromRgb565(c0);
+    const vec3 p1 = fromRgb565(c1);
+    vec4 palette[4] = {vec4(p0, 255.0f), vec4(p1, 255.0f)};
+    if (c0 > c1) {
+        palette[2] = vec4((p0 * 2.0f + p1) / 3.0f, 255.0f);
+        palette[3] = vec4((p0 + p1 * 2.0f) / 3.0f, 255.0f);
+    }
+    else {
+        palette[2] = vec4((p0 + p1) * 0.5f, 255.0f);
+        palette[3] = vec4(0.0f);
+    }
+    const uint32_t indices = block[4] | block[5] << 8 | block[6] << 16 | static_cast<uint32_t>(block[7]) << 24;
+    for (int i = 0; i < 16; ++i) {
+        const vec4& c = palette[indices >> (i * 2) & 3];
+        for (int k = 0; k < 4; ++k) {
+            pixels[i * 4 + k] = static_cast<uint8_t>(c[k] + 0.5f);
+        }
+    }
+}
+
+void decompressBC3Block(const uint8_t* block, uint8_t* pixels) {
+    // The color block of BC3 always uses the 4 color mode.
+    uint8_t color[8];
+    memcpy(color, block + 8, sizeof(color));
+    const uint16_t c0 = static_cast<uint16_t>(color[0] | color[1] << 8);
+    const uint16_t c1 = static_cast<uint16_t>(color[2] | color[3] << 8);
+    if (c0 <= c1) {
+        // Swap so the BC1 decoder uses the 4 color mode.
+        std::swap(color[0], color[2]);
+        std::swap(color[1], color[3]);
+        for (int i = 4; i < 8; ++i) {
+            color[i] ^= 0x55;
+        }
+    }
+    decompressBC1Block(color, pixels);
+
+    const int a0 = block[0];
+    const int a1 = block[1];
+    int palette[8] = {a0, a1};
+    if (a0 > a1) {
+        for (int i = 1; i < 7; ++i) {
+            palette[i + 1] = ((7 - i) * a0 + i * a1 + 3) / 7;
+        }
+    }
+    else {
+        for (int i = 1; i < 5; ++i) {
+            palette[i + 1] = ((5 - i) * a0 + i * a1 + 2) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i) {
+        indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+    }
+    for (int i = 0; i < 16; ++i) {
+        pixels[i * 4 + 3] = static_cast<uint8_t>(palette[indices >> (i * 3) & 7]);
+    }
+}
+
+/// Compresses the block rows [firstRow, lastRow).
+static void compressRows(const uint8_t* pixels, uint32_t width, uint32_t height, bool bc3,
+    uint32_t firstRow, uint32_t lastRow, uint8_t* destination) {
+    const uint32_t blocksX = (width + 3) / 4;
+    const size_t blockSize = bc3 ? 16 : 8;
+    uint8_t block[64];
+    for (uint32_t by = firstRow; by < lastRow; ++by) {
+        for (uint32_t bx = 0; bx < blocksX; ++bx) {
+            for (uint32_t y = 0; y < 4; ++y) {
+                const uint32_t py = std::min(by * 4 + y, height - 1);
+                for (uint32_t x = 0; x < 4; ++x) {
+                    const uint32_t px = std::min(bx * 4 + x, width - 1);
+                    memcpy(block + (y * 4 + x) * 4, pixels + (static_cast<size_t>(py) * width + px) * 4, 4);
+                }
+            }
+            uint8_t* out = destination + (static_cast<size_t>(by) * blocksX + bx) * blockSize;
+            if (bc3) {
+                compressBC3Block(block, out);
+            }
+            else {
+                compressBC1Block(block, out);
+            }
+        }
+    }
+}
+
+std::vector<uint8_t> compressImage(const uint8_t* pixels, uint32_t width, uint32_t height, Ktx2Format format,
+    size_t threadCount) {
+    std::vector<uint8_t> result;
+    const bool bc1 = format == Ktx2Format::BC1_RGB_UNORM || format == Ktx2Format::BC1_RGB_SRGB
+        || format == Ktx2Format::BC1_RGBA_UNORM || format == Ktx2Format::BC1_RGBA_SRGB;
+    const bool bc3 = format == Ktx2Format::BC3_UNORM || format == Ktx2Format::BC3_SRGB;
+    if ((!bc1 && !bc3) || width == 0 || height == 0) {
+        return result;
+    }
+    result.resize(ktx2LevelSize(format, width, height));
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+
+    size_t threads = threadCount == 0 ? std::thread::hardware_concurrency() : threadCount;
+    threads = std::min(threads, static_cast<size_t>(blocksX) * blocksY / MIN_BLOCKS_PER_THREAD);
+    threads = std::max<size_t>(1, std::min<size_t>(threads, blocksY));
+    if (threads == 1) {
+        compressRows(pixels, width, height, bc3, 0, blocksY, result.data());
+        return result;
+    }
+    const uint32_t rowsPerThread = static_cast<uint32_t>((blocksY + threads - 1) / threads);
+    std::vector<std::future<void>> workers;
+    workers.reserve(threads - 1);
+    for (uint32_t first = rowsPerThread; first < blocksY; first += rowsPerThread) {
+        workers.push_back(std::async(std::launch::async, compressRows, pixels, width, height, bc3,
+            first, std::min(first + rowsPerThread, blocksY), result.data()));
+    }
+    compressRows(pixels, width, height, bc3, 0, std::min(rowsPerThread, blocksY), result.data());
+    for (auto& worker : workers) {
+        worker.get();
+    }
+    return result;
+}
+
+std::vector<uint8_t> downsampleImage(const uint8_t* pixels, uint32_t width, uint32_t height) {
+    const uint32_t w = std::max(1u, width / 2);
+    const uint32_t h = std::max(1u, height / 2);
+    std::vector<uint8_t> result(static_cast<size_t>(w) * h * 4);
+    for (uint32_t y = 0; y < h; ++y) {
+        const uint32_t y0 = std::min(y * 2, height - 1);
+        const uint32_t y1 = std::min(y * 2 + 1, height - 1);
+        for (uint32_t x = 0; x < w; ++x) {
+            const uint32_t x0 = std::min(x * 2, width - 1);
+            const uint32_t x1 = std::min(x * 2 + 1, width - 1);
+            for (uint32_t k = 0; k < 4; ++k) {
+                const uint32_t sum = pixels[(static_cast<size_t>(y0) * width + x0) * 4 + k]
+                    + pixels[(static_cast<size_t>(y0) * width + x1) * 4 + k]
+                    + pixels[(static_cast<size_t>(y1) * width + x0) * 4 + k]
+                    + pixels[(static_cast<size_t>(y1) * width + x1) * 4 + k];
+                result[(static_cast<size_t>(y) * w + x) * 4 + k] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+    return result;
+}
+
+bool hasAlpha(const uint8_t* pixels, uint32_t width, uint32_t height) {
+    const size_t count = static_cast<size_t>(width) * height;
+    for (size_t i = 0; i < count; ++i) {
+        if (pixels[i * 4 + 3] != 255) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void compressTexture(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, bool mipmaps,
+    size_t threadCount, Ktx2Texture& texture) {
+    const bool alpha = hasAlpha(pixels, width, height);
+    if (alpha) {
+        texture.format = srgb ? Ktx2Format::BC3_SRGB : Ktx2Format::BC3_UNORM;
+    }
+    else {
+        texture.format = srgb ? Ktx2Format::BC1_RGB_SRGB : Ktx2Format::BC1_RGB_UNORM;
+    }
+    texture.width = width;
+    texture.height = height;
+    texture.supercompression = Ktx2Texture::NONE;
+    texture.levels.clear();
+    texture.data.clear();
+
+    std::vector<uint8_t> level;
+    const uint8_t* source = pixels;
+    uint32_t w = width;
+    uint32_t h = height;
+    while (true) {
+        std::vector<uint8_t> blocks = compressImage(source, w, h, texture.format, threadCount);
+        Ktx2Texture::Level info;
+        info.offset = texture.data.size();
+        info.length = blocks.size();
+        texture.levels.push_back(info);
+        texture.data.insert(texture.data.end(), blocks.begin(), blocks.end());
+        if (!mipmaps || (w == 1 && h == 1)) {
+            break;
+        }
+        level = downsampleImage(source, w, h);
+        source = level.data();
+        w = std::max(1u, w / 2);
+        h = std::max(1u, h / 2);
+    }
+}
+
+} // namespace kepler
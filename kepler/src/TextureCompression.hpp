@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Base.hpp"
+#include "Ktx2.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace kepler {
+
+/// Compresses a 4x4 block of RGBA8 pixels to BC1 (DXT1) using the principal axis of the colors.
+/// The 4 color mode is always used so alpha is ignored.
+/// @param[in]  pixels 16 RGBA pixels in rows.
+/// @param[out] block  8 bytes.
+void compressBC1Block(const uint8_t* pixels, uint8_t* block);
+
+/// Compresses a 4x4 block of RGBA8 pixels to BC3 (DXT5). Alpha is stored like BC4.
+/// @param[out] block 16 bytes.
+void compressBC3Block(const uint8_t* pixels, uint8_t* block);
+
+/// Decompresses a BC1 block to 16 RGBA8 pixels.
+void decompressBC1Block(const uint8_t* block, uint8_t* pixels);
+
+/// Decompresses a BC3 block to 16 RGBA8 pixels.
+void decompressBC3Block(const uint8_t* block, uint8_t* pixels);
+
+/// Compresses an RGBA8 image to BC1 or BC3. Pixels past the edge of the image are clamped.
+/// @param[in] pixels      The image, tightly packed rows from the top.
+/// @param[in] format      Any of the BC1 or BC3 formats.
+/// @param[in] threadCount The number of threads to use. Zero uses one per core.
+/// @return The blocks in rows. Empty if the format is not BC1 or BC3.
+std::vector<uint8_t> compressImage(const uint8_t* pixels, uint32_t width, uint32_t height, Ktx2Format format,
+    size_t threadCount = 0);
+
+/// Halves an RGBA8 image with a box filter. Odd sizes are rounded down but never below 1.
+std::vector<uint8_t> downsampleImage(const uint8_t* pixels, uint32_t width, uint32_t height);
+
+/// Returns true if any pixel of the RGBA8 image is not opaque.
+bool hasAlpha(const uint8_t* pixels, uint32_t width, uint32_t height);
+
+/// Builds the mip chain of an RGBA8 image and compresses every level.
+/// BC1 is used for opaque images and BC3 for images with alpha.
+/// @param[in]  pixels      The image, tightly packed rows from the top.
+/// @param[in]  srgb        True if the color channels are sRGB encoded.
+/// @param[in]  mipmaps     True to build the full mip chain; false for only level 0.
+/// @param[in]  threadCount The number of threads to use. Zero uses one per core.
+/// @param[out] texture     The compressed texture that can be written with writeKtx2().
+void compressTexture(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, bool mipmaps,
+    size_t threadCount, Ktx2Texture& texture);
+
+} // namespace kepler
@@ -0,0 +1,157 @@
+#include "stdafx.h"
+#include "VertexQuantization.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace kepler {
+
+static constexpr float UNORM16_MAX = 65535.0f;
+static constexpr float SNORM16_MAX = 32767.0f;
+
+static inline const float* element(const float* data, size_t index, size_t stride) {
+    return reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(data) + index * stride);
+}
+
+static inline uint16_t toUnorm16(float v) {
+    return static_cast<uint16_t>(std::lround(std::min(std::max(v, 0.0f), 1.0f) * UNORM16_MAX));
+}
+
+static inline int16_t toSnorm16(float v) {
+    return static_cast<int16_t>(std::lround(std::min(std::max(v, -1.0f), 1.0f) * SNORM16_MAX));
+}
+
+static inline float fromSnorm16(int16_t v) {
+    // Same as OpenGL's signed normalized conversion.
+    return std::max(static_cast<float>(v) / SNORM16_MAX, -1.0f);
+}
+
+/// Returns the angle between two unit vectors.
+/// atan2 is used because acos loses too much precision for the tiny angles of quantization.
+static inline float angleBetween(const vec3& a, const vec3& b) {
+    return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b));
+}
+
+mat4 positionDequantizationMatrix(const BoundingBox& box) {
+    return glm::translate(box.min) * glm::scale(box.max - box.min);
+}
+
+float quantizePositions(uint16_t* destination, const float* positions, size_t vertexCount, size_t stride, const BoundingBox& box) {
+    if (stride == 0) {
+        stride = sizeof(float) * 3;
+    }
+    const vec3 size = box.max - box.min;
+    float maxError = 0.0f;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const float* p = element(positions, i, stride);
+        uint16_t* q = destination + i * 4;
+        for (int k = 0; k < 3; ++k) {
+            float normalized = size[k] > 0.0f ? (p[k] - box.min[k]) / size[k] : 0.0f;
+            q[k] = toUnorm16(normalized);
+        }
+        q[3] = 0;
+        vec3 restored(box.min.x + q[0] / UNORM16_MAX * size.x,
+            box.min.y + q[1] / UNORM16_MAX * size.y,
+            box.min.z + q[2] / UNORM16_MAX * size.z);
+        maxError = std::max(maxError, glm::distance(restored, vec3(p[0], p[1], p[2])));
+    }
+    return maxError;
+}
+
+vec2 octEncode(const vec3& v) {
+    float l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    if (l1 == 0.0f) {
+        return vec2(0.0f);
+    }
+    vec2 p(v.x / l1, v.y / l1);
+    if (v.z < 0.0f) {
+        // fold the lower hemisphere over the diagonals
+        vec2 folded((1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+            (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+        p = folded;
+    }
+    return p;
+}
+
+vec3 octDecode(const vec2& e) {
+    vec3 v(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+    float t = std::max(-v.z, 0.0f);
+    v.x += v.x >= 0.0f ? -t : t;
+    v.y += v.y >= 0.0f ? -t : t;
+    return glm::normalize(v);
+}
+
+float quantizeNormals(int16_t* destination, const float* normals, size_t vertexCount, size_t stride) {
+    if (stride == 0) {
+        stride = sizeof(float) * 3;
+    }
+    float maxError = 0.0f;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const float* n = element(normals, i, stride);
+        vec3 normal(n[0], n[1], n[2]);
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+            normal /= length;
+        }
+        vec2 e = octEncode(normal);
+        int16_t* q = destination + i * 2;
+        q[0] = toSnorm16(e.x);
+        q[1] = toSnorm16(e.y);
+        if (length > 0.0f) {
+            maxError = std::max(maxError, angleBetween(normal, octDecode(vec2(fromSnorm16(q[0]), fromSnorm16(q[1])))));
+        }
+    }
+    return maxError;
+}
+
+float quantizeTangents(int16_t* destination, const float* tangents, size_t vertexCount, size_t stride) {
+    if (stride == 0) {
+        stride = sizeof(float) * 4;
+    }
+    float maxError = 0.0f;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const float* t = element(tangents, i, stride);
+        vec3 tangent(t[0], t[1], t[2]);
+        float length = glm::length(tangent);
+        if (length > 0.0f) {
+            tangent /= length;
+        }
+        vec2 e = octEncode(tangent);
+        int16_t* q = destination + i * 4;
+        q[0] = toSnorm16(e.x);
+        q[1] = toSnorm16(e.y);
+        q[2] = t[3] < 0.0f ? -32767 : 32767;
+        q[3] = 0;
+        if (length > 0.0f) {
+            maxError = std::max(maxError, angleBetween(tangent, octDecode(vec2(fromSnorm16(q[0]), fromSnorm16(q[1])))));
+        }
+    }
+    return maxError;
+}
+
+bool quantizeTexCoords(uint16_t* destination, const float* texcoords, size_t vertexCount, size_t stride, float* maxError) {
+    if (stride == 0) {
+        stride = sizeof(float) * 2;
+    }
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const float* t = element(texcoords, i, stride);
+        if (t[0] < 0.0f || t[0] > 1.0f || t[1] < 0.0f || t[1] > 1.0f) {
+            return false;
+        }
+    }
+    float error = 0.0f;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const float* t = element(texcoords, i, stride);
+        uint16_t* q = destination + i * 2;
+        for (int k = 0; k < 2; ++k) {
+            q[k] = toUnorm16(t[k]);
+            error = std::max(error, std::abs(q[k] / UNORM16_MAX - t[k]));
+        }
+    }
+    if (maxError) {
+        *maxError = error;
+    }
+    return true;
+}
+
+} // namespace kepler
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Base.hpp"
+#include "BaseMath.hpp"
+#include "BoundingBox.hpp"
+
+#include <cstdint>
+
+namespace kepler {
+
+/// Returns the matrix that transforms positions quantized by quantizePositions() back to the box.
+/// The matrix is meant to be folded into the model matrix so the shader doesn't have to dequantize.
+mat4 positionDequantizationMatrix(const BoundingBox& box);
+
+/// Quantizes positions to 16 bit unsigned normalized integers relative to the box.
+/// 4 components are written per vertex so each vertex stays 4 byte aligned. The 4th component is 0.
+/// @param[out] destination Room for vertexCount * 4 values.
+/// @param[in]  positions   Pointer to the first position (3 floats).
+/// @param[in]  vertexCount The number of vertices.
+/// @param[in]  stride      The number of bytes between positions. Zero means tightly packed.
+/// @param[in]  box         The bounds of the positions.
+/// @return The largest distance between a position and its dequantized position.
+float quantizePositions(uint16_t* destination, const float* positions, size_t vertexCount, size_t stride, const BoundingBox& box);
+
+/// Encodes a unit vector as a point in [-1, 1] using the octahedral mapping.
+vec2 octEncode(const vec3& v);
+
+/// Decodes a vector encoded by octEncode(). The result is normalized.
+vec3 octDecode(const vec2& e);
+
+/// Octahedral encodes unit vectors to 2 16 bit signed normalized integers per vertex.
+/// @param[out] destination Room for vertexCount * 2 values.
+/// @return The largest angle in radians between a vector and its decoded vector.
+float quantizeNormals(int16_t* destination, const float* normals, size_t vertexCount, size_t stride);
+
+/// Quantizes tangents to 4 16 bit signed normalized integers per vertex.
+/// The first 2 are the octahedral encoded direction, the 3rd is the sign of the bitangent (w) and the 4th is 0.
+/// @param[out] destination Room for vertexCount * 4 values.
+/// @param[in]  tangents    Pointer to the first tangent (4 floats).
+/// @return The largest angle in radians between a tangent and its decoded tangent.
+float quantizeTangents(int16_t* destination, const float* tangents, size_t vertexCount, size_t stride);
+
+/// Quantizes texture coordinates to 2 16 bit unsigned normalized integers per vertex.
+/// @param[out] destination Room for vertexCount * 2 values.
+/// @param[out] maxError    The largest difference between a coordinate and its dequantized value. May be null.
+/// @return False if a coordinate is outside of [0, 1] and can't be represented. Nothing is written in that case.
+bool quantizeTexCoords(uint16_t* destination, const float* texcoords, size_t vertexCount, size_t stride, float* maxError = nullptr);
+
+} // namespace kepler
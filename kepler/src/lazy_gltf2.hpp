@@ -11,6 +11,7 @@
 #include <sstream>
 #include <vector>
 #include <array>
+#include <unordered_map>
 #include <memory>
 #include <cstdint>
 #ifndef _WIN32
@@ -20,6 +21,7 @@
 #define LAZY_GLTF2_DATA_APP_BASE64 "data:application/octet-stream;base64,"
 #define LAZY_GLTF2_DATA_IMAGE_JPG "data:image/jpeg;base64,"
 #define LAZY_GLTF2_DATA_IMAGE_PNG "data:image/png;base64,"
+#define LAZY_GLTF2_DATA_IMAGE_KTX2 "data:image/ktx2;base64,"
 #define RAPIDJSON_NO_SIZETYPEDEFINE
 namespace rapidjson { typedef ::std::size_t SizeType; }
 
@@ -64,6 +66,7 @@ struct FileCloser {
     }
 };
 using JsonDocument = ::rapidjson::Document;
+using JsonAllocator = ::rapidjson::Document::AllocatorType;
 using JsonValue = ::rapidjson::Document::GenericValue;
 using unique_file_ptr = ::std::unique_ptr<FILE, FileCloser>;
 
@@ -131,6 +134,15 @@ enum {
 /// Use this class to load a gltf or glb file.
 class Gltf {
 public:
+    /// How the json is parsed.
+    enum class ParseMode {
+        /// Streams the file through a small buffer and copies every string into the document.
+        STREAM,
+        /// Reads the whole json into one buffer that the Gltf keeps and parses it in place so strings aren't copied.
+        /// The document's memory pool is sized from the json length. Faster and smaller for large files.
+        IN_SITU
+    };
+
     Gltf() = default;
     /// Creates a Gltf object and loads a file.
     /// @param path Path to the file to load.
@@ -149,8 +161,9 @@ public:
 
     /// Loads a glTF 2.0 file.
     /// @param[in] path Path to the file to load.
+    /// @param[in] mode How to parse the json.
     /// @return True if json file was loaded successful; false otherwise.
-    bool load(const char* path) noexcept;
+    bool load(const char* path, ParseMode mode = ParseMode::STREAM) noexcept;
 
     /// Returns the base directory of the file that was loaded.
     /// The path will use forward slashes regardless of OS.
@@ -185,79 +198,79 @@ public:
     Scene scene(size_t index) const noexcept;
     /// Returns the number of scenes.
     size_t sceneCount() const noexcept {
-        return count("scenes");
+        return arraySize(SCENES);
     }
     std::vector<Scene> scenes() const noexcept;
 
     Node node(size_t index) const noexcept;
     size_t nodeCount() const noexcept {
-        return count("nodes");
+        return arraySize(NODES);
     }
     std::vector<Node> nodes() const noexcept;
 
     Mesh mesh(size_t index) const noexcept;
     size_t meshCount() const noexcept {
-        return count("meshes");
+        return arraySize(MESHES);
     }
     std::vector<Mesh> meshes() const noexcept;
 
     Camera camera(size_t index) const noexcept;
     size_t cameraCount() const noexcept {
-        return count("cameras");
+        return arraySize(CAMERAS);
     }
     std::vector<Camera> cameras() const noexcept;
 
     Accessor accessor(size_t index) const noexcept;
     size_t accessorCount() const noexcept {
-        return count("accessors");
+        return arraySize(ACCESSORS);
     }
     std::vector<Accessor> accessors() const noexcept;
 
     Buffer buffer(size_t index) const noexcept;
     size_t bufferCount() const noexcept {
-        return count("buffers");
+        return arraySize(BUFFERS);
     }
     std::vector<Buffer> buffers() const noexcept;
 
     BufferView bufferView(size_t index) const noexcept;
     size_t bufferViewCount() const noexcept {
-        return count("bufferViews");
+        return arraySize(BUFFER_VIEWS);
     }
     std::vector<BufferView> bufferViews() const noexcept;
 
     Animation animation(size_t index) const noexcept;
     size_t animationCount() const noexcept {
-        return count("animations");
+        return arraySize(ANIMATIONS);
     }
     std::vector<Animation> animations() const noexcept;
 
     Image image(size_t index) const noexcept;
     size_t imageCount() const noexcept {
-        return count("images");
+        return arraySize(IMAGES);
     }
     std::vector<Image> images() const noexcept;
 
     Texture texture(size_t index) const noexcept;
     size_t textureCount() const noexcept {
-        return count("textures");
+        return arraySize(TEXTURES);
     }
     std::vector<Texture> textures() const noexcept;
 
     Sampler sampler(size_t index) const noexcept;
     size_t samplerCount() const noexcept {
-        return count("samplers");
+        return arraySize(SAMPLERS);
     }
     std::vector<Sampler> samplers() const noexcept;
 
     Material material(size_t index) const noexcept;
     size_t materialCount() const noexcept {
-        return count("materials");
+        return arraySize(MATERIALS);
     }
     std::vector<Material> materials() const noexcept;
 
     Skin skin(size_t index) const noexcept;
     size_t skinCount() const noexcept {
-        return count("skins");
+        return arraySize(SKINS);
     }
     std::vector<Skin> skins() const noexcept;
 
@@ -278,6 +291,18 @@ public:
     template<typename T>
     bool loadGlbData(std::vector<T>& data) const noexcept;
 
+    /// Gets the location of the BIN chunk of a GLB file.
+    /// @return False if the file isn't a GLB or doesn't have a BIN chunk.
+    bool glbLocation(std::string& path, size_t& offset, size_t& length) const noexcept {
+        if (m_glb) {
+            path = m_glb->path;
+            offset = m_glb->offset;
+            length = m_glb->chunkLength;
+            return true;
+        }
+        return false;
+    }
+
     /// Returns a pointer to the json document. May be null.
     const JsonDocument* doc() const noexcept {
         return m_doc.get();
@@ -303,43 +328,128 @@ private:
         GlbData& operator=(const GlbData&) = delete;
     };
 
-    size_t count(const char* key) const noexcept {
-        if (m_doc) {
-            const auto& it = m_doc->FindMember(key);
-            if (it != m_doc->MemberEnd()) {
-                return it->value.Size();
+    /// The top level arrays of objects.
+    enum ArrayType {
+        SCENES,
+        NODES,
+        MESHES,
+        CAMERAS,
+        ACCESSORS,
+        BUFFERS,
+        BUFFER_VIEWS,
+        ANIMATIONS,
+        IMAGES,
+        TEXTURES,
+        SAMPLERS,
+        MATERIALS,
+        SKINS,
+        ARRAY_TYPE_COUNT
+    };
+
+    /// Hashes the null terminated strings that names are indexed by.
+    struct NameHash {
+        size_t operator()(const char* str) const noexcept {
+            // FNV-1a
+            std::uint32_t hash = 2166136261u;
+            for (; *str != '\0'; ++str) {
+                hash = (hash ^ static_cast<unsigned char>(*str)) * 16777619u;
             }
+            return hash;
         }
-        return 0;
+    };
+    struct NameEqual {
+        bool operator()(const char* lhs, const char* rhs) const noexcept {
+            return strcmp(lhs, rhs) == 0;
+        }
+    };
+    /// Maps the names of the objects of an array to their index. The names point into the json document.
+    using NameIndex = std::unordered_map<const char*, size_t, NameHash, NameEqual>;
+
+    size_t arraySize(ArrayType type) const noexcept {
+        const JsonValue* values = m_arrays[type];
+        return values != nullptr ? values->Size() : 0;
     }
 
     template<typename T>
-    T findByName(const char* key, const char* name) {
-        const auto& it = m_doc->FindMember(key);
-        if (name != nullptr && it != m_doc->MemberEnd() && it->value.IsArray()) {
-            const auto size = it->value.Size();
+    T object(ArrayType type, size_t index) const noexcept {
+        const JsonValue* values = m_arrays[type];
+        if (values != nullptr && index < values->Size()) {
+            return T(this, &(*values)[index]);
+        }
+        return T();
+    }
+
+    template<typename T>
+    std::vector<T> objects(ArrayType type) const {
+        std::vector<T> vec;
+        if (const JsonValue* values = m_arrays[type]) {
+            const auto size = values->Size();
+            vec.reserve(size);
             for (size_t i = 0; i < size; ++i) {
-                const auto& v = it->value[i];
+                vec.emplace_back(this, &(*values)[i]);
+            }
+        }
+        return vec;
+    }
+
+    /// Finds an object by name. The name index of the array is built by the first lookup.
+    /// If more than one object has the name then the first is returned.
+    template<typename T>
+    T findByName(ArrayType type, const char* name) {
+        const JsonValue* values = m_arrays[type];
+        if (name == nullptr || values == nullptr) {
+            return T();
+        }
+        auto& index = m_names[type];
+        if (!index) {
+            index.reset(new NameIndex());
+            const auto size = values->Size();
+            index->reserve(size);
+            for (size_t i = 0; i < size; ++i) {
+                const auto& v = (*values)[i];
                 const auto& nameIt = v.FindMember("name");
                 if (nameIt != v.MemberEnd() && nameIt->value.IsString()) {
-                    if (strcmp(name, nameIt->value.GetString()) == 0) {
-                        return T(this, &v);
-                    }
+                    index->emplace(nameIt->value.GetString(), i);
                 }
             }
         }
+        const auto it = index->find(name);
+        if (it != index->end()) {
+            return T(this, &(*values)[it->second]);
+        }
         return T();
     }
 
-    bool loadGlbMetaData(const char* path);
+    /// Looks up the top level arrays once so accessing an object by index doesn't search the root object.
+    void resolveArrays() noexcept;
+
+    bool loadGlbMetaData(const char* path, ParseMode mode);
+
+    /// Parses json text that this Gltf takes ownership of.
+    /// @param[in] text   Null terminated json text.
+    /// @param[in] length The length of the text not counting the null terminator.
+    void parse(std::unique_ptr<char[]> text, size_t length, ParseMode mode);
 
     void clear() noexcept {
+        m_arrays.fill(nullptr);
+        for (auto& index : m_names) {
+            index.reset(nullptr);
+        }
         m_doc.reset(nullptr);
+        m_allocator.reset(nullptr);
+        m_text.reset(nullptr);
         m_glb.reset(nullptr);
         m_baseDir.clear();
     }
 
+    /// The json text that in situ documents point into.
+    std::unique_ptr<char[]> m_text;
+    /// The memory pool of in situ documents. Declared before the document so it is destroyed after it.
+    std::unique_ptr<JsonAllocator> m_allocator;
     std::unique_ptr<JsonDocument> m_doc;
+    /// The top level arrays of the document. Null if the document doesn't have the array.
+    std::array<const JsonValue*, ARRAY_TYPE_COUNT> m_arrays = {};
+    std::array<std::unique_ptr<NameIndex>, ARRAY_TYPE_COUNT> m_names;
     std::unique_ptr<GlbData> m_glb;
     std::string m_baseDir;
 };
@@ -502,6 +612,17 @@ static std::vector<T> getNumberVector(const JsonValue* json, const char* key) {
     return vec;
 }
 
+/// Returns the member json object with the given key or null if not found.
+static const JsonValue* findMember(const JsonValue* json, const char* key) {
+    if (json != nullptr) {
+        auto it = json->FindMember(key);
+        if (it != json->MemberEnd() && it->value.IsObject()) {
+            return &it->value;
+        }
+    }
+    return nullptr;
+}
+
 template<typename T>
 static T findObject(const Gltf* gltf, const JsonValue* json, const char* key) {
     if (json != nullptr) {
@@ -527,25 +648,6 @@ static T findObject(const Gltf* gltf, const JsonValue* json, const char* key, si
     return T();
 }
 
-template<typename T>
-static T findGltfObject(const Gltf* gltf, const char* key, size_t index) {
-    return findGltfObject<T>(gltf, gltf->doc(), key, index);
-}
-
-template<typename T>
-static T findGltfObject(const Gltf* gltf, const JsonValue* json, const char* key, size_t index) {
-    if (json) {
-        const auto it = json->FindMember(key);
-        if (it != json->MemberEnd()) {
-            const auto& values = it->value;
-            if (values.IsArray() && index < values.Size()) {
-                return T(gltf, &values[index]);
-            }
-        }
-    }
-    return T();
-}
-
 template<typename T>
 static std::vector<T> getObjectVector(const Gltf* gltf, const JsonValue* json, const char* key) {
     std::vector<T> vec;
@@ -561,11 +663,6 @@ static std::vector<T> getObjectVector(const Gltf* gltf, const JsonValue* json, c
     return vec;
 }
 
-template<typename T>
-static std::vector<T> getObjectVector(const Gltf* gltf, const char* key) {
-    return getObjectVector<T>(gltf, gltf->doc(), key);
-}
-
 static std::vector<const char*> getKeys(const JsonValue* json, const char* key) {
     std::vector<const char*> vec;
     if (json != nullptr) {
@@ -614,27 +711,16 @@ static bool copyNumbers(const JsonValue* json, const char* key, size_t count, T*
 }
 
 /// Decodes a base64 string.
-/// @param[in]  text       The base64 text to decode.
-/// @param[in]  byteLength The expected number of bytes to read.
-/// @param[out] data       The vector to copy the data to.
+/// @param[in]  text   The base64 text to decode.
+/// @param[in]  length The number of characters in the text.
+/// @param[out] data   The vector to copy the data to.
 /// @return True if the base64 text was decoded successfully; false otherwise.
 template<typename T>
-bool readBase64(const char* text, size_t byteLength, std::vector<T>&data) {
-    std::istringstream in(text);
-    data.clear();
-    data.reserve(byteLength);
-    lib64::decoder decoder;
-    lib64::base64_init_decodestate(&decoder._state);
-    std::array<char, 1024> code;
-    std::array<char, 1024> plaintext;
-    int codelength;
-    do {
-        in.read(code.data(), code.size());
-        codelength = static_cast<int>(in.gcount());
-        int plainlength = decoder.decode(code.data(), codelength, plaintext.data());
-        data.insert(data.end(), plaintext.begin(), plaintext.begin() + plainlength);
-    } while (in.good() && codelength > 0);
-    base64_init_decodestate(&decoder._state);
+bool readBase64(const char* text, size_t length, std::vector<T>& data) {
+    static_assert(sizeof(T) == 1, "vector type must be 1 byte (like char or unsigned char)");
+    // Decode straight into the vector and trim it to what the padding and skipped characters left.
+    data.resize(lib64::decoded_size(length));
+    data.resize(lib64::decode(text, length, reinterpret_cast<uint8_t*>(data.data())));
     return true;
 }
 
@@ -681,6 +767,34 @@ public:
         }
         return nullptr;
     }
+
+    /// Returns a string property and its length, which saves a strlen of long strings like data uris.
+    const char* str(const char* key, size_t& length) const noexcept {
+        if (m_json != nullptr && key != nullptr) {
+            auto it = m_json->FindMember(key);
+            if (it != m_json->MemberEnd() && it->value.IsString()) {
+                length = it->value.GetStringLength();
+                return it->value.GetString();
+            }
+        }
+        length = 0;
+        return nullptr;
+    }
+
+    /// Returns the json object of an extension of this GLTF object.
+    /// @param name The name of the extension. Like "MSFT_lod".
+    /// @return The extension object or null if not found.
+    const JsonValue* extension(const char* name) const noexcept {
+        if (const JsonValue* extensions = findMember(m_json, "extensions")) {
+            return findMember(extensions, name);
+        }
+        return nullptr;
+    }
+
+    /// Returns the extras json object of this GLTF object or null if not found.
+    const JsonValue* extras() const noexcept {
+        return findMember(m_json, "extras");
+    }
     friend bool operator==(const Object& lhs, const Object& rhs);
 protected:
     /// Returns the size of an array or the number of members in an object.
@@ -904,6 +1018,16 @@ public:
     bool skin(size_t& index) const noexcept {
         return findNumber(m_json, "skin", index);
     }
+
+    /// Returns the node indices of the MSFT_lod extension ordered from the most to the least detailed.
+    /// This node is the most detailed level and is not included.
+    std::vector<size_t> lods() const noexcept {
+        return getNumberVector<size_t>(extension("MSFT_lod"), "ids");
+    }
+    /// Returns the MSFT_screencoverage values from the extras of this node.
+    std::vector<float> screenCoverage() const noexcept {
+        return getNumberVector<float>(extras(), "MSFT_screencoverage");
+    }
 };
 
 /// The root nodes of a scene.
@@ -952,6 +1076,76 @@ public:
     /// @return True if the buffer was loaded successfully; false otherwise.
     template<typename T>
     bool load(std::vector<T>& data) const noexcept;
+
+    /// Gets the file that the buffer's data is stored in so it can be read without load(), like with a memory map.
+    /// @param[out] path   The path of the GLB or .bin file.
+    /// @param[out] offset The byte offset of the buffer's data in the file.
+    /// @return True if the buffer is stored in a file; false for base64 buffers.
+    bool fileLocation(std::string& path, size_t& offset) const noexcept;
+};
+
+/// The compressed data of a buffer view that uses EXT_meshopt_compression.
+/// The buffer of the view itself may be a fallback without data; the decoded data replaces it.
+class MeshoptCompression : public Object {
+public:
+    MeshoptCompression() {}
+    MeshoptCompression(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+
+    enum class Mode {
+        ATTRIBUTES,
+        TRIANGLES,
+        INDICES
+    };
+
+    enum class Filter {
+        NONE,
+        OCTAHEDRAL,
+        QUATERNION,
+        EXPONENTIAL
+    };
+
+    /// Gets the index of the buffer that holds the compressed data.
+    bool buffer(size_t& index) const noexcept {
+        return findNumber(m_json, "buffer", index);
+    }
+    size_t byteOffset() const noexcept {
+        return findNumberOrDefault<size_t>(m_json, "byteOffset", 0);
+    }
+    /// The size of the compressed data.
+    size_t byteLength() const noexcept {
+        return findNumberOrDefault<size_t>(m_json, "byteLength", 0);
+    }
+    /// The size of each decoded element.
+    size_t byteStride() const noexcept {
+        return findNumberOrDefault<size_t>(m_json, "byteStride", 0);
+    }
+    /// The number of decoded elements.
+    size_t count() const noexcept {
+        return findNumberOrDefault<size_t>(m_json, "count", 0);
+    }
+
+    Mode mode() const noexcept {
+        const char* s = str("mode");
+        if (s != nullptr) {
+            switch (*s) {
+            case 'T': return Mode::TRIANGLES;
+            case 'I': return Mode::INDICES;
+            }
+        }
+        return Mode::ATTRIBUTES;
+    }
+
+    Filter filter() const noexcept {
+        const char* s = str("filter");
+        if (s != nullptr) {
+            switch (*s) {
+            case 'O': return Filter::OCTAHEDRAL;
+            case 'Q': return Filter::QUATERNION;
+            case 'E': return Filter::EXPONENTIAL;
+            }
+        }
+        return Filter::NONE;
+    }
 };
 
 /// A view into a buffer generally representing a subset of the buffer.
@@ -1002,6 +1196,12 @@ public:
     bool target(int& value) const noexcept {
         return findNumber<int>(m_json, "target", value);
     }
+
+    /// Returns the EXT_meshopt_compression extension of the view. Null if the view isn't compressed.
+    MeshoptCompression meshoptCompression() const noexcept {
+        const JsonValue* json = extension("EXT_meshopt_compression");
+        return json != nullptr ? MeshoptCompression(m_gltf, json) : MeshoptCompression();
+    }
 };
 
 class SparseValues : public Object {
@@ -1228,7 +1428,8 @@ public:
     }
     bool isBase64() const {
         const char* s = uri();
-        return startsWith(s, LAZY_GLTF2_DATA_IMAGE_JPG) || startsWith(s, LAZY_GLTF2_DATA_IMAGE_PNG);
+        return startsWith(s, LAZY_GLTF2_DATA_IMAGE_JPG) || startsWith(s, LAZY_GLTF2_DATA_IMAGE_PNG)
+            || startsWith(s, LAZY_GLTF2_DATA_IMAGE_KTX2);
     }
     template<typename T>
     bool loadBase64(std::vector<T>& data) const;
@@ -1332,6 +1533,13 @@ public:
     bool source(size_t& index) const noexcept {
         return findNumber(m_json, "source", index);
     }
+
+    /// Gets the index of the KTX2 image of the KHR_texture_basisu extension.
+    /// @param[out] index The variable to copy the index to.
+    /// @return True if the texture has the extension.
+    bool basisuSource(size_t& index) const noexcept {
+        return findNumber(extension("KHR_texture_basisu"), "source", index);
+    }
     Sampler sampler() const noexcept {
         size_t num;
         if (findNumber(m_json, "sampler", num)) {
@@ -1845,25 +2053,44 @@ T numberOfComponents(Accessor::Type type) noexcept {
 
 // impl
 
-inline bool Gltf::load(const char* path) noexcept {
+inline bool Gltf::load(const char* path, ParseMode mode) noexcept {
     if (path == nullptr || *path == '\0') {
         return false;
     }
     clear();
     size_t len = strlen(path);
     if (lowercase(path[len - 1]) == 'b') { // .glb
-        return loadGlbMetaData(path);
+        return loadGlbMetaData(path, mode);
     }
     unique_file_ptr file = openFile(path, "rb");
     FILE* fp = file.get();
     if (!fp) {
         return false;
     }
+    if (mode == ParseMode::IN_SITU) {
+        if (std::fseek(fp, 0, SEEK_END)) {
+            return false;
+        }
+        const long size = std::ftell(fp);
+        if (size < 0 || std::fseek(fp, 0, SEEK_SET)) {
+            return false;
+        }
+        const size_t length = static_cast<size_t>(size);
+        std::unique_ptr<char[]> text(new char[length + 1]);
+        if (fread(text.get(), 1, length, fp) != length) {
+            return false;
+        }
+        text[length] = '\0';
+        parse(std::move(text), length, mode);
+        m_baseDir.assign(dirName(path));
+        return true;
+    }
     char readBuffer[65536];
     rapidjson::FileReadStream is(fp, readBuffer, sizeof(readBuffer));
 
     m_doc.reset(new JsonDocument());
     m_doc->ParseStream(is);
+    resolveArrays();
     m_baseDir.assign(dirName(path));
     return true;
 }
@@ -1885,107 +2112,107 @@ inline Scene Gltf::defaultScene() const noexcept {
 }
 
 inline Scene Gltf::scene(size_t index) const noexcept {
-    return findGltfObject<Scene>(this, "scenes", index);
+    return object<Scene>(SCENES, index);
 }
 
 inline std::vector<Scene> Gltf::scenes() const noexcept {
-    return getObjectVector<Scene>(this, "scenes");
+    return objects<Scene>(SCENES);
 }
 
 inline Node Gltf::node(size_t index) const noexcept {
-    return findGltfObject<Node>(this, "nodes", index);
+    return object<Node>(NODES, index);
 }
 
 inline std::vector<Node> Gltf::nodes() const noexcept {
-    return getObjectVector<Node>(this, "nodes");
+    return objects<Node>(NODES);
 }
 
 inline Mesh Gltf::mesh(size_t index) const noexcept {
-    return findGltfObject<Mesh>(this, "meshes", index);
+    return object<Mesh>(MESHES, index);
 }
 
 inline std::vector<Mesh> Gltf::meshes() const noexcept {
-    return getObjectVector<Mesh>(this, "meshes");
+    return objects<Mesh>(MESHES);
 }
 
 inline Camera Gltf::camera(size_t index) const noexcept {
-    return findGltfObject<Camera>(this, "cameras", index);
+    return object<Camera>(CAMERAS, index);
 }
 
 inline std::vector<Camera> Gltf::cameras() const noexcept {
-    return getObjectVector<Camera>(this, "cameras");
+    return objects<Camera>(CAMERAS);
 }
 
 inline Accessor Gltf::accessor(size_t index) const noexcept {
-    return findGltfObject<Accessor>(this, "accessors", index);
+    return object<Accessor>(ACCESSORS, index);
 }
 
 inline std::vector<Accessor> Gltf::accessors() const noexcept {
-    return getObjectVector<Accessor>(this, "accessors");
+    return objects<Accessor>(ACCESSORS);
 }
 
 inline Buffer Gltf::buffer(size_t index) const noexcept {
-    return findGltfObject<Buffer>(this, "buffers", index);
+    return object<Buffer>(BUFFERS, index);
 }
 
 inline std::vector<Buffer> Gltf::buffers() const noexcept {
-    return getObjectVector<Buffer>(this, "buffers");
+    return objects<Buffer>(BUFFERS);
 }
 
 inline BufferView Gltf::bufferView(size_t index) const noexcept {
-    return findGltfObject<BufferView>(this, "bufferViews", index);
+    return object<BufferView>(BUFFER_VIEWS, index);
 }
 
 inline std::vector<BufferView> Gltf::bufferViews() const noexcept {
-    return getObjectVector<BufferView>(this, "bufferViews");
+    return objects<BufferView>(BUFFER_VIEWS);
 }
 
 inline Animation Gltf::animation(size_t index) const noexcept {
-    return findGltfObject<Animation>(this, "animations", index);
+    return object<Animation>(ANIMATIONS, index);
 }
 
 inline std::vector<Animation> Gltf::animations() const noexcept {
-    return getObjectVector<Animation>(this, "animations");
+    return objects<Animation>(ANIMATIONS);
 }
 
 inline Image Gltf::image(size_t index) const noexcept {
-    return findGltfObject<Image>(this, "images", index);
+    return object<Image>(IMAGES, index);
 }
 
 inline std::vector<Image> Gltf::images() const noexcept {
-    return getObjectVector<Image>(this, "images");
+    return objects<Image>(IMAGES);
 }
 
 inline Texture Gltf::texture(size_t index) const noexcept {
-    return findGltfObject<Texture>(this, "textures", index);
+    return object<Texture>(TEXTURES, index);
 }
 
 inline std::vector<Texture> Gltf::textures() const noexcept {
-    return getObjectVector<Texture>(this, "textures");
+    return objects<Texture>(TEXTURES);
 }
 
 inline Sampler Gltf::sampler(size_t index) const noexcept {
-    return findGltfObject<Sampler>(this, "samplers", index);
+    return object<Sampler>(SAMPLERS, index);
 }
 
 inline std::vector<Sampler> Gltf::samplers() const noexcept {
-    return getObjectVector<Sampler>(this, "samplers");
+    return objects<Sampler>(SAMPLERS);
 }
 
 inline Material Gltf::material(size_t index) const noexcept {
-    return findGltfObject<Material>(this, "materials", index);
+    return object<Material>(MATERIALS, index);
 }
 
 inline std::vector<Material> Gltf::materials() const noexcept {
-    return getObjectVector<Material>(this, "materials");
+    return objects<Material>(MATERIALS);
 }
 
 inline Skin Gltf::skin(size_t index) const noexcept {
-    return findGltfObject<Skin>(this, "skins", index);
+    return object<Skin>(SKINS, index);
 }
 
 inline std::vector<Skin> Gltf::skins() const noexcept {
-    return getObjectVector<Skin>(this, "skins");
+    return objects<Skin>(SKINS);
 }
 
 inline Asset Gltf::asset() const noexcept {
@@ -2002,19 +2229,19 @@ inline Asset Gltf::asset() const noexcept {
 }
 
 inline Node Gltf::findNode(const char* name) {
-    return findByName<Node>("nodes", name);
+    return findByName<Node>(NODES, name);
 }
 
 inline Mesh Gltf::findMesh(const char* name) {
-    return findByName<Mesh>("meshes", name);
+    return findByName<Mesh>(MESHES, name);
 }
 
 inline Skin Gltf::findSkin(const char* name) {
-    return findByName<Skin>("skins", name);
+    return findByName<Skin>(SKINS, name);
 }
 
 inline Material Gltf::findMaterial(const char* name) {
-    return findByName<Material>("materials", name);
+    return findByName<Material>(MATERIALS, name);
 }
 
 inline std::vector<const char*> Gltf::extensionsRequired() const noexcept {
@@ -2025,7 +2252,41 @@ inline std::vector<const char*> Gltf::extensionsUsed() const noexcept {
     return getStrings(doc(), "extensionsUsed");
 }
 
-inline bool Gltf::loadGlbMetaData(const char* path) {
+inline void Gltf::parse(std::unique_ptr<char[]> text, size_t length, ParseMode mode) {
+    if (mode == ParseMode::IN_SITU) {
+        // The document of a glTF takes about as much memory as its json once strings aren't copied, so a pool
+        // chunk the size of the json holds most documents in one or two allocations.
+        static constexpr size_t minChunkSize = 64 * 1024;
+        m_allocator.reset(new JsonAllocator(length > minChunkSize ? length : minChunkSize));
+        m_doc.reset(new JsonDocument(m_allocator.get()));
+        m_text = std::move(text);
+        m_doc->ParseInsitu(m_text.get());
+    }
+    else {
+        rapidjson::MemoryStream stream(text.get(), length);
+        m_doc.reset(new JsonDocument());
+        m_doc->ParseStream(stream);
+    }
+    resolveArrays();
+}
+
+inline void Gltf::resolveArrays() noexcept {
+    static const char* keys[ARRAY_TYPE_COUNT] = {
+        "scenes", "nodes", "meshes", "cameras", "accessors", "buffers", "bufferViews", "animations", "images",
+        "textures", "samplers", "materials", "skins"
+    };
+    m_arrays.fill(nullptr);
+    if (m_doc && m_doc->IsObject()) {
+        for (size_t i = 0; i < ARRAY_TYPE_COUNT; ++i) {
+            const auto it = m_doc->FindMember(keys[i]);
+            if (it != m_doc->MemberEnd() && it->value.IsArray()) {
+                m_arrays[i] = &it->value;
+            }
+        }
+    }
+}
+
+inline bool Gltf::loadGlbMetaData(const char* path, ParseMode mode) {
     unique_file_ptr file = openFile(path, "rb");
     FILE* fp = file.get();
     if (!fp) {
@@ -2040,14 +2301,13 @@ inline bool Gltf::loadGlbMetaData(const char* path) {
     if (fread(header.data(), sizeof(std::uint32_t), header.size(), fp) == header.size()) {
         if (header[magic] == MAGIC && header[chunkType] == JSON_CHUNK_TYPE) {
             const size_t bufferLength = header[chunkLength];
-            std::unique_ptr<char[]> buffer(new char[bufferLength]);
+            std::unique_ptr<char[]> buffer(new char[bufferLength + 1]);
             size_t bytesRead = fread(buffer.get(), 1, bufferLength, fp);
             if (bytesRead != bufferLength) {
                 return false;
             }
-            rapidjson::MemoryStream stream(buffer.get(), bufferLength);
-            m_doc.reset(new JsonDocument());
-            m_doc->ParseStream(stream);
+            buffer[bufferLength] = '\0';
+            parse(std::move(buffer), bufferLength, mode);
 
             // attempt to read the binary buffer chunk
             if (std::fseek(fp, sizeof(header) + header[chunkLength], SEEK_SET)) {
@@ -2122,7 +2382,8 @@ bool Buffer::load(std::vector<T>& data) const noexcept {
     if (m_gltf == nullptr) {
         return false;
     }
-    const char* uriStr = uri();
+    size_t uriLength;
+    const char* uriStr = str("uri", uriLength);
     if (uriStr == nullptr) {
         // GLB
         // TODO verify that this is the first buffer of the buffers array?
@@ -2132,7 +2393,8 @@ bool Buffer::load(std::vector<T>& data) const noexcept {
     }
     else if (startsWith(uriStr, LAZY_GLTF2_DATA_APP_BASE64)) {
         // base64
-        return readBase64(uriStr + sizeof(LAZY_GLTF2_DATA_APP_BASE64) - 1, byteLength(), data);
+        const size_t prefix = sizeof(LAZY_GLTF2_DATA_APP_BASE64) - 1;
+        return readBase64(uriStr + prefix, uriLength - prefix, data);
     }
     else {
         // TODO make sure this is a local file URI
@@ -2142,21 +2404,41 @@ bool Buffer::load(std::vector<T>& data) const noexcept {
     }
 }
 
+inline bool Buffer::fileLocation(std::string& path, size_t& offset) const noexcept {
+    if (m_gltf == nullptr) {
+        return false;
+    }
+    const char* uriStr = uri();
+    if (uriStr == nullptr) {
+        size_t length;
+        return m_gltf->glbLocation(path, offset, length);
+    }
+    if (startsWith(uriStr, LAZY_GLTF2_DATA_APP_BASE64)) {
+        return false;
+    }
+    path = m_gltf->baseDir() + uriStr;
+    offset = 0;
+    return true;
+}
+
 template<typename T>
 bool Image::loadBase64(std::vector<T>& data) const {
-    const char* text = uri();
+    size_t length;
+    const char* text = str("uri", length);
+    size_t prefix;
     if (startsWith(text, LAZY_GLTF2_DATA_IMAGE_JPG)) {
-        text += sizeof(LAZY_GLTF2_DATA_IMAGE_JPG) - 1;
+        prefix = sizeof(LAZY_GLTF2_DATA_IMAGE_JPG) - 1;
     }
     else if (startsWith(text, LAZY_GLTF2_DATA_IMAGE_PNG)) {
-        text += sizeof(LAZY_GLTF2_DATA_IMAGE_PNG) - 1;
+        prefix = sizeof(LAZY_GLTF2_DATA_IMAGE_PNG) - 1;
+    }
+    else if (startsWith(text, LAZY_GLTF2_DATA_IMAGE_KTX2)) {
+        prefix = sizeof(LAZY_GLTF2_DATA_IMAGE_KTX2) - 1;
     }
     else {
         return false;
     }
-    // the data will be roughly 75% the size of the base64 text
-    const size_t byteLength = strlen(text) * 3 >> 2;
-    return readBase64(text, byteLength, data);
+    return readBase64(text + prefix, length - prefix, data);
 }
 
 inline std::vector<Primitive> Mesh::primitives() const noexcept {
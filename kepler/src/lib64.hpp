@@ -6,6 +6,20 @@
 #ifndef LIB64_HPP
 #define LIB64_HPP
 #include <iostream>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LIB64_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+/// MSVC allows any intrinsic in any function so no target attribute is needed.
+#define LIB64_TARGET(isa)
+#else
+#define LIB64_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
 #ifndef BASE64_BUFFERSIZE
 #define BASE64_BUFFERSIZE 1024
 #endif
@@ -126,5 +140,235 @@ struct decoder {
         delete[] plaintext;
     }
 };
+
+/// Returns the most bytes that length characters of base64 text can decode to.
+inline size_t decoded_size(size_t length) {
+    return (length + 3) / 4 * 3;
+}
+
+namespace detail {
+
+/// Maps a character to its 6 bit value or 0xFF if it isn't part of the base64 alphabet.
+struct decode_table {
+    uint8_t values[256];
+
+    decode_table() {
+        for (int i = 0; i < 256; ++i) {
+            values[i] = 0xFF;
+        }
+        const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (uint8_t i = 0; i < 64; ++i) {
+            values[static_cast<uint8_t>(alphabet[i])] = i;
+        }
+    }
+};
+
+inline const uint8_t* decoding_table() {
+    static const decode_table table;
+    return table.values;
+}
+
+/// Decodes one character at a time and skips characters that aren't in the alphabet, like base64_decode_block.
+inline size_t decode_scalar(const char* in, size_t length, uint8_t* out) {
+    const uint8_t* table = decoding_table();
+    const uint8_t* const start = out;
+    const char* const end = in + length;
+    // Whole quads without anything to skip are by far the common case.
+    while (end - in >= 4) {
+        const uint32_t a = table[static_cast<uint8_t>(in[0])];
+        const uint32_t b = table[static_cast<uint8_t>(in[1])];
+        const uint32_t c = table[static_cast<uint8_t>(in[2])];
+        const uint32_t d = table[static_cast<uint8_t>(in[3])];
+        if ((a | b | c | d) & 0x80) {
+            break;
+        }
+        const uint32_t bits = a << 18 | b << 12 | c << 6 | d;
+        out[0] = static_cast<uint8_t>(bits >> 16);
+        out[1] = static_cast<uint8_t>(bits >> 8);
+        out[2] = static_cast<uint8_t>(bits);
+        in += 4;
+        out += 3;
+    }
+    uint32_t bits = 0;
+    int count = 0;
+    for (; in != end; ++in) {
+        const uint32_t value = table[static_cast<uint8_t>(*in)];
+        if (value & 0x80) {
+            continue;
+        }
+        bits = bits << 6 | value;
+        if (++count == 4) {
+            out[0] = static_cast<uint8_t>(bits >> 16);
+            out[1] = static_cast<uint8_t>(bits >> 8);
+            out[2] = static_cast<uint8_t>(bits);
+            out += 3;
+            bits = 0;
+            count = 0;
+        }
+    }
+    // A partial quad is what is left before the padding.
+    if (count == 2) {
+        *out++ = static_cast<uint8_t>(bits >> 4);
+    }
+    else if (count == 3) {
+        *out++ = static_cast<uint8_t>(bits >> 10);
+        *out++ = static_cast<uint8_t>(bits >> 2);
+    }
+    return static_cast<size_t>(out - start);
+}
+
+#ifdef LIB64_X86
+
+/// Translates 16 characters to their 6 bit values.
+/// @return False if any character isn't in the alphabet.
+LIB64_TARGET("ssse3")
+inline bool translate_sse(__m128i chars, __m128i& values) {
+    // The alphabet is 5 ranges so the offset of each is picked with compares. Characters 0x80 and up are
+    // negative and fail every range.
+    const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('Z' + 1)));
+    const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('z' + 1)));
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    const __m128i plus = _mm_cmpeq_epi8(chars, _mm_set1_epi8('+'));
+    const __m128i slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+    const __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(_mm_or_si128(digit, plus), slash));
+    if (_mm_movemask_epi8(valid) != 0xFFFF) {
+        return false;
+    }
+    __m128i shift = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+    shift = _mm_or_si128(shift, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+    shift = _mm_or_si128(shift, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+    shift = _mm_or_si128(shift, _mm_and_si128(plus, _mm_set1_epi8(62 - '+')));
+    shift = _mm_or_si128(shift, _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+    values = _mm_add_epi8(chars, shift);
+    return true;
+}
+
+/// Packs the 6 bit values of each group of 4 bytes into 3 bytes. The 12 bytes are at the start of the result.
+LIB64_TARGET("ssse3")
+inline __m128i pack_sse(__m128i values) {
+    // 00aaaaaa 00bbbbbb -> 0000aaaa aabbbbbb
+    const __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    // -> 00000000 aaaaaabb bbbbcccc ccdddddd
+    const __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(quads, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+/// Decodes 16 characters to 12 bytes at a time. Stops at the first block that has a character outside the
+/// alphabet, such as padding, and leaves the rest to the scalar decoder.
+LIB64_TARGET("ssse3")
+inline size_t decode_sse(const char*& in, const char* end, uint8_t*& out, const uint8_t* out_end) {
+    const uint8_t* const start = out;
+    // Each block stores 16 bytes so there must be room for the 4 that are overwritten by the next block.
+    while (end - in >= 16 && out_end - out >= 16) {
+        __m128i values;
+        if (!translate_sse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), values)) {
+            break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), pack_sse(values));
+        in += 16;
+        out += 12;
+    }
+    return static_cast<size_t>(out - start);
+}
+
+LIB64_TARGET("avx2")
+inline bool translate_avx2(__m256i chars, __m256i& values) {
+    const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), chars));
+    const __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), chars));
+    const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+    const __m256i plus = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('+'));
+    const __m256i slash = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/'));
+    const __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(_mm256_or_si256(digit, plus), slash));
+    if (_mm256_movemask_epi8(valid) != -1) {
+        return false;
+    }
+    __m256i shift = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+    shift = _mm256_or_si256(shift, _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')));
+    shift = _mm256_or_si256(shift, _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+    shift = _mm256_or_si256(shift, _mm256_and_si256(plus, _mm256_set1_epi8(62 - '+')));
+    shift = _mm256_or_si256(shift, _mm256_and_si256(slash, _mm256_set1_epi8(63 - '/')));
+    values = _mm256_add_epi8(chars, shift);
+    return true;
+}
+
+/// Decodes 32 characters to 24 bytes at a time. Same as decode_sse otherwise.
+LIB64_TARGET("avx2")
+inline size_t decode_avx2(const char*& in, const char* end, uint8_t*& out, const uint8_t* out_end) {
+    const uint8_t* const start = out;
+    const __m256i pack_shuffle = _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    // Each lane packs to 12 bytes so the lanes are joined with a cross lane permute.
+    const __m256i join_lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+    while (end - in >= 32 && out_end - out >= 32) {
+        __m256i values;
+        if (!translate_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in)), values)) {
+            break;
+        }
+        const __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        const __m256i quads = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+        const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(quads, pack_shuffle), join_lanes);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), packed);
+        in += 32;
+        out += 24;
+    }
+    return static_cast<size_t>(out - start);
+}
+
+enum simd_level {
+    simd_none, simd_ssse3, simd_avx2
+};
+
+inline simd_level detect_simd() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    const int max_leaf = info[0];
+    __cpuid(info, 1);
+    const bool ssse3 = (info[2] & (1 << 9)) != 0;
+    // AVX2 also needs the OS to save the ymm registers.
+    const bool os_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    bool avx2 = false;
+    if (max_leaf >= 7 && os_avx) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    const bool ssse3 = __builtin_cpu_supports("ssse3");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    return avx2 ? simd_avx2 : ssse3 ? simd_ssse3 : simd_none;
+}
+
+inline simd_level supported_simd() {
+    static const simd_level level = detect_simd();
+    return level;
+}
+
+#endif // LIB64_X86
+} // namespace detail
+
+/// Decodes base64 text straight into memory. Uses AVX2 or SSSE3 when the CPU has them and decodes the rest
+/// one character at a time. Characters outside the base64 alphabet, like padding and white space, are skipped.
+/// @param[in]  in     The base64 text. Doesn't need to be null terminated.
+/// @param[in]  length The number of characters.
+/// @param[out] out    Must have room for decoded_size(length) bytes.
+/// @return The number of bytes decoded.
+inline size_t decode(const char* in, size_t length, uint8_t* out) {
+    const char* const end = in + length;
+    uint8_t* const start = out;
+#ifdef LIB64_X86
+    const uint8_t* const out_end = out + decoded_size(length);
+    const detail::simd_level level = detail::supported_simd();
+    if (level == detail::simd_avx2) {
+        detail::decode_avx2(in, end, out, out_end);
+    }
+    if (level >= detail::simd_ssse3) {
+        detail::decode_sse(in, end, out, out_end);
+    }
+#endif
+    out += detail::decode_scalar(in, static_cast<size_t>(end - in), out);
+    return static_cast<size_t>(out - start);
+}
 }
 #endif
@@ -16,9 +16,18 @@
 #include <Scene.hpp>
 #include <Technique.hpp>
 #include <Material.hpp>
+#include <OcclusionCuller.hpp>
+#include <TextureCache.hpp>
+#include <TextureUploader.hpp>
+#include <TextureStreamer.hpp>
+#include <GpuTimer.hpp>
+#include <GLStats.hpp>
+#include <CookedScene.hpp>
 
 #include <iostream>
 #include <algorithm>
+#include <iomanip>
+#include <sstream>
 
 namespace kepler {
 namespace gl {
@@ -105,21 +114,114 @@ void Gltf2Test::start() {
 }
 
 void Gltf2Test::update() {
+    if (_sceneLoad) {
+        const bool done = _sceneLoad->update();
+        if (_scene == nullptr && (_scene = _sceneLoad->scene())) {
+            // Progressive loads return the scene while nodes are still being added.
+            _scene->addNode(_compass.node());
+        }
+        if (done) {
+            if (_scene) {
+                // Added back by showScene() so it isn't part of the bounding box.
+                _scene->removeChild(_compass.node());
+            }
+            _scene = _sceneLoad->scene();
+            _sceneLoad.reset();
+            showScene();
+        }
+    }
+    if (_uploader) {
+        _uploader->update();
+    }
+    if (_streamer) {
+        if (_scene) {
+            _streamer->requestScene(*_scene, app()->height());
+        }
+        _streamer->update();
+    }
 }
 
 void Gltf2Test::render() {
+    if (_gpuTimer) {
+        _gpuTimer->beginFrame();
+        _gpuTimer->begin("render");
+    }
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     if (_scene) {
-        _scene->visit([](Node* node) {
-            if (auto renderer = node->drawable()) {
-                renderer->draw();
-            }
-        });
+        ProfileScope profile("scene");
+        if (_gpuTimer) {
+            _gpuTimer->begin("scene");
+        }
+        if (_culler) {
+            _culler->drawScene(*_scene);
+        }
+        else {
+            _scene->visit([](Node* node) {
+                if (auto renderer = node->drawable()) {
+                    renderer->draw();
+                }
+            });
+        }
+        if (_gpuTimer) {
+            _gpuTimer->end();
+        }
     }
 
     if (_font) {
-        _font->drawText(g_text.c_str(), 0.f, 0.f);
+        if (_sceneLoad) {
+            std::string text = g_text + " " + std::to_string(static_cast<int>(_sceneLoad->progress() * 100.0f)) + "%";
+            _font->drawText(text.c_str(), 0.f, 0.f);
+        }
+        else {
+            _font->drawText(g_text.c_str(), 0.f, 0.f);
+        }
+        if (_culler) {
+            const auto& stats = _culler->stats();
+            std::string text = "queries: " + std::to_string(stats.queriesIssued)
+                + " skipped: " + std::to_string(stats.objectsSkipped)
+                + " rendered: " + std::to_string(stats.objectsRendered)
+                + " latency: " + std::to_string(stats.averageLatency);
+            _font->drawText(text.c_str(), 0.f, _font->sizeAsFloat());
+        }
+        if (_uploader && _uploader->busy()) {
+            const auto& stats = _uploader->stats();
+            std::string text = "uploading: " + std::to_string(stats.bytesPending / 1024) + " KB";
+            _font->drawText(text.c_str(), 0.f, _font->sizeAsFloat() * 2.f);
+        }
+        if (_streamer) {
+            const auto stats = _streamer->stats();
+            std::string text = "streamed: " + std::to_string(stats.residentBytes / 1024) + " KB of "
+                + std::to_string(stats.totalBytes / 1024) + " KB budget: " + std::to_string(stats.budget / 1024) + " KB"
+                + " levels: " + std::to_string(stats.residentLevels) + "/" + std::to_string(stats.totalLevels);
+            _font->drawText(text.c_str(), 0.f, _font->sizeAsFloat() * 3.f);
+        }
+        if (_gpuTimer) {
+            // The GPU results of the last few frames aren't ready yet.
+            const auto frame = FrameProfiler::frame(FrameProfiler::HISTORY - 1);
+            float y = _font->sizeAsFloat() * 4.f;
+            for (const auto& scope : frame.scopes) {
+                std::ostringstream text;
+                text << std::fixed << std::setprecision(2) << scope.name << " cpu: " << scope.cpuMs << " ms";
+                if (scope.gpuCount > 0) {
+                    text << " gpu: " << scope.gpuMs << " ms";
+                }
+                _font->drawText(text.str().c_str(), 0.f, y);
+                y += _font->sizeAsFloat();
+            }
+        }
+    }
+    if (_font && GLStats::enabled()) {
+        const auto& stats = GLStats::lastFrame();
+        std::string text;
+        for (size_t i = 0; i < GLStats::CATEGORY_COUNT; ++i) {
+            const auto category = static_cast<GLStats::Category>(i);
+            text += std::string(GLStats::categoryName(category)) + ": " + std::to_string(stats[category]) + " ";
+        }
+        _font->drawText(text.c_str(), 0.f, static_cast<float>(app()->height()) - _font->sizeAsFloat());
+    }
+    if (_gpuTimer) {
+        _gpuTimer->end();
     }
 }
 
@@ -135,15 +237,51 @@ void Gltf2Test::keyEvent(int key, int scancode, int action, int mods) {
 		case KEY_DOWN:
 			_scene->childAt(0)->translateY(-0.1f);
 			break;
+        case KEY_C:
+            // toggle counting GL calls. The counts of each frame are written to gl_stats.csv
+            GLStats::setEnabled(!GLStats::enabled());
+            if (GLStats::enabled()) {
+                GLStats::openCsv("gl_stats.csv");
+            }
+            else {
+                GLStats::closeCsv();
+            }
+            break;
         case KEY_F:
             focus();
             break;
+        case KEY_L:
+            // toggle loading scenes in the background. Nodes are drawn as soon as their meshes are ready.
+            _asyncLoading = !_asyncLoading;
+            break;
+        case KEY_K:
+            // write the scene to a cooked file next to the glTF file and load it back from there
+            cookScene();
+            break;
+        case KEY_G:
+            // toggle GPU timing of the scene
+            _gpuTimer = _gpuTimer ? nullptr : GpuTimer::create();
+            break;
         case KEY_N:
             loadNextPath();
             break;
+        case KEY_O:
+            // toggle occlusion culling
+            _culler = _culler ? nullptr : OcclusionCuller::create();
+            break;
         case KEY_P:
             loadPrevPath();
             break;
+        case KEY_T:
+            // toggle mip streaming of KTX2 textures. Applies to the textures of the next scene that is loaded.
+            _streamer = _streamer ? nullptr : TextureStreamer::create();
+            TextureCache::setStreamer(_streamer);
+            break;
+        case KEY_U:
+            // toggle uploading textures over several frames
+            _uploader = _uploader ? nullptr : TextureUploader::create();
+            TextureCache::setUploader(_uploader);
+            break;
         case KEY_F4:
             if (mods & MOD_CTRL) {
                 MainMenu::gotoMainMenu();
@@ -189,7 +327,7 @@ void Gltf2Test::dropEvent(int count, const char** paths) {
     // Load the first GLTF file found. Ignore directories.
     for (int i = 0; i < count; ++i) {
         const char* path = paths[i];
-        if (endsWith(path, ".gltf") || endsWith(path, ".glb")) {
+        if (endsWith(path, ".gltf") || endsWith(path, ".glb") || endsWith(path, ".kcs")) {
             std::clog << "Load: " << path << std::endl;
             loadSceneFromFile(paths[i]);
             return;
@@ -210,17 +348,50 @@ void Gltf2Test::loadSceneFromFile(const char* path) {
     }
     _orbitCamera.detach();
     _scene.reset();
+    _sceneLoad.reset();
+    g_text.assign(path);
 
-    GLTF2Loader loader;
-    loader.setCameraAspectRatio(app()->aspectRatio());
-    _scene = loader.loadSceneFromFile(path);
+    if (endsWith(path, ".kcs")) {
+        _scene = CookedScene::load(path);
+    }
+    else {
+        GLTF2Loader loader;
+        loader.setCameraAspectRatio(app()->aspectRatio());
+        if (_asyncLoading) {
+            // update() shows the scene once it has nodes.
+            loader.setProgressiveLoading(true);
+            _sceneLoad = loader.loadSceneFromFileAsync(path);
+            return;
+        }
+        _scene = loader.loadSceneFromFile(path);
+    }
+    showScene();
+}
 
+void Gltf2Test::showScene() {
     if (_scene) {
         calcBoundingBox(_scene.get());
         _orbitCamera.attach(_scene.get());
         _scene->addNode(_compass.node());
     }
-    g_text.assign(path);
+}
+
+void Gltf2Test::cookScene() {
+    if (_scene == nullptr) {
+        return;
+    }
+    const std::string path = endsWith(g_text.c_str(), ".kcs") ? g_text : g_text + ".kcs";
+    // Only the loaded nodes are cooked.
+    _orbitCamera.detach();
+    _scene->removeChild(_compass.node());
+    if (CookedScene::write(*_scene, path.c_str())) {
+        std::clog << "Cooked: " << path << std::endl;
+        loadSceneFromFile(path.c_str());
+    }
+    else {
+        _orbitCamera.attach(_scene.get());
+        _scene->addNode(_compass.node());
+    }
 }
 
 void Gltf2Test::loadNextPath() {
@@ -27,6 +27,10 @@ public:
 private:
     void focus();
     void loadSceneFromFile(const char* path);
+    /// Frames the camera on the scene and adds the compass.
+    void showScene();
+    /// Writes the scene to a cooked file and loads it back.
+    void cookScene();
     void loadNextPath();
     void loadPrevPath();
     void calcBoundingBox(Scene* scene);
@@ -34,7 +38,13 @@ private:
 private:
     bool _moveCamera;
     shared_ptr<Scene> _scene;
+    shared_ptr<SceneLoad> _sceneLoad;
+    bool _asyncLoading = false;
     shared_ptr<BmpFont> _font;
+    shared_ptr<OcclusionCuller> _culler;
+    shared_ptr<TextureUploader> _uploader;
+    shared_ptr<TextureStreamer> _streamer;
+    shared_ptr<GpuTimer> _gpuTimer;
     AxisCompass _compass;
     OrbitCamera _orbitCamera;
     BoundingBox _box;
@@ -15,7 +15,8 @@
 #include <MeshPrimitive.hpp>
 #include <MeshRenderer.hpp>
 #include <MeshUtils.hpp>
-#include <Image.hpp>
+#include <Texture.hpp>
+#include <TextureCache.hpp>
 #include <Sampler.hpp>
 #include <Logging.hpp>
 #include <Performance.hpp>
@@ -223,9 +224,8 @@ static shared_ptr<Material> createPointLightMaterial(const char* texture_path, s
     static constexpr char* VERT = "res/shaders/point_light.vert";
     static constexpr char* FRAG = "res/shaders/point_light.frag";
     auto effect = Effect::createFromFile(VERT, FRAG);
-    auto image = Image::createFromFile(texture_path);
-    auto texture = Texture::create2D(image.get(), GL_RGB, true);
-    if (!effect || !image || !texture) {
+    auto texture = Texture::createShared(TextureCache::textureFromFile(texture_path, GL_RGB, true));
+    if (!effect || !texture) {
         loge("failed to load light material");
         return nullptr;
     }
@@ -2,6 +2,8 @@
 
 #include <RenderState.hpp>
 
+#include <array>
+
 using namespace kepler;
 using namespace kepler::gl;
 
@@ -15,3 +17,44 @@ TEST(renderState, set_bits) {
     EXPECT_TRUE(r.isDepthTestEnabled());
     EXPECT_FALSE(r.isCullingEnabled());
 }
+
+static std::array<GLboolean, 4> colorWriteMask() {
+    std::array<GLboolean, 4> mask;
+    glGetBooleanv(GL_COLOR_WRITEMASK, mask.data());
+    return mask;
+}
+
+TEST(renderState, color_mask_after_occlusion_proxy) {
+    // The same sequence as OcclusionCuller: an occluder, a proxy that only writes to a query and then a normal draw.
+    RenderState occluder;
+    occluder.setDepthTest(true);
+    RenderState proxy;
+    proxy.setColorMask(false, false, false, false);
+    proxy.setDepthMask(false);
+    proxy.setDepthTest(true);
+    RenderState normal;
+    normal.setDepthTest(true);
+
+    const std::array<GLboolean, 4> all = {GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE};
+    const std::array<GLboolean, 4> none = {GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE};
+    occluder.bind();
+    EXPECT_EQ(all, colorWriteMask());
+    proxy.bind();
+    EXPECT_EQ(none, colorWriteMask());
+    GLboolean depthMask = GL_TRUE;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+    EXPECT_EQ(GL_FALSE, depthMask);
+    normal.bind();
+    EXPECT_EQ(all, colorWriteMask());
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+    EXPECT_EQ(GL_TRUE, depthMask);
+
+    // Each channel goes to its own slot.
+    RenderState redBlue;
+    redBlue.setColorMask(true, false, true, false);
+    redBlue.bind();
+    const std::array<GLboolean, 4> expected = {GL_TRUE, GL_FALSE, GL_TRUE, GL_FALSE};
+    EXPECT_EQ(expected, colorWriteMask());
+    normal.bind();
+    EXPECT_EQ(all, colorWriteMask());
+}
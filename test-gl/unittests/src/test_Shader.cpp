@@ -1,6 +1,9 @@
 #include "common_test.hpp"
 
 #include <Shader.hpp>
+#include <Effect.hpp>
+
+#include <set>
 
 using namespace kepler;
 using namespace kepler::gl;
@@ -38,3 +41,31 @@ TEST(shader, fragment) {
     other.destroy();
     EXPECT_FALSE(static_cast<bool>(other));
 }
+
+TEST(effect, sampler_texture_units) {
+    // The base color array of the basic material next to the light buffers of clustered lighting.
+    const std::string vert =
+        "#version 330 core\n"
+        "void main() { gl_Position = vec4(0.0); }\n";
+    const std::string frag =
+        "#version 330 core\n"
+        "uniform sampler2DArray s_baseMaps;\n"
+        "uniform samplerBuffer s_lights;\n"
+        "uniform usamplerBuffer s_lightIndices;\n"
+        "uniform sampler2DShadow s_shadowMap;\n"
+        "out vec4 color;\n"
+        "void main() {\n"
+        "    color = texture(s_baseMaps, vec3(0.0)) + texelFetch(s_lights, 0) + vec4(texelFetch(s_lightIndices, 0))\n"
+        "        + vec4(texture(s_shadowMap, vec3(0.0)));\n"
+        "}\n";
+    auto effect = Effect::createFromSource(vert, frag);
+    ASSERT_NE(nullptr, effect);
+    const char* names[] = {"s_baseMaps", "s_lights", "s_lightIndices", "s_shadowMap"};
+    std::set<unsigned int> units;
+    for (const char* name : names) {
+        const Uniform* uniform = effect->uniform(name);
+        ASSERT_NE(nullptr, uniform) << name;
+        units.insert(uniform->textureUnit());
+    }
+    EXPECT_EQ(4u, units.size());
+}
@@ -0,0 +1,84 @@
+#include "common_test.hpp"
+
+#include <lib64.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+static std::string encode(const std::vector<uint8_t>& bytes) {
+    static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string text;
+    size_t i = 0;
+    for (; i + 3 <= bytes.size(); i += 3) {
+        const uint32_t bits = bytes[i] << 16 | bytes[i + 1] << 8 | bytes[i + 2];
+        text += alphabet[bits >> 18 & 63];
+        text += alphabet[bits >> 12 & 63];
+        text += alphabet[bits >> 6 & 63];
+        text += alphabet[bits & 63];
+    }
+    if (bytes.size() - i == 1) {
+        const uint32_t bits = bytes[i] << 16;
+        text += alphabet[bits >> 18 & 63];
+        text += alphabet[bits >> 12 & 63];
+        text += "==";
+    }
+    else if (bytes.size() - i == 2) {
+        const uint32_t bits = bytes[i] << 16 | bytes[i + 1] << 8;
+        text += alphabet[bits >> 18 & 63];
+        text += alphabet[bits >> 12 & 63];
+        text += alphabet[bits >> 6 & 63];
+        text += '=';
+    }
+    return text;
+}
+
+static std::vector<uint8_t> randomBytes(size_t count, unsigned int seed) {
+    std::mt19937 random(seed);
+    std::vector<uint8_t> bytes(count);
+    for (auto& b : bytes) {
+        b = static_cast<uint8_t>(random());
+    }
+    return bytes;
+}
+
+static std::vector<uint8_t> decode(const std::string& text) {
+    std::vector<uint8_t> bytes(lib64::decoded_size(text.size()));
+    bytes.resize(lib64::decode(text.data(), text.size(), bytes.data()));
+    return bytes;
+}
+
+/// Decodes with the libb64 state machine that the loader used before.
+static std::vector<uint8_t> decodeLibb64(const std::string& text) {
+    std::vector<uint8_t> bytes(lib64::decoded_size(text.size()) + 1);
+    lib64::decoder decoder;
+    lib64::base64_init_decodestate(&decoder._state);
+    const int length = decoder.decode(text.data(), static_cast<int>(text.size()), reinterpret_cast<char*>(bytes.data()));
+    bytes.resize(length);
+    return bytes;
+}
+
+TEST(base64, decode) {
+    EXPECT_EQ(std::vector<uint8_t>(), decode(""));
+    const std::string hello = "Hello, World";
+    EXPECT_EQ(std::vector<uint8_t>(hello.begin(), hello.end()), decode("SGVsbG8sIFdvcmxk"));
+    const std::string padded = "Hello";
+    EXPECT_EQ(std::vector<uint8_t>(padded.begin(), padded.end()), decode("SGVsbG8="));
+
+    // Every length around the 16 and 32 character blocks of the vector paths.
+    for (size_t count = 0; count < 200; ++count) {
+        const auto bytes = randomBytes(count, static_cast<unsigned int>(count));
+        EXPECT_EQ(bytes, decode(encode(bytes))) << count;
+    }
+}
+
+TEST(base64, skips_invalid_characters) {
+    const auto bytes = randomBytes(1000, 7);
+    std::string text = encode(bytes);
+    // Line breaks and junk in the middle of a vector block.
+    text.insert(500, "\r\n");
+    text.insert(100, " \x80");
+    text.insert(20, "#");
+    EXPECT_EQ(bytes, decode(text));
+    EXPECT_EQ(decodeLibb64(text), decode(text));
+}
@@ -0,0 +1,187 @@
+#include "common_test.hpp"
+
+#include <CookedFormat.hpp>
+#include <OpenGL.hpp>
+
+#include <cstring>
+
+using namespace kepler;
+
+static cooked::SceneData createCookedScene() {
+    cooked::SceneData scene;
+    const float vertices[] = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+    const uint16_t indices[] = {0, 1, 2};
+    const uint8_t pixels[] = {255, 0, 0, 255};
+
+    cooked::Buffer vbo = {};
+    vbo.target = GL_ARRAY_BUFFER;
+    vbo.size = sizeof(vertices);
+    vbo.offset = scene.addData(vertices, sizeof(vertices));
+    scene.buffers.push_back(vbo);
+    cooked::Buffer ibo = {};
+    ibo.target = GL_ELEMENT_ARRAY_BUFFER;
+    ibo.size = sizeof(indices);
+    ibo.offset = scene.addData(indices, sizeof(indices));
+    scene.buffers.push_back(ibo);
+
+    cooked::Level level = {};
+    level.size = sizeof(pixels);
+    level.offset = scene.addData(pixels, sizeof(pixels));
+    scene.levels.push_back(level);
+    cooked::Texture texture = {};
+    texture.target = GL_TEXTURE_2D;
+    texture.internalFormat = GL_RGBA8;
+    texture.width = 1;
+    texture.height = 1;
+    texture.depth = 1;
+    texture.levelCount = 1;
+    scene.textures.push_back(texture);
+
+    cooked::Material material = {};
+    material.baseMap = 0;
+    material.baseMapLayer = -1;
+    material.name = scene.addString("red");
+    scene.materials.push_back(material);
+
+    cooked::Attribute attribute = {};
+    attribute.buffer = 0;
+    attribute.componentSize = 3;
+    attribute.type = GL_FLOAT;
+    attribute.count = 3;
+    scene.attributes.push_back(attribute);
+
+    cooked::Primitive prim = {};
+    prim.attributeCount = 1;
+    prim.material = 0;
+    prim.indexBuffer = 1;
+    prim.indexType = GL_UNSIGNED_SHORT;
+    prim.indexCount = 3;
+    scene.primitives.push_back(prim);
+
+    cooked::Mesh mesh = {};
+    mesh.primitiveCount = 1;
+    mesh.name = scene.addString("triangle");
+    scene.meshes.push_back(mesh);
+
+    cooked::Node root = {};
+    root.parent = cooked::NONE;
+    root.mesh = cooked::NONE;
+    root.name = scene.addString("root");
+    scene.nodes.push_back(root);
+    cooked::Node child = {};
+    child.parent = 0;
+    child.mesh = 0;
+    scene.nodes.push_back(child);
+    return scene;
+}
+
+TEST(cookedFormat, round_trip) {
+    std::vector<uint8_t> file;
+    cooked::write(createCookedScene(), file);
+    EXPECT_EQ(0u, file.size() % cooked::ALIGNMENT);
+    EXPECT_TRUE(cooked::isCooked(file.data(), file.size()));
+
+    cooked::SceneView view;
+    ASSERT_TRUE(cooked::read(ByteSpan(file.data(), file.size()), view));
+    EXPECT_EQ(2u, view.nodeCount);
+    EXPECT_EQ(1u, view.meshCount);
+    EXPECT_EQ(2u, view.bufferCount);
+    EXPECT_STREQ("root", view.string(view.nodes[0].name));
+    EXPECT_STREQ("", view.string(view.nodes[1].name));
+    EXPECT_STREQ("triangle", view.string(view.meshes[0].name));
+    EXPECT_EQ(0u, view.nodes[1].parent);
+
+    // Every table and blob is aligned so it can be used in place.
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(view.primitives) % cooked::ALIGNMENT);
+    EXPECT_EQ(0u, view.buffers[1].offset % cooked::ALIGNMENT);
+    ByteSpan indices = view.bytes(view.buffers[1].offset, view.buffers[1].size);
+    ASSERT_EQ(6u, indices.size);
+    EXPECT_EQ(2u, reinterpret_cast<const uint16_t*>(indices.data)[2]);
+    ByteSpan pixels = view.bytes(view.levels[0].offset, view.levels[0].size);
+    ASSERT_EQ(4u, pixels.size);
+    EXPECT_EQ(255u, pixels.data[0]);
+}
+
+TEST(cookedFormat, rejects_invalid_files) {
+    std::vector<uint8_t> file;
+    cooked::write(createCookedScene(), file);
+    cooked::SceneView view;
+
+    std::vector<uint8_t> truncated(file.begin(), file.end() - cooked::ALIGNMENT);
+    EXPECT_FALSE(cooked::read(ByteSpan(truncated.data(), truncated.size()), view));
+
+    std::vector<uint8_t> magic = file;
+    magic[1] = 'X';
+    EXPECT_FALSE(cooked::read(ByteSpan(magic.data(), magic.size()), view));
+
+    // A child that comes before its parent.
+    auto scene = createCookedScene();
+    scene.nodes[0].parent = 1;
+    cooked::write(scene, file);
+    EXPECT_FALSE(cooked::read(ByteSpan(file.data(), file.size()), view));
+
+    // A buffer that goes past the end of the data.
+    scene = createCookedScene();
+    scene.buffers[0].size = scene.data.size() + 1;
+    cooked::write(scene, file);
+    EXPECT_FALSE(cooked::read(ByteSpan(file.data(), file.size()), view));
+
+    scene = createCookedScene();
+    scene.materials[0].baseMap = 5;
+    cooked::write(scene, file);
+    EXPECT_FALSE(cooked::read(ByteSpan(file.data(), file.size()), view));
+}
+
+TEST(cookedFormat, rejects_out_of_range_attributes_and_indices) {
+    std::vector<uint8_t> file;
+    cooked::SceneView view;
+
+    // Three vec3 floats from an offset of 4 bytes end past the 36 bytes of the buffer.
+    auto scene = createCookedScene();
+    scene.attributes[0].offset = 4;
+    cooked::write(scene, file);
+    EXPECT_FALSE(cooked::read(ByteSpan(file.data(), file.size()), view));
+
+    scene = createCookedScene();
+    scene.attributes[0].stride = 16;
+    cooked::write(scene, file);
+    EXPECT_FALSE(cooked::read(ByteSpan(file.data(), file.size()), view));
+
+    // The fourth index is past the end of the index buffer.
+    scene = createCookedScene();
+    scene.primitives[0].indexCount = 4;
+    cooked::write(scene, file);
+    EXPECT_FALSE(cooked::read(ByteSpan(file.data(), file.size()), view));
+
+    // An index that refers to a vertex the attributes don't have.
+    scene = createCookedScene();
+    reinterpret_cast<uint16_t*>(scene.data.data() + scene.buffers[1].offset)[2] = 3;
+    cooked::write(scene, file);
+    EXPECT_FALSE(cooked::read(ByteSpan(file.data(), file.size()), view));
+}
+
+TEST(cookedFormat, rejects_levels_of_the_wrong_size) {
+    std::vector<uint8_t> file;
+    cooked::SceneView view;
+
+    // A 2x2 RGBA8 level needs 16 bytes but the level only has the 4 bytes of a 1x1 level.
+    auto scene = createCookedScene();
+    scene.textures[0].width = 2;
+    scene.textures[0].height = 2;
+    cooked::write(scene, file);
+    EXPECT_FALSE(cooked::read(ByteSpan(file.data(), file.size()), view));
+
+    // Even a 1x1 level of BC7 is a whole 16 byte block.
+    scene = createCookedScene();
+    scene.textures[0].flags = cooked::Texture::COMPRESSED;
+    scene.textures[0].internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+    cooked::write(scene, file);
+    EXPECT_FALSE(cooked::read(ByteSpan(file.data(), file.size()), view));
+
+    // More levels than the mip chain of a 1x1 texture.
+    scene = createCookedScene();
+    scene.levels.push_back(scene.levels[0]);
+    scene.textures[0].levelCount = 2;
+    cooked::write(scene, file);
+    EXPECT_FALSE(cooked::read(ByteSpan(file.data(), file.size()), view));
+}
@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 
 #include <FileSystem.hpp>
+#include <MappedFile.hpp>
 
 using namespace kepler;
 
@@ -26,6 +27,19 @@ TEST(filesystem, joinPath) {
     EXPECT_EQ(joinPath(directoryName("res/box.gltf"), "image.png"), "res/image.png");
 }
 
+TEST(filesystem, canonicalPath) {
+    EXPECT_EQ(canonicalPath(""), "");
+    EXPECT_EQ(canonicalPath("res/./textures/../image.png"), canonicalPath("res/image.png"));
+    EXPECT_EQ(canonicalPath("res//image.png"), canonicalPath("res/image.png"));
+    EXPECT_EQ(canonicalPath("res\\image.png"), canonicalPath("res/image.png"));
+
+    constexpr char* path = "canonical.txt";
+    writeTextFile(path, "text");
+    EXPECT_EQ(canonicalPath("./canonical.txt"), canonicalPath(path));
+    EXPECT_NE(canonicalPath(path), path);
+    remove(path);
+}
+
 TEST(filesystem, fileExists) {
     constexpr char* path = "test.txt";
     remove(path);
@@ -67,3 +81,25 @@ TEST(filesystem, read_write_text_file) {
     EXPECT_EQ(out, in);
     remove(path);
 }
+
+TEST(filesystem, mapped_file) {
+    std::vector<unsigned char> out;
+    for (unsigned char i = 0; i < 0xFF; ++i) {
+        out.push_back(i);
+    }
+    writeBinaryFile(TEST_PATH, out);
+    {
+        auto file = MappedFile::open(TEST_PATH);
+        ASSERT_NE(file, nullptr);
+        ASSERT_EQ(out.size(), file->size());
+        EXPECT_TRUE(std::equal(out.begin(), out.end(), file->data()));
+
+        ByteSpan span = file->span().subspan(16, 4);
+        ASSERT_EQ(4u, span.size);
+        EXPECT_EQ(16, span.data[0]);
+        EXPECT_TRUE(file->span().subspan(250, 10).empty());
+        EXPECT_EQ(0xFFu, file->span().subspan(0, 0xFF).size);
+    }
+    remove(TEST_PATH);
+    EXPECT_EQ(MappedFile::open("file_that_does_not_exist.bin"), nullptr);
+}
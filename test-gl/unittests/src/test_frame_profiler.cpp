@@ -0,0 +1,52 @@
+#include "common_test.hpp"
+
+#include <Performance.hpp>
+
+using namespace kepler;
+
+TEST(frameProfiler, cpu_and_gpu) {
+    FrameProfiler::clear();
+    EXPECT_EQ(0u, FrameProfiler::frame(0).number);
+
+    FrameProfiler::beginFrame();
+    FrameProfiler::addCpuTime("render", 2.0);
+    FrameProfiler::addCpuTime("render", 1.0);
+    FrameProfiler::addCpuTime("update", 0.5);
+    const uint64_t first = FrameProfiler::frameNumber();
+    EXPECT_EQ(1u, first);
+
+    FrameProfiler::beginFrame();
+    FrameProfiler::beginFrame();
+    // GPU results arrive a few frames later.
+    FrameProfiler::addGpuTime(first, "render", 4.0);
+
+    auto frame = FrameProfiler::frame(2);
+    ASSERT_EQ(first, frame.number);
+    ASSERT_EQ(2u, frame.scopes.size());
+    EXPECT_EQ("render", frame.scopes[0].name);
+    EXPECT_DOUBLE_EQ(3.0, frame.scopes[0].cpuMs);
+    EXPECT_EQ(2u, frame.scopes[0].cpuCount);
+    EXPECT_DOUBLE_EQ(4.0, frame.scopes[0].gpuMs);
+    EXPECT_EQ(1u, frame.scopes[0].gpuCount);
+    EXPECT_EQ(0u, frame.scopes[1].gpuCount);
+
+    EXPECT_TRUE(FrameProfiler::frame(0).scopes.empty());
+}
+
+TEST(frameProfiler, history) {
+    FrameProfiler::clear();
+    FrameProfiler::beginFrame();
+    const uint64_t first = FrameProfiler::frameNumber();
+    for (size_t i = 0; i < FrameProfiler::HISTORY; ++i) {
+        FrameProfiler::beginFrame();
+    }
+    // The first frame was overwritten so its results are dropped.
+    FrameProfiler::addGpuTime(first, "render", 1.0);
+    FrameProfiler::addGpuTime(first + 100, "render", 1.0);
+    for (size_t i = 0; i < FrameProfiler::HISTORY; ++i) {
+        auto frame = FrameProfiler::frame(i);
+        EXPECT_EQ(FrameProfiler::frameNumber() - i, frame.number);
+        EXPECT_TRUE(frame.scopes.empty());
+    }
+    EXPECT_EQ(0u, FrameProfiler::frame(FrameProfiler::HISTORY).number);
+}
@@ -0,0 +1,35 @@
+#include "common_test.hpp"
+
+#include <GLStats.hpp>
+
+using namespace kepler;
+using namespace kepler::gl;
+
+TEST(glStats, counts) {
+    GLStats::setEnabled(false);
+    GLStats::beginFrame();
+    GLStats::count(GLStats::Category::DRAW_CALLS);
+    EXPECT_EQ(0u, GLStats::currentFrame()[GLStats::Category::DRAW_CALLS]);
+
+    GLStats::setEnabled(true);
+    GLStats::beginFrame();
+    GLStats::count(GLStats::Category::DRAW_CALLS);
+    GLStats::count(GLStats::Category::DRAW_CALLS);
+    GLStats::count(GLStats::Category::UNIFORM_UPLOADS);
+    EXPECT_EQ(2u, GLStats::currentFrame()[GLStats::Category::DRAW_CALLS]);
+
+    const uint64_t number = GLStats::currentFrame().number;
+    GLStats::beginFrame();
+    const auto& last = GLStats::lastFrame();
+    EXPECT_EQ(number, last.number);
+    EXPECT_EQ(2u, last[GLStats::Category::DRAW_CALLS]);
+    EXPECT_EQ(1u, last[GLStats::Category::UNIFORM_UPLOADS]);
+    EXPECT_EQ(0u, last[GLStats::Category::STATE_CHANGES]);
+    EXPECT_EQ(0u, GLStats::currentFrame()[GLStats::Category::DRAW_CALLS]);
+    GLStats::setEnabled(false);
+}
+
+TEST(glStats, category_names) {
+    EXPECT_STREQ("draw_calls", GLStats::categoryName(GLStats::Category::DRAW_CALLS));
+    EXPECT_STREQ("state_changes", GLStats::categoryName(GLStats::Category::STATE_CHANGES));
+}
@@ -0,0 +1,116 @@
+#include "common_test.hpp"
+
+#include <LightClusters.hpp>
+#include <BaseMath.hpp>
+
+#include <algorithm>
+#include <random>
+
+using namespace kepler;
+
+static constexpr float NEAR = 0.1f;
+static constexpr float FAR = 100.f;
+
+static std::vector<PointLight> randomLights(size_t count) {
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> xy(-40.f, 40.f);
+    std::uniform_real_distribution<float> z(-110.f, 5.f);
+    std::uniform_real_distribution<float> range(0.5f, 8.f);
+    std::vector<PointLight> lights(count);
+    for (auto& light : lights) {
+        light.position = vec3(xy(random), xy(random), z(random));
+        light.range = range(random);
+    }
+    return lights;
+}
+
+static bool clusterHasLight(const LightClusters& clusters, size_t cluster, uint32_t light) {
+    const auto& c = clusters.clusters();
+    const auto& indices = clusters.lightIndices();
+    auto begin = indices.begin() + c[cluster * 2];
+    auto end = begin + c[cluster * 2 + 1];
+    return std::find(begin, end, light) != end;
+}
+
+TEST(lightClusters, singleLight) {
+    mat4 view = glm::lookAt(vec3(0.f), vec3(0.f, 0.f, -1.f), vec3(0.f, 1.f, 0.f));
+    mat4 projection = glm::perspective(glm::radians(60.f), 16.f / 9.f, NEAR, FAR);
+    PointLight light;
+    light.position = vec3(0.f, 0.f, -10.f);
+    light.range = 1.f;
+
+    auto clusters = LightClusters::create(16, 9, 24);
+    clusters->update(&light, 1, view, projection, NEAR, FAR);
+    EXPECT_EQ(1u, clusters->lightCount());
+    EXPECT_EQ(16u * 9u * 24u * 2u, clusters->clusters().size());
+
+    const int slice = clusters->slice(10.f);
+    EXPECT_TRUE(clusterHasLight(*clusters, clusters->clusterIndex(8, 4, slice), 0));
+    EXPECT_FALSE(clusterHasLight(*clusters, clusters->clusterIndex(0, 0, slice), 0));
+    EXPECT_FALSE(clusterHasLight(*clusters, clusters->clusterIndex(8, 4, 0), 0));
+    EXPECT_FALSE(clusterHasLight(*clusters, clusters->clusterIndex(8, 4, 23), 0));
+    // only a small part of the grid is touched
+    EXPECT_LT(clusters->lightIndices().size(), 40u);
+
+    EXPECT_EQ(0, clusters->slice(NEAR));
+    EXPECT_EQ(23, clusters->slice(FAR));
+    EXPECT_EQ(0, clusters->slice(0.f));
+}
+
+TEST(lightClusters, conservative) {
+    // Every point lit by a light must be in a cluster that lists the light.
+    mat4 view = glm::lookAt(vec3(1.f, 2.f, 3.f), vec3(0.f, 0.f, -20.f), vec3(0.f, 1.f, 0.f));
+    mat4 projection = glm::perspective(glm::radians(60.f), 16.f / 9.f, NEAR, FAR);
+    auto lights = randomLights(300);
+    auto clusters = LightClusters::create(16, 9, 24);
+    clusters->update(lights.data(), lights.size(), view, projection, NEAR, FAR);
+
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    size_t checked = 0;
+    for (size_t i = 0; i < lights.size(); ++i) {
+        for (int k = 0; k < 20; ++k) {
+            vec3 p = lights[i].position + vec3(unit(random), unit(random), unit(random)) * (lights[i].range * 0.57f);
+            vec4 clip = projection * view * vec4(p, 1.f);
+            if (clip.w <= NEAR || clip.w >= FAR || std::abs(clip.x) >= clip.w || std::abs(clip.y) >= clip.w) {
+                continue;
+            }
+            int tx = std::min(static_cast<int>((clip.x / clip.w + 1.f) * 0.5f * 16.f), 15);
+            int ty = std::min(static_cast<int>((clip.y / clip.w + 1.f) * 0.5f * 9.f), 8);
+            size_t cluster = clusters->clusterIndex(tx, ty, clusters->slice(clip.w));
+            EXPECT_TRUE(clusterHasLight(*clusters, cluster, static_cast<uint32_t>(i)));
+            ++checked;
+        }
+    }
+    EXPECT_GT(checked, 100u);
+}
+
+TEST(lightClusters, threadsAndSimdMatch) {
+    mat4 view = glm::lookAt(vec3(0.f), vec3(0.f, 0.f, -1.f), vec3(0.f, 1.f, 0.f));
+    mat4 projection = glm::perspective(glm::radians(70.f), 1.5f, NEAR, FAR);
+    auto lights = randomLights(1000);
+
+    auto reference = LightClusters::create();
+    reference->setThreadCount(1);
+    reference->setSimdEnabled(false);
+    reference->update(lights.data(), lights.size(), view, projection, NEAR, FAR);
+
+    auto clusters = LightClusters::create();
+    clusters->setThreadCount(4);
+    clusters->update(lights.data(), lights.size(), view, projection, NEAR, FAR);
+    EXPECT_EQ(reference->clusters(), clusters->clusters());
+    EXPECT_EQ(reference->lightIndices(), clusters->lightIndices());
+}
+
+TEST(lightClusters, orthographic) {
+    mat4 view = glm::lookAt(vec3(0.f), vec3(0.f, 0.f, -1.f), vec3(0.f, 1.f, 0.f));
+    mat4 projection = glm::ortho(-10.f, 10.f, -10.f, 10.f, NEAR, FAR);
+    PointLight light;
+    light.position = vec3(-9.f, 9.f, -50.f);
+    light.range = 0.5f;
+    auto clusters = LightClusters::create(10, 10, 10);
+    clusters->update(&light, 1, view, projection, NEAR, FAR);
+    EXPECT_TRUE(clusters->linearSlices());
+    EXPECT_TRUE(clusterHasLight(*clusters, clusters->clusterIndex(0, 9, clusters->slice(50.f)), 0));
+    EXPECT_FALSE(clusterHasLight(*clusters, clusters->clusterIndex(9, 0, clusters->slice(50.f)), 0));
+}
@@ -0,0 +1,96 @@
+#include "common_test.hpp"
+
+#include <MeshOptimizer.hpp>
+#include <BaseMath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+using namespace kepler;
+
+/// Creates a grid of quads in the xy plane with the triangles in a random order.
+static void createShuffledGrid(int size, std::vector<vec3>& positions, std::vector<uint32_t>& indices) {
+    for (int y = 0; y <= size; ++y) {
+        for (int x = 0; x <= size; ++x) {
+            positions.emplace_back(static_cast<float>(x), static_cast<float>(y), 0.f);
+        }
+    }
+    std::vector<std::array<uint32_t, 3>> triangles;
+    const uint32_t row = size + 1;
+    for (uint32_t y = 0; y < static_cast<uint32_t>(size); ++y) {
+        for (uint32_t x = 0; x < static_cast<uint32_t>(size); ++x) {
+            uint32_t i = y * row + x;
+            triangles.push_back({i, i + 1, i + row + 1});
+            triangles.push_back({i, i + row + 1, i + row});
+        }
+    }
+    std::mt19937 random(7);
+    std::shuffle(triangles.begin(), triangles.end(), random);
+    for (const auto& t : triangles) {
+        indices.insert(indices.end(), t.begin(), t.end());
+    }
+}
+
+/// Returns the triangles sorted so that two index buffers can be compared regardless of the order.
+static std::vector<std::array<uint32_t, 3>> sortedTriangles(const std::vector<uint32_t>& indices) {
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        std::array<uint32_t, 3> t = {indices[i], indices[i + 1], indices[i + 2]};
+        // rotate so the winding is kept
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        triangles.push_back(t);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+TEST(meshOptimizer, analyzeVertexCache) {
+    const std::vector<uint32_t> indices = {0, 1, 2, 2, 1, 3};
+    auto stats = analyzeVertexCache(indices.data(), indices.size(), 4);
+    EXPECT_FLOAT_EQ(2.f, stats.acmr);
+    EXPECT_FLOAT_EQ(1.f, stats.atvr);
+}
+
+TEST(meshOptimizer, vertexCache) {
+    std::vector<vec3> positions;
+    std::vector<uint32_t> indices;
+    createShuffledGrid(32, positions, indices);
+    auto before = analyzeVertexCache(indices.data(), indices.size(), positions.size());
+    std::vector<uint32_t> clusters;
+    auto result = optimizeVertexCache(indices.data(), indices.size(), positions.size(), 16, &clusters);
+    auto after = analyzeVertexCache(result.data(), result.size(), positions.size());
+    EXPECT_EQ(sortedTriangles(indices), sortedTriangles(result));
+    EXPECT_LT(after.acmr, before.acmr * 0.5f);
+    EXPECT_LT(after.atvr, before.atvr);
+    ASSERT_FALSE(clusters.empty());
+    EXPECT_EQ(0, clusters[0]);
+    EXPECT_TRUE(std::is_sorted(clusters.begin(), clusters.end()));
+}
+
+TEST(meshOptimizer, overdraw) {
+    std::vector<vec3> positions;
+    std::vector<uint32_t> indices;
+    createShuffledGrid(16, positions, indices);
+    std::vector<uint32_t> clusters;
+    auto cacheOptimized = optimizeVertexCache(indices.data(), indices.size(), positions.size(), 16, &clusters);
+    auto result = optimizeOverdraw(cacheOptimized.data(), cacheOptimized.size(), &positions[0].x, positions.size(), 0, clusters, 1.05f);
+    EXPECT_EQ(sortedTriangles(indices), sortedTriangles(result));
+    float before = analyzeVertexCache(cacheOptimized.data(), cacheOptimized.size(), positions.size()).acmr;
+    float after = analyzeVertexCache(result.data(), result.size(), positions.size()).acmr;
+    EXPECT_LE(after, before * 1.05f);
+}
+
+TEST(meshOptimizer, vertexFetch) {
+    const std::vector<float> vertices = {0.f, 1.f, 2.f, 3.f, 4.f};
+    std::vector<uint32_t> indices = {4, 2, 0, 0, 2, 1};
+    size_t uniqueCount = 0;
+    auto remap = optimizeVertexFetch(indices.data(), indices.size(), vertices.size(), uniqueCount);
+    EXPECT_EQ(4, uniqueCount);
+    EXPECT_EQ((std::vector<uint32_t>{0, 1, 2, 2, 1, 3}), indices);
+    EXPECT_EQ(UINT32_MAX, remap[3]);
+
+    std::vector<float> result(uniqueCount);
+    remapVertices(result.data(), vertices.data(), vertices.size(), sizeof(float), 0, remap);
+    EXPECT_EQ((std::vector<float>{4.f, 2.f, 0.f, 1.f}), result);
+}
@@ -0,0 +1,179 @@
+#include "common_test.hpp"
+
+#include <MeshSimplifier.hpp>
+#include <LodSelector.hpp>
+#include <BaseMath.hpp>
+
+using namespace kepler;
+
+/// Creates a flat grid of quads in the xy plane.
+static void createGrid(int size, std::vector<vec3>& positions, std::vector<uint32_t>& indices) {
+    for (int y = 0; y <= size; ++y) {
+        for (int x = 0; x <= size; ++x) {
+            positions.emplace_back(static_cast<float>(x), static_cast<float>(y), 0.f);
+        }
+    }
+    const uint32_t row = size + 1;
+    for (uint32_t y = 0; y < static_cast<uint32_t>(size); ++y) {
+        for (uint32_t x = 0; x < static_cast<uint32_t>(size); ++x) {
+            uint32_t i = y * row + x;
+            indices.insert(indices.end(), {i, i + 1, i + row + 1, i, i + row + 1, i + row});
+        }
+    }
+}
+
+/// Creates a UV sphere without seams.
+static void createSphere(int rings, int segments, std::vector<vec3>& positions, std::vector<uint32_t>& indices) {
+    const float pi = glm::pi<float>();
+    positions.emplace_back(0.f, 1.f, 0.f);
+    for (int r = 1; r < rings; ++r) {
+        float phi = pi * r / rings;
+        for (int s = 0; s < segments; ++s) {
+            float theta = 2.f * pi * s / segments;
+            positions.emplace_back(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+        }
+    }
+    positions.emplace_back(0.f, -1.f, 0.f);
+    const uint32_t bottom = static_cast<uint32_t>(positions.size() - 1);
+    auto ring = [segments](int r, int s) { return static_cast<uint32_t>(1 + (r - 1) * segments + (s % segments)); };
+    for (int s = 0; s < segments; ++s) {
+        indices.insert(indices.end(), {0, ring(1, s + 1), ring(1, s)});
+        indices.insert(indices.end(), {bottom, ring(rings - 1, s), ring(rings - 1, s + 1)});
+    }
+    for (int r = 1; r < rings - 1; ++r) {
+        for (int s = 0; s < segments; ++s) {
+            indices.insert(indices.end(), {ring(r, s), ring(r, s + 1), ring(r + 1, s + 1)});
+            indices.insert(indices.end(), {ring(r, s), ring(r + 1, s + 1), ring(r + 1, s)});
+        }
+    }
+}
+
+TEST(meshSimplifier, flatGrid) {
+    std::vector<vec3> positions;
+    std::vector<uint32_t> indices;
+    createGrid(8, positions, indices);
+    float error = 1.f;
+    auto result = simplifyMesh(&positions[0].x, positions.size(), 0, indices.data(), indices.size(), 0, 0.001f, &error);
+    // A flat grid collapses down to the 2 triangles of its corners without any error.
+    EXPECT_EQ(6, result.size());
+    EXPECT_NEAR(0.f, error, 1e-4f);
+    for (uint32_t index : result) {
+        const vec3& p = positions[index];
+        EXPECT_TRUE((p.x == 0.f || p.x == 8.f) && (p.y == 0.f || p.y == 8.f));
+    }
+}
+
+TEST(meshSimplifier, targetIndexCount) {
+    std::vector<vec3> positions;
+    std::vector<uint32_t> indices;
+    createSphere(16, 24, positions, indices);
+    const size_t target = indices.size() / 4;
+    float error = 0.f;
+    auto result = simplifyMesh(&positions[0].x, positions.size(), sizeof(vec3), indices.data(), indices.size(), target, 1.f, &error);
+    EXPECT_LE(result.size(), target);
+    EXPECT_GT(result.size(), target / 2);
+    EXPECT_EQ(0, result.size() % 3);
+    EXPECT_GT(error, 0.f);
+    for (uint32_t index : result) {
+        EXPECT_LT(index, positions.size());
+    }
+}
+
+TEST(meshSimplifier, targetError) {
+    std::vector<vec3> positions;
+    std::vector<uint32_t> indices;
+    createSphere(16, 24, positions, indices);
+    float error = 1.f;
+    auto result = simplifyMesh(&positions[0].x, positions.size(), 0, indices.data(), indices.size(), 0, 0.f, &error);
+    // A curved surface can't be simplified without some error.
+    EXPECT_EQ(indices.size(), result.size());
+    EXPECT_EQ(0.f, error);
+}
+
+TEST(meshSimplifier, seamsAreLocked) {
+    std::vector<vec3> positions;
+    std::vector<uint32_t> indices;
+    createGrid(4, positions, indices);
+    // Split the middle column of vertices like a UV seam.
+    const size_t originalCount = positions.size();
+    for (size_t i = 0; i < originalCount; ++i) {
+        if (positions[i].x == 2.f) {
+            positions.push_back(positions[i]);
+        }
+    }
+    for (size_t t = 0; t < indices.size(); t += 3) {
+        float centerX = (positions[indices[t]].x + positions[indices[t + 1]].x + positions[indices[t + 2]].x) / 3.f;
+        if (centerX > 2.f) {
+            for (size_t k = 0; k < 3; ++k) {
+                uint32_t& index = indices[t + k];
+                if (positions[index].x == 2.f) {
+                    index = static_cast<uint32_t>(originalCount + static_cast<uint32_t>(positions[index].y));
+                }
+            }
+        }
+    }
+    auto result = simplifyMesh(&positions[0].x, positions.size(), 0, indices.data(), indices.size(), 0, 0.01f);
+    size_t seamVertices = 0;
+    for (uint32_t index : result) {
+        if (index >= originalCount) {
+            ++seamVertices;
+        }
+    }
+    EXPECT_GT(seamVertices, 0);
+    EXPECT_LT(result.size(), indices.size());
+}
+
+TEST(meshSimplifier, generateLods) {
+    std::vector<vec3> positions;
+    std::vector<uint32_t> indices;
+    createSphere(16, 24, positions, indices);
+    auto lods = generateLods(&positions[0].x, positions.size(), 0, indices.data(), indices.size(), 4, 0.5f, 0.5f);
+    ASSERT_EQ(4, lods.size());
+    size_t previousCount = indices.size();
+    float previousError = 0.f;
+    for (const auto& lod : lods) {
+        EXPECT_LT(lod.indices.size(), previousCount);
+        EXPECT_GE(lod.error, previousError);
+        previousCount = lod.indices.size();
+        previousError = lod.error;
+    }
+}
+
+TEST(lodSelector, screenSize) {
+    mat4 view = glm::lookAt(vec3(0, 0, 10), vec3(0), vec3(0, 1, 0));
+    mat4 projection = glm::perspective(glm::radians(90.f), 1.f, 0.1f, 100.f);
+    BoundingBox box(vec3(-1), vec3(1));
+    float radius = glm::length(vec3(1));
+    EXPECT_NEAR(radius / 10.f, LodSelector::screenSize(box, view, projection), 1e-4f);
+    // farther away is smaller
+    BoundingBox far(vec3(-1, -1, -21), vec3(1, 1, -19));
+    EXPECT_NEAR(radius / 30.f, LodSelector::screenSize(far, view, projection), 1e-4f);
+    // inside the sphere
+    BoundingBox around(vec3(-20), vec3(20));
+    EXPECT_GT(LodSelector::screenSize(around, view, projection), 1.f);
+}
+
+TEST(lodSelector, hysteresis) {
+    const float thresholds[] = {0.5f, 0.25f, 0.1f};
+    LodSelector selector;
+    selector.setHysteresis(0.1f);
+    EXPECT_EQ(0, selector.select(1.f, thresholds, 3));
+    EXPECT_EQ(1, selector.select(0.4f, thresholds, 3));
+    // Just above the threshold doesn't switch back.
+    EXPECT_EQ(1, selector.select(0.52f, thresholds, 3));
+    EXPECT_EQ(0, selector.select(0.56f, thresholds, 3));
+    // Just below the threshold doesn't switch.
+    EXPECT_EQ(0, selector.select(0.48f, thresholds, 3));
+    EXPECT_EQ(3, selector.select(0.01f, thresholds, 3));
+    EXPECT_EQ(3, selector.level());
+    selector.reset();
+    EXPECT_EQ(2, selector.select(0.2f, thresholds, 3));
+}
+
+TEST(lodSelector, screenSizeFromCoverage) {
+    // A sphere half as tall as a square viewport covers pi / 16 of it.
+    EXPECT_NEAR(0.5f, LodSelector::screenSizeFromCoverage(PI / 16.f), 1e-5f);
+    // The same area of a wider viewport is more pixels.
+    EXPECT_NEAR(1.0f, LodSelector::screenSizeFromCoverage(PI / 16.f, 4.f), 1e-5f);
+    EXPECT_EQ(0.f, LodSelector::screenSizeFromCoverage(0.f));
+}
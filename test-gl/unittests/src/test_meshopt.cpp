@@ -0,0 +1,339 @@
+#include "common_test.hpp"
+
+#include <MeshoptDecoder.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace kepler;
+
+// Minimal encoders for the streams of EXT_meshopt_compression. They don't try to compress well but use every
+// kind of code the decoders have to handle.
+
+static uint8_t zigzag8(uint8_t v) {
+    return static_cast<uint8_t>(((int8_t)v >> 7) ^ (v << 1));
+}
+
+static void encodeVByte(std::vector<uint8_t>& out, uint32_t v) {
+    do {
+        out.push_back(static_cast<uint8_t>((v & 127) | (v > 127 ? 128 : 0)));
+        v >>= 7;
+    } while (v != 0);
+}
+
+static uint32_t zigzag32(uint32_t delta) {
+    return (delta << 1) ^ (0u - (delta >> 31));
+}
+
+static void encodeBytesGroup(std::vector<uint8_t>& out, const uint8_t* values, int bitsLog2) {
+    if (bitsLog2 == 0) {
+        return;
+    }
+    if (bitsLog2 == 3) {
+        out.insert(out.end(), values, values + 16);
+        return;
+    }
+    const int bits = 1 << bitsLog2;
+    const int escape = (1 << bits) - 1;
+    std::vector<uint8_t> extra;
+    for (int i = 0; i < 16; i += 8 / bits) {
+        uint8_t byte = 0;
+        for (int j = 0; j < 8 / bits; ++j) {
+            const uint8_t v = values[i + j];
+            byte = static_cast<uint8_t>(byte << bits | (v >= escape ? escape : v));
+            if (v >= escape) {
+                extra.push_back(v);
+            }
+        }
+        out.push_back(byte);
+    }
+    out.insert(out.end(), extra.begin(), extra.end());
+}
+
+static std::vector<uint8_t> encodeVertices(const uint8_t* vertices, size_t count, size_t stride) {
+    std::vector<uint8_t> out(1, 0xA0);
+    std::vector<uint8_t> last(vertices, vertices + stride);
+    const size_t blockSize = std::min<size_t>((8192 / stride) & ~15, 256);
+    for (size_t offset = 0; offset < count; offset += blockSize) {
+        const size_t blockCount = std::min(blockSize, count - offset);
+        const size_t aligned = (blockCount + 15) & ~15;
+        for (size_t k = 0; k < stride; ++k) {
+            std::vector<uint8_t> deltas(aligned, 0);
+            uint8_t previous = last[k];
+            for (size_t i = 0; i < blockCount; ++i) {
+                const uint8_t v = vertices[(offset + i) * stride + k];
+                deltas[i] = zigzag8(static_cast<uint8_t>(v - previous));
+                previous = v;
+            }
+            const size_t headerOffset = out.size();
+            out.resize(out.size() + (aligned / 16 + 3) / 4, 0);
+            for (size_t g = 0; g < aligned; g += 16) {
+                // Pick the smallest of the four encodings.
+                int best = 3;
+                size_t bestSize = 16;
+                for (int bitsLog2 = 0; bitsLog2 < 3; ++bitsLog2) {
+                    std::vector<uint8_t> trial;
+                    encodeBytesGroup(trial, &deltas[g], bitsLog2);
+                    bool fits = true;
+                    if (bitsLog2 == 0) {
+                        for (int i = 0; i < 16; ++i) {
+                            fits = fits && deltas[g + i] == 0;
+                        }
+                    }
+                    if (fits && trial.size() < bestSize) {
+                        best = bitsLog2;
+                        bestSize = trial.size();
+                    }
+                }
+                out[headerOffset + g / 64] |= static_cast<uint8_t>(best << ((g / 16 % 4) * 2));
+                encodeBytesGroup(out, &deltas[g], best);
+            }
+        }
+        memcpy(last.data(), vertices + (offset + blockCount - 1) * stride, stride);
+    }
+    out.resize(out.size() + std::max<size_t>(32, stride) - stride, 0);
+    out.insert(out.end(), vertices, vertices + stride);
+    return out;
+}
+
+/// Encodes triangles with edge and vertex FIFO codes, table codes and free indices.
+static std::vector<uint8_t> encodeTriangles(const std::vector<uint32_t>& indices) {
+    uint32_t edges[16][2];
+    uint32_t fifo[16];
+    memset(edges, -1, sizeof(edges));
+    memset(fifo, -1, sizeof(fifo));
+    size_t edgeOffset = 0;
+    size_t vertexOffset = 0;
+    auto pushEdge = [&](uint32_t a, uint32_t b) {
+        edges[edgeOffset][0] = a;
+        edges[edgeOffset][1] = b;
+        edgeOffset = (edgeOffset + 1) & 15;
+    };
+    auto pushVertex = [&](uint32_t v, bool condition) {
+        fifo[vertexOffset] = v;
+        vertexOffset = (vertexOffset + (condition ? 1 : 0)) & 15;
+    };
+    auto findVertex = [&](uint32_t v) {
+        for (int i = 0; i < 16; ++i) {
+            if (fifo[(vertexOffset - 1 - i) & 15] == v) {
+                return i;
+            }
+        }
+        return -1;
+    };
+    const uint8_t table[16] = {0x00, 0x01, 0x10, 0x11, 0x12, 0x21, 0x22, 0x02, 0x20, 0x13, 0x31, 0x23, 0x32, 0x33, 0x03, 0x30};
+    std::vector<uint8_t> codes;
+    std::vector<uint8_t> data;
+    uint32_t next = 0;
+    uint32_t last = 0;
+    auto freeIndex = [&](uint32_t v) {
+        encodeVByte(data, zigzag32(v - last));
+        last = v;
+    };
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        uint32_t tri[3] = {indices[i], indices[i + 1], indices[i + 2]};
+        int fe = -1;
+        for (int r = 0; r < 3 && fe < 0; ++r) {
+            for (int e = 0; e < 15; ++e) {
+                const uint32_t* edge = edges[(edgeOffset - 1 - e) & 15];
+                if (edge[0] == tri[r] && edge[1] == tri[(r + 1) % 3]) {
+                    const uint32_t rotated[3] = {tri[r], tri[(r + 1) % 3], tri[(r + 2) % 3]};
+                    memcpy(tri, rotated, sizeof(tri));
+                    fe = e;
+                    break;
+                }
+            }
+        }
+        const uint32_t a = tri[0];
+        const uint32_t b = tri[1];
+        const uint32_t c = tri[2];
+        if (fe >= 0) {
+            const int fc = findVertex(c);
+            int fec = fc >= 1 && fc < 13 ? fc : (c == next ? (next++, 0) : 15);
+            if (fec == 15 && c + 1 == last) {
+                fec = 13;
+                last = c;
+            }
+            else if (fec == 15 && c == last + 1) {
+                fec = 14;
+                last = c;
+            }
+            codes.push_back(static_cast<uint8_t>(fe << 4 | fec));
+            if (fec == 15) {
+                freeIndex(c);
+            }
+            pushVertex(c, fec == 0 || fec >= 13);
+            pushEdge(c, b);
+            pushEdge(a, c);
+            continue;
+        }
+        const int fb = findVertex(b);
+        const int fc = findVertex(c);
+        const int fea = a == next ? (next++, 0) : 15;
+        int feb = fb >= 0 && fb < 14 ? fb + 1 : (b == next ? (next++, 0) : 15);
+        int fec = fc >= 0 && fc < 14 ? fc + 1 : (c == next ? (next++, 0) : 15);
+        // A zero aux byte would reset the numbering, so a free first vertex never uses new ones.
+        if (fea == 15 && feb == 0 && fec == 0) {
+            next -= 2;
+            feb = fec = 15;
+        }
+        const uint8_t aux = static_cast<uint8_t>(feb << 4 | fec);
+        const uint8_t* found = std::find(table, table + 16, aux);
+        const bool useTable = fea == 0 && found != table + 16;
+        if (useTable) {
+            codes.push_back(static_cast<uint8_t>(0xF0 | (found - table)));
+        }
+        else {
+            codes.push_back(fea == 0 ? 0xFE : 0xFF);
+            data.push_back(aux);
+            if (fea == 15) {
+                freeIndex(a);
+            }
+            if (feb == 15) {
+                freeIndex(b);
+            }
+            if (fec == 15) {
+                freeIndex(c);
+            }
+        }
+        pushVertex(a, true);
+        pushVertex(b, feb == 0 || (!useTable && feb == 15));
+        pushVertex(c, fec == 0 || (!useTable && fec == 15));
+        pushEdge(b, a);
+        pushEdge(c, b);
+        pushEdge(a, c);
+    }
+    std::vector<uint8_t> out(1, 0xE1);
+    out.insert(out.end(), codes.begin(), codes.end());
+    out.insert(out.end(), data.begin(), data.end());
+    out.insert(out.end(), table, table + 16);
+    return out;
+}
+
+static std::vector<uint8_t> encodeSequence(const std::vector<uint32_t>& indices) {
+    std::vector<uint8_t> out(1, 0xD1);
+    uint32_t last[2] = {0, 0};
+    for (uint32_t index : indices) {
+        // Use the closer of the two baselines.
+        const int32_t d0 = static_cast<int32_t>(index - last[0]);
+        const int32_t d1 = static_cast<int32_t>(index - last[1]);
+        const int current = std::abs(d1) < std::abs(d0) ? 1 : 0;
+        encodeVByte(out, zigzag32(index - last[current]) << 1 | current);
+        last[current] = index;
+    }
+    out.insert(out.end(), 4, 0);
+    return out;
+}
+
+/// A grid of quads so the triangles share edges and vertices like a real mesh.
+static std::vector<uint32_t> gridIndices(uint32_t size) {
+    std::vector<uint32_t> indices;
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            const uint32_t i = y * (size + 1) + x;
+            const uint32_t quad[] = {i, i + size + 1, i + 1, i + 1, i + size + 1, i + size + 2};
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+    return indices;
+}
+
+TEST(meshopt, vertices) {
+    std::mt19937 random(3);
+    for (size_t stride : {4, 12, 16, 32, 36}) {
+        for (size_t count : {1, 15, 16, 17, 300, 1000}) {
+            std::vector<uint8_t> vertices(count * stride);
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                // Smooth data with some noise exercises every group encoding.
+                vertices[i] = static_cast<uint8_t>(i / stride + (random() % 8 == 0 ? random() : 0));
+            }
+            const auto encoded = encodeVertices(vertices.data(), count, stride);
+            std::vector<uint8_t> decoded(vertices.size());
+            ASSERT_TRUE(meshopt::decodeVertexBuffer(decoded.data(), count, stride, encoded.data(), encoded.size()))
+                << stride << " " << count;
+            EXPECT_EQ(vertices, decoded) << stride << " " << count;
+        }
+    }
+}
+
+TEST(meshopt, triangles) {
+    auto indices = gridIndices(20);
+    // A triangle of vertices that are far away from the others.
+    indices.insert(indices.end(), {1000, 2000, 1500});
+    const auto encoded = encodeTriangles(indices);
+    std::vector<uint32_t> decoded(indices.size());
+    ASSERT_TRUE(meshopt::decodeIndexBuffer(decoded.data(), indices.size(), 4, encoded.data(), encoded.size()));
+    // Triangles may be rotated but keep their winding.
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        bool same = false;
+        for (int r = 0; r < 3; ++r) {
+            same = same || (decoded[i] == indices[i + r] && decoded[i + 1] == indices[i + (r + 1) % 3]
+                && decoded[i + 2] == indices[i + (r + 2) % 3]);
+        }
+        EXPECT_TRUE(same) << i;
+    }
+    std::vector<uint16_t> shorts(indices.size());
+    ASSERT_TRUE(meshopt::decodeIndexBuffer(shorts.data(), indices.size(), 2, encoded.data(), encoded.size()));
+    EXPECT_EQ(decoded[7], shorts[7]);
+}
+
+TEST(meshopt, sequence) {
+    std::vector<uint32_t> indices = {0, 1, 2, 3, 2, 1, 100000, 5, 100001, 6, 0, 70000};
+    const auto encoded = encodeSequence(indices);
+    std::vector<uint32_t> decoded(indices.size());
+    ASSERT_TRUE(meshopt::decodeIndexSequence(decoded.data(), indices.size(), 4, encoded.data(), encoded.size()));
+    EXPECT_EQ(indices, decoded);
+}
+
+TEST(meshopt, rejects_invalid_data) {
+    const auto indices = gridIndices(4);
+    std::vector<uint32_t> decoded(indices.size());
+    auto encoded = encodeTriangles(indices);
+    EXPECT_FALSE(meshopt::decodeIndexBuffer(decoded.data(), indices.size(), 4, encoded.data(), encoded.size() - 1));
+    encoded[0] = 0xE5;
+    EXPECT_FALSE(meshopt::decodeIndexBuffer(decoded.data(), indices.size(), 4, encoded.data(), encoded.size()));
+
+    encoded = encodeSequence(indices);
+    EXPECT_FALSE(meshopt::decodeIndexSequence(decoded.data(), indices.size(), 4, encoded.data(), encoded.size() - 1));
+
+    std::vector<uint8_t> vertices(64 * 16, 7);
+    std::vector<uint8_t> out(vertices.size());
+    encoded = encodeVertices(vertices.data(), 64, 16);
+    EXPECT_FALSE(meshopt::decodeVertexBuffer(out.data(), 64, 16, encoded.data(), encoded.size() - 1));
+    EXPECT_FALSE(meshopt::decodeVertexBuffer(out.data(), 64, 16, encoded.data(), 10));
+    EXPECT_FALSE(meshopt::decodeVertexBuffer(out.data(), 64, 6, encoded.data(), encoded.size()));
+    // Every truncation fails without reading past the end.
+    for (size_t size = 0; size + 1 < encoded.size(); size += 7) {
+        std::vector<uint8_t> truncated(encoded.begin(), encoded.begin() + size);
+        EXPECT_FALSE(meshopt::decodeVertexBuffer(out.data(), 64, 16, truncated.data(), truncated.size())) << size;
+    }
+}
+
+TEST(meshopt, filters) {
+    // The unit vector (0.6, 0, -0.8) in 16 bit octahedral form: the lower hemisphere folds (3/7, 0) to (1, 4/7).
+    int16_t oct[4] = {32767, static_cast<int16_t>(32767 * 4 / 7), 32767, 1234};
+    meshopt::decodeFilterOct(oct, 1, 8);
+    EXPECT_NEAR(0.6f, oct[0] / 32767.0f, 1e-3f);
+    EXPECT_NEAR(0.0f, oct[1] / 32767.0f, 1e-3f);
+    EXPECT_NEAR(-0.8f, oct[2] / 32767.0f, 1e-3f);
+    EXPECT_EQ(1234, oct[3]);
+
+    // The identity quaternion: w is dropped (index 3) and rebuilt.
+    int16_t quat[4] = {0, 0, 0, static_cast<int16_t>(0x7FFC | 3)};
+    meshopt::decodeFilterQuat(quat, 1, 8);
+    EXPECT_EQ(0, quat[0]);
+    EXPECT_EQ(0, quat[1]);
+    EXPECT_EQ(0, quat[2]);
+    EXPECT_EQ(32767, quat[3]);
+
+    // 3 * 2^-1 and -5 * 2^2.
+    uint32_t exp[2] = {0xFF000003u, 0x02000000u | (static_cast<uint32_t>(-5) & 0xFFFFFF)};
+    meshopt::decodeFilterExp(exp, 1, 8);
+    float f[2];
+    memcpy(f, exp, sizeof(f));
+    EXPECT_EQ(1.5f, f[0]);
+    EXPECT_EQ(-20.0f, f[1]);
+}
@@ -231,6 +231,23 @@ TEST(node, is_drawable) {
     EXPECT_TRUE(meshRenderer);
 }
 
+TEST(mesh, selection_thresholds) {
+    auto mesh = Mesh::create();
+    float screenSize = 1.0f;
+    for (int i = 0; i < 10; ++i) {
+        screenSize *= 0.5f;
+        mesh->addLod(Mesh::create(), screenSize);
+    }
+    EXPECT_EQ(mesh->lodScreenSizes(), mesh->selectionThresholds());
+    // Every LOD is kept when the cull size is added after them.
+    mesh->setCullScreenSize(screenSize * 0.5f);
+    ASSERT_EQ(11u, mesh->selectionThresholds().size());
+    EXPECT_EQ(screenSize, mesh->selectionThresholds()[9]);
+    EXPECT_EQ(screenSize * 0.5f, mesh->selectionThresholds().back());
+    mesh->setCullScreenSize(0.0f);
+    EXPECT_EQ(10u, mesh->selectionThresholds().size());
+}
+
 class TestNodeListener : public Node::Listener {
 public:
     bool _called;
@@ -0,0 +1,98 @@
+#include "common_test.hpp"
+
+#include <OcclusionBuffer.hpp>
+#include <Occluder.hpp>
+#include <BaseMath.hpp>
+
+using namespace kepler;
+
+static const mat4 viewProjection = glm::perspective(glm::radians(60.f), 2.f, 0.1f, 100.f);
+
+/// A wall facing the camera at z = -5.
+static OccluderMesh createWall(float halfSize) {
+    OccluderMesh wall;
+    wall.positions = {
+        vec3(-halfSize, -halfSize, -5), vec3(halfSize, -halfSize, -5),
+        vec3(halfSize, halfSize, -5), vec3(-halfSize, halfSize, -5)};
+    wall.indices = {0, 1, 2, 0, 2, 3};
+    return wall;
+}
+
+TEST(occlusionBuffer, size) {
+    OcclusionBuffer buffer(250, 125);
+    EXPECT_EQ(256, buffer.width());
+    EXPECT_EQ(128, buffer.height());
+}
+
+TEST(occlusionBuffer, emptyBuffer) {
+    OcclusionBuffer buffer(128, 64);
+    buffer.clear(viewProjection);
+    buffer.finish();
+    EXPECT_TRUE(buffer.isVisible(BoundingBox(vec3(-1, -1, -20), vec3(1, 1, -18))));
+    // behind the camera
+    EXPECT_FALSE(buffer.isVisible(BoundingBox(vec3(-1, -1, 5), vec3(1, 1, 6))));
+    // crosses the near plane
+    EXPECT_TRUE(buffer.isVisible(BoundingBox(vec3(-1, -1, -1), vec3(1, 1, 1))));
+}
+
+TEST(occlusionBuffer, hiddenBehindWall) {
+    OcclusionBuffer buffer(128, 64);
+    buffer.clear(viewProjection);
+    buffer.addOccluder(createWall(10), IDENTITY_MATRIX);
+    buffer.finish();
+
+    EXPECT_FALSE(buffer.isVisible(BoundingBox(vec3(-1, -1, -20), vec3(1, 1, -18))));
+    EXPECT_TRUE(buffer.isVisible(BoundingBox(vec3(-1, -1, -3), vec3(1, 1, -2))));
+    // pokes through the wall
+    EXPECT_TRUE(buffer.isVisible(BoundingBox(vec3(-1, -1, -6), vec3(1, 1, -4))));
+}
+
+TEST(occlusionBuffer, partiallyHidden) {
+    OcclusionBuffer buffer(128, 64);
+    buffer.clear(viewProjection);
+    buffer.addOccluder(createWall(1), IDENTITY_MATRIX);
+    buffer.finish();
+
+    EXPECT_FALSE(buffer.isVisible(BoundingBox(vec3(-0.5f, -0.5f, -8), vec3(0.5f, 0.5f, -7))));
+    // wider than the wall
+    EXPECT_TRUE(buffer.isVisible(BoundingBox(vec3(-5, -0.5f, -8), vec3(5, 0.5f, -7))));
+}
+
+TEST(occlusionBuffer, worldMatrix) {
+    OcclusionBuffer buffer(128, 64);
+    buffer.clear(viewProjection);
+    buffer.addOccluder(createWall(1), glm::translate(vec3(10, 0, 0)));
+    buffer.finish();
+    EXPECT_TRUE(buffer.isVisible(BoundingBox(vec3(-0.5f, -0.5f, -8), vec3(0.5f, 0.5f, -7))));
+}
+
+TEST(occlusionBuffer, simdMatchesScalar) {
+    if (!OcclusionBuffer::simdSupported()) {
+        return;
+    }
+    OcclusionBuffer simd(96, 48);
+    OcclusionBuffer scalar(96, 48);
+    scalar.setSimdEnabled(false);
+    auto box = Occluder::createBox(BoundingBox(vec3(-2, -1, -9), vec3(1, 2, -4)));
+    mat4 world = glm::rotate(0.5f, vec3(0, 1, 0));
+    for (auto* buffer : {&simd, &scalar}) {
+        buffer->clear(viewProjection);
+        buffer->addOccluder(createWall(1), IDENTITY_MATRIX);
+        buffer->addOccluder(*box->mesh(), world);
+        buffer->finish();
+    }
+    for (int y = 0; y < simd.height(); ++y) {
+        for (int x = 0; x < simd.width(); ++x) {
+            EXPECT_FLOAT_EQ(scalar.depth(x, y), simd.depth(x, y));
+        }
+    }
+}
+
+TEST(occlusionBuffer, renderAsync) {
+    OcclusionBuffer buffer(128, 64);
+    std::vector<OccluderInstance> occluders;
+    occluders.push_back({std::make_shared<OccluderMesh>(createWall(10)), IDENTITY_MATRIX});
+    buffer.renderAsync(viewProjection, std::move(occluders));
+    buffer.wait();
+    EXPECT_FALSE(buffer.isVisible(BoundingBox(vec3(-1, -1, -20), vec3(1, 1, -18))));
+}
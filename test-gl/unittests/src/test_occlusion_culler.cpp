@@ -0,0 +1,187 @@
+#include "common_test.hpp"
+
+#include <OcclusionCuller.hpp>
+#include <Scene.hpp>
+#include <Node.hpp>
+#include <Camera.hpp>
+#include <DrawableComponent.hpp>
+#include <Bounded.hpp>
+
+using namespace kepler;
+using namespace kepler::gl;
+
+namespace {
+
+/// A unit box that counts how often it is drawn. Nothing is rendered.
+class CountingDrawable : public virtual DrawableComponent, public Bounded {
+public:
+    void draw() override {
+        ++draws;
+    }
+    bool getBoundingBox(BoundingBox& box) override {
+        box = BoundingBox(vec3(-0.5f), vec3(0.5f));
+        return true;
+    }
+    const std::string& typeName() const override {
+        static std::string typeName("CountingDrawable");
+        return typeName;
+    }
+
+    int draws = 0;
+};
+
+/// Query results come from the test instead of the GPU.
+class ScriptedCuller : public OcclusionCuller {
+public:
+    /// False leaves every query pending.
+    bool available = true;
+    GLuint samples = 1;
+
+protected:
+    bool readQuery(GLuint, GLuint& result) override {
+        if (!available) {
+            return false;
+        }
+        result = samples;
+        return true;
+    }
+};
+
+struct CullerScene {
+    shared_ptr<Scene> scene;
+    shared_ptr<Node> node;
+    shared_ptr<CountingDrawable> drawable;
+};
+
+/// Adds a box at the origin to the scene.
+void addBox(CullerScene& s) {
+    s.node = s.scene->createChild("box");
+    s.drawable = std::make_shared<CountingDrawable>();
+    s.node->addComponent(s.drawable);
+}
+
+/// A scene with a camera at z = 5 that looks at a box at the origin.
+CullerScene createCullerScene() {
+    CullerScene s;
+    s.scene = Scene::create();
+    auto cameraNode = s.scene->createChild("camera");
+    cameraNode->setTranslation(0, 0, 5);
+    auto camera = Camera::createPerspective(45.0f, 1.0f, 0.1f, 100.0f);
+    cameraNode->addComponent(camera);
+    s.scene->setActiveCamera(camera);
+    addBox(s);
+    return s;
+}
+
+/// Draws frames until the box was found to be occluded.
+void occludeBox(ScriptedCuller& culler, CullerScene& s) {
+    culler.setVisibleQueryInterval(1);
+    culler.samples = 0;
+    // The first frame draws the box, the second wraps the draw in a query and the third reads the result.
+    for (int i = 0; i < 3; ++i) {
+        culler.drawScene(*s.scene);
+    }
+    ASSERT_EQ(1u, culler.stats().objectsSkipped);
+}
+
+} // anonymous namespace
+
+TEST(occlusionCuller, visible_retested_after_interval) {
+    auto s = createCullerScene();
+    ScriptedCuller culler;
+    culler.setVisibleQueryInterval(3);
+    size_t queries = 0;
+    for (int frame = 0; frame < 9; ++frame) {
+        culler.drawScene(*s.scene);
+        EXPECT_EQ(1u, culler.stats().objectsRendered);
+        queries += culler.stats().queriesIssued;
+    }
+    // Visible objects are drawn every frame but only tested every third frame.
+    EXPECT_EQ(9, s.drawable->draws);
+    EXPECT_EQ(3u, queries);
+}
+
+TEST(occlusionCuller, occluded_tested_with_proxy) {
+    auto s = createCullerScene();
+    ScriptedCuller culler;
+    occludeBox(culler, s);
+    const int draws = s.drawable->draws;
+
+    // Each frame reads the last proxy query and issues the next one without drawing the box.
+    for (int frame = 0; frame < 3; ++frame) {
+        culler.drawScene(*s.scene);
+        EXPECT_EQ(1u, culler.stats().queriesIssued);
+        EXPECT_EQ(1u, culler.stats().objectsSkipped);
+        EXPECT_EQ(0u, culler.stats().objectsRendered);
+    }
+    EXPECT_EQ(draws, s.drawable->draws);
+
+    culler.samples = 1;
+    culler.drawScene(*s.scene);
+    EXPECT_EQ(1u, culler.stats().objectsRendered);
+    EXPECT_EQ(draws + 1, s.drawable->draws);
+}
+
+TEST(occlusionCuller, pending_result_keeps_visibility) {
+    auto s = createCullerScene();
+    ScriptedCuller culler;
+    occludeBox(culler, s);
+    const int draws = s.drawable->draws;
+
+    // The proxy query of the last frame stays in flight so nothing new is issued and the box stays occluded.
+    culler.available = false;
+    for (int frame = 0; frame < 3; ++frame) {
+        culler.drawScene(*s.scene);
+        EXPECT_EQ(0u, culler.stats().queriesIssued);
+        EXPECT_EQ(1u, culler.stats().queriesPending);
+        EXPECT_EQ(1u, culler.stats().objectsSkipped);
+    }
+    EXPECT_EQ(draws, s.drawable->draws);
+
+    // With conditional rendering the box is drawn on the condition of the query in flight every frame.
+    culler.setConditionalRender(true);
+    culler.drawScene(*s.scene);
+    culler.drawScene(*s.scene);
+    EXPECT_EQ(0u, culler.stats().queriesIssued);
+    EXPECT_EQ(draws + 2, s.drawable->draws);
+
+    // A visible box with a pending query stays visible.
+    auto visible = createCullerScene();
+    ScriptedCuller visibleCuller;
+    visibleCuller.setVisibleQueryInterval(1);
+    visibleCuller.available = false;
+    for (int frame = 0; frame < 4; ++frame) {
+        visibleCuller.drawScene(*visible.scene);
+        EXPECT_EQ(1u, visibleCuller.stats().objectsRendered);
+    }
+}
+
+TEST(occlusionCuller, forgets_removed_nodes) {
+    auto s = createCullerScene();
+    ScriptedCuller culler;
+    culler.setVisibleQueryInterval(1);
+    culler.available = false;
+    culler.drawScene(*s.scene);
+    culler.drawScene(*s.scene);
+    EXPECT_EQ(1u, culler.stats().queriesPending);
+
+    s.scene->removeChild(s.node);
+    culler.drawScene(*s.scene);
+    EXPECT_EQ(0u, culler.stats().queriesPending);
+    EXPECT_EQ(0u, culler.stats().objectsRendered + culler.stats().objectsSkipped);
+}
+
+TEST(occlusionCuller, new_node_does_not_inherit_visibility) {
+    auto s = createCullerScene();
+    ScriptedCuller culler;
+    occludeBox(culler, s);
+
+    // Replace the occluded box between two frames. Its memory may be reused for the new one.
+    s.scene->removeChild(s.node);
+    s.node = nullptr;
+    s.drawable = nullptr;
+    addBox(s);
+    culler.drawScene(*s.scene);
+    EXPECT_EQ(1u, culler.stats().objectsRendered);
+    EXPECT_EQ(1, s.drawable->draws);
+}
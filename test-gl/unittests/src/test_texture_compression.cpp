@@ -0,0 +1,132 @@
+#include "common_test.hpp"
+
+#include <TextureCompression.hpp>
+#include <Ktx2.hpp>
+
+#include <random>
+
+using namespace kepler;
+
+static std::vector<uint8_t> gradientImage(uint32_t width, uint32_t height, bool alpha) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            uint8_t* p = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+            p[0] = static_cast<uint8_t>(x * 255 / std::max(1u, width - 1));
+            p[1] = static_cast<uint8_t>(y * 255 / std::max(1u, height - 1));
+            p[2] = 64;
+            p[3] = alpha ? static_cast<uint8_t>((x + y) * 255 / std::max(1u, width + height - 2)) : 255;
+        }
+    }
+    return pixels;
+}
+
+static int maxDifference(const uint8_t* a, const uint8_t* b, size_t count) {
+    int result = 0;
+    for (size_t i = 0; i < count; ++i) {
+        result = std::max(result, std::abs(static_cast<int>(a[i]) - static_cast<int>(b[i])));
+    }
+    return result;
+}
+
+TEST(textureCompression, bc1_solid_block) {
+    std::vector<uint8_t> pixels(64);
+    for (int i = 0; i < 16; ++i) {
+        pixels[i * 4 + 0] = 255;
+        pixels[i * 4 + 1] = 0;
+        pixels[i * 4 + 2] = 255;
+        pixels[i * 4 + 3] = 255;
+    }
+    uint8_t block[8];
+    compressBC1Block(pixels.data(), block);
+    uint8_t decoded[64];
+    decompressBC1Block(block, decoded);
+    EXPECT_EQ(0, maxDifference(pixels.data(), decoded, 64));
+}
+
+TEST(textureCompression, bc1_gradient_block) {
+    // The colors are on a line so the error only comes from having 4 colors.
+    std::vector<uint8_t> pixels(64);
+    for (int i = 0; i < 16; ++i) {
+        pixels[i * 4 + 0] = static_cast<uint8_t>(i * 17);
+        pixels[i * 4 + 1] = static_cast<uint8_t>(255 - i * 17);
+        pixels[i * 4 + 2] = 128;
+        pixels[i * 4 + 3] = 255;
+    }
+    uint8_t block[8];
+    compressBC1Block(pixels.data(), block);
+    uint8_t decoded[64];
+    decompressBC1Block(block, decoded);
+    EXPECT_LE(maxDifference(pixels.data(), decoded, 64), 48);
+    // Always the 4 color mode.
+    EXPECT_GE(block[0] | block[1] << 8, block[2] | block[3] << 8);
+}
+
+TEST(textureCompression, bc3_alpha) {
+    auto pixels = gradientImage(4, 4, true);
+    uint8_t block[16];
+    compressBC3Block(pixels.data(), block);
+    uint8_t decoded[64];
+    decompressBC3Block(block, decoded);
+    int alphaError = 0;
+    for (int i = 0; i < 16; ++i) {
+        alphaError = std::max(alphaError, std::abs(pixels[i * 4 + 3] - decoded[i * 4 + 3]));
+    }
+    EXPECT_LE(alphaError, 255 / 14 + 1);
+}
+
+TEST(textureCompression, threads_match) {
+    auto pixels = gradientImage(250, 130, true);
+    auto single = compressImage(pixels.data(), 250, 130, Ktx2Format::BC3_UNORM, 1);
+    auto multi = compressImage(pixels.data(), 250, 130, Ktx2Format::BC3_UNORM, 4);
+    EXPECT_EQ(ktx2LevelSize(Ktx2Format::BC3_UNORM, 250, 130), single.size());
+    EXPECT_EQ(single, multi);
+    EXPECT_TRUE(compressImage(pixels.data(), 250, 130, Ktx2Format::BC7_UNORM).empty());
+}
+
+TEST(textureCompression, ktx2_round_trip) {
+    auto pixels = gradientImage(37, 16, false);
+    Ktx2Texture texture;
+    compressTexture(pixels.data(), 37, 16, true, true, 0, texture);
+    EXPECT_EQ(Ktx2Format::BC1_RGB_SRGB, texture.format);
+    // 37x16, 18x8, 9x4, 4x2, 2x1, 1x1
+    ASSERT_EQ(6u, texture.levels.size());
+
+    std::vector<uint8_t> file;
+    ASSERT_TRUE(writeKtx2(texture, file));
+    EXPECT_TRUE(isKtx2(file.data(), file.size()));
+
+    Ktx2Texture loaded;
+    ASSERT_TRUE(readKtx2(file.data(), file.size(), loaded));
+    EXPECT_EQ(texture.format, loaded.format);
+    EXPECT_EQ(37u, loaded.width);
+    EXPECT_EQ(16u, loaded.height);
+    EXPECT_TRUE(loaded.uploadable());
+    ASSERT_EQ(texture.levels.size(), loaded.levels.size());
+    for (size_t i = 0; i < loaded.levels.size(); ++i) {
+        ASSERT_EQ(texture.levels[i].length, loaded.levels[i].length);
+        EXPECT_EQ(0, memcmp(texture.levelData(i), loaded.levelData(i), loaded.levels[i].length));
+    }
+
+    file.resize(file.size() - 1);
+    EXPECT_FALSE(readKtx2(file.data(), file.size(), loaded));
+    const uint8_t png[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n', 0, 0, 0, 0};
+    EXPECT_FALSE(isKtx2(png, sizeof(png)));
+}
+
+TEST(textureCompression, ktx2_short_level) {
+    auto pixels = gradientImage(16, 16, false);
+    Ktx2Texture texture;
+    compressTexture(pixels.data(), 16, 16, true, false, 0, texture);
+    std::vector<uint8_t> file;
+    ASSERT_TRUE(writeKtx2(texture, file));
+
+    // Shorten the byteLength of level 0 in the level index that follows the 80 byte header.
+    const size_t byteLengthOffset = 80 + 8;
+    uint32_t byteLength;
+    memcpy(&byteLength, &file[byteLengthOffset], sizeof(byteLength));
+    byteLength -= 8;
+    memcpy(&file[byteLengthOffset], &byteLength, sizeof(byteLength));
+    Ktx2Texture loaded;
+    EXPECT_FALSE(readKtx2(file.data(), file.size(), loaded));
+}
@@ -0,0 +1,137 @@
+#include "common_test.hpp"
+
+#include <TextureStreamer.hpp>
+#include <Texture.hpp>
+#include <Ktx2.hpp>
+
+using namespace kepler;
+using namespace kepler::gl;
+
+TEST(textureStreamer, required_level) {
+    // 1024x512 has 11 levels.
+    EXPECT_EQ(0u, TextureStreamer::requiredLevel(1024, 512, 2000.0f, 11));
+    EXPECT_EQ(0u, TextureStreamer::requiredLevel(1024, 512, 1024.0f, 11));
+    EXPECT_EQ(0u, TextureStreamer::requiredLevel(1024, 512, 1000.0f, 11));
+    EXPECT_EQ(1u, TextureStreamer::requiredLevel(1024, 512, 512.0f, 11));
+    EXPECT_EQ(1u, TextureStreamer::requiredLevel(1024, 512, 300.0f, 11));
+    EXPECT_EQ(10u, TextureStreamer::requiredLevel(1024, 512, 0.5f, 11));
+    EXPECT_EQ(10u, TextureStreamer::requiredLevel(1024, 512, 0.0f, 11));
+    // Clamped to the levels in the file.
+    EXPECT_EQ(3u, TextureStreamer::requiredLevel(1024, 512, 1.0f, 4));
+}
+
+/// A 256x256 RGBA8 texture with its 9 levels.
+static shared_ptr<const Ktx2Texture> createKtx2() {
+    auto ktx = std::make_shared<Ktx2Texture>();
+    ktx->format = Ktx2Format::R8G8B8A8_UNORM;
+    ktx->width = 256;
+    ktx->height = 256;
+    for (uint32_t size = 256; size > 0; size /= 2) {
+        Ktx2Texture::Level level;
+        level.offset = ktx->data.size();
+        level.length = ktx2LevelSize(ktx->format, size, size);
+        ktx->data.resize(ktx->data.size() + level.length, 128);
+        ktx->levels.push_back(level);
+    }
+    return ktx;
+}
+
+static GLint baseLevel(const Texture& texture) {
+    GLint level = -1;
+    glBindTexture(GL_TEXTURE_2D, texture.handle());
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, &level);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return level;
+}
+
+// The bytes of the levels of a 256x256 RGBA8 texture from level 0, 1 and 2 to the end.
+static constexpr size_t FULL_BYTES = 349524;
+static constexpr size_t FROM_LEVEL_1 = FULL_BYTES - 256 * 256 * 4;
+static constexpr size_t FROM_LEVEL_2 = FROM_LEVEL_1 - 128 * 128 * 4;
+
+TEST(textureStreamer, loads_small_levels) {
+    auto streamer = TextureStreamer::create();
+    auto texture = streamer->load(createKtx2());
+    ASSERT_NE(nullptr, texture);
+    // Only the levels of 64x64 and smaller are uploaded.
+    EXPECT_EQ(2, baseLevel(*texture));
+    auto stats = streamer->stats();
+    EXPECT_EQ(1u, stats.textures);
+    EXPECT_EQ(FROM_LEVEL_2, stats.residentBytes);
+    EXPECT_EQ(FULL_BYTES, stats.totalBytes);
+    EXPECT_EQ(7u, stats.residentLevels);
+    EXPECT_EQ(9u, stats.totalLevels);
+}
+
+TEST(textureStreamer, streams_requested_levels) {
+    auto streamer = TextureStreamer::create();
+    auto texture = streamer->load(createKtx2());
+    ASSERT_NE(nullptr, texture);
+
+    // A byte budget of 1 uploads one level per update.
+    streamer->request(*texture, 256.0f);
+    streamer->update(1);
+    EXPECT_EQ(1, baseLevel(*texture));
+    streamer->request(*texture, 256.0f);
+    streamer->update(1);
+    EXPECT_EQ(0, baseLevel(*texture));
+    EXPECT_EQ(FULL_BYTES, streamer->stats().residentBytes);
+    EXPECT_EQ(2u, streamer->stats().streamedLevels);
+
+    // Levels that aren't requested anymore stay while they fit in the budget.
+    streamer->update();
+    EXPECT_EQ(0, baseLevel(*texture));
+}
+
+TEST(textureStreamer, stays_under_budget) {
+    auto streamer = TextureStreamer::create(FULL_BYTES + FROM_LEVEL_1);
+    auto a = streamer->load(createKtx2());
+    auto b = streamer->load(createKtx2());
+    ASSERT_NE(nullptr, a);
+    ASSERT_NE(nullptr, b);
+    for (int frame = 0; frame < 4; ++frame) {
+        streamer->request(*a, 256.0f);
+        streamer->request(*b, 256.0f);
+        streamer->update();
+        EXPECT_LE(streamer->stats().residentBytes, streamer->stats().budget);
+    }
+    // Both can't have level 0 so one of them keeps level 1.
+    EXPECT_EQ(FULL_BYTES + FROM_LEVEL_1, streamer->stats().residentBytes);
+    EXPECT_EQ(1, baseLevel(*a) + baseLevel(*b));
+
+    // A budget smaller than the small levels evicts everything else but keeps the small levels.
+    streamer->setBudget(FROM_LEVEL_2);
+    streamer->update();
+    EXPECT_EQ(2 * FROM_LEVEL_2, streamer->stats().residentBytes);
+    EXPECT_EQ(2, baseLevel(*a));
+    EXPECT_EQ(2, baseLevel(*b));
+}
+
+TEST(textureStreamer, evicts_least_recently_needed_first) {
+    auto streamer = TextureStreamer::create(2 * FULL_BYTES);
+    auto a = streamer->load(createKtx2());
+    auto b = streamer->load(createKtx2());
+    ASSERT_NE(nullptr, a);
+    ASSERT_NE(nullptr, b);
+    streamer->request(*a, 256.0f);
+    streamer->request(*b, 256.0f);
+    streamer->update();
+    ASSERT_EQ(0, baseLevel(*a));
+    ASSERT_EQ(0, baseLevel(*b));
+
+    // b was needed more recently than a. Neither is requested when the budget shrinks.
+    streamer->request(*b, 256.0f);
+    streamer->update();
+    streamer->setBudget(FULL_BYTES + FROM_LEVEL_2);
+    streamer->update();
+    EXPECT_EQ(2, baseLevel(*a));
+    EXPECT_EQ(0, baseLevel(*b));
+    EXPECT_EQ(2u, streamer->stats().evictedLevels);
+
+    // Once a is needed again it streams back in and b, which isn't needed anymore, gives up its levels.
+    streamer->request(*a, 256.0f);
+    streamer->update();
+    EXPECT_EQ(0, baseLevel(*a));
+    EXPECT_EQ(2, baseLevel(*b));
+    EXPECT_LE(streamer->stats().residentBytes, streamer->stats().budget);
+}
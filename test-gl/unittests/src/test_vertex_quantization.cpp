@@ -0,0 +1,95 @@
+#include "common_test.hpp"
+
+#include <VertexQuantization.hpp>
+#include <BaseMath.hpp>
+
+#include <random>
+
+using namespace kepler;
+
+static std::vector<vec3> randomUnitVectors(size_t count) {
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    std::vector<vec3> vectors;
+    while (vectors.size() < count) {
+        vec3 v(distribution(random), distribution(random), distribution(random));
+        float length = glm::length(v);
+        if (length > 0.01f && length <= 1.f) {
+            vectors.push_back(v / length);
+        }
+    }
+    return vectors;
+}
+
+TEST(vertexQuantization, positions) {
+    BoundingBox box(vec3(-2.f, 1.f, 5.f), vec3(6.f, 3.f, 5.f));
+    std::vector<vec3> positions = {vec3(-2.f, 1.f, 5.f), vec3(6.f, 3.f, 5.f), vec3(1.234f, 2.5f, 5.f)};
+    std::vector<uint16_t> quantized(positions.size() * 4);
+    float error = quantizePositions(quantized.data(), &positions[0].x, positions.size(), 0, box);
+    EXPECT_LT(error, 8.f / 65535.f);
+    EXPECT_EQ(0, quantized[0]);
+    EXPECT_EQ(65535, quantized[4]);
+    EXPECT_EQ(65535, quantized[5]);
+    // the flat axis dequantizes to the box
+    EXPECT_EQ(0, quantized[6]);
+
+    mat4 m = positionDequantizationMatrix(box);
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const uint16_t* q = &quantized[i * 4];
+        vec3 p = vec3(m * vec4(q[0] / 65535.f, q[1] / 65535.f, q[2] / 65535.f, 1.f));
+        EXPECT_NEAR(positions[i].x, p.x, 1e-4f);
+        EXPECT_NEAR(positions[i].y, p.y, 1e-4f);
+        EXPECT_NEAR(positions[i].z, p.z, 1e-4f);
+    }
+}
+
+TEST(vertexQuantization, octahedral) {
+    auto vectors = randomUnitVectors(1000);
+    vectors.push_back(vec3(0.f, 0.f, -1.f));
+    vectors.push_back(vec3(1.f, 0.f, 0.f));
+    for (const auto& v : vectors) {
+        vec2 e = octEncode(v);
+        EXPECT_LE(std::abs(e.x), 1.f);
+        EXPECT_LE(std::abs(e.y), 1.f);
+        vec3 d = octDecode(e);
+        EXPECT_NEAR(v.x, d.x, 1e-5f);
+        EXPECT_NEAR(v.y, d.y, 1e-5f);
+        EXPECT_NEAR(v.z, d.z, 1e-5f);
+    }
+}
+
+TEST(vertexQuantization, normals) {
+    auto normals = randomUnitVectors(1000);
+    std::vector<int16_t> quantized(normals.size() * 2);
+    float error = quantizeNormals(quantized.data(), &normals[0].x, normals.size(), 0);
+    // 16 bit octahedral normals are accurate to a few thousandths of a degree
+    EXPECT_LT(error, glm::radians(0.01f));
+}
+
+TEST(vertexQuantization, tangents) {
+    auto directions = randomUnitVectors(100);
+    std::vector<vec4> tangents;
+    for (size_t i = 0; i < directions.size(); ++i) {
+        tangents.emplace_back(directions[i], i % 2 == 0 ? 1.f : -1.f);
+    }
+    std::vector<int16_t> quantized(tangents.size() * 4);
+    float error = quantizeTangents(quantized.data(), &tangents[0].x, tangents.size(), 0);
+    EXPECT_LT(error, glm::radians(0.01f));
+    EXPECT_EQ(32767, quantized[2]);
+    EXPECT_EQ(-32767, quantized[6]);
+}
+
+TEST(vertexQuantization, texCoords) {
+    std::vector<vec2> texcoords = {vec2(0.f, 1.f), vec2(0.25f, 0.75f), vec2(0.1f, 0.9f)};
+    std::vector<uint16_t> quantized(texcoords.size() * 2);
+    float error = 1.f;
+    EXPECT_TRUE(quantizeTexCoords(quantized.data(), &texcoords[0].x, texcoords.size(), 0, &error));
+    EXPECT_LE(error, 0.5f / 65535.f);
+    EXPECT_EQ(0, quantized[0]);
+    EXPECT_EQ(65535, quantized[1]);
+
+    // wrapped coordinates can't be stored as normalized integers
+    texcoords.push_back(vec2(1.5f, 0.f));
+    quantized.resize(texcoords.size() * 2);
+    EXPECT_FALSE(quantizeTexCoords(quantized.data(), &texcoords[0].x, texcoords.size(), 0, &error));
+}